@@ -9,7 +9,7 @@ CFLAGS="-c -O2 -m32"
 
 LINKER="gcc"
 LFLAGS="-O2 -s -m32 -L/usr/lib32/"
-LIBS="-pthread -lm"
+LIBS="-pthread -lm -ldl"
 
 OUTFILE="./pragma_server"
 
@@ -25,29 +25,35 @@ SRC[7]=./src/qcommon/files
 SRC[8]=./src/qcommon/md4
 SRC[9]=./src/qcommon/net_chan
 SRC[10]=./src/qcommon/shared
-SRC[11]=./src/script/scr_builtins_math
-SRC[12]=./src/script/scr_debug
-SRC[13]=./src/script/scr_exec
-SRC[14]=./src/script/scr_main
-SRC[15]=./src/script/scr_builtins_shared
-SRC[16]=./src/script/scr_utils
-SRC[17]=./src/server/sv_ai
-SRC[18]=./src/server/sv_devtools
-SRC[19]=./src/server/sv_load
-SRC[20]=./src/server/sv_gentity
-SRC[21]=./src/server/sv_physics
-SRC[22]=./src/server/sv_script
-SRC[23]=./src/server/sv_ccmds
-SRC[24]=./src/server/sv_builtins
-SRC[25]=./src/server/sv_write
-SRC[26]=./src/server/sv_init
-SRC[27]=./src/server/sv_main
-SRC[28]=./src/server/sv_send
-SRC[29]=./src/server/sv_user
-SRC[30]=./src/server/sv_world
-SRC[31]=./src/platform/linux_net
-SRC[32]=./src/platform/linux_shared
-SRC[33]=./src/platform/linux_main
+SRC[11]=./src/qcommon/profile
+SRC[12]=./src/script/scr_builtins_math
+SRC[13]=./src/script/scr_debug
+SRC[14]=./src/script/scr_exec
+SRC[15]=./src/script/scr_main
+SRC[16]=./src/script/scr_builtins_shared
+SRC[17]=./src/script/scr_utils
+SRC[18]=./src/script/scr_strings
+SRC[19]=./src/script/scr_aot
+SRC[20]=./src/server/sv_ai
+SRC[21]=./src/server/sv_devtools
+SRC[22]=./src/server/sv_load
+SRC[23]=./src/server/sv_gentity
+SRC[24]=./src/server/sv_physics
+SRC[25]=./src/server/sv_sweep
+SRC[26]=./src/server/sv_script
+SRC[27]=./src/server/sv_ccmds
+SRC[28]=./src/server/sv_save
+SRC[29]=./src/server/sv_bench
+SRC[30]=./src/server/sv_builtins
+SRC[31]=./src/server/sv_write
+SRC[32]=./src/server/sv_init
+SRC[33]=./src/server/sv_main
+SRC[34]=./src/server/sv_send
+SRC[35]=./src/server/sv_user
+SRC[36]=./src/server/sv_world
+SRC[37]=./src/platform/linux_net
+SRC[38]=./src/platform/linux_shared
+SRC[39]=./src/platform/linux_main
 
 #clear
 
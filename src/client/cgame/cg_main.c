@@ -10,6 +10,7 @@ See the attached GNU General Public License v2 for more details.
 
 #include "../client.h"
 #include "cg_local.h"
+#include "../fx/effects.h"
 
 cg_t cg;
 cgMedia_t cgMedia;
@@ -74,6 +75,7 @@ void CG_ClearState()
 	CG_ClearLightStyles();
 
 	CL_ClearTEnts();
+	FX_ClearEffects();
 }
 
 /*
@@ -179,6 +181,9 @@ void CG_Frame(float frametime, int time, float realtime)
 	if (CG_IsActive() == false)
 		return;
 
+	// previous frame is over, drop its temporary strings
+	Scr_CollectStrings(VM_CLGAME);
+
 	Scr_BindVM(VM_CLGAME);
 
 	cg.script_globals->frametime = frametime;
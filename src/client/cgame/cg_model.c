@@ -34,7 +34,7 @@ void CG_GetTagOrigin(clentity_t *ent, int tagIndex, vec3_t outOrigin)
 	tag = SV_PositionTagOnEntity(ent, tagName);
 	if (!tag)
 	{
-		Scr_RunError("gettagorigin(): model '%s' nas no tag '%s'\n", model->name, tagName);
+		Scr_RunError("gettagorigin(): model '%s' has no tag '%s'\n", model->name, tagName);
 		return;
 	}
 
@@ -11,146 +11,330 @@ See the attached GNU General Public License v2 for more details.
 #include "../client.h"
 #include "cg_local.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define CG_SIMD_X86 1
+	#include <immintrin.h>
+	#if defined(__GNUC__) || defined(__clang__)
+		#define CG_TARGET(x) __attribute__((target(x)))
+	#else
+		#define CG_TARGET(x)
+	#endif
+#endif
+
 /*
 ==============================================================
 
 PARTICLE MANAGEMENT
 
+Live particles are stored as a structure of arrays packed into [0, count)
+so the simulation streams through contiguous floats, a dead particle is
+freed by moving the last one into its slot. Effects still fill a cparticle_t
+from CG_ParticleFromPool, these are staged and moved into the store when
+particles are simulated next.
+
 ==============================================================
 */
 
-int				cg_numparticles = 0;
-cparticle_t		cg_particles[MAX_PARTICLES];
+#define	MAX_PARTICLE_SPAWNS		4096	// new particles between two simulations
+
+typedef struct
+{
+	int		count;
+	int		time[MAX_PARTICLES];		// cl.time at spawn
+	float	org[3][MAX_PARTICLES];
+	float	vel[3][MAX_PARTICLES];
+	float	accel[3][MAX_PARTICLES];
+	float	color[3][MAX_PARTICLES];
+	float	size[2][MAX_PARTICLES];
+	float	alpha[MAX_PARTICLES];
+	float	alphavel[MAX_PARTICLES];
+} particlestore_t;
+
+static particlestore_t	cg_parts;
+static int				cg_deadparts[MAX_PARTICLES];
+
+static cparticle_t		cg_spawnparts[MAX_PARTICLE_SPAWNS];
+static int				cg_numspawnparts;
+
+static cvar_t			*cl_particlesimd;
 
 
 /*
-==================
-CG_FreeParticle
-==================
+==============================================================
+
+SIMULATION KERNELS
+
+A kernel moves particles [first, last) to their position at time now and
+writes the visible ones straight into out, at most maxout of them. Indexes
+of faded out particles are appended to dead in increasing order.
+Every kernel must match the scalar one, cg_particlebench compares them.
+
+==============================================================
 */
-void CG_FreeParticle(cparticle_t* part)
+
+typedef int (*particlekernel_t)(int first, int last, int now, particle_t *out, int maxout, int *dead, int *numdead);
+
+typedef struct
+{
+	char				*name;
+	int					cpuflags; // CPU_* required
+	particlekernel_t	simulate;
+} particlekernels_t;
+
+static int CG_SimulateParticles_C(int first, int last, int now, particle_t *out, int maxout, int *dead, int *numdead)
 {
-	if (!part || !part->inuse)
+	particlestore_t	*s = &cg_parts;
+	particle_t		*p;
+	float			t, t2, alpha;
+	int				i, numout = 0;
+
+	for (i = first; i < last; i++)
 	{
-		//Com_Error(ERR_DROP, "CG_FreeParticle: not active\n");
-		return;
+		t = (float)(now - s->time[i]) * 0.001f;
+		alpha = s->alpha[i] + t * s->alphavel[i];
+		if (alpha <= 0)
+		{
+			// faded out
+			dead[(*numdead)++] = i;
+			continue;
+		}
+
+		if (numout == maxout)
+			continue;
+
+		if (alpha > 1.0f)
+			alpha = 1.0f;
+
+		t2 = t * t;
+
+		p = &out[numout++];
+		p->origin[0] = s->org[0][i] + s->vel[0][i] * t + s->accel[0][i] * t2;
+		p->origin[1] = s->org[1][i] + s->vel[1][i] * t + s->accel[1][i] * t2;
+		p->origin[2] = s->org[2][i] + s->vel[2][i] * t + s->accel[2][i] * t2;
+		p->color[0] = s->color[0][i];
+		p->color[1] = s->color[1][i];
+		p->color[2] = s->color[2][i];
+		p->size[0] = s->size[0][i];
+		p->size[1] = s->size[1][i];
+		p->alpha = alpha;
 	}
-	memset(part, 0, sizeof(cparticle_t));
-	part->inuse = false;
-	cg_numparticles--;
+	return numout;
+}
+
+#ifdef CG_SIMD_X86
+CG_TARGET("sse2") static int CG_SimulateParticles_SSE2(int first, int last, int now, particle_t *out, int maxout, int *dead, int *numdead)
+{
+	particlestore_t	*s = &cg_parts;
+	particle_t		*p;
+	__m128			t, t2, alpha;
+	__m128			scale = _mm_set1_ps(0.001f), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	__m128i			vnow = _mm_set1_epi32(now);
+	float			org[3][4], a[4];
+	int				i, j, k, deadmask, numout = 0;
+
+	for (i = first; i + 4 <= last; i += 4)
+	{
+		t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(vnow, _mm_loadu_si128((const __m128i*)&s->time[i]))), scale);
+		alpha = _mm_add_ps(_mm_loadu_ps(&s->alpha[i]), _mm_mul_ps(t, _mm_loadu_ps(&s->alphavel[i])));
+		deadmask = _mm_movemask_ps(_mm_cmple_ps(alpha, zero));
+
+		if (deadmask != 15 && numout < maxout)
+		{
+			t2 = _mm_mul_ps(t, t);
+			for (j = 0; j < 3; j++)
+			{
+				_mm_storeu_ps(org[j], _mm_add_ps(_mm_add_ps(_mm_loadu_ps(&s->org[j][i]),
+					_mm_mul_ps(_mm_loadu_ps(&s->vel[j][i]), t)), _mm_mul_ps(_mm_loadu_ps(&s->accel[j][i]), t2)));
+			}
+			_mm_storeu_ps(a, _mm_min_ps(alpha, one));
+		}
+
+		for (k = 0; k < 4; k++)
+		{
+			if (deadmask & (1 << k))
+			{
+				dead[(*numdead)++] = i + k;
+				continue;
+			}
+
+			if (numout == maxout)
+				continue;
+
+			p = &out[numout++];
+			p->origin[0] = org[0][k];
+			p->origin[1] = org[1][k];
+			p->origin[2] = org[2][k];
+			p->color[0] = s->color[0][i + k];
+			p->color[1] = s->color[1][i + k];
+			p->color[2] = s->color[2][i + k];
+			p->size[0] = s->size[0][i + k];
+			p->size[1] = s->size[1][i + k];
+			p->alpha = a[k];
+		}
+	}
+
+	return numout + CG_SimulateParticles_C(i, last, now, out + numout, maxout - numout, dead, numdead);
 }
+#endif /*CG_SIMD_X86*/
+
+// ordered from slowest to fastest, scalar must stay first
+static const particlekernels_t particleKernels[] =
+{
+	{ "scalar", 0, CG_SimulateParticles_C },
+#ifdef CG_SIMD_X86
+	{ "sse2", CPU_SSE2, CG_SimulateParticles_SSE2 },
+#endif
+};
+#define NUM_PARTICLE_KERNELS (int)(sizeof(particleKernels) / sizeof(particleKernels[0]))
+
+static const particlekernels_t *partkernel = &particleKernels[0];
 
 /*
 ===================
-CG_AllocParticle
+CG_SelectParticleKernel
+
+cl_particlesimd 0 forces the scalar kernel, 1 picks the fastest one this CPU supports
 ===================
 */
-cparticle_t* CG_AllocParticle()
+static void CG_SelectParticleKernel(void)
 {
-	cparticle_t* part = NULL;
+	int		i, cpu;
 
-	for (int i = 0; i < MAX_PARTICLES; i++)
+	cl_particlesimd->modified = false;
+
+	cpu = COM_CPUFeatures();
+	partkernel = &particleKernels[0];
+	if (cl_particlesimd->value)
 	{
-		if (!cg_particles[i].inuse)
+		for (i = NUM_PARTICLE_KERNELS - 1; i > 0; i--)
 		{
-			part = &cg_particles[i];
+			if ((cpu & particleKernels[i].cpuflags) == particleKernels[i].cpuflags)
+			{
+				partkernel = &particleKernels[i];
+				break;
+			}
 		}
 	}
 
-	if(part != NULL)
-		cg_numparticles ++;
-
-
-	part->inuse = true;
-
-//	printf("cg_numparticles=%i\n", cg_numparticles);
-
-	return part;
+	Com_DPrintf(DP_FX, "particle kernel: %s\n", partkernel->name);
 }
 
 
 /*
-===============
-CG_ClearParticles
+==================
+CG_FreeParticle
 
-Clear all particles
-===============
+Moves the last live particle into the freed slot
+==================
 */
-void CG_ClearParticles()
+static void CG_FreeParticle(int index)
 {
-	memset(cg_particles, 0, sizeof(cg_particles));
-	cg_numparticles = 0;
+	particlestore_t	*s = &cg_parts;
+	int				j, last;
 
-//	for (int i = 0; i < MAX_PARTICLES - 1; i++)
-//	{
-//		cg_particles[i].next = &cg_particles[i + 1];
-//	}
+	last = --s->count;
+	if (index == last)
+		return;
+
+	s->time[index] = s->time[last];
+	for (j = 0; j < 3; j++)
+	{
+		s->org[j][index] = s->org[j][last];
+		s->vel[j][index] = s->vel[j][last];
+		s->accel[j][index] = s->accel[j][last];
+		s->color[j][index] = s->color[j][last];
+	}
+	s->size[0][index] = s->size[0][last];
+	s->size[1][index] = s->size[1][last];
+	s->alpha[index] = s->alpha[last];
+	s->alphavel[index] = s->alphavel[last];
 }
 
 /*
 ===============
-CG_SimulateAndAddParticles
+CG_SpawnParticles
 
-Simulate and add to scene all active particles
+Moves particles made by effects since the last simulation into the store,
+instant particles are only ever drawn once so they go straight to the view
 ===============
 */
-void CG_SimulateAndAddParticles()
+static void CG_SpawnParticles()
 {
+	particlestore_t	*s = &cg_parts;
 	cparticle_t		*p;
-	float			alpha;
-	float			time, time2;
 	vec3_t			org;
-	vec3_t			color;
-
-
-	time = 0.000001;
+	float			t;
+	int				i, j, n;
 
-	int i;
-	for (i = 0; i < MAX_PARTICLES; i++)
+	for (i = 0, p = cg_spawnparts; i < cg_numspawnparts; i++, p++)
 	{
-		p = &cg_particles[i];
-		if (!p->inuse)
-			continue;
-
 		// PMM - added INSTANT_PARTICLE handling for heat beam
-		if (p->alphavel != INSTANT_PARTICLE)
+		if (p->alphavel == INSTANT_PARTICLE)
 		{
-			time = (cl.time - p->time) * 0.001;
-			alpha = p->alpha + time * p->alphavel;
-			if (alpha <= 0)
-			{	
-				// faded out
-				CG_FreeParticle(p);
-				continue;
-			}
+			t = (float)(cl.time - p->time) * 0.001f;
+			for (j = 0; j < 3; j++)
+				org[j] = p->org[j] + p->vel[j] * t + p->accel[j] * t * t;
+			V_AddParticle(org, p->color, p->alpha > 1.0f ? 1.0f : p->alpha, p->size);
+			continue;
 		}
-		else
+
+		n = s->count++;
+		s->time[n] = p->time;
+		for (j = 0; j < 3; j++)
 		{
-			alpha = p->alpha;
+			s->org[j][n] = p->org[j];
+			s->vel[j][n] = p->vel[j];
+			s->accel[j][n] = p->accel[j];
+			s->color[j][n] = p->color[j];
 		}
+		s->size[0][n] = p->size[0];
+		s->size[1][n] = p->size[1];
+		s->alpha[n] = p->alpha;
+		s->alphavel[n] = p->alphavel;
+	}
+	cg_numspawnparts = 0;
+}
+
+
+/*
+===============
+CG_ClearParticles
+
+Clear all particles
+===============
+*/
+void CG_ClearParticles()
+{
+	cg_parts.count = 0;
+	cg_numspawnparts = 0;
+}
 
+/*
+===============
+CG_SimulateAndAddParticles
 
-		if (alpha > 1.0)
-			alpha = 1;
+Simulate and add to scene all active particles
+===============
+*/
+void CG_SimulateAndAddParticles()
+{
+	particle_t	*out;
+	int			maxout, numout, numdead;
 
-		VectorCopy(p->color, color);
+	if (cl_particlesimd->modified)
+		CG_SelectParticleKernel();
 
-		time2 = time * time;
+	CG_SpawnParticles();
 
-		org[0] = p->org[0] + p->vel[0] * time + p->accel[0] * time2;
-		org[1] = p->org[1] + p->vel[1] * time + p->accel[1] * time2;
-		org[2] = p->org[2] + p->vel[2] * time + p->accel[2] * time2;
+	out = V_ParticleStream(&maxout);
 
-		V_AddParticle(org, color, alpha, p->size);
-		// PMM
-		if (p->alphavel == INSTANT_PARTICLE)
-		{
-			p->alphavel = 0.0;
-			p->alpha = 0.0;
-		}
-	}
+	numdead = 0;
+	numout = partkernel->simulate(0, cg_parts.count, cl.time, out, maxout, cg_deadparts, &numdead);
+	V_CommitParticleStream(numout);
 
-//	active_particles = active;
+	// free from the end so the particle moved into a dead slot is always alive
+	while (numdead > 0)
+		CG_FreeParticle(cg_deadparts[--numdead]);
 }
 
 /*
@@ -162,7 +346,15 @@ Grabs particle from pool, returns NULL if all particles are in use
 */
 cparticle_t* CG_ParticleFromPool()
 {
-	return CG_AllocParticle();
+	cparticle_t* part;
+
+	if (!CG_AreThereFreeParticles())
+		return NULL;
+
+	part = &cg_spawnparts[cg_numspawnparts++];
+	memset(part, 0, sizeof(cparticle_t));
+	part->inuse = true;
+	return part;
 }
 
 /*
@@ -174,7 +366,102 @@ Returns true if there are any free particles left
 */
 qboolean CG_AreThereFreeParticles()
 {
-	return true;
+	return (cg_numspawnparts < MAX_PARTICLE_SPAWNS && cg_parts.count + cg_numspawnparts < MAX_PARTICLES);
+}
+
+/*
+===============
+CG_ParticleBench_f
+
+Runs the simulation step on a synthetic particle set without drawing,
+times every kernel this CPU supports and checks them against the scalar one.
+Clears all live particles.
+===============
+*/
+static void CG_ParticleBench_f(void)
+{
+	particlestore_t	*s = &cg_parts;
+	particle_t		*out, *ref;
+	long long		start, usec;
+	float			err, maxerr;
+	int				i, j, k, count, frames, numout, numref, numdead, cpu;
+
+	count = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : MAX_PARTICLES;
+	frames = Cmd_Argc() > 2 ? atoi(Cmd_Argv(2)) : 100;
+	if (count < 1 || count > MAX_PARTICLES)
+		count = MAX_PARTICLES;
+	if (frames < 1)
+		frames = 1;
+
+	CG_ClearParticles();
+	for (i = 0; i < count; i++)
+	{
+		s->time[i] = 0;
+		for (j = 0; j < 3; j++)
+		{
+			s->org[j][i] = crand() * 1024;
+			s->vel[j][i] = crand() * 20;
+			s->accel[j][i] = j == 2 ? -PARTICLE_GRAVITY : 0;
+			s->color[j][i] = frand();
+		}
+		s->size[0][i] = s->size[1][i] = 3;
+		s->alpha[i] = 1.0f;
+		s->alphavel[i] = (i & 7) ? -0.001f : -1000.0f; // every 8th particle is dead after the first frame
+	}
+	s->count = count;
+
+	out = Z_Malloc(sizeof(particle_t) * count);
+	ref = Z_Malloc(sizeof(particle_t) * count);
+
+	numdead = 0;
+	numref = CG_SimulateParticles_C(0, count, frames * 16, ref, count, cg_deadparts, &numdead);
+
+	cpu = COM_CPUFeatures();
+	Com_Printf("%i particles, %i frames\n", count, frames);
+	for (k = 0; k < NUM_PARTICLE_KERNELS; k++)
+	{
+		if ((cpu & particleKernels[k].cpuflags) != particleKernels[k].cpuflags)
+			continue;
+
+		start = Sys_Microseconds();
+		for (i = 1; i <= frames; i++)
+		{
+			numdead = 0;
+			numout = particleKernels[k].simulate(0, count, i * 16, out, count, cg_deadparts, &numdead);
+		}
+		usec = Sys_Microseconds() - start;
+
+		maxerr = 0;
+		for (i = 0; i < numout && numout == numref; i++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				err = fabs(out[i].origin[j] - ref[i].origin[j]);
+				if (err > maxerr)
+					maxerr = err;
+			}
+		}
+
+		Com_Printf("%-8s %8.3f ms/frame %8.1f Mparticles/s  %s\n", particleKernels[k].name, usec / 1000.0 / frames,
+			usec ? (double)count * frames / usec : 0.0, numout != numref ? "COUNT MISMATCH" : (maxerr > 0 ? va("max error %g", maxerr) : "exact"));
+	}
+
+	Z_Free(out);
+	Z_Free(ref);
+	CG_ClearParticles();
+}
+
+/*
+===============
+CG_InitParticles
+===============
+*/
+void CG_InitParticles()
+{
+	cl_particlesimd = Cvar_Get("cl_particlesimd", "1", CVAR_ARCHIVE, "Use SIMD particle simulation when the CPU supports it.");
+	CG_SelectParticleKernel();
+
+	Cmd_AddCommand("cg_particlebench", CG_ParticleBench_f);
 }
 
 /*
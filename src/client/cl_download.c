@@ -315,6 +315,26 @@ void CL_Precache_f(void)
 
 //=============================================================================
 
+/*
+===============
+CL_RequestDownload
+
+Asks the server for cls.downloadname, starting at offset
+===============
+*/
+static void CL_RequestDownload(int offset)
+{
+	char* cmd = cl_download_windowed->value ? "wdownload" : "download";
+
+	cls.downloadwindowed = false;
+
+	MSG_WriteByte(&cls.netchan.message, clc_stringcmd);
+	if (offset > 0)
+		MSG_WriteString(&cls.netchan.message, va("%s %s %i", cmd, cls.downloadname, offset));
+	else
+		MSG_WriteString(&cls.netchan.message, va("%s %s", cmd, cls.downloadname));
+}
+
 void CL_DownloadFileName(char* dest, int destlen, char* fn)
 {
 // braxi -- removed player skins
@@ -324,6 +344,49 @@ void CL_DownloadFileName(char* dest, int destlen, char* fn)
 		Com_sprintf(dest, destlen, "%s/%s", FS_Gamedir(), fn);
 }
 
+/*
+===============
+CL_RefuseDownload
+
+Returns true for names a server must never make us write. Trailing dots and
+spaces are dropped before looking at the extension, Windows ignores them
+when opening the file
+===============
+*/
+static qboolean CL_RefuseDownload(char* filename)
+{
+	char	name[MAX_OSPATH];
+	char	*ext;
+	int		len;
+
+	if (strstr(filename, ".."))
+	{
+		Com_Printf("Refusing to download a path with ..\n");
+		return true;
+	}
+
+	if (strchr(filename, ':'))
+	{
+		Com_Printf("Refusing to download %s\n", filename);
+		return true;
+	}
+
+	Com_sprintf(name, sizeof(name), "%s", filename);
+	len = (int)strlen(name);
+	while (len > 0 && (name[len - 1] == '.' || name[len - 1] == ' '))
+		name[--len] = 0;
+
+	// progs modules are native code (see scr_aot.c), never take them from a server
+	ext = strrchr(name, '.');
+	if (ext && (!Q_stricmp(ext, ".dll") || !Q_stricmp(ext, ".so")))
+	{
+		Com_Printf("Refusing to download native code %s\n", filename);
+		return true;
+	}
+
+	return false;
+}
+
 /*
 ===============
 CL_CheckOrDownloadFile
@@ -337,11 +400,8 @@ qboolean	CL_CheckOrDownloadFile(char* filename)
 	FILE* fp;
 	char	name[MAX_OSPATH];
 
-	if (strstr(filename, ".."))
-	{
-		Com_Printf("Refusing to download a path with ..\n");
+	if (CL_RefuseDownload(filename))
 		return true;
-	}
 
 	if (FS_LoadFile(filename, NULL) != -1)
 	{	// it exists, no need to download
@@ -373,13 +433,11 @@ qboolean	CL_CheckOrDownloadFile(char* filename)
 
 		// give the server an offset to start the download
 		Com_Printf("Resuming %s\n", cls.downloadname);
-		MSG_WriteByte(&cls.netchan.message, clc_stringcmd);
-		MSG_WriteString(&cls.netchan.message, va("download %s %i", cls.downloadname, len));
+		CL_RequestDownload(len);
 	}
 	else {
 		Com_Printf("Downloading %s\n", cls.downloadname);
-		MSG_WriteByte(&cls.netchan.message, clc_stringcmd);
-		MSG_WriteString(&cls.netchan.message, va("download %s", cls.downloadname));
+		CL_RequestDownload(0);
 	}
 
 	cls.downloadnumber++;
@@ -406,11 +464,8 @@ void	CL_Download_f(void)
 
 	Com_sprintf(filename, sizeof(filename), "%s", Cmd_Argv(1));
 
-	if (strstr(filename, ".."))
-	{
-		Com_Printf("Refusing to download a path with ..\n");
+	if (CL_RefuseDownload(filename))
 		return;
-	}
 
 	if (FS_LoadFile(filename, NULL) != -1)
 	{	// it exists, no need to download
@@ -426,12 +481,234 @@ void	CL_Download_f(void)
 	COM_StripExtension(cls.downloadname, cls.downloadtempname);
 	strcat(cls.downloadtempname, ".tmp");
 
-	MSG_WriteByte(&cls.netchan.message, clc_stringcmd);
-	MSG_WriteString(&cls.netchan.message, va("download %s", cls.downloadname));
+	CL_RequestDownload(0);
 
 	cls.downloadnumber++;
 }
 
+/*
+===============
+CL_DownloadTest_f
+
+"download_test <filename> [drop percent]"
+
+Windowed download of a file the local server already has into a scratch file,
+interrupted and resumed halfway, then compared with the original
+===============
+*/
+void	CL_DownloadTest_f(void)
+{
+	char	name[MAX_OSPATH];
+
+	if (Cmd_Argc() < 2)
+	{
+		Com_Printf("Usage: download_test <filename> [drop percent]\n");
+		return;
+	}
+
+	if (cls.state != CS_ACTIVE || !Com_ServerState())
+	{
+		Com_Printf("download_test needs a local server\n");
+		return;
+	}
+
+	if (cls.download)
+	{
+		Com_Printf("A download is already in progress.\n");
+		return;
+	}
+
+	if (!cl_download_windowed->value)
+	{
+		Com_Printf("download_test needs cl_download_windowed 1\n");
+		return;
+	}
+
+	if (CL_RefuseDownload(Cmd_Argv(1)) || FS_LoadFile(Cmd_Argv(1), NULL) == -1)
+	{
+		Com_Printf("Can't test with %s\n", Cmd_Argv(1));
+		return;
+	}
+
+	Com_sprintf(cls.downloadname, sizeof(cls.downloadname), "%s", Cmd_Argv(1));
+	Com_sprintf(cls.downloadtempname, sizeof(cls.downloadtempname), "download_test.tmp");
+
+	CL_DownloadFileName(name, sizeof(name), cls.downloadtempname);
+	remove(name);
+
+	cls.downloadtest = 1;
+	cls.downloadtestdrop = Cmd_Argc() > 2 ? atoi(Cmd_Argv(2)) : 0;
+	if (cls.downloadtestdrop < 0)
+		cls.downloadtestdrop = 0;
+	if (cls.downloadtestdrop > 90)
+		cls.downloadtestdrop = 90;
+	cls.downloadteststart = Sys_Milliseconds();
+
+	Com_Printf("download_test: %s, dropping %i%% of fragments\n", cls.downloadname, cls.downloadtestdrop);
+	CL_RequestDownload(0);
+}
+
+/*
+=====================
+CL_DownloadTestResume
+
+Pretends the connection broke halfway through a download_test and
+resumes from the length of the temp file, like CL_CheckOrDownloadFile does
+=====================
+*/
+static void CL_DownloadTestResume(void)
+{
+	char	name[MAX_OSPATH];
+	int		len;
+
+	fclose(cls.download);
+
+	CL_DownloadFileName(name, sizeof(name), cls.downloadtempname);
+	cls.download = fopen(name, "r+b");
+	cls.downloadwindowed = false;
+	if (!cls.download)
+	{
+		Com_Printf("download_test: failed to reopen %s\n", cls.downloadtempname);
+		cls.downloadtest = 0;
+		return;
+	}
+
+	fseek(cls.download, 0, SEEK_END);
+	len = ftell(cls.download);
+
+	cls.downloadtest = 2;
+	Com_Printf("download_test: interrupted, resuming at %i bytes\n", len);
+	CL_RequestDownload(len);
+}
+
+/*
+=====================
+CL_FinishDownloadTest
+
+Compares the temp file with the original and checks the
+server kept to sv_download_rate, then throws the copy away
+=====================
+*/
+static void CL_FinishDownloadTest(void)
+{
+	char		name[MAX_OSPATH];
+	byte		buf[4096];
+	byte		*orig;
+	FILE		*f;
+	int			origlen, len, ofs, rate;
+	float		secs, kbps, limit;
+	qboolean	ok;
+
+	secs = (Sys_Milliseconds() - cls.downloadteststart) * 0.001f;
+	cls.downloadtest = 0;
+
+	CL_DownloadFileName(name, sizeof(name), cls.downloadtempname);
+
+	ok = false;
+	origlen = FS_LoadFile(cls.downloadname, (void **)&orig);
+	f = fopen(name, "rb");
+	if (orig && f)
+	{
+		fseek(f, 0, SEEK_END);
+		len = ftell(f);
+		fseek(f, 0, SEEK_SET);
+
+		ok = (len == origlen);
+		for (ofs = 0; ok && ofs < len; ofs += sizeof(buf))
+		{
+			int n = min(len - ofs, (int)sizeof(buf));
+			ok = ((int)fread(buf, 1, n, f) == n && !memcmp(buf, orig + ofs, n));
+		}
+	}
+	if (f)
+		fclose(f);
+	if (orig)
+		FS_FreeFile(orig);
+	remove(name);
+
+	if (!ok)
+	{
+		Com_Printf("download_test: FAILED, %s differs from the original\n", cls.downloadtempname);
+		return;
+	}
+
+	// the token bucket may burst a tenth of a second worth at the start of each request
+	rate = max((int)Cvar_VariableValue("sv_download_rate"), DOWNLOAD_FRAGMENT_SIZE);
+	limit = rate * secs + 2 * (max(rate / 10, DOWNLOAD_FRAGMENT_SIZE));
+	kbps = secs > 0.0f ? (origlen / 1024.0f / secs) : 0.0f;
+
+	Com_Printf("download_test: %s, %i bytes in %.2f seconds (%.1f KB/s, %.0f%% of sv_download_rate)\n",
+		origlen > limit ? "FAILED" : "passed", origlen, secs, kbps, kbps * 1024.0f * 100.0f / rate);
+}
+
+/*
+=====================
+CL_OpenDownloadFile
+
+Opens the temp file unless we're resuming and it's already open
+=====================
+*/
+static qboolean CL_OpenDownloadFile(void)
+{
+	char	name[MAX_OSPATH];
+
+	if (cls.download)
+		return true;
+
+	CL_DownloadFileName(name, sizeof(name), cls.downloadtempname);
+
+	FS_CreatePath(name);
+
+	cls.download = fopen(name, "wb");
+	if (!cls.download)
+	{
+		Com_Printf("Failed to open %s\n", cls.downloadtempname);
+		return false;
+	}
+	return true;
+}
+
+/*
+=====================
+CL_FinishDownload
+
+Renames the temp file to it's final name and moves on to the next file
+=====================
+*/
+static void CL_FinishDownload(void)
+{
+	char	oldn[MAX_OSPATH];
+	char	newn[MAX_OSPATH];
+	int		r;
+
+	fclose(cls.download);
+
+	cls.download = NULL;
+	cls.downloadpercent = 0;
+	cls.downloadwindowed = false;
+
+	if (cls.downloadtest)
+	{
+		CL_FinishDownloadTest();
+		return;
+	}
+
+	// rename the temp file to it's final name
+	CL_DownloadFileName(oldn, sizeof(oldn), cls.downloadtempname);
+	CL_DownloadFileName(newn, sizeof(newn), cls.downloadname);
+	if (CL_RefuseDownload(cls.downloadname))
+		remove(oldn);
+	else
+	{
+		r = rename(oldn, newn);
+		if (r)
+			Com_Printf("failed to rename.\n");
+	}
+
+	// get another file if needed
+	CL_RequestNextDownload();
+}
+
 /*
 =====================
 CL_ParseDownload
@@ -442,8 +719,6 @@ A download message has been received from the server
 void CL_ParseDownload(void)
 {
 	int		size, percent;
-	char	name[MAX_OSPATH];
-	int		r;
 
 	// read the data
 	size = MSG_ReadShort(&net_message);
@@ -462,20 +737,11 @@ void CL_ParseDownload(void)
 	}
 
 	// open the file if not opened yet
-	if (!cls.download)
+	if (!CL_OpenDownloadFile())
 	{
-		CL_DownloadFileName(name, sizeof(name), cls.downloadtempname);
-
-		FS_CreatePath(name);
-
-		cls.download = fopen(name, "wb");
-		if (!cls.download)
-		{
-			net_message.readcount += size;
-			Com_Printf("Failed to open %s\n", cls.downloadtempname);
-			CL_RequestNextDownload();
-			return;
-		}
+		net_message.readcount += size;
+		CL_RequestNextDownload();
+		return;
 	}
 
 	fwrite(net_message.data + net_message.readcount, 1, size, cls.download);
@@ -491,25 +757,179 @@ void CL_ParseDownload(void)
 	}
 	else
 	{
-		char	oldn[MAX_OSPATH];
-		char	newn[MAX_OSPATH];
-
-		//		Com_Printf ("100%%\n");
+		CL_FinishDownload();
+	}
+}
 
-		fclose(cls.download);
+/*
+=====================
+CL_ParseWindowedDownload
 
-		// rename the temp file to it's final name
-		CL_DownloadFileName(oldn, sizeof(oldn), cls.downloadtempname);
-		CL_DownloadFileName(newn, sizeof(newn), cls.downloadname);
-		r = rename(oldn, newn);
-		if (r)
-			Com_Printf("failed to rename.\n");
+The server accepted a "wdownload", fragments will follow out-of-band
+=====================
+*/
+void CL_ParseWindowedDownload(void)
+{
+	int		id, size, offset;
 
-		cls.download = NULL;
-		cls.downloadpercent = 0;
+	id = MSG_ReadLong(&net_message);
+	size = MSG_ReadLong(&net_message);
+	offset = MSG_ReadLong(&net_message);
 
-		// get another file if needed
+	if (size == -1)
+	{
+		Com_Printf("Server does not have this file.\n");
+		if (cls.download)
+		{
+			fclose(cls.download);
+			cls.download = NULL;
+		}
+		cls.downloadtest = 0;
+		CL_RequestNextDownload();
+		return;
+	}
 
+	if (!CL_OpenDownloadFile())
+	{
 		CL_RequestNextDownload();
+		return;
 	}
-}
\ No newline at end of file
+
+	cls.downloadwindowed = true;
+	cls.downloadid = id;
+	cls.downloadsize = size;
+	cls.downloadoffset = offset;
+	cls.downloadnumfrags = (size - offset + DOWNLOAD_FRAGMENT_SIZE - 1) / DOWNLOAD_FRAGMENT_SIZE;
+	cls.downloadbase = 0;
+	cls.downloadmask = 0;
+	cls.downloadackbase = -1; // first ack goes out right away
+	cls.downloadackmask = 0;
+	cls.downloadacktime = cls.realtime;
+	cls.downloadpercent = size ? (offset * 100 / size) : 0;
+
+	if (!cls.downloadnumfrags)
+		CL_FinishDownload(); // nothing left to resume
+}
+
+/*
+=====================
+CL_ParseDownloadFragment
+
+A "dlfrag" out-of-band packet, fragments can arrive in any order or more than once.
+Fragments ahead of downloadbase are held back and only contiguous data is written,
+so the temp file never has holes and resuming from its length is safe
+=====================
+*/
+static byte	download_frags[MAX_DOWNLOAD_WINDOW][DOWNLOAD_FRAGMENT_SIZE];
+static int	download_fragsize[MAX_DOWNLOAD_WINDOW];
+
+void CL_ParseDownloadFragment(void)
+{
+	int		id, frag, size, bit, slot;
+	byte	*data;
+
+	id = MSG_ReadLong(&net_message);
+	frag = MSG_ReadLong(&net_message);
+	size = MSG_ReadShort(&net_message);
+
+	if (!cls.download || !cls.downloadwindowed || id != cls.downloadid)
+		return; // stale
+
+	if (size <= 0 || size > DOWNLOAD_FRAGMENT_SIZE || net_message.readcount + size > net_message.cursize)
+		return;
+
+	if (frag < cls.downloadbase || frag >= cls.downloadnumfrags)
+		return; // already have it
+
+	bit = frag - cls.downloadbase;
+	if (bit >= MAX_DOWNLOAD_WINDOW || (cls.downloadmask & (1u << bit)))
+		return;
+
+	if (cls.downloadtest && (rand() % 100) < cls.downloadtestdrop)
+		return; // download_test pretends it was lost
+
+	data = net_message.data + net_message.readcount;
+	net_message.readcount += size;
+
+	cls.downloadmask |= (1u << bit);
+	if (bit)
+	{
+		// hold it until everything before it is here
+		slot = frag % MAX_DOWNLOAD_WINDOW;
+		memcpy(download_frags[slot], data, size);
+		download_fragsize[slot] = size;
+		return;
+	}
+
+	fseek(cls.download, cls.downloadoffset + frag * DOWNLOAD_FRAGMENT_SIZE, SEEK_SET);
+	fwrite(data, 1, size, cls.download);
+
+	while (cls.downloadmask & 1)
+	{
+		cls.downloadmask >>= 1;
+		cls.downloadbase++;
+
+		if (cls.downloadmask & 1)
+		{
+			slot = cls.downloadbase % MAX_DOWNLOAD_WINDOW;
+			fwrite(download_frags[slot], 1, download_fragsize[slot], cls.download);
+		}
+	}
+
+	if (cls.downloadsize)
+		cls.downloadpercent = (cls.downloadoffset + cls.downloadbase * DOWNLOAD_FRAGMENT_SIZE) * 100.0f / cls.downloadsize;
+
+	if (cls.downloadbase < cls.downloadnumfrags)
+	{
+		if (cls.downloadtest == 1 && cls.downloadbase * 2 >= cls.downloadnumfrags)
+			CL_DownloadTestResume();
+		return;
+	}
+
+	// send the final ack reliably so the server can let go of the file
+	CL_WriteDownloadAck(&cls.netchan.message);
+	CL_FinishDownload();
+}
+
+/*
+=====================
+CL_DownloadAckDue
+
+Acknowledgements go out as soon as a fragment arrived, otherwise
+they're only repeated every DOWNLOAD_ACK_MSEC in case one was lost
+=====================
+*/
+#define DOWNLOAD_ACK_MSEC	100
+
+qboolean CL_DownloadAckDue(void)
+{
+	if (!cls.download || !cls.downloadwindowed)
+		return false;
+
+	if (cls.downloadbase != cls.downloadackbase || cls.downloadmask != cls.downloadackmask)
+		return true;
+
+	return cls.realtime - cls.downloadacktime >= DOWNLOAD_ACK_MSEC;
+}
+
+/*
+=====================
+CL_WriteDownloadAck
+
+Tells the server which fragments of a windowed download have arrived
+=====================
+*/
+void CL_WriteDownloadAck(sizebuf_t* buf)
+{
+	if (!cls.download || !cls.downloadwindowed)
+		return;
+
+	MSG_WriteByte(buf, clc_download_ack);
+	MSG_WriteLong(buf, cls.downloadid);
+	MSG_WriteLong(buf, cls.downloadbase);
+	MSG_WriteLong(buf, cls.downloadmask >> 1); // bit 0 is always downloadbase which we don't have
+
+	cls.downloadackbase = cls.downloadbase;
+	cls.downloadackmask = cls.downloadmask;
+	cls.downloadacktime = cls.realtime;
+}
@@ -11,6 +11,7 @@ See the attached GNU General Public License v2 for more details.
 // cl_ents.c -- entity management
 
 #include "client.h"
+#include "fx/effects.h"
 
 void CG_AddViewMuzzleFlash(rentity_t* refent, player_state_t* ps);
 void CG_AddViewFlashLight(rentity_t* refent, player_state_t* ps);
@@ -200,6 +201,7 @@ static inline void CL_EntityAddAttachedModels(clentity_t* clent, entity_state_t*
 		//memset(&attachEnt, 0, sizeof(attachEnt));
 		attachEnt = *refent; // copy all of it
 		attachEnt.frame = attachEnt.oldframe = 0;
+		attachEnt.entnum = 0; // parent owns the light cache slot
 		r = *refent;
 
 		AxisClear(attachEnt.axis);
@@ -284,6 +286,7 @@ void CL_AddPacketEntities(frame_t* frame)
 		renderfx = state->renderFlags;
 
 		rent.backlerp = (1.0 - cl.lerpfrac);
+		rent.entnum = state->number;
 		rent.inheritLight = -1;
 		rent.hiddenPartsBits = state->hidePartBits;
 
@@ -613,6 +616,7 @@ void CL_AddEntities()
 
 	CL_AddPacketEntities (&cl.frame);
 	CG_AddEntities();
+	CL_AddEffectsToScene();
 }
 
 /*
@@ -482,6 +482,15 @@ void CL_SendCmd (void)
 
 	if (cls.state == CS_CONNECTED)
 	{
+		// acknowledge windowed download fragments as they arrive
+		if (CL_DownloadAckDue())
+		{
+			SZ_Init (&buf, data, sizeof(data));
+			CL_WriteDownloadAck (&buf);
+			Netchan_Transmit (&cls.netchan, buf.cursize, buf.data);
+			return;
+		}
+
 		if (cls.netchan.message.cursize	|| curtime - cls.netchan.last_sent > 1000)
 			Netchan_Transmit (&cls.netchan, 0, buf.data);	
 		return;
@@ -539,6 +548,10 @@ void CL_SendCmd (void)
 		buf.data + checksumIndex + 1, buf.cursize - checksumIndex - 1,
 		cls.netchan.outgoing_sequence);
 
+	// not covered by the checksum
+	if (CL_DownloadAckDue())
+		CL_WriteDownloadAck (&buf);
+
 	//
 	// deliver the message
 	//
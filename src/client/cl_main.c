@@ -34,6 +34,8 @@ cvar_t	*cl_shownet;
 cvar_t	*cl_showmiss;
 cvar_t	*cl_showclamp;
 
+cvar_t	*cl_download_windowed;
+
 cvar_t	*cl_paused;
 cvar_t	*cl_timedemo;
 
@@ -601,6 +603,7 @@ void CL_Disconnect (void)
 		fclose(cls.download);
 		cls.download = NULL;
 	}
+	cls.downloadtest = 0;
 
 	cls.state = CS_DISCONNECTED;
 }
@@ -909,6 +912,14 @@ void CL_ConnectionlessPacket (void)
 		return;
 	}
 
+	// windowed download fragment from the server we are connected to
+	if (!strcmp(c, "dlfrag"))
+	{
+		if (cls.state >= CS_CONNECTED && NET_CompareAdr(net_from, cls.netchan.remote_address))
+			CL_ParseDownloadFragment ();
+		return;
+	}
+
 	// echo request from server
 	if (!strcmp(c, "echo"))
 	{
@@ -1111,6 +1122,7 @@ void CL_InitLocal (void)
 	cl_showmiss = Cvar_Get ("cl_showmiss", "0", 0, NULL);
 	cl_showclamp = Cvar_Get ("cl_showclamp", "0", 0, NULL);
 	cl_timeout = Cvar_Get ("cl_timeout", "120", 0, NULL);
+	cl_download_windowed = Cvar_Get ("cl_download_windowed", "1", CVAR_ARCHIVE, "Download files in out-of-band fragments instead of 1KB reliable chunks.");
 	cl_paused = Cvar_Get ("paused", "0", 0, NULL);
 	cl_timedemo = Cvar_Get ("timedemo", "0", CVAR_CHEAT, NULL);
 
@@ -1162,6 +1174,7 @@ void CL_InitLocal (void)
 	Cmd_AddCommand("changing", CL_Changing_f);
 	Cmd_AddCommand("precache", CL_Precache_f);
 	Cmd_AddCommand("download", CL_Download_f);
+	Cmd_AddCommand("download_test", CL_DownloadTest_f);
 
 
 	Cmd_AddCommand("test", CL_Test_f);
@@ -1459,6 +1472,7 @@ void CL_Init (void)
 	S_Init ();	// sound must be initialized after window is created
 
 	V_Init ();
+	CG_InitParticles ();
 	
 	net_message.data = net_message_buffer;
 	net_message.maxsize = sizeof(net_message_buffer);
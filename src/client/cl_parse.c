@@ -47,7 +47,9 @@ char *svc_strings[256] =
 
 	"svc_packet_entities",
 	"svc_delta_packet_entities",
-	"svc_frame"
+	"svc_frame",
+
+	"svc_download_windowed"
 };
 
 extern void CL_ParseDownload(void);
@@ -451,6 +453,10 @@ void CL_ParseServerMessage (void)
 		case SVC_DOWNLOAD:
 			CL_ParseDownload();
 			break;
+
+		case SVC_DOWNLOAD_WINDOWED:
+			CL_ParseWindowedDownload();
+			break;
 \
 		case SVC_PLAYFX:
 			CL_ParsePlayFX();
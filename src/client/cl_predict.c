@@ -42,7 +42,7 @@ void CL_CheckPredictionError (void)
 	else
 	{
 		if (cl_showmiss->value && (delta[0] || delta[1] || delta[2]) )
-			Com_Printf ("prediction miss on serverframe %i: %i\n", cl.frame.serverframe, delta[0] + delta[1] + delta[2]);
+			Com_Printf ("prediction miss on serverframe %i: %i (%i moves predicted last frame)\n", cl.frame.serverframe, delta[0] + delta[1] + delta[2], cl.predicted_moves);
 
 		VectorCopy (cl.frame.playerstate.pmove.origin, cl.predicted_origins[frame]);
 
@@ -130,6 +130,123 @@ void CL_ClipMoveToEntities ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end,
 }
 
 
+/*
+=================
+CL_PmoveStateToCG
+
+Copy pmove state TO cgame
+=================
+*/
+static void CL_PmoveStateToCG(cl_globalvars_t* cgGlobals, pmove_state_t* s)
+{
+	int i;
+
+	cgGlobals->pm_state_pm_type = (int)s->pm_type;
+	cgGlobals->pm_state_gravity = (int)s->gravity;
+	cgGlobals->pm_state_pm_flags = (int)s->pm_flags;
+	cgGlobals->pm_state_pm_time = (int)s->pm_time;
+
+	for (i = 0; i < 3; i++)
+	{
+		cgGlobals->pm_state_origin[i] = s->origin[i];
+		cgGlobals->pm_state_velocity[i] = s->velocity[i];
+		cgGlobals->pm_state_delta_angles[i] = (float)s->delta_angles[i];
+
+		cgGlobals->pm_state_mins[i] = s->mins[i];
+		cgGlobals->pm_state_maxs[i] = s->maxs[i];
+	}
+}
+
+/*
+=================
+CL_PmoveStateFromCG
+
+Read pmove state FROM cgame
+=================
+*/
+static void CL_PmoveStateFromCG(cl_globalvars_t* cgGlobals, pmove_t* pm)
+{
+	int i;
+
+	pm->s.pm_type = cgGlobals->pm_state_pm_type;
+	pm->s.gravity = cgGlobals->pm_state_gravity;
+	pm->s.pm_flags = cgGlobals->pm_state_pm_flags;
+	pm->s.pm_time = cgGlobals->pm_state_pm_time;
+	pm->viewheight = cgGlobals->cam_viewoffset[2];
+
+	for (i = 0; i < 3; i++)
+	{
+		pm->s.origin[i] = cgGlobals->pm_state_origin[i];
+		pm->s.velocity[i] = cgGlobals->pm_state_velocity[i];
+		pm->s.delta_angles[i] = cgGlobals->pm_state_delta_angles[i];
+
+		pm->s.mins[i] = cgGlobals->pm_state_mins[i];
+		pm->s.maxs[i] = cgGlobals->pm_state_maxs[i];
+
+		pm->mins[i] = cgGlobals->pm_state_mins[i];
+		pm->maxs[i] = cgGlobals->pm_state_maxs[i];
+
+		pm->viewangles[i] = cgGlobals->cam_viewangles[i];
+	}
+}
+
+/*
+=================
+CL_PmoveStatesEqual
+
+pmove_state_t has padding so it can't be memcmp'd
+=================
+*/
+static qboolean CL_PmoveStatesEqual(pmove_state_t* a, pmove_state_t* b)
+{
+	int i;
+
+	if (a->pm_type != b->pm_type || a->pm_flags != b->pm_flags || a->pm_time != b->pm_time || a->gravity != b->gravity)
+		return false;
+
+	for (i = 0; i < 3; i++)
+	{
+		if (a->origin[i] != b->origin[i] || a->velocity[i] != b->velocity[i])
+			return false;
+		if (a->mins[i] != b->mins[i] || a->maxs[i] != b->maxs[i] || a->delta_angles[i] != b->delta_angles[i])
+			return false;
+	}
+	return true;
+}
+
+/*
+=================
+CL_PredictionCacheStart
+
+Returns the command sequence prediction can continue from, the commands
+after ack are only simulated again when a new server frame disagrees with
+what we predicted for ack
+=================
+*/
+static int CL_PredictionCacheStart(int ack, int current)
+{
+	int frame;
+
+	if (!cl.predicted_last || ack < cl.predicted_first || ack > cl.predicted_last || current - cl.predicted_first >= CMD_BACKUP)
+		return ack; // nothing usable
+
+	if (cl.frame.serverframe == cl.predicted_serverframe)
+		return cl.predicted_last; // no new information from server
+
+	cl.predicted_serverframe = cl.frame.serverframe;
+
+	frame = ack & (CMD_BACKUP - 1);
+	if (!CL_PmoveStatesEqual(&cl.frame.playerstate.pmove, &cl.predicted_states[frame]))
+	{
+		if (cl_showmiss->value)
+			Com_Printf("prediction replay on serverframe %i: %i moves\n", cl.frame.serverframe, current - ack - 1);
+		return ack;
+	}
+
+	cl.predicted_first = ack;
+	return cl.predicted_last;
+}
+
 /*
 =================
 CL_PredictMovement
@@ -140,7 +257,7 @@ Sets cl.predicted_origin and cl.predicted_angles
 
 void CL_PredictMovement (void)
 {
-	int			ack, current;
+	int			ack, current, start;
 	int			frame;
 	int			oldframe;
 	usercmd_t	*cmd;
@@ -151,6 +268,8 @@ void CL_PredictMovement (void)
 
 	vec3_t inmove, inangles;
 
+	cl.predicted_moves = 0;
+
 	if (cls.state != CS_ACTIVE)
 		return;
 
@@ -163,6 +282,7 @@ void CL_PredictMovement (void)
 		{
 			cl.predicted_angles[i] = cl.viewangles[i] + SHORT2ANGLE(cl.frame.playerstate.pmove.delta_angles[i]);
 		}
+		cl.predicted_last = 0;
 		return;
 	}
 
@@ -174,39 +294,57 @@ void CL_PredictMovement (void)
 	{
 		if (cl_showmiss->value)
 			Com_Printf ("exceeded CMD_BACKUP\n");
+		cl.predicted_last = 0;
 		return;	
 	}
 
+	cl_globalvars_t* cgGlobals = NULL;
+
+	if (cg.qcvm_active && cg.entities)
+		cgGlobals = cg.script_globals;	// reki -- 27-12-23 Can cg.script_globals be NULL? hopefully not. 
+										// BraXi - yup, can be when !cg.qcvm_active
 
 	//
-	// copy current state to pmove
+	// copy current state to pmove, either the server's or the last one we predicted
 	//
 	memset (&pm, 0, sizeof(pm));
-	pm.s = cl.frame.playerstate.pmove;
-
-	cl_globalvars_t* cgGlobals = NULL;
 
-	if (cg.qcvm_active && cg.entities)
+	start = cgGlobals ? CL_PredictionCacheStart(ack, current) : ack;
+	if (start == ack)
 	{
-		cgGlobals = cg.script_globals;	// reki -- 27-12-23 Can cg.script_globals be NULL? hopefully not. 
-										// BraXi - yup, can be when !cg.qcvm_active
+		pm.s = cl.frame.playerstate.pmove;
 
-		//
-		// copy pmove state TO cgame
-		//
-		cgGlobals->pm_state_pm_type = (int)pm.s.pm_type;
-		cgGlobals->pm_state_gravity = (int)pm.s.gravity;
-		cgGlobals->pm_state_pm_flags = (int)pm.s.pm_flags;
-		cgGlobals->pm_state_pm_time = (int)pm.s.pm_time;
+		cl.predicted_first = cl.predicted_last = ack;
+		cl.predicted_serverframe = cl.frame.serverframe;
 
+		frame = ack & (CMD_BACKUP - 1);
+		cl.predicted_states[frame] = pm.s;
+		if (cgGlobals)
+		{
+			cl.predicted_viewheights[frame] = cgGlobals->cam_viewoffset[2];
+			VectorCopy(cgGlobals->cam_viewangles, cl.predicted_viewangles[frame]);
+		}
+	}
+	else
+	{
+		frame = start & (CMD_BACKUP - 1);
+		pm.s = cl.predicted_states[frame];
+		pm.viewheight = cl.predicted_viewheights[frame];
+		VectorCopy(cl.predicted_viewangles[frame], pm.viewangles);
 		for (i = 0; i < 3; i++)
 		{
-			cgGlobals->pm_state_origin[i] = pm.s.origin[i];
-			cgGlobals->pm_state_velocity[i] = pm.s.velocity[i];
-			cgGlobals->pm_state_delta_angles[i] = (float)pm.s.delta_angles[i];
+			pm.mins[i] = pm.s.mins[i];
+			pm.maxs[i] = pm.s.maxs[i];
+		}
+	}
 
-			cgGlobals->pm_state_mins[i] = pm.s.mins[i];
-			cgGlobals->pm_state_maxs[i] = pm.s.maxs[i];
+	if (cgGlobals)
+	{
+		CL_PmoveStateToCG(cgGlobals, &pm.s);
+		if (start != ack)
+		{
+			cgGlobals->cam_viewoffset[2] = pm.viewheight;
+			VectorCopy(pm.viewangles, cgGlobals->cam_viewangles);
 		}
 
 		// make sure qc knows our number for trace function
@@ -215,12 +353,10 @@ void CL_PredictMovement (void)
 
 //	SCR_DebugGraph (current - ack - 1, 0);
 
-	frame = 0;
-
-	// run frames
-	while (++ack < current)
+	// run frames we haven't predicted yet
+	while (++start < current)
 	{
-		frame = ack & (CMD_BACKUP-1);
+		frame = start & (CMD_BACKUP-1);
 		cmd = &cl.cmds[frame];
 
 		inmove[0] = (float)cmd->forwardmove;
@@ -229,7 +365,7 @@ void CL_PredictMovement (void)
 		for (i = 0; i < 3; i++)
 			inangles[i] = (float)cmd->angles[i];
 
-		if(cg.qcvm_active && cg.entities && cgGlobals != NULL)
+		if(cgGlobals != NULL)
 		{
 			//
 			// call cgame's pmove
@@ -241,35 +377,24 @@ void CL_PredictMovement (void)
 			Scr_AddFloat(3, (float)cmd->msec);
 			Scr_Execute(VM_CLGAME, cg.script_globals->CG_PlayerMove, __FUNCTION__);
 
-			//
-			// read pmove state FROM cgame
-			//
-			pm.s.pm_type = cgGlobals->pm_state_pm_type;
-			pm.s.gravity = cgGlobals->pm_state_gravity;
-			pm.s.pm_flags = cgGlobals->pm_state_pm_flags;
-			pm.s.pm_time = cgGlobals->pm_state_pm_time;
-			pm.viewheight = cg.script_globals->cam_viewoffset[2];
-
-			for (i = 0; i < 3; i++)
-			{
-				pm.s.origin[i] = cgGlobals->pm_state_origin[i];
-				pm.s.velocity[i] = cgGlobals->pm_state_velocity[i];
-				pm.s.delta_angles[i] = cgGlobals->pm_state_delta_angles[i];
-
-				pm.s.mins[i] = cgGlobals->pm_state_mins[i];
-				pm.s.maxs[i] = cgGlobals->pm_state_maxs[i];
-
-				pm.mins[i] = cgGlobals->pm_state_mins[i];
-				pm.maxs[i] = cgGlobals->pm_state_maxs[i];
-
-				pm.viewangles[i] = cg.script_globals->cam_viewangles[i];
-			}
+			CL_PmoveStateFromCG(cgGlobals, &pm);
+			cl.predicted_moves++;
 		}
+
 		// save for debug checking
 		VectorCopy (pm.s.origin, cl.predicted_origins[frame]);
+
+		// and for the next frames
+		cl.predicted_states[frame] = pm.s;
+		cl.predicted_viewheights[frame] = pm.viewheight;
+		VectorCopy(pm.viewangles, cl.predicted_viewangles[frame]);
+		cl.predicted_last = start;
 	}
 
-	oldframe = (ack-2) & (CMD_BACKUP-1);
+	if (cl_showmiss->value > 1 && cl.predicted_moves)
+		Com_Printf("predicted %i moves, %i cached\n", cl.predicted_moves, current - ack - 1 - cl.predicted_moves);
+
+	oldframe = (start-2) & (CMD_BACKUP-1);
 	oldz = cl.predicted_origins[oldframe][2];
 	step = pm.s.origin[2] - oldz;
 	if (step > 63 && step < 160 && (pm.s.pm_flags & PMF_ON_GROUND) )
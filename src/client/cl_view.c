@@ -113,6 +113,32 @@ void V_AddParticle (vec3_t org, vec3_t color, float alpha, vec2_t size)
 	p->alpha = alpha;
 }
 
+/*
+=====================
+V_ParticleStream
+
+Returns where the next particles go and how many still fit, for callers that
+write particles in bulk. Follow with V_CommitParticleStream.
+=====================
+*/
+particle_t *V_ParticleStream (int *space)
+{
+	*space = MAX_PARTICLES - r_numparticles;
+	return &r_particles[r_numparticles];
+}
+
+/*
+=====================
+V_CommitParticleStream
+=====================
+*/
+void V_CommitParticleStream (int count)
+{
+	if (count > MAX_PARTICLES - r_numparticles)
+		Com_Error (ERR_DROP, "V_CommitParticleStream: %i particles overflow", count);
+	r_numparticles += count;
+}
+
 /*
 =====================
 V_AddPointLight
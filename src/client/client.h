@@ -112,6 +112,16 @@ typedef struct
 	vec3_t		predicted_angles;
 	vec3_t		prediction_error;
 
+	// results of CG_PlayerMove for each command so they're only simulated once,
+	// replayed from the server's state when it disagrees with predicted_states[ack]
+	pmove_state_t	predicted_states[CMD_BACKUP];
+	float		predicted_viewheights[CMD_BACKUP];
+	vec3_t		predicted_viewangles[CMD_BACKUP];
+	int			predicted_first;	// command sequence the cache was replayed from
+	int			predicted_last;		// last command sequence in the cache, 0 when empty
+	int			predicted_serverframe;	// cl.frame.serverframe the cache was checked against
+	int			predicted_moves;	// commands simulated this frame
+
 	frame_t		frame;				// received from server
 	int			surpressCount;		// number of messages rate supressed
 	frame_t		frames[UPDATE_BACKUP];
@@ -239,6 +249,21 @@ typedef struct
 //	dltype_t	downloadtype;		// braxi -- unused but I may find it useful later
 	int			downloadpercent;
 
+	// windowed download, fragments arrive out-of-band in any order
+	qboolean	downloadwindowed;
+	int			downloadid;			// from SVC_DOWNLOAD_WINDOWED, fragments with other ids are stale
+	int			downloadsize;
+	int			downloadoffset;		// resumed from this many bytes
+	int			downloadnumfrags;
+	int			downloadbase;		// first fragment still missing
+	unsigned int downloadmask;		// bit N set when fragment downloadbase+N has arrived
+	int			downloadackbase;	// last acknowledgement sent, only repeated every DOWNLOAD_ACK_MSEC
+	unsigned int downloadackmask;	// unless something new arrived
+	int			downloadacktime;
+	int			downloadtest;		// download_test stage, 0 for a normal download
+	int			downloadtestdrop;	// percentage of fragments thrown away by download_test
+	int			downloadteststart;
+
 // demo recording info must be here, so it isn't cleared on level change
 	qboolean	demorecording;
 	qboolean	demowaiting;	// don't record until a non-delta message is received
@@ -275,6 +300,8 @@ extern	cvar_t	*cl_shownet;
 extern	cvar_t	*cl_showmiss;
 extern	cvar_t	*cl_showclamp;
 
+extern	cvar_t	*cl_download_windowed;
+
 extern	cvar_t	*lookspring;
 extern	cvar_t	*lookstrafe;
 extern	cvar_t	*sensitivity;
@@ -445,6 +472,11 @@ extern char *svc_strings[256];
 void CL_ParseServerMessage (void);
 void SHOWNET(char *s);
 void CL_Download_f (void);
+void CL_ParseWindowedDownload (void);
+void CL_ParseDownloadFragment (void);
+void CL_WriteDownloadAck (sizebuf_t *buf);
+qboolean CL_DownloadAckDue (void);
+void CL_DownloadTest_f (void);
 
 qboolean CL_CheatsAllowed();
 
@@ -459,6 +491,8 @@ void V_RenderView( float stereo_separation );
 void V_AddEntity (rentity_t *ent);
 void V_AddDebugPrimitive(debugprimitive_t *obj);
 void V_AddParticle (vec3_t org, vec3_t color, float alpha, vec2_t size);
+particle_t *V_ParticleStream (int *space);
+void V_CommitParticleStream (int count);
 void V_AddPointLight(vec3_t org, float intensity, float r, float g, float b);
 void V_AddSpotLight(vec3_t org, vec3_t dir, float intensity, float cutoff, float r, float g, float b);
 void V_AddLightStyle (int style, float r, float g, float b);
@@ -491,6 +525,7 @@ void CG_EntityEvent(entity_state_t *ent);
 //
 // cg_particles.c
 //
+void CG_InitParticles();
 void CG_SimulateAndAddParticles();
 
 
@@ -8,7 +8,13 @@
 //
 
 void FX_ClearParticles();
+void FX_ClearEffects();
 int CL_FindEffect(char* name);
 
 void CL_InitEffects();
-void CL_ShutdownEffects();
\ No newline at end of file
+void CL_ShutdownEffects();
+
+//
+// fx_play.c
+//
+void CL_AddEffectsToScene();
\ No newline at end of file
@@ -37,23 +37,29 @@ static parsefield_t fields_fx_particle[] =
 	{"randomdistrubution", F_VECTOR3, FOFS(fx_particle_def_t,randomDistrubution)},
 
 	{"velocity", F_VECTOR3, FOFS(fx_particle_def_t,velocity)},	// if !(flags & FXF_RANDOM_VELOCITY)
-	{"addrandomvelocity", F_FLOAT, FOFS(fx_particle_def_t,addRandomVelocity)},		// if !(flags & FXF_RANDOM_GRAVITY)
+	{"addrandomvelocity", F_VECTOR3, FOFS(fx_particle_def_t,addRandomVelocity)},		// if !(flags & FXF_RANDOM_GRAVITY)
 	
-	{"gravity", F_FLOAT, FOFS(fx_particle_def_t,gravity)},
-	{"addrandomgravity", F_FLOAT, FOFS(fx_particle_def_t,addRandomGravity)},
+	{"gravity", F_INT, FOFS(fx_particle_def_t,gravity)},
+	{"addrandomgravity", F_INT, FOFS(fx_particle_def_t,addRandomGravity)},
 
 	{"color", F_VECTOR4, FOFS(fx_particle_def_t,color)},
 	{"color2", F_VECTOR4, FOFS(fx_particle_def_t,color2)},
 
 	{"size", F_VECTOR2, FOFS(fx_particle_def_t,size)},
-	{"size2", F_VECTOR2, FOFS(fx_particle_def_t,size2)}
+	{"size2", F_VECTOR2, FOFS(fx_particle_def_t,size2)},
+	{NULL, 0, 0}
 };
 
 static parsefield_t fields_fx_dlight[] =
 {
+	{"lifetime", F_FLOAT, FOFS(fx_dlight_t,lifetime)},
+	{"delay", F_FLOAT, FOFS(fx_dlight_t,delay)},
 	{"origin", F_VECTOR3, FOFS(fx_dlight_t,origin)},
 	{"color", F_VECTOR3, FOFS(fx_dlight_t,color)},
-	{"radius", F_FLOAT, FOFS(fx_dlight_t,radius)}
+	{"radius", F_FLOAT, FOFS(fx_dlight_t,radius)},
+	{"randomradius", F_FLOAT, FOFS(fx_dlight_t,randomradius)},
+	{"endradius", F_FLOAT, FOFS(fx_dlight_t,endradius)},
+	{NULL, 0, 0}
 };
 
 
@@ -72,7 +78,7 @@ static void FX_CreatePartSegment(fxdef_t* owner)
 
 	fx_particle_def_t* part = Z_TagMalloc(sizeof(fx_particle_def_t), TAG_FX);
 
-	VectorSet(part->color, 1.0f, 1.0f, 1.0f);
+	Vector4Set(part->color, 1.0f, 1.0f, 1.0f, 1.0f);
 	part->size[0] = part->size[1] = 1.0;
 	part->size2[0] = part->size2[1] = 1.0;
 
@@ -192,7 +198,7 @@ static void FX_ParseFile(char* data, fxdef_t* def)
 FX_LoadFromFile
 ===============
 */
-qboolean FX_LoadFromFile(char* name)
+int FX_LoadFromFile(char* name)
 {
 	unsigned int	len;
 	char			* data = NULL;
@@ -200,16 +206,16 @@ qboolean FX_LoadFromFile(char* name)
 	int				fxindex;
 	fxdef_t			*fx;
 	
+	// se if its already loaded, a full list can still hand those out
+	fxindex = CL_FindEffect(name);
+	if (fxindex != -1)
+		return fxindex;
+
 	if (fxSys.numLoadedEffects >= FX_MAX_EFFECTS)
 	{
-		Com_Error(ERR_DROP, "reached limit of %i loaded effects\n");
-		return false;
-	}
-
-	// se if its already loaded
-	fxindex = CL_FindEffect(name);
-	if (fxindex == -1)
+		Com_Error(ERR_DROP, "reached limit of %i loaded effects\n", FX_MAX_EFFECTS);
 		return -1;
+	}
 
 	// load file
 	Com_sprintf(filename, sizeof(filename), "fx/%s.efx", name);
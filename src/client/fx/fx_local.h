@@ -56,9 +56,9 @@ See the attached GNU General Public License v2 for more details.
 *	[..............]
 */
 
-#define FX_MAX_PARTICLES 1024
+#define FX_MAX_PARTICLES 16384		// pool shared by all fx runners
 #define FX_MAX_EFFECTS 256			// max loaded effects at a time, cannot be blindly increased due to net protocol encoding as a byte
-#define FX_MAX_ACTIVE_EFFECTS 256	// number of fxrunners at max
+#define FX_MAX_ACTIVE_EFFECTS 1024	// number of fxrunners at max
 #define FX_MAX_SEGMENTS_PER_TYPE 8	
 
 typedef enum
@@ -141,6 +141,8 @@ typedef struct fxdef_s
 
 typedef struct fx_runner_s
 {
+	struct fx_runner_s	*prev, *next;	// in fxSys active or free list
+
 	qboolean	inuse;
 
 	int		startTime;
@@ -148,11 +150,18 @@ typedef struct fx_runner_s
 
 	vec3_t	origin;
 	vec3_t	dir;
+	vec3_t	axis[3];		// effect space, axis[2] follows dir so upright effects align to it
 
 	int		entity;			// index to cl_entities[]
 	int		tag;			// index to tag on entity's model
 
 	int		effectIndex;
+
+	unsigned int	seed;				// random stream, the same effect started at the same time and place looks the same on every client
+	int				cluster;			// for pvs culling, -1 if not in the world
+	int				spawnedSegments;	// bit per particle segment that has been emitted
+
+	struct fx_particle_s	*particles;	// allocated from fxSys.particles
 } fx_runner_t;
 
 // ================================================================ //
@@ -162,7 +171,7 @@ typedef struct fx_particle_s
 {
 	struct fx_particle_s* next;
 
-	int			effectIndex;
+	fx_particle_def_t	*def;
 
 	unsigned int	starttime;
 	unsigned int	lifetime;
@@ -170,7 +179,6 @@ typedef struct fx_particle_s
 	vec3_t		origin;
 	vec3_t		velocity;
 	float		gravity;
-	rgba_t		rgba;
 
 	struct image_s* mat;
 } fx_particle_t;
@@ -183,18 +191,25 @@ typedef struct fxsysstate_s
 
 	// active effects
 	fx_runner_t			fxRunners[FX_MAX_ACTIVE_EFFECTS];
+	fx_runner_t			*active_runners, *free_runners;
 	int					numActiveFX;
 
 	// particles managment
 	fx_particle_t		particles[FX_MAX_PARTICLES];
-	fx_particle_t		*active_particles, *free_particles;
+	fx_particle_t		*free_particles;
 	int					numParticlesInUse;
+	int					numParticlesDropped;	// pool was empty
 } fxsysstate_t;
 
 extern fxsysstate_t fxSys;
 
 int CL_FindEffect(char* name);
-qboolean FX_LoadFromFile(char* name);
+int FX_LoadFromFile(char* name);
+void FX_ClearParticles();
+void FX_ClearRunners();
+int FX_RunEffects(int time, particle_t *out, int maxout, qboolean toScene);
+void FX_StartFX(int effectIndex, vec3_t origin, vec3_t dir);
+void CL_PlayOneShotEffect(char* name, vec3_t origin, vec3_t dir);
 
 
 int FX_GetNumLoadedEffects();
@@ -13,7 +13,8 @@ See the attached GNU General Public License v2 for more details.
 
 fxsysstate_t fxSys;
 
-static cvar_t* fx_show;
+cvar_t* fx_show;
+cvar_t* fx_cullDist;
 
 
 int FX_GetNumLoadedEffects() // FIXME
@@ -62,12 +63,84 @@ static void Cmd_LoadFX_f(void)
 
 static void Cmd_PlayFX_f(void)
 {
-	char* name = Cmd_Argv(1);
-	if (Cmd_Argc() != 2)
+	vec3_t origin, dir = { 0, 0, 1 };
+
+	if (Cmd_Argc() != 5)
 	{
 		Com_Printf("playfx <filename> x y z: play effect at xyz\n");
 		return;
 	}
+
+	origin[0] = atof(Cmd_Argv(2));
+	origin[1] = atof(Cmd_Argv(3));
+	origin[2] = atof(Cmd_Argv(4));
+	CL_PlayOneShotEffect(Cmd_Argv(1), origin, dir);
+}
+
+/*
+=================
+Cmd_FXStress_f
+
+Starts count copies of an effect around the view and runs them without
+culling or drawing to measure simulation cost. Clears all playing effects.
+=================
+*/
+static void Cmd_FXStress_f(void)
+{
+	particle_t	*out;
+	vec3_t		origin, dir = { 0, 0, 1 };
+	long long	start, usec;
+	int			i, j, fxindex, count, frames, time, numout, numactive, peakparts;
+
+	if (Cmd_Argc() < 2)
+	{
+		Com_Printf("fx_stress <filename> [count] [frames] : run count effects for frames without drawing\n");
+		return;
+	}
+
+	fxindex = FX_LoadFromFile(Cmd_Argv(1));
+	if (fxindex == -1)
+	{
+		Com_Printf("effect '%s' is not loaded\n", Cmd_Argv(1));
+		return;
+	}
+
+	count = Cmd_Argc() > 2 ? atoi(Cmd_Argv(2)) : 1000;
+	frames = Cmd_Argc() > 3 ? atoi(Cmd_Argv(3)) : 100;
+	if (count < 1 || count > FX_MAX_ACTIVE_EFFECTS)
+		count = FX_MAX_ACTIVE_EFFECTS;
+	if (frames < 1)
+		frames = 1;
+
+	FX_ClearRunners();
+	for (i = 0; i < count; i++)
+	{
+		for (j = 0; j < 3; j++)
+			origin[j] = cl.refdef.view.origin[j] + crand() * 1024;
+		FX_StartFX(fxindex, origin, dir);
+	}
+	numactive = fxSys.numActiveFX;
+
+	out = Z_Malloc(sizeof(particle_t) * FX_MAX_PARTICLES);
+
+	peakparts = numout = 0;
+	fxSys.numParticlesDropped = 0;
+	start = Sys_Microseconds();
+	for (i = 0, time = cl.time; i < frames; i++, time += 16)
+	{
+		numout = FX_RunEffects(time, out, FX_MAX_PARTICLES, false);
+		if (fxSys.numParticlesInUse > peakparts)
+			peakparts = fxSys.numParticlesInUse;
+	}
+	usec = Sys_Microseconds() - start;
+
+	Z_Free(out);
+
+	Com_Printf("%i effects '%s', %i frames of 16 ms\n", numactive, fxSys.fxDefs[fxindex]->name, frames);
+	Com_Printf("%.3f ms/frame, %.3f ms/frame per 1000 effects\n", usec / 1000.0 / frames, usec / (double)frames / numactive);
+	Com_Printf("%i peak particles, %i drawn in the last frame, %i dropped (pool of %i)\n", peakparts, numout, fxSys.numParticlesDropped, FX_MAX_PARTICLES);
+
+	FX_ClearRunners();
 }
 
 /*
@@ -81,30 +154,35 @@ void FX_ClearParticles()
 
 	memset(fxSys.particles, 0, sizeof(fxSys.particles));
 	fxSys.free_particles = &fxSys.particles[0];
-	fxSys.active_particles = NULL;
 
-	for (i = 0; i < FX_MAX_PARTICLES; i++)
+	for (i = 0; i < FX_MAX_PARTICLES - 1; i++)
 	{
 		fxSys.particles[i].next = &fxSys.particles[i + 1];
 	}
 
 	fxSys.particles[FX_MAX_PARTICLES - 1].next = NULL;
+	fxSys.numParticlesInUse = 0;
 }
 
+/*
+=================
+FX_ClearEffects
 
-
+Stops all playing effects, called when changing levels
+=================
+*/
+void FX_ClearEffects()
+{
+	FX_ClearRunners();
+}
 
 
 static void FX_FreeEffects()
 {
+	FX_ClearRunners();
 	Z_FreeTags(TAG_FX);
 	memset(&fxSys.fxDefs, 0, sizeof(fxSys.fxDefs));
 	fxSys.numLoadedEffects = 0;
-
-	for (int i = 0; i < FX_MAX_ACTIVE_EFFECTS; i++)
-	{
-
-	}
 }
 
 /*
@@ -115,8 +193,7 @@ CL_InitEffects
 void CL_InitEffects()
 {
 	fx_show  = Cvar_Get("fx_show", "1", CVAR_CHEAT, NULL);
-
-	FX_ClearParticles();
+	fx_cullDist = Cvar_Get("fx_cullDist", "4096", 0, "Effects farther than this from the view are not drawn, 0 disables.");
 
 	if (fxSys.numLoadedEffects > 0)
 	{
@@ -124,6 +201,7 @@ void CL_InitEffects()
 	}
 
 	memset(&fxSys, 0, sizeof(fxSys));
+	FX_ClearRunners();
 
 	Com_Printf("... max particles  : %i\n", FX_MAX_PARTICLES);
 	Com_Printf("... max fx runners : %i\n", FX_MAX_ACTIVE_EFFECTS);
@@ -131,6 +209,7 @@ void CL_InitEffects()
 
 	Cmd_AddCommand("loadfx", Cmd_LoadFX_f);
 	Cmd_AddCommand("playfx", Cmd_PlayFX_f);
+	Cmd_AddCommand("fx_stress", Cmd_FXStress_f);
 
 	Com_Printf("Initialized FX system.\n");
 }	
@@ -147,5 +226,6 @@ void CL_ShutdownEffects()
 
 	Cmd_RemoveCommand("loadfx");
 	Cmd_RemoveCommand("playfx");
+	Cmd_RemoveCommand("fx_stress");
 
 }
@@ -11,31 +11,418 @@ See the attached GNU General Public License v2 for more details.
 #include "../client.h"
 #include "fx_local.h"
 
-static vec3_t fx_v_forward, fx_v_right, fx_v_up;
+extern cvar_t *fx_cullDist;
+extern cvar_t *fx_show;
 
-#define random()	( ( rand() & 0x7fff ) / ( (float)0x7fff ) )
-#define crandom()	( 2.0 * ( random() - 0.5 ) )
+/*
+==============================================================
 
-fx_runner_t* FX_SpawnFX()
+RANDOM STREAMS
+
+Each runner draws from its own xorshift stream seeded by the effect, start
+time and origin, so the effect doesn't depend on what else called rand()
+
+==============================================================
+*/
+
+static unsigned int FX_Rand(unsigned int *seed)
+{
+	unsigned int x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return x;
+}
+
+static float FX_Random(unsigned int *seed)	// 0 to 1
+{
+	return (FX_Rand(seed) & 0xffffff) / (float)0x1000000;
+}
+
+static float FX_CRandom(unsigned int *seed)	// -1 to 1
+{
+	return 2.0f * FX_Random(seed) - 1.0f;
+}
+
+static unsigned int FX_SeedForRunner(fx_runner_t* runner)
+{
+	unsigned int seed;
+
+	seed = (unsigned int)runner->effectIndex * 2654435761u;
+	seed ^= (unsigned int)runner->startTime * 40503u;
+	seed ^= (unsigned int)(int)runner->origin[0] * 73856093u;
+	seed ^= (unsigned int)(int)runner->origin[1] * 19349663u;
+	seed ^= (unsigned int)(int)runner->origin[2] * 83492791u;
+	return seed ? seed : 1;
+}
+
+
+/*
+==============================================================
+
+RUNNERS AND PARTICLE POOL
+
+==============================================================
+*/
+
+/*
+===============
+FX_ClearRunners
+
+Returns all runners and particles to their free lists
+===============
+*/
+void FX_ClearRunners()
 {
 	int i;
-	fx_runner_t* runner = NULL;
 
-	for (i = 0; i < FX_MAX_ACTIVE_EFFECTS; i++)
+	memset(fxSys.fxRunners, 0, sizeof(fxSys.fxRunners));
+	fxSys.active_runners = NULL;
+	fxSys.free_runners = &fxSys.fxRunners[0];
+	for (i = 0; i < FX_MAX_ACTIVE_EFFECTS - 1; i++)
+		fxSys.fxRunners[i].next = &fxSys.fxRunners[i + 1];
+	fxSys.numActiveFX = 0;
+
+	FX_ClearParticles();
+}
+
+/*
+===============
+FX_SpawnFX
+===============
+*/
+fx_runner_t* FX_SpawnFX()
+{
+	fx_runner_t* runner;
+
+	runner = fxSys.free_runners;
+	if (runner == NULL)
+		return NULL;
+	fxSys.free_runners = runner->next;
+
+	memset(runner, 0, sizeof(fx_runner_t));
+	runner->entity = -1;
+	runner->tag = -1;
+	runner->cluster = -1;
+	runner->inuse = true;
+
+	runner->next = fxSys.active_runners;
+	if (runner->next)
+		runner->next->prev = runner;
+	fxSys.active_runners = runner;
+	fxSys.numActiveFX++;
+	return runner;
+}
+
+/*
+===============
+FX_FreeRunner
+===============
+*/
+static void FX_FreeRunner(fx_runner_t* runner)
+{
+	fx_particle_t *p, *next;
+
+	for (p = runner->particles; p; p = next)
 	{
-		if (cl.time > fxSys.fxRunners[i].endTime) // can this be problematic on looping effects??
+		next = p->next;
+		p->next = fxSys.free_particles;
+		fxSys.free_particles = p;
+		fxSys.numParticlesInUse--;
+	}
+
+	if (runner->prev)
+		runner->prev->next = runner->next;
+	else
+		fxSys.active_runners = runner->next;
+	if (runner->next)
+		runner->next->prev = runner->prev;
+
+	runner->inuse = false;
+	runner->prev = NULL;
+	runner->next = fxSys.free_runners;
+	fxSys.free_runners = runner;
+	fxSys.numActiveFX--;
+}
+
+/*
+===============
+FX_SetRunnerPlacement
+
+Builds effect space from dir and finds the cluster for pvs culling
+===============
+*/
+static void FX_SetRunnerPlacement(fx_runner_t* runner, vec3_t origin, vec3_t dir)
+{
+	vec3_t ref;
+
+	VectorCopy(origin, runner->origin);
+	VectorCopy(dir, runner->dir);
+
+	VectorCopy(dir, runner->axis[2]);
+	if (VectorNormalize(runner->axis[2]) == 0.0f)
+		VectorSet(runner->axis[2], 0, 0, 1);
+
+	// dir straight up gives the identity axis
+	if (fabs(runner->axis[2][0]) < 0.9f)
+		VectorSet(ref, 1, 0, 0);
+	else
+		VectorSet(ref, 0, 1, 0);
+	CrossProduct(runner->axis[2], ref, runner->axis[1]);
+	VectorNormalize(runner->axis[1]);
+	CrossProduct(runner->axis[1], runner->axis[2], runner->axis[0]);
+
+	runner->cluster = CM_LeafCluster(CM_PointLeafnum(runner->origin));
+}
+
+/*
+===============
+FX_EmitPartSegment
+
+Spawns all particles of a segment into the runner, they share the start time
+===============
+*/
+static void FX_EmitPartSegment(fx_runner_t* runner, fx_particle_def_t* part)
+{
+	fx_particle_t	*p;
+	vec3_t			ofs, vel;
+	int				i, v, cnt;
+
+	cnt = part->count;
+	if (part->addRandomCount > 0)
+		cnt += FX_Rand(&runner->seed) % part->addRandomCount;
+
+	for (i = 0; i < cnt; i++)
+	{
+		p = fxSys.free_particles;
+		if (p == NULL)
 		{
-			memset(&fxSys.fxRunners[i], 0, sizeof(fx_runner_t));
-			runner = &fxSys.fxRunners[i];
-			runner->entity = -1;
-			runner->tag = -1;
-			runner->inuse = true;
-			break;
+			fxSys.numParticlesDropped += cnt - i;
+			return;
+		}
+		fxSys.free_particles = p->next;
+		fxSys.numParticlesInUse++;
+
+		p->next = runner->particles;
+		runner->particles = p;
+
+		p->def = part;
+		p->starttime = runner->startTime + (int)(part->delay * 1000);
+		p->lifetime = (int)(part->lifetime * 1000);
+		p->mat = NULL;
+
+		// initial position and velocity are in effect space
+		for (v = 0; v < 3; v++)
+		{
+			ofs[v] = part->origin[v];
+			if (part->randomDistrubution[v] > 0.0f)
+				ofs[v] += FX_CRandom(&runner->seed) * part->randomDistrubution[v];
+
+			vel[v] = part->velocity[v];
+			if (part->addRandomVelocity[v] != 0.0f)
+				vel[v] += FX_CRandom(&runner->seed) * part->addRandomVelocity[v];
 		}
+
+		VectorCopy(runner->origin, p->origin);
+		VectorClear(p->velocity);
+		for (v = 0; v < 3; v++)
+		{
+			VectorMA(p->origin, ofs[v], runner->axis[v], p->origin);
+			VectorMA(p->velocity, vel[v], runner->axis[v], p->velocity);
+		}
+
+		p->gravity = part->gravity;
+		if (part->addRandomGravity > 0)
+			p->gravity += FX_Random(&runner->seed) * part->addRandomGravity;
 	}
-	return runner;
 }
 
+/*
+===============
+FX_RunnerParticles
+
+Writes runner's visible particles to out, returns how many were written.
+Expired particles go back to the pool.
+===============
+*/
+static int FX_RunnerParticles(fx_runner_t* runner, int time, particle_t* out, int maxout)
+{
+	fx_particle_t		*p, **prev;
+	fx_particle_def_t	*def;
+	particle_t			*o;
+	float				t, life, frac;
+	int					age, numout = 0;
+
+	prev = &runner->particles;
+	while ((p = *prev) != NULL)
+	{
+		age = time - (int)p->starttime;
+		if (age >= (int)p->lifetime)
+		{
+			*prev = p->next;
+			p->next = fxSys.free_particles;
+			fxSys.free_particles = p;
+			fxSys.numParticlesInUse--;
+			continue;
+		}
+		prev = &p->next;
+
+		if (age < 0 || numout == maxout)
+			continue;
+
+		def = p->def;
+		t = age * 0.001f;
+		life = p->lifetime * 0.001f;
+
+		o = &out[numout++];
+		VectorMA(p->origin, t, p->velocity, o->origin);
+		o->origin[2] -= 0.5f * p->gravity * t * t;
+
+		// fade to color2 and scale to size2 over the rest of the lifetime
+		frac = 0.0f;
+		if (t > def->fadeColorAfterTime)
+			frac = (t - def->fadeColorAfterTime) / (life - def->fadeColorAfterTime);
+		o->color[0] = def->color[0] + (def->color2[0] - def->color[0]) * frac;
+		o->color[1] = def->color[1] + (def->color2[1] - def->color[1]) * frac;
+		o->color[2] = def->color[2] + (def->color2[2] - def->color[2]) * frac;
+		o->alpha = def->color[3] + (def->color2[3] - def->color[3]) * frac;
+
+		frac = 0.0f;
+		if (t > def->scaleAfterTime)
+			frac = (t - def->scaleAfterTime) / (life - def->scaleAfterTime);
+		o->size[0] = def->size[0] + (def->size2[0] - def->size[0]) * frac;
+		o->size[1] = def->size[1] + (def->size2[1] - def->size[1]) * frac;
+
+		o->material = p->mat;
+	}
+	return numout;
+}
+
+/*
+===============
+FX_AddRunnerLights
+===============
+*/
+static void FX_AddRunnerLights(fx_runner_t* runner, fxdef_t* fx, int time)
+{
+	fx_dlight_t		*dl;
+	vec3_t			org;
+	unsigned int	seed;
+	float			t, radius;
+	int				i, v;
+
+	for (i = 0; i < fx->numDLightSegments; i++)
+	{
+		dl = fx->dlight[i];
+		if (dl == NULL)
+			continue;
+
+		t = (time - runner->startTime) * 0.001f - dl->delay;
+		if (t < 0 || t > dl->lifetime)
+			continue;
+
+		// the random part must not change from frame to frame
+		seed = runner->seed + (i + 1) * 0x9e3779b9u;
+		radius = dl->radius + FX_Random(&seed) * dl->randomradius;
+		if (dl->endradius > 0 && dl->lifetime > 0)
+			radius += (dl->endradius - radius) * (t / dl->lifetime);
+
+		VectorCopy(runner->origin, org);
+		for (v = 0; v < 3; v++)
+			VectorMA(org, dl->origin[v], runner->axis[v], org);
+
+		V_AddPointLight(org, radius, dl->color[0], dl->color[1], dl->color[2]);
+	}
+}
+
+/*
+===============
+FX_RunEffects
+
+Advances all runners to time and writes their particles to out.
+When toScene is set emitters are culled by distance and pvs to the view
+and dynamic lights are added to the scene, culled runners keep playing.
+===============
+*/
+int FX_RunEffects(int time, particle_t* out, int maxout, qboolean toScene)
+{
+	fx_runner_t		*runner, *next;
+	fxdef_t			*fx;
+	clentity_t		*cent;
+	byte			*pvs = NULL;
+	vec3_t			delta;
+	float			cullDist;
+	qboolean		culled;
+	int				i, viewcluster, numout = 0;
+
+	cullDist = fx_cullDist->value;
+	if (toScene)
+	{
+		viewcluster = CM_LeafCluster(CM_PointLeafnum(cl.refdef.view.origin));
+		if (viewcluster != -1)
+			pvs = CM_ClusterPVS(viewcluster);
+	}
+
+	for (runner = fxSys.active_runners; runner; runner = next)
+	{
+		next = runner->next;
+
+		if (time > runner->endTime)
+		{
+			FX_FreeRunner(runner);
+			continue;
+		}
+
+		fx = fxSys.fxDefs[runner->effectIndex];
+
+		// follow the entity while it is in the frame
+		if (runner->entity != -1)
+		{
+			cent = &cl_entities[runner->entity];
+			if (cent->serverframe == cl.frame.serverframe && !VectorCompare(cent->current.origin, runner->origin))
+				FX_SetRunnerPlacement(runner, cent->current.origin, runner->dir);
+		}
+
+		for (i = 0; i < fx->numPartSegments; i++)
+		{
+			if (runner->spawnedSegments & (1 << i))
+				continue;
+			if (time < runner->startTime + (int)(fx->part[i]->delay * 1000))
+				continue;
+			runner->spawnedSegments |= (1 << i);
+			FX_EmitPartSegment(runner, fx->part[i]);
+		}
+
+		if (toScene)
+		{
+			culled = false;
+			if (cullDist > 0)
+			{
+				VectorSubtract(runner->origin, cl.refdef.view.origin, delta);
+				if (DotProduct(delta, delta) > cullDist * cullDist)
+					culled = true;
+			}
+			if (pvs && runner->cluster != -1 && !(pvs[runner->cluster >> 3] & (1 << (runner->cluster & 7))))
+				culled = true;
+
+			if (culled)
+			{
+				// nothing is drawn, but expired particles still go back to the pool
+				FX_RunnerParticles(runner, time, out, 0);
+				continue;
+			}
+
+			FX_AddRunnerLights(runner, fx, time);
+		}
+
+		numout += FX_RunnerParticles(runner, time, out + numout, maxout - numout);
+	}
+	return numout;
+}
+
+
 /*
 ===============
 FX_GetLength
@@ -121,71 +508,8 @@ void FX_StartFX(int effectIndex, vec3_t origin, vec3_t dir)
 	runner->startTime = cl.time;
 	runner->endTime = runner->startTime + (int)(fxlength * 1000);
 	runner->effectIndex = effectIndex;
-	VectorCopy(origin, runner->origin);
-	VectorCopy(dir, runner->dir);
-}
-
-void CL_AddEffectParticlesToScene(fx_runner_t* fxrunner)
-{
-	int r; // runner
-	int p; // particle
-	int v; // vector
-	int cnt; // total count
-	fxdef_t* fx;
-	fx_particle_def_t* part;
-
-	vec3_t start, velocity;
-	int gravity;
-
-	fx = fxSys.fxDefs[fxrunner->effectIndex];
-	part = fx->part[0];
-
-	// for each particle segment
-	for (r = 0; r < fx->numPartSegments; r++, part++)
-	{
-		cnt = part->count;
-		if (part->addRandomCount > 0)
-			cnt += (rand() % part->addRandomCount);
-
-		// for each particle in segment
-		for (p = 0; p < cnt; p++)
-		{
-			// TODO: these should be definitely shared
-			// FIXME: origin and velocity should be relative to angles
-
-			//
-			// calculate initial position
-			// 
-			for (v = 0; v < 3; v++)
-			{
-				start[v] = fxrunner->origin[v] + part->origin[v]; /* * fxrunner->dir[v];*/
-
-				if (part->randomDistrubution[v] > 0.0f)
-					start[v] += (crandom() * part->randomDistrubution[v]);
-			}
-
-			//
-			// calculate initial velocity
-			//
-			for (v = 0; v < 3; v++)
-			{
-				velocity[v] = part->velocity[v];
-				if(part->addRandomVelocity[v] != 0.0f)
-					velocity[v] += (crandom() * part->addRandomVelocity[v]);
-			}
-
-			//
-			// calculate initial gravity
-			//
-			gravity = part->gravity;
-			if (part->addRandomGravity > 0)
-				gravity += (rand() & part->addRandomGravity);
-
-			VectorMA(start, 1, fx_v_forward, start);
-			VectorMA(start, 1, fx_v_right, start);
-			VectorMA(start, 1, fx_v_up, start);
-		}
-	}
+	FX_SetRunnerPlacement(runner, origin, dir);
+	runner->seed = FX_SeedForRunner(runner);
 }
 
 /*
@@ -197,29 +521,13 @@ Add effects to scene
 */
 void CL_AddEffectsToScene()
 {
-	int i;
-	fx_runner_t	*fxrunner;
-	fxdef_t		*fx;
-//	rentity_t	rent;
+	particle_t	*out;
+	int			maxout;
 
-
-	fxrunner = &fxSys.fxRunners[0];
-	for (i = 0; i < FX_MAX_ACTIVE_EFFECTS; i++, fxrunner++)
-	{
-		if (cl.time > fxrunner->endTime)
-			continue;
-
-		AngleVectors(fxrunner->dir, fx_v_forward, fx_v_right, fx_v_up);
-
-		fx = fxSys.fxDefs[fxrunner->effectIndex];
-
-		CL_AddEffectParticlesToScene(fxrunner);
-
-		//memset(&rent, 0, sizeof(rent));
-		//void V_AddEntity(rentity_t * ent);
-		//void V_AddParticle(vec3_t org, vec3_t color, float alpha);
-		//V_AddLight(dl->origin, dl->radius, dl->color[0], dl->color[1], dl->color[2]);
-	}
+	out = V_ParticleStream(&maxout);
+	maxout = FX_RunEffects(cl.time, out, maxout, true);
+	if (fx_show->value)
+		V_CommitParticleStream(maxout);
 }
 
 
@@ -233,6 +541,7 @@ void FX_StartFXAttachedToEntity(int effectIndex, int entityIndex, char *tagName)
 	clentity_t* cent;
 	fx_runner_t* runner;
 	float fxlength;
+	vec3_t up = { 0, 0, 1 };
 
 	if (effectIndex < 0 || effectIndex >= fxSys.numLoadedEffects)
 	{
@@ -267,10 +576,11 @@ void FX_StartFXAttachedToEntity(int effectIndex, int entityIndex, char *tagName)
 	runner->startTime = cl.time;
 	runner->endTime = runner->startTime + (int)(fxlength * 1000);
 	runner->effectIndex = effectIndex;
-	VectorCopy(cent->current.origin, runner->origin);
+	runner->entity = entityIndex;
 
 	// fixme: calc direction from tag rotation
-	runner->dir[2] = 1; // up	
+	FX_SetRunnerPlacement(runner, cent->current.origin, up);
+	runner->seed = FX_SeedForRunner(runner);
 }
 
 /*
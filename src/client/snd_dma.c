@@ -15,8 +15,9 @@ See the attached GNU General Public License v2 for more details.
 
 void S_Play(void);
 void S_SoundList(void);
-void S_Update_();
+void S_Update_(float mixahead);
 void S_StopAllSounds(void);
+void S_Stall_f(void);
 
 
 // =======================================================================
@@ -37,10 +38,8 @@ int			sound_started = 0;
 
 dma_t		dma;
 
-vec3_t		listener_origin;
-vec3_t		listener_forward;
-vec3_t		listener_right;
-vec3_t		listener_up;
+listener_t	listener;				// used by whoever owns the channels
+static listener_t	s_framelistener;	// this frame's listener on the main thread
 
 qboolean	s_registering;
 
@@ -54,6 +53,7 @@ int   		paintedtime; 	// sample PAIRS
 #define		MAX_SFX		(MAX_SOUNDS*2)
 sfx_t		known_sfx[MAX_SFX];
 int			num_sfx;
+static nameindex_t	s_sfxindex;		// known_sfx names
 
 #define		MAX_PLAYSOUNDS	128
 playsound_t	s_playsounds[MAX_PLAYSOUNDS];
@@ -62,6 +62,30 @@ playsound_t	s_pendingplays;
 
 int			s_beginofs;
 
+// everything S_StartSound needs to create a playsound
+typedef struct
+{
+	sfx_t		*sfx;
+	vec3_t		origin;			// the entity's origin at the time of the call if !fixed_origin
+	qboolean	fixed_origin;
+	int			entnum;
+	int			entchannel;
+	int			volume;			// 0-255
+	float		attenuation;
+	float		timeofs;
+	int			servertime;		// cl.frame.servertime
+	int			defertime;		// Sys_Milliseconds() when it started waiting for the loader
+} sndstart_t;
+
+// starts waiting for the loader thread, main thread only
+#define		MAX_DEFERRED	64
+#define		MAX_DEFER_MSEC	500		// dropped when the sound took longer than this
+static sndstart_t	s_deferred[MAX_DEFERRED];
+static int			s_numdeferred;
+
+volatile int	s_underruns;		// mixer fell behind the DMA position
+static qboolean	s_resync;			// painting was suspended, the next catch up isn't an underrun
+
 cvar_t		*s_volume;
 cvar_t		*s_testsound;
 cvar_t		*s_loadas8bit;
@@ -69,11 +93,65 @@ cvar_t		*s_khz;
 cvar_t		*s_show;
 cvar_t		*s_mixahead;
 cvar_t		*s_primary;
+cvar_t		*s_simd;
+cvar_t		*s_mixthread;
+cvar_t		*s_mixthread_ahead;
 
 
 int		s_rawend;
 portable_samplepair_t	s_rawsamples[MAX_RAW_SAMPLES];
 
+static void			*s_mixer;		// mixer thread handle, NULL when mixing in the client frame
+static void			*s_rawlock;		// held by the mixer thread while it runs commands and paints
+static int			s_cmddrops;
+
+// main thread, until when the mixer thread needs an entity's origin, in msec
+static int			s_entsoundend[MAX_GENTITIES];
+
+typedef enum
+{
+	SNDCMD_START,
+	SNDCMD_STOPENTITY,
+	SNDCMD_STOPALL,
+	SNDCMD_ENTITYORIGIN,
+	SNDCMD_LISTENER,	// respatializes and drops last frame's loop sounds
+	SNDCMD_LOOPSOUND,
+	SNDCMD_VOLUME,
+	SNDCMD_FENCE
+} sndcmdtype_t;
+
+typedef struct
+{
+	sndcmdtype_t	type;
+	union
+	{
+		sndstart_t	start;
+		struct
+		{
+			listener_t	listener;
+			qboolean	paused;		// loading plaque is up
+			float		mixahead;
+		} frame;
+		struct
+		{
+			sfx_t		*sfx;
+			int			left, right;
+		} loop;
+		struct
+		{
+			int			entnum;
+			vec3_t		origin;
+		} entity;
+		float		volume;
+	} u;
+} sndcmd_t;
+
+static sndcmd_t *S_PostCommand (sndcmdtype_t type);
+static void S_FlushCommands (void);
+static void S_StartMixThread (void);
+static void S_StopMixThread (void);
+static void S_SyncMixThread (void);
+
 
 // ====================================================================
 // User-setable variables
@@ -95,6 +173,11 @@ void S_SoundInfo_f(void)
     Com_Printf("%5d submission_chunk\n", dma.submission_chunk);
     Com_Printf("%5d speed\n", dma.speed);
     Com_Printf("0x%x dma buffer\n", dma.buffer);
+	Com_Printf("%5d underruns\n", Sys_AtomicAdd (&s_underruns, 0));
+	if (s_mixer)
+		Com_Printf("mixing on its own thread, %i dropped commands\n", s_cmddrops);
+	else
+		Com_Printf("mixing in the client frame\n");
 }
 
 
@@ -122,19 +205,29 @@ void S_Init (void)
 		s_show = Cvar_Get ("s_show", "0", 0, NULL);
 		s_testsound = Cvar_Get ("s_testsound", "0", 0, NULL);
 		s_primary = Cvar_Get ("s_primary", "0", CVAR_ARCHIVE, NULL); // win32 specific
+		s_simd = Cvar_Get ("s_simd", "1", CVAR_ARCHIVE, "Use SSE2/AVX2 sound mixing when the CPU supports it.");
+		s_mixthread = Cvar_Get ("s_mixthread", "0", CVAR_ARCHIVE, "Mix sound on its own thread, takes effect on snd_restart.");
+		s_mixthread_ahead = Cvar_Get ("s_mixthread_ahead", "0.05", CVAR_ARCHIVE, "Seconds of sound the mixer thread keeps ahead of the device.");
 
 		Cmd_AddCommand("play", S_Play);
 		Cmd_AddCommand("stopsound", S_StopAllSounds);
 		Cmd_AddCommand("soundlist", S_SoundList);
 		Cmd_AddCommand("soundinfo", S_SoundInfo_f);
+		Cmd_AddCommand("s_mixbench", S_MixBench_f);
+		Cmd_AddCommand("s_stall", S_Stall_f);
 
 		if (!SNDDMA_Init())
 			return;
 
-		S_InitScaletable ();
+		S_InitScaletable (s_volume->value);
+		s_volume->modified = false;
+		S_SelectMixKernels ();
 
 		sound_started = 1;
 		num_sfx = 0;
+		NameIndex_Clear (&s_sfxindex);
+
+		S_InitLoader ();
 
 		soundtime = 0;
 		paintedtime = 0;
@@ -142,6 +235,8 @@ void S_Init (void)
 		Com_Printf ("sound sampling rate: %i\n", dma.speed);
 
 		S_StopAllSounds ();
+
+		S_StartMixThread ();
 	}
 
 	Com_Printf("------------------------------------\n");
@@ -160,6 +255,9 @@ void S_Shutdown(void)
 	if (!sound_started)
 		return;
 
+	S_StopMixThread();
+	S_ShutdownLoader();
+
 	SNDDMA_Shutdown();
 
 	sound_started = 0;
@@ -168,6 +266,8 @@ void S_Shutdown(void)
 	Cmd_RemoveCommand("stopsound");
 	Cmd_RemoveCommand("soundlist");
 	Cmd_RemoveCommand("soundinfo");
+	Cmd_RemoveCommand("s_mixbench");
+	Cmd_RemoveCommand("s_stall");
 
 	// free all sounds
 	for (i=0, sfx=known_sfx ; i < num_sfx ; i++,sfx++)
@@ -180,6 +280,7 @@ void S_Shutdown(void)
 	}
 
 	num_sfx = 0;
+	NameIndex_Clear (&s_sfxindex);
 }
 
 
@@ -217,11 +318,9 @@ sfx_t *S_FindName (char *name, qboolean create)
 	}
 
 	// see if already loaded
-	for (i=0 ; i < num_sfx ; i++)
-		if (!strcmp(known_sfx[i].name, name))
-		{
-			return &known_sfx[i];
-		}
+	i = NameIndex_Find (&s_sfxindex, name);
+	if (i >= 0)
+		return &known_sfx[i];
 
 	if (!create)
 		return NULL;
@@ -243,6 +342,8 @@ sfx_t *S_FindName (char *name, qboolean create)
 	memset (sfx, 0, sizeof(*sfx));
 	strcpy (sfx->name, name);
 	sfx->registration_sequence = s_registration_sequence;
+	sfx->firstplay = -1;
+	NameIndex_Add (&s_sfxindex, sfx->name, i);
 	
 	return sfx;
 }
@@ -280,6 +381,8 @@ sfx_t *S_AliasName (char *aliasname, char *truename)
 	strcpy (sfx->name, aliasname);
 	sfx->registration_sequence = s_registration_sequence;
 	sfx->truename = s;
+	sfx->firstplay = -1;
+	NameIndex_Add (&s_sfxindex, sfx->name, i);
 
 	return sfx;
 }
@@ -332,6 +435,13 @@ void S_EndRegistration (void)
 	sfx_t	*sfx;
 	int		size;
 
+	// the mixer thread must let go of the sounds that are about to be freed
+	if (s_mixer)
+	{
+		S_StopAllSounds ();
+		S_SyncMixThread ();
+	}
+
 	// free any sounds not from this registration sequence
 	for (i=0, sfx=known_sfx ; i < num_sfx ; i++,sfx++)
 	{
@@ -341,6 +451,9 @@ void S_EndRegistration (void)
 		{	// don't need this sound
 			if (sfx->cache)	// it is possible to have a leftover
 				Z_Free (sfx->cache);	// from a server that didn't finish loading
+			else if (sfx->loadstate == SFX_LOADING)
+				S_ReleaseDeferredPlays (sfx);	// drops them, the loader result will be stale
+			NameIndex_Remove (&s_sfxindex, i);
 			memset (sfx, 0, sizeof(*sfx));
 		}
 		else
@@ -354,11 +467,13 @@ void S_EndRegistration (void)
 
 	}
 
-	// load everything in
+	// queue everything for loading, giving failed sounds another try
 	for (i=0, sfx=known_sfx ; i < num_sfx ; i++,sfx++)
 	{
 		if (!sfx->name[0])
 			continue;
+		if (sfx->loadstate == SFX_FAILED)
+			sfx->loadstate = SFX_UNLOADED;
 		S_LoadSound (sfx);
 	}
 
@@ -397,7 +512,7 @@ channel_t *S_PickChannel(int entnum, int entchannel)
 		}
 
 		// don't let monster sounds override player sounds
-		if (channels[ch_idx].entnum == cl.playernum+1 && entnum != cl.playernum+1 && channels[ch_idx].sfx)
+		if (channels[ch_idx].entnum == listener.entnum && entnum != listener.entnum && channels[ch_idx].sfx)
 			continue;
 
 		if (channels[ch_idx].end - paintedtime < life_left)
@@ -423,21 +538,21 @@ S_SpatializeOrigin
 Used for spatializing channels and autosounds
 =================
 */
-void S_SpatializeOrigin (vec3_t origin, float master_vol, float dist_mult, int *left_vol, int *right_vol)
+void S_SpatializeOrigin (listener_t *l, vec3_t origin, float master_vol, float dist_mult, int *left_vol, int *right_vol)
 {
     vec_t		dot;
     vec_t		dist;
     vec_t		lscale, rscale, scale;
     vec3_t		source_vec;
 
-	if (cls.state != CS_ACTIVE)
+	if (!l->active)
 	{
 		*left_vol = *right_vol = 255;
 		return;
 	}
 
 // calculate stereo seperation and distance attenuation
-	VectorSubtract(origin, listener_origin, source_vec);
+	VectorSubtract(origin, l->origin, source_vec);
 
 	dist = VectorNormalize(source_vec);
 	dist -= SOUND_FULLVOLUME;
@@ -445,7 +560,7 @@ void S_SpatializeOrigin (vec3_t origin, float master_vol, float dist_mult, int *
 		dist = 0;			// close enough to be at full volume
 	dist *= dist_mult;		// different attenuation levels
 	
-	dot = DotProduct(listener_right, source_vec);
+	dot = DotProduct(l->right, source_vec);
 
 	if (dma.channels == 1 || !dist_mult)
 	{ // no attenuation = no spatialization
@@ -480,21 +595,22 @@ void S_Spatialize(channel_t *ch)
 	vec3_t		origin;
 
 	// anything coming from the view entity will always be full volume
-	if (ch->entnum == cl.playernum+1)
+	if (ch->entnum == listener.entnum)
 	{
 		ch->leftvol = ch->master_vol;
 		ch->rightvol = ch->master_vol;
 		return;
 	}
 
-	if (ch->fixed_origin)
+	// the mixer thread can't look at client entities, it is sent their origins
+	if (ch->fixed_origin || s_mixer)
 	{
 		VectorCopy (ch->origin, origin);
 	}
 	else
 		CL_GetEntitySoundOrigin (ch->entnum, origin);
 
-	S_SpatializeOrigin (origin, ch->master_vol, ch->dist_mult, &ch->leftvol, &ch->rightvol);
+	S_SpatializeOrigin (&listener, origin, ch->master_vol, ch->dist_mult, &ch->leftvol, &ch->rightvol);
 }           
 
 
@@ -553,7 +669,7 @@ void S_IssuePlaysound (playsound_t *ps)
 	channel_t	*ch;
 	sfxcache_t	*sc;
 
-	if (s_show->value)
+	if (s_show->value && !s_mixer)
 		Com_Printf ("Issue %i\n", ps->begin);
 	// pick a channel to play on
 	ch = S_PickChannel(ps->entnum, ps->entchannel);
@@ -578,10 +694,11 @@ void S_IssuePlaysound (playsound_t *ps)
 	S_Spatialize(ch);
 
 	ch->pos = 0;
-	sc = S_LoadSound (ch->sfx);
+	sc = ch->sfx->cache;
 	if (!sc)
 	{
 		ch->end = 0;
+		S_FreePlaysound (ps);
 		return;
 	}
     ch->end = paintedtime + sc->length;
@@ -595,6 +712,93 @@ void S_IssuePlaysound (playsound_t *ps)
 // Start a sound effect
 // =======================================================================
 
+/*
+====================
+S_ExecuteStart
+
+Turns a start into a playsound, runs where the channels are owned
+====================
+*/
+static void S_ExecuteStart (sndstart_t *start)
+{
+	playsound_t	*ps;
+	int			begin;
+
+	ps = S_AllocPlaysound ();
+	if (!ps)
+		return;
+
+	VectorCopy (start->origin, ps->origin);
+	ps->fixed_origin = start->fixed_origin;
+	ps->entnum = start->entnum;
+	ps->entchannel = start->entchannel;
+	ps->attenuation = start->attenuation;
+	ps->volume = start->volume;
+	ps->sfx = start->sfx;
+
+	// drift s_beginofs
+	begin = start->servertime * 0.001 * dma.speed + s_beginofs;
+	if (begin < paintedtime)
+	{
+		begin = paintedtime;
+		s_beginofs = begin - (start->servertime * 0.001 * dma.speed);
+	}
+	else if (begin > paintedtime + 0.3 * dma.speed)
+	{
+		begin = paintedtime + 0.1 * dma.speed;
+		s_beginofs = begin - (start->servertime * 0.001 * dma.speed);
+	}
+	else
+	{
+		s_beginofs-=10;
+	}
+
+	if (!start->timeofs)
+		ps->begin = paintedtime;
+	else
+		ps->begin = begin + start->timeofs * dma.speed;
+
+	S_InsertPlaysound (ps);
+}
+
+/*
+====================
+S_SubmitStart
+
+Hands a start whose sound is cached to the channel owner
+====================
+*/
+static void S_SubmitStart (sndstart_t *start)
+{
+	sndcmd_t	*cmd;
+	sfxcache_t	*sc;
+	int			end;
+
+	if (!s_mixer)
+	{
+		S_ExecuteStart (start);
+		return;
+	}
+
+	if (!start->fixed_origin)
+	{
+		CL_GetEntitySoundOrigin (start->entnum, start->origin);
+
+		// keep sending the entity's origin for as long as the sound can last
+		sc = start->sfx->cache;
+		if (sc->loopstart >= 0)
+			end = 0x7fffffff;
+		else
+			end = Sys_Milliseconds() + MAX_DEFER_MSEC + (start->timeofs + (float)sc->length / dma.speed) * 1000;
+		if (s_entsoundend[start->entnum] < end)
+			s_entsoundend[start->entnum] = end;
+	}
+
+	cmd = S_PostCommand (SNDCMD_START);
+	if (cmd)
+		cmd->u.start = *start;
+}
+
 /*
 ====================
 S_StartSound
@@ -607,9 +811,7 @@ Entchannel 0 will never override a playing sound
 void S_StartSound(vec3_t origin, int entnum, int entchannel, sfx_t *sfx, float fvol, float attenuation, float timeofs)
 {
 	sfxcache_t	*sc;
-	int			vol;
-	playsound_t	*ps, *sort;
-	int			start;
+	sndstart_t	start;
 
 	if (!sound_started)
 		return;
@@ -617,55 +819,61 @@ void S_StartSound(vec3_t origin, int entnum, int entchannel, sfx_t *sfx, float f
 	if (!sfx)
 		return;
 
-	// make sure the sound is loaded
-	sc = S_LoadSound (sfx);
-	if (!sc)
-		return;		// couldn't load the sound's data
-
-	vol = fvol*255;
-
-	// make the playsound_t
-	ps = S_AllocPlaysound ();
-	if (!ps)
-		return;
+	if (entchannel < 0)
+		Com_Error (ERR_DROP, "S_StartSound: entchannel < 0");
 
-	if (origin)
+	if (!sfx->requested)
 	{
-		VectorCopy (origin, ps->origin);
-		ps->fixed_origin = true;
+		sfx->requested = true;
+		sfx->requesttime = Sys_Microseconds();
+		if (!sfx->cache)
+			s_loadstats.cold++;
 	}
-	else
-		ps->fixed_origin = false;
 
-	ps->entnum = entnum;
-	ps->entchannel = entchannel;
-	ps->attenuation = attenuation;
-	ps->volume = vol;
-	ps->sfx = sfx;
+	// make sure the sound is loaded, or at least on its way
+	sc = S_LoadSound (sfx);
+	if (sc)
+		S_NoteFirstPlay (sfx);
+	else if (sfx->loadstate != SFX_LOADING)
+		return;		// couldn't load the sound's data
 
-	// drift s_beginofs
-	start = cl.frame.servertime * 0.001 * dma.speed + s_beginofs;
-	if (start < paintedtime)
-	{
-		start = paintedtime;
-		s_beginofs = start - (cl.frame.servertime * 0.001 * dma.speed);
-	}
-	else if (start > paintedtime + 0.3 * dma.speed)
+	memset (&start, 0, sizeof(start));
+	start.sfx = sfx;
+	if (origin)
 	{
-		start = paintedtime + 0.1 * dma.speed;
-		s_beginofs = start - (cl.frame.servertime * 0.001 * dma.speed);
+		VectorCopy (origin, start.origin);
+		start.fixed_origin = true;
 	}
-	else
-	{
-		s_beginofs-=10;
+	start.entnum = entnum;
+	start.entchannel = entchannel;
+	start.volume = fvol*255;
+	start.attenuation = attenuation;
+	start.timeofs = timeofs;
+	start.servertime = cl.frame.servertime;
+
+	if (!sc)
+	{	// hold it back until the loader is done with the sound
+		if (s_numdeferred == MAX_DEFERRED)
+			return;
+		start.defertime = Sys_Milliseconds();
+		s_deferred[s_numdeferred++] = start;
+		return;
 	}
 
-	if (!timeofs)
-		ps->begin = paintedtime;
-	else
-		ps->begin = start + timeofs * dma.speed;
+	S_SubmitStart (&start);
+}
+
+/*
+====================
+S_InsertPlaysound
+
+Sorts a playsound into the pending sound list
+====================
+*/
+void S_InsertPlaysound (playsound_t *ps)
+{
+	playsound_t	*sort;
 
-	// sort into the pending sound list
 	for (sort = s_pendingplays.next ; 
 		sort != &s_pendingplays && sort->begin < ps->begin ;
 		sort = sort->next)
@@ -678,12 +886,73 @@ void S_StartSound(vec3_t origin, int entnum, int entchannel, sfx_t *sfx, float f
 	ps->prev->next = ps;
 }
 
+/*
+====================
+S_ReleaseDeferredPlays
+
+Called when the loader finished a sound, its starts either go ahead
+now or get dropped when they are too late to make sense
+====================
+*/
+void S_ReleaseDeferredPlays (sfx_t *sfx)
+{
+	int			i;
+	sndstart_t	start;
+
+	for (i = 0 ; i < s_numdeferred ; )
+	{
+		if (s_deferred[i].sfx != sfx)
+		{
+			i++;
+			continue;
+		}
+
+		start = s_deferred[i];
+		s_deferred[i] = s_deferred[--s_numdeferred];
+
+		if (!sfx->cache || Sys_Milliseconds() - start.defertime > MAX_DEFER_MSEC)
+		{
+			if (s_show->value)
+				Com_Printf ("dropped late %s\n", sfx->name);
+			continue;
+		}
+
+		S_SubmitStart (&start);
+	}
+}
+
+/*
+====================
+S_NoteFirstPlay
+
+Records how long the first S_StartSound of a sound had to wait for it
+====================
+*/
+void S_NoteFirstPlay (sfx_t *sfx)
+{
+	int		latency;
+
+	if (!sfx->requested || sfx->firstplay >= 0)
+		return;
+
+	latency = (int)(Sys_Microseconds() - sfx->requesttime);
+	sfx->firstplay = latency;
+
+	s_loadstats.firstplays++;
+	s_loadstats.latency += latency;
+	if (latency > s_loadstats.maxlatency)
+		s_loadstats.maxlatency = latency;
+
+	if (latency >= 1000)
+		Com_DPrintf (DP_SND, "%s: first play waited %.2f ms\n", sfx->name, latency / 1000.0f);
+}
+
 /*
 ==================
-S_StopEntitySounds
+S_StopEntityChannel
 ==================
 */
-void S_StopEntitySounds(int entnum)
+static void S_StopEntityChannel(int entnum)
 {
 	for (int i = 0; i < MAX_CHANNELS; i++)
 	{
@@ -696,6 +965,26 @@ void S_StopEntitySounds(int entnum)
 	}
 }
 
+/*
+==================
+S_StopEntitySounds
+==================
+*/
+void S_StopEntitySounds(int entnum)
+{
+	sndcmd_t	*cmd;
+
+	if (!s_mixer)
+	{
+		S_StopEntityChannel (entnum);
+		return;
+	}
+
+	cmd = S_PostCommand (SNDCMD_STOPENTITY);
+	if (cmd)
+		cmd->u.entity.entnum = entnum;
+}
+
 /*
 ==================
 S_StartLocalSound
@@ -731,6 +1020,7 @@ void S_ClearBuffer (void)
 		return;
 
 	s_rawend = 0;
+	s_resync = true;
 
 	if (dma.samplebits == 8)
 		clear = 0x80;
@@ -745,16 +1035,15 @@ void S_ClearBuffer (void)
 
 /*
 ==================
-S_StopAllSounds
+S_ResetChannels
+
+Clears all playsounds and channels, runs where the channels are owned
 ==================
 */
-void S_StopAllSounds(void)
+static void S_ResetChannels(void)
 {
 	int		i;
 
-	if (!sound_started)
-		return;
-
 	// clear all the playsounds
 	memset(s_playsounds, 0, sizeof(s_playsounds));
 	s_freeplays.next = s_freeplays.prev = &s_freeplays;
@@ -774,6 +1063,91 @@ void S_StopAllSounds(void)
 	S_ClearBuffer ();
 }
 
+/*
+==================
+S_StopAllSounds
+==================
+*/
+void S_StopAllSounds(void)
+{
+	if (!sound_started)
+		return;
+
+	s_numdeferred = 0;
+
+	if (!s_mixer)
+	{
+		S_ResetChannels ();
+		return;
+	}
+
+	memset (s_entsoundend, 0, sizeof(s_entsoundend));
+	S_PostCommand (SNDCMD_STOPALL);
+	S_FlushCommands ();
+}
+
+/*
+==================
+S_UpdateChannels
+
+Respatializes the dynamic sounds and drops the last frame's
+autosounds, runs where the channels are owned
+==================
+*/
+static void S_UpdateChannels (void)
+{
+	int			i;
+	channel_t	*ch;
+
+	ch = channels;
+	for (i=0 ; i<MAX_CHANNELS; i++, ch++)
+	{
+		if (!ch->sfx)
+			continue;
+		if (ch->autosound)
+		{	// autosounds are regenerated fresh each frame
+			memset (ch, 0, sizeof(*ch));
+			continue;
+		}
+		S_Spatialize(ch);         // respatialize channel
+		if (!ch->leftvol && !ch->rightvol)
+		{
+			memset (ch, 0, sizeof(*ch));
+			continue;
+		}
+	}
+}
+
+/*
+==================
+S_AddLoopChannel
+
+Returns false when there are no channels left
+==================
+*/
+static qboolean S_AddLoopChannel (sfx_t *sfx, int left, int right)
+{
+	channel_t	*ch;
+	sfxcache_t	*sc;
+
+	sc = sfx->cache;
+	if (!sc)
+		return true;
+
+	// allocate a channel
+	ch = S_PickChannel(0, 0);
+	if (!ch)
+		return false;
+
+	ch->leftvol = left;
+	ch->rightvol = right;
+	ch->autosound = true;	// remove next frame
+	ch->sfx = sfx;
+	ch->pos = paintedtime % sc->length;
+	ch->end = paintedtime + sc->length - ch->pos;
+	return true;
+}
+
 /*
 ==================
 S_AddLoopSounds
@@ -788,7 +1162,7 @@ void S_AddLoopSounds (void)
 	int			i, j;
 	int			sounds[MAX_GENTITIES];
 	int			left, right, left_total, right_total;
-	channel_t	*ch;
+	sndcmd_t	*cmd;
 	sfx_t		*sfx;
 	sfxcache_t	*sc;
 	int			num;
@@ -834,7 +1208,7 @@ void S_AddLoopSounds (void)
 		}
 		else
 		{
-			S_SpatializeOrigin(ent->origin, 255.0, SOUND_LOOPATTENUATE, &left_total, &right_total);
+			S_SpatializeOrigin(&s_framelistener, ent->origin, 255.0, SOUND_LOOPATTENUATE, &left_total, &right_total);
 		}
 		// -- end Reki ---
 
@@ -848,7 +1222,7 @@ void S_AddLoopSounds (void)
 			num = (cl.frame.parse_entities + j)&(MAX_PARSE_ENTITIES-1);
 			ent = &cl_parse_entities[num];
 
-			S_SpatializeOrigin (ent->origin, 255.0, SOUND_LOOPATTENUATE, &left, &right);
+			S_SpatializeOrigin (&s_framelistener, ent->origin, 255.0, SOUND_LOOPATTENUATE, &left, &right);
 			left_total += left;
 			right_total += right;
 		}
@@ -856,22 +1230,23 @@ void S_AddLoopSounds (void)
 		if (left_total == 0 && right_total == 0)
 			continue;		// not audible
 
-		// allocate a channel
-		ch = S_PickChannel(0, 0);
-		if (!ch)
-			return;
-
 		if (left_total > 255)
 			left_total = 255;
 		if (right_total > 255)
 			right_total = 255;
 
-		ch->leftvol = left_total;
-		ch->rightvol = right_total;
-		ch->autosound = true;	// remove next frame
-		ch->sfx = sfx;
-		ch->pos = paintedtime % sc->length;
-		ch->end = paintedtime + sc->length - ch->pos;
+		if (s_mixer)
+		{
+			cmd = S_PostCommand (SNDCMD_LOOPSOUND);
+			if (cmd)
+			{
+				cmd->u.loop.sfx = sfx;
+				cmd->u.loop.left = left_total;
+				cmd->u.loop.right = right_total;
+			}
+		}
+		else if (!S_AddLoopChannel (sfx, left_total, right_total))
+			return;
 	}
 }
 
@@ -893,6 +1268,10 @@ void S_RawSamples (int samples, int rate, int width, int numChannels, byte *data
 	if (!sound_started)
 		return;
 
+	// the mixer thread reads the raw samples while painting
+	if (s_mixer)
+		Sys_LockMutex (s_rawlock);
+
 	if (s_rawend < paintedtime)
 		s_rawend = paintedtime;
 	scale = (float)rate / dma.speed;
@@ -972,10 +1351,304 @@ void S_RawSamples (int samples, int rate, int width, int numChannels, byte *data
 			s_rawsamples[dst].right = (((byte *)data)[src]-128) << 16;
 		}
 	}
+
+	if (s_mixer)
+		Sys_UnlockMutex (s_rawlock);
+}
+
+/*
+===============================================================================
+
+MIXER THREAD
+
+With s_mixthread 1 the channels, playsounds and the DMA buffer belong to
+a thread that paints every few milliseconds, so a long client frame no
+longer underruns the device. The main thread talks to it only through a
+single producer, single consumer command ring. Commands posted during a
+frame are published together by S_FlushCommands, so the mixer never sees
+half of a frame's loop sounds.
+
+===============================================================================
+*/
+
+#define	MAX_SNDCMDS		1024	// must be a power of two
+#define	MIXTHREAD_MSEC	5
+
+static sndcmd_t		s_cmds[MAX_SNDCMDS];
+static volatile int	s_cmdhead;		// published by the main thread
+static volatile int	s_cmdtail;		// published by the mixer thread
+static int			s_cmdwrite;		// main thread, not yet published
+static int			s_cmdflushed;	// main thread copy of s_cmdhead
+static int			s_cmdread;		// mixer thread copy of s_cmdtail
+
+static volatile int	s_mixquit;
+static volatile int	s_fencedone;
+static int			s_fencesequence;
+
+// owned by the mixer thread
+static qboolean		s_mixpaused;
+static float		s_mixaheadsec;
+
+/*
+==================
+S_PostCommand
+
+Main thread only, returns NULL when the mixer thread stopped taking
+commands. The command is seen by the mixer after S_FlushCommands.
+==================
+*/
+static sndcmd_t *S_PostCommand (sndcmdtype_t type)
+{
+	sndcmd_t	*cmd;
+	int			tries;
+
+	tries = 0;
+	while (s_cmdwrite - Sys_AtomicAdd (&s_cmdtail, 0) >= MAX_SNDCMDS)
+	{	// give the mixer a moment to catch up before dropping anything
+		if (tries++ == 100)
+		{
+			s_cmddrops++;
+			return NULL;
+		}
+		S_FlushCommands ();
+		Sys_Sleep (1);
+	}
+
+	cmd = &s_cmds[s_cmdwrite & (MAX_SNDCMDS-1)];
+	memset (cmd, 0, sizeof(*cmd));
+	cmd->type = type;
+	s_cmdwrite++;
+
+	return cmd;
+}
+
+/*
+==================
+S_FlushCommands
+==================
+*/
+static void S_FlushCommands (void)
+{
+	if (s_cmdwrite == s_cmdflushed)
+		return;
+
+	Sys_AtomicAdd (&s_cmdhead, s_cmdwrite - s_cmdflushed);
+	s_cmdflushed = s_cmdwrite;
+}
+
+/*
+==================
+S_SetEntityOrigin
+==================
+*/
+static void S_SetEntityOrigin (int entnum, vec3_t origin)
+{
+	int			i;
+	channel_t	*ch;
+	playsound_t	*ps;
+
+	for (i=0, ch=channels ; i<MAX_CHANNELS ; i++, ch++)
+	{
+		if (ch->sfx && ch->entnum == entnum && !ch->fixed_origin)
+			VectorCopy (origin, ch->origin);
+	}
+
+	for (ps = s_pendingplays.next ; ps != &s_pendingplays ; ps = ps->next)
+	{
+		if (ps->entnum == entnum && !ps->fixed_origin)
+			VectorCopy (origin, ps->origin);
+	}
+}
+
+/*
+==================
+S_ExecuteCommand
+
+Mixer thread
+==================
+*/
+static void S_ExecuteCommand (sndcmd_t *cmd)
+{
+	switch (cmd->type)
+	{
+	case SNDCMD_START:
+		S_ExecuteStart (&cmd->u.start);
+		break;
+
+	case SNDCMD_STOPENTITY:
+		S_StopEntityChannel (cmd->u.entity.entnum);
+		break;
+
+	case SNDCMD_STOPALL:
+		S_ResetChannels ();
+		break;
+
+	case SNDCMD_ENTITYORIGIN:
+		S_SetEntityOrigin (cmd->u.entity.entnum, cmd->u.entity.origin);
+		break;
+
+	case SNDCMD_LISTENER:
+		if (cmd->u.frame.paused)
+		{
+			if (!s_mixpaused)
+				S_ClearBuffer ();
+			s_mixpaused = true;
+			break;
+		}
+		s_mixpaused = false;
+		s_mixaheadsec = cmd->u.frame.mixahead;
+		listener = cmd->u.frame.listener;
+		S_UpdateChannels ();
+		break;
+
+	case SNDCMD_LOOPSOUND:
+		S_AddLoopChannel (cmd->u.loop.sfx, cmd->u.loop.left, cmd->u.loop.right);
+		break;
+
+	case SNDCMD_VOLUME:
+		S_InitScaletable (cmd->u.volume);
+		break;
+
+	case SNDCMD_FENCE:
+		// fences run in order, so the count is the last sequence number
+		Sys_AtomicAdd (&s_fencedone, 1);
+		break;
+	}
+}
+
+/*
+==================
+S_MixThread
+==================
+*/
+static void S_MixThread (void *arg)
+{
+	int		head, tail;
+
+	while (!Sys_AtomicAdd (&s_mixquit, 0))
+	{
+		Sys_LockMutex (s_rawlock);
+
+		head = Sys_AtomicAdd (&s_cmdhead, 0);
+		for (tail = s_cmdread ; tail != head ; tail++)
+			S_ExecuteCommand (&s_cmds[tail & (MAX_SNDCMDS-1)]);
+		Sys_AtomicAdd (&s_cmdtail, head - s_cmdread);
+		s_cmdread = head;
+
+		if (!s_mixpaused)
+			S_Update_ (s_mixaheadsec);
+
+		Sys_UnlockMutex (s_rawlock);
+
+		Sys_Sleep (MIXTHREAD_MSEC);
+	}
+}
+
+/*
+==================
+S_StartMixThread
+==================
+*/
+static void S_StartMixThread (void)
+{
+	if (!s_mixthread->value)
+		return;
+
+	s_cmdhead = s_cmdtail = s_cmdwrite = 0;
+	s_cmdflushed = s_cmdread = 0;
+	s_mixquit = 0;
+	s_fencedone = s_fencesequence = 0;
+	s_mixpaused = false;
+	s_mixaheadsec = s_mixthread_ahead->value;
+	memset (s_entsoundend, 0, sizeof(s_entsoundend));
+
+	s_rawlock = Sys_CreateMutex ();
+	if (s_rawlock)
+		s_mixer = Sys_CreateThread (S_MixThread, NULL);
+	if (!s_mixer)
+	{
+		if (s_rawlock)
+			Sys_DestroyMutex (s_rawlock);
+		s_rawlock = NULL;
+		Com_Printf ("S_Init: no mixer thread, mixing in the client frame\n");
+	}
+}
+
+/*
+==================
+S_StopMixThread
+==================
+*/
+static void S_StopMixThread (void)
+{
+	if (!s_mixer)
+		return;
+
+	Sys_AtomicAdd (&s_mixquit, 1);
+	Sys_WaitThread (s_mixer);
+	s_mixer = NULL;
+	Sys_DestroyMutex (s_rawlock);
+	s_rawlock = NULL;
+}
+
+/*
+==================
+S_SyncMixThread
+
+Waits until the mixer thread ran every command posted so far
+==================
+*/
+static void S_SyncMixThread (void)
+{
+	int			i, fence;
+
+	if (!s_mixer)
+		return;
+
+	if (!S_PostCommand (SNDCMD_FENCE))
+		return;
+	fence = ++s_fencesequence;
+	S_FlushCommands ();
+
+	for (i = 0 ; i < 2000 && Sys_AtomicAdd (&s_fencedone, 0) < fence ; i++)
+		Sys_Sleep (1);
+}
+
+/*
+==================
+S_PostEntityOrigins
+
+Sends the origins of entities that may still have sounds playing
+==================
+*/
+static void S_PostEntityOrigins (void)
+{
+	int			i, now;
+	sndcmd_t	*cmd;
+
+	now = Sys_Milliseconds();
+	for (i = 0 ; i < MAX_GENTITIES ; i++)
+	{
+		if (!s_entsoundend[i])
+			continue;
+		if (s_entsoundend[i] < now)
+		{
+			s_entsoundend[i] = 0;
+			continue;
+		}
+
+		cmd = S_PostCommand (SNDCMD_ENTITYORIGIN);
+		if (!cmd)
+			return;
+		cmd->u.entity.entnum = i;
+		CL_GetEntitySoundOrigin (i, cmd->u.entity.origin);
+	}
 }
 
 //=============================================================================
 
+static int	s_stallmsec, s_stallframes, s_stallunderruns;
+
 /*
 ============
 S_Update
@@ -988,50 +1661,85 @@ void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
 	int			i;
 	int			total;
 	channel_t	*ch;
-	channel_t	*combine;
+	sndcmd_t	*cmd;
 
 	if (!sound_started)
 		return;
 
+	// s_stall pretends the client frame took much longer
+	if (s_stallframes > 0)
+	{
+		Sys_Sleep (s_stallmsec);
+		if (!--s_stallframes)
+			Com_Printf ("s_stall: %i underruns\n", Sys_AtomicAdd (&s_underruns, 0) - s_stallunderruns);
+	}
+
+	S_UpdateLoads ();
+
+	if (s_simd->modified)
+		S_SelectMixKernels ();
+
 	// if the loading plaque is up, clear everything
 	// out to make sure we aren't looping a dirty
 	// dma buffer while loading
 	if (cls.disable_screen)
 	{
-		S_ClearBuffer ();
+		if (s_mixer)
+		{
+			cmd = S_PostCommand (SNDCMD_LISTENER);
+			if (cmd)
+				cmd->u.frame.paused = true;
+			S_FlushCommands ();
+		}
+		else
+			S_ClearBuffer ();
 		return;
 	}
 
 	// rebuild scale tables if volume is modified
 	if (s_volume->modified)
-		S_InitScaletable ();
-
-	VectorCopy(origin, listener_origin);
-	VectorCopy(forward, listener_forward);
-	VectorCopy(right, listener_right);
-	VectorCopy(up, listener_up);
+	{
+		s_volume->modified = false;
+		if (s_mixer)
+		{
+			cmd = S_PostCommand (SNDCMD_VOLUME);
+			if (cmd)
+				cmd->u.volume = s_volume->value;
+		}
+		else
+			S_InitScaletable (s_volume->value);
+	}
 
-	combine = NULL;
+	VectorCopy(origin, s_framelistener.origin);
+	VectorCopy(forward, s_framelistener.forward);
+	VectorCopy(right, s_framelistener.right);
+	VectorCopy(up, s_framelistener.up);
+	s_framelistener.entnum = cl.playernum+1;
+	s_framelistener.active = (cls.state == CS_ACTIVE);
 
-	// update spatialization for dynamic sounds	
-	ch = channels;
-	for (i=0 ; i<MAX_CHANNELS; i++, ch++)
+	if (s_mixer)
 	{
-		if (!ch->sfx)
-			continue;
-		if (ch->autosound)
-		{	// autosounds are regenerated fresh each frame
-			memset (ch, 0, sizeof(*ch));
-			continue;
-		}
-		S_Spatialize(ch);         // respatialize channel
-		if (!ch->leftvol && !ch->rightvol)
+		S_PostEntityOrigins ();
+
+		cmd = S_PostCommand (SNDCMD_LISTENER);
+		if (cmd)
 		{
-			memset (ch, 0, sizeof(*ch));
-			continue;
+			cmd->u.frame.listener = s_framelistener;
+			cmd->u.frame.mixahead = s_mixthread_ahead->value;
 		}
+
+		S_AddLoopSounds ();
+
+		// the mixer thread paints on its own
+		S_FlushCommands ();
+		return;
 	}
 
+	listener = s_framelistener;
+
+	// update spatialization for dynamic sounds	
+	S_UpdateChannels ();
+
 	// add loopsounds
 	S_AddLoopSounds ();
 
@@ -1053,7 +1761,7 @@ void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
 	}
 
 // mix some sound
-	S_Update_();
+	S_Update_(s_mixahead->value);
 }
 
 void GetSoundtime(void)
@@ -1077,7 +1785,7 @@ void GetSoundtime(void)
 		{	// time to chop things off to avoid 32 bit limits
 			buffers = 0;
 			paintedtime = fullsamples;
-			S_StopAllSounds ();
+			S_ResetChannels ();
 		}
 	}
 	oldsamplepos = samplepos;
@@ -1086,7 +1794,7 @@ void GetSoundtime(void)
 }
 
 
-void S_Update_(void)
+void S_Update_(float mixahead)
 {
 	unsigned        endtime;
 	int				samps;
@@ -1105,12 +1813,18 @@ void S_Update_(void)
 // check to make sure that we haven't overshot
 	if (paintedtime < soundtime)
 	{
-		Com_DPrintf (DP_SND,"S_Update_ : overflow\n");
+		if (!s_resync)
+		{
+			Sys_AtomicAdd (&s_underruns, 1);
+			if (!s_mixer)
+				Com_DPrintf (DP_SND,"S_Update_ : overflow\n");
+		}
 		paintedtime = soundtime;
 	}
+	s_resync = false;
 
 // mix ahead of current position
-	endtime = soundtime + s_mixahead->value * dma.speed;
+	endtime = soundtime + mixahead * dma.speed;
 //endtime = (soundtime + 4096) & ~4095;
 
 	// mix to an even submission block size
@@ -1125,6 +1839,38 @@ void S_Update_(void)
 	SNDDMA_Submit ();
 }
 
+/*
+==================
+S_Stall_f
+
+s_stall <msec> [frames]
+Sleeps in the next frames' S_Update to see if the mixer keeps up
+with a stalled main thread, reports the underruns afterwards
+==================
+*/
+void S_Stall_f (void)
+{
+	if (Cmd_Argc() < 2)
+	{
+		Com_Printf ("usage: s_stall <msec> [frames]\n");
+		return;
+	}
+
+	s_stallmsec = atoi (Cmd_Argv(1));
+	if (s_stallmsec < 1)
+		s_stallmsec = 1;
+	else if (s_stallmsec > 2000)
+		s_stallmsec = 2000;
+
+	s_stallframes = Cmd_Argc() > 2 ? atoi (Cmd_Argv(2)) : 1;
+	if (s_stallframes < 1)
+		s_stallframes = 1;
+
+	s_stallunderruns = Sys_AtomicAdd (&s_underruns, 0);
+	Com_Printf ("stalling %i frames for %i ms, mixing %s\n", s_stallframes, s_stallmsec,
+		s_mixer ? "on its own thread" : "in the client frame");
+}
+
 /*
 ===============================================================================
 
@@ -1176,16 +1922,29 @@ void S_SoundList(void)
 				Com_Printf ("L");
 			else
 				Com_Printf (" ");
-			Com_Printf("(%2db) %6i : %s\n",sc->width*8,  size, sfx->name);
+			Com_Printf("(%2db) %6i : %s", sc->width*8,  size, sfx->name);
+			if (sfx->firstplay >= 0)
+				Com_Printf(" (decode %.2f ms, first play %.2f ms)\n", sfx->decodetime / 1000.0f, sfx->firstplay / 1000.0f);
+			else
+				Com_Printf(" (decode %.2f ms)\n", sfx->decodetime / 1000.0f);
 		}
 		else
 		{
 			if (sfx->name[0] == '*')
 				Com_Printf("  placeholder : %s\n", sfx->name);
+			else if (sfx->loadstate == SFX_LOADING)
+				Com_Printf("  loading     : %s\n", sfx->name);
+			else if (sfx->loadstate == SFX_FAILED)
+				Com_Printf("  failed      : %s\n", sfx->name);
 			else
 				Com_Printf("  not loaded  : %s\n", sfx->name);
 		}
 	}
 	Com_Printf ("Total resident: %i\n", total);
+
+	Com_Printf ("%i loaded %s, %.2f ms decoding\n", s_loadstats.loaded, s_async->value ? "in background" : "inline", s_loadstats.decodetime / 1000.0);
+	if (s_loadstats.firstplays)
+		Com_Printf ("%i first plays, %i not preloaded, latency avg %.2f ms max %.2f ms\n", s_loadstats.firstplays, s_loadstats.cold,
+			s_loadstats.latency / 1000.0 / s_loadstats.firstplays, s_loadstats.maxlatency / 1000.0);
 }
 
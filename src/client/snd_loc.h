@@ -27,14 +27,39 @@ typedef struct
 	byte		data[1];		// variable sized
 } sfxcache_t;
 
+typedef enum
+{
+	SFX_UNLOADED,
+	SFX_LOADING,	// queued for or being decoded by the loader thread
+	SFX_LOADED,
+	SFX_FAILED		// not retried until the next S_EndRegistration
+} sfxloadstate_t;
+
 typedef struct sfx_s
 {
 	char 		name[MAX_QPATH];
 	int			registration_sequence;
 	sfxcache_t	*cache;
 	char 		*truename;
+
+	sfxloadstate_t	loadstate;
+	int			loadid;			// identifies the loader job for this sfx
+	int			decodetime;		// usec the loader spent on it
+	qboolean	requested;		// S_StartSound was called for it
+	long long	requesttime;	// Sys_Microseconds() of the first S_StartSound
+	int			firstplay;		// usec from the first S_StartSound until it could be mixed, -1 if not yet
 } sfx_t;
 
+typedef struct
+{
+	int			loaded;
+	long long	decodetime;		// usec, all loads
+	int			firstplays;		// sounds played at least once
+	int			cold;			// first plays of sounds that were not loaded yet
+	long long	latency;		// usec, all first plays
+	int			maxlatency;
+} sndloadstats_t;
+
 // a playsound_t will be generated by each call to S_StartSound,
 // when the mixer reaches playsound->begin, the playsound will
 // be assigned to a channel
@@ -114,15 +139,22 @@ void	SNDDMA_Submit(void);
 
 //====================================================================
 
+typedef struct
+{
+	vec3_t		origin;
+	vec3_t		forward;
+	vec3_t		right;
+	vec3_t		up;
+	int			entnum;		// sounds from this entity are not spatialized
+	qboolean	active;		// false while not connected, everything plays full volume
+} listener_t;
+
 #define	MAX_CHANNELS			32
 extern	channel_t   channels[MAX_CHANNELS];
 
 extern	int		paintedtime;
 extern	int		s_rawend;
-extern	vec3_t	listener_origin;
-extern	vec3_t	listener_forward;
-extern	vec3_t	listener_right;
-extern	vec3_t	listener_up;
+extern	listener_t	listener;
 extern	dma_t	dma;
 extern	playsound_t	s_pendingplays;
 
@@ -137,19 +169,33 @@ extern cvar_t	*s_show;
 extern cvar_t	*s_mixahead;
 extern cvar_t	*s_testsound;
 extern cvar_t	*s_primary;
+extern cvar_t	*s_simd;
+extern cvar_t	*s_async;
 
-wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength);
+extern sndloadstats_t	s_loadstats;
 
-void S_InitScaletable (void);
+void S_InitScaletable (float volume);
+void S_SelectMixKernels (void);
 
+// returns NULL while the sound is still being loaded in the background
 sfxcache_t *S_LoadSound (sfx_t *s);
 
+void S_InitLoader (void);
+void S_ShutdownLoader (void);
+void S_UpdateLoads (void);
+
+void S_NoteFirstPlay (sfx_t *sfx);
+void S_ReleaseDeferredPlays (sfx_t *sfx);
+
 void S_IssuePlaysound (playsound_t *ps);
+void S_InsertPlaysound (playsound_t *ps);
 
 void S_PaintChannels(int endtime);
+void S_MixBench_f(void);
 
 // picks a channel based on priorities, empty slots, number of channels
 channel_t *S_PickChannel(int entnum, int entchannel);
 
 // spatializes a channel
 void S_Spatialize(channel_t *ch);
+void S_SpatializeOrigin (listener_t *l, vec3_t origin, float master_vol, float dist_mult, int *left_vol, int *right_vol);
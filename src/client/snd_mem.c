@@ -17,33 +17,74 @@ int			cache_full_cycle;
 
 byte *S_Alloc (int size);
 
+/*
+===============================================================================
+
+BACKGROUND LOADER
+
+Sounds are read, parsed and resampled by a loader thread so a cache miss
+never stalls the mixer. The loader only touches its sndload_t, the file
+handle opened for it and malloc memory; everything that involves the
+filesystem search paths, the zone or sfx_t happens on the main thread in
+S_QueueLoad and S_FinishLoad. Without a thread the same jobs run inline.
+
+===============================================================================
+*/
+
+typedef struct sndload_s
+{
+	struct sndload_s	*next;
+
+	sfx_t		*sfx;
+	int			loadid;			// stale if sfx->loadid changed meanwhile
+	char		name[MAX_QPATH];
+	FILE		*file;
+	int			filelen;
+	int			outrate;		// dma.speed
+	qboolean	as8bit;			// s_loadas8bit
+
+	// results
+	sfxcache_t	*cache;			// malloc, NULL if the load failed
+	int			cachesize;
+	int			decodetime;		// usec
+	char		error[128];
+} sndload_t;
+
+static void			*s_loadthread;
+static void			*s_loadlock;
+static void			*s_loadsem;
+static sndload_t	*s_loadqueue, *s_loadqueue_tail;	// waiting for the loader
+static sndload_t	*s_loaddone;						// waiting for S_FinishLoad
+static qboolean		s_loadquit;
+static int			s_loadsequence;
+
+cvar_t		*s_async;
+sndloadstats_t	s_loadstats;
+
+static qboolean GetWavinfo (char *name, byte *wav, int wavlength, wavinfo_t *info, char *error, int errorsize);
+
 /*
 ================
 ResampleSfx
 ================
 */
-void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
+static void ResampleSfx (sfxcache_t *sc, int inrate, int inwidth, byte *data, int outrate, qboolean as8bit)
 {
 	int		outcount;
 	int		srcsample;
 	float	stepscale;
 	int		i;
 	int		sample, samplefrac, fracstep;
-	sfxcache_t	*sc;
-	
-	sc = sfx->cache;
-	if (!sc)
-		return;
 
-	stepscale = (float)inrate / dma.speed;	// this is usually 0.5, 1, or 2
+	stepscale = (float)inrate / outrate;	// this is usually 0.5, 1, or 2
 
 	outcount = sc->length / stepscale;
 	sc->length = outcount;
 	if (sc->loopstart != -1)
 		sc->loopstart = sc->loopstart / stepscale;
 
-	sc->speed = dma.speed;
-	if (s_loadas8bit->value)
+	sc->speed = outrate;
+	if (as8bit)
 		sc->width = 1;
 	else
 		sc->width = inwidth;
@@ -79,85 +120,355 @@ void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 	}
 }
 
-//=============================================================================
-
 /*
 ==============
-S_LoadSound
+S_DecodeSound
+
+Reads and resamples a queued sound, runs on the loader thread so it
+must not use the zone, the console or Com_Error
 ==============
 */
-sfxcache_t *S_LoadSound (sfx_t *s)
+static void S_DecodeSound (sndload_t *job)
 {
-    char	namebuffer[MAX_QPATH];
-	byte	*data;
+	byte		*data;
 	wavinfo_t	info;
-	int		len;
-	float	stepscale;
-	sfxcache_t	*sc;
-	int		size;
-	char	*name;
+	float		stepscale;
+	int			len;
+	long long	start;
 
-	if (s->name[0] == '*')
-		return NULL;
+	start = Sys_Microseconds ();
 
-// see if still in memory
-	sc = s->cache;
-	if (sc)
-		return sc;
+	data = malloc (job->filelen);
+	if (!data)
+	{
+		fclose (job->file);
+		Com_sprintf (job->error, sizeof(job->error), "out of memory");
+		return;
+	}
+
+	len = fread (data, 1, job->filelen, job->file);
+	fclose (job->file);
+	job->file = NULL;
+	if (len != job->filelen)
+	{
+		Com_sprintf (job->error, sizeof(job->error), "read error");
+		free (data);
+		return;
+	}
+
+	if (!GetWavinfo (job->name, data, len, &info, job->error, sizeof(job->error)))
+	{
+		free (data);
+		return;
+	}
+
+	if (info.channels != 1)
+	{
+		Com_sprintf (job->error, sizeof(job->error), "%s is a stereo sample", job->name);
+		free (data);
+		return;
+	}
+
+	stepscale = (float)info.rate / job->outrate;
+	len = info.samples / stepscale;
+
+	len = len * info.width * info.channels;
+
+	job->cachesize = len + sizeof(sfxcache_t);
+	job->cache = malloc (job->cachesize);
+	if (!job->cache)
+	{
+		Com_sprintf (job->error, sizeof(job->error), "out of memory");
+		free (data);
+		return;
+	}
+	memset (job->cache, 0, job->cachesize);
+
+	job->cache->length = info.samples;
+	job->cache->loopstart = info.loopstart;
+	job->cache->speed = info.rate;
+	job->cache->width = info.width;
+	job->cache->stereo = info.channels;
+
+	ResampleSfx (job->cache, info.rate, info.width, data + info.dataofs, job->outrate, job->as8bit);
+
+	free (data);
+
+	job->decodetime = (int)(Sys_Microseconds () - start);
+}
+
+/*
+==============
+S_LoaderThread
+==============
+*/
+static void S_LoaderThread (void *arg)
+{
+	sndload_t	*job;
+	qboolean	quit;
+
+	while (1)
+	{
+		Sys_WaitSemaphore (s_loadsem);
+
+		Sys_LockMutex (s_loadlock);
+		job = s_loadqueue;
+		if (job)
+		{
+			s_loadqueue = job->next;
+			if (!s_loadqueue)
+				s_loadqueue_tail = NULL;
+		}
+		quit = s_loadquit;
+		Sys_UnlockMutex (s_loadlock);
+
+		if (!job)
+		{
+			if (quit)
+				return;
+			continue;
+		}
+
+		S_DecodeSound (job);
+
+		Sys_LockMutex (s_loadlock);
+		job->next = s_loaddone;
+		s_loaddone = job;
+		Sys_UnlockMutex (s_loadlock);
+	}
+}
+
+/*
+==============
+S_FinishLoad
+
+Moves a decoded sound into the zone and releases the plays that
+were waiting for it
+==============
+*/
+static void S_FinishLoad (sndload_t *job)
+{
+	sfx_t	*sfx;
+
+	sfx = job->sfx;
+
+	// the sfx was freed by S_EndRegistration or queued again since
+	if (sfx->loadid != job->loadid || sfx->loadstate != SFX_LOADING)
+	{
+		free (job->cache);
+		Z_Free (job);
+		return;
+	}
+
+	if (!job->cache)
+	{
+		Com_Printf ("Couldn't load %s: %s\n", job->name, job->error);
+		sfx->loadstate = SFX_FAILED;
+	}
+	else
+	{
+		sfx->cache = Z_TagMalloc (job->cachesize, TAG_SOUND);
+		memcpy (sfx->cache, job->cache, job->cachesize);
+		sfx->decodetime = job->decodetime;
+		sfx->loadstate = SFX_LOADED;
+
+		s_loadstats.loaded++;
+		s_loadstats.decodetime += job->decodetime;
+		S_NoteFirstPlay (sfx);
+	}
+
+	S_ReleaseDeferredPlays (sfx);
+
+	free (job->cache);
+	Z_Free (job);
+}
+
+/*
+==============
+S_UpdateLoads
+
+Called every frame to pick up sounds the loader finished
+==============
+*/
+void S_UpdateLoads (void)
+{
+	sndload_t	*job, *next;
+
+	if (!s_loadthread)
+		return;
+
+	Sys_LockMutex (s_loadlock);
+	job = s_loaddone;
+	s_loaddone = NULL;
+	Sys_UnlockMutex (s_loadlock);
+
+	for ( ; job ; job = next)
+	{
+		next = job->next;
+		S_FinishLoad (job);
+	}
+}
+
+/*
+==============
+S_QueueLoad
+
+Opens the sound file and hands it to the loader, the sfx stays in
+SFX_LOADING until S_FinishLoad
+==============
+*/
+static void S_QueueLoad (sfx_t *s)
+{
+	char		namebuffer[MAX_QPATH];
+	char		*name;
+	sndload_t	*job;
+	FILE		*f;
+	int			len;
 
-//Com_Printf ("S_LoadSound: %x\n", (int)stackbuf);
-// load it in
 	if (s->truename)
 		name = s->truename;
 	else
 		name = s->name;
 
 	if (name[0] == '#')
-		strcpy(namebuffer, &name[1]);
+		Com_sprintf (namebuffer, sizeof(namebuffer), "%s", &name[1]);
 	else
 		Com_sprintf (namebuffer, sizeof(namebuffer), "sound/%s", name);
 
-//	Com_Printf ("loading %s\n",namebuffer);
+	len = FS_FOpenFile (namebuffer, &f);
+	if (!f)
+	{
+		Com_DPrintf (DP_SND, "Couldn't load %s\n", namebuffer);
+		s->loadstate = SFX_FAILED;
+		return;
+	}
 
-	size = FS_LoadFile (namebuffer, (void **)&data);
+	job = Z_Malloc (sizeof(*job));
+	job->sfx = s;
+	job->loadid = s->loadid = ++s_loadsequence;
+	strcpy (job->name, s->name);
+	job->file = f;
+	job->filelen = len;
+	job->outrate = dma.speed;
+	job->as8bit = s_loadas8bit->value ? true : false;
 
-	if (!data)
+	s->loadstate = SFX_LOADING;
+
+	if (!s_loadthread)
 	{
-		Com_DPrintf (DP_SND,"Couldn't load %s\n", namebuffer);
-		return NULL;
+		S_DecodeSound (job);
+		S_FinishLoad (job);
+		return;
 	}
 
-	info = GetWavinfo (s->name, data, size);
-	if (info.channels != 1)
-	{
-		Com_Printf ("%s is a stereo sample\n",s->name);
-		FS_FreeFile (data);
+	Sys_LockMutex (s_loadlock);
+	if (s_loadqueue_tail)
+		s_loadqueue_tail->next = job;
+	else
+		s_loadqueue = job;
+	s_loadqueue_tail = job;
+	Sys_UnlockMutex (s_loadlock);
+
+	Sys_PostSemaphore (s_loadsem);
+}
+
+/*
+==============
+S_LoadSound
+
+Returns the cached sound, or NULL while the loader is still working on
+it. Without a loader thread the sound is loaded before returning.
+==============
+*/
+sfxcache_t *S_LoadSound (sfx_t *s)
+{
+	if (s->name[0] == '*')
 		return NULL;
-	}
 
-	stepscale = (float)info.rate / dma.speed;	
-	len = info.samples / stepscale;
+// see if still in memory
+	if (s->cache)
+		return s->cache;
 
-	len = len * info.width * info.channels;
+	if (s->loadstate == SFX_UNLOADED)
+		S_QueueLoad (s);
+
+	return s->cache;
+}
 
-	sc = s->cache = Z_Malloc (len + sizeof(sfxcache_t));
-	if (!sc)
+/*
+==============
+S_InitLoader
+==============
+*/
+void S_InitLoader (void)
+{
+	s_async = Cvar_Get ("s_async", "1", CVAR_ARCHIVE, "Load sounds on a background thread, takes effect on snd_restart.");
+
+	memset (&s_loadstats, 0, sizeof(s_loadstats));
+	s_loadqueue = s_loadqueue_tail = s_loaddone = NULL;
+	s_loadquit = false;
+
+	if (!s_async->value)
+		return;
+
+	s_loadlock = Sys_CreateMutex ();
+	s_loadsem = Sys_CreateSemaphore (0);
+	if (s_loadlock && s_loadsem)
+		s_loadthread = Sys_CreateThread (S_LoaderThread, NULL);
+
+	if (!s_loadthread)
 	{
-		FS_FreeFile (data);
-		return NULL;
+		Com_Printf ("S_InitLoader: no loader thread, loading sounds inline\n");
+		if (s_loadlock)
+			Sys_DestroyMutex (s_loadlock);
+		if (s_loadsem)
+			Sys_DestroySemaphore (s_loadsem);
+		s_loadlock = s_loadsem = NULL;
 	}
-	
-	sc->length = info.samples;
-	sc->loopstart = info.loopstart;
-	sc->speed = info.rate;
-	sc->width = info.width;
-	sc->stereo = info.channels;
+}
+
+/*
+==============
+S_ShutdownLoader
+
+Stops the loader and drops everything it didn't finish
+==============
+*/
+void S_ShutdownLoader (void)
+{
+	sndload_t	*job, *next;
+
+	if (!s_loadthread)
+		return;
+
+	Sys_LockMutex (s_loadlock);
+	job = s_loadqueue;
+	s_loadqueue = s_loadqueue_tail = NULL;
+	s_loadquit = true;
+	Sys_UnlockMutex (s_loadlock);
+
+	Sys_PostSemaphore (s_loadsem);
+	Sys_WaitThread (s_loadthread);
+	s_loadthread = NULL;
 
-	ResampleSfx (s, sc->speed, sc->width, data + info.dataofs);
+	for ( ; job ; job = next)
+	{
+		next = job->next;
+		fclose (job->file);
+		Z_Free (job);
+	}
 
-	FS_FreeFile (data);
+	for (job = s_loaddone ; job ; job = next)
+	{
+		next = job->next;
+		free (job->cache);
+		Z_Free (job);
+	}
+	s_loaddone = NULL;
 
-	return sc;
+	Sys_DestroyMutex (s_loadlock);
+	Sys_DestroySemaphore (s_loadsem);
+	s_loadlock = s_loadsem = NULL;
 }
 
 
@@ -170,181 +481,177 @@ WAV loading
 ===============================================================================
 */
 
-
-byte	*data_p;
-byte 	*iff_end;
-byte 	*last_chunk;
-byte 	*iff_data;
-int 	iff_chunk_len;
+typedef struct
+{
+	byte	*data_p;
+	byte	*iff_end;
+	byte	*last_chunk;
+	byte	*iff_data;
+	int		iff_chunk_len;
+} iffparse_t;
 
 
-short GetLittleShort(void)
+static short GetLittleShort(iffparse_t *iff)
 {
 	short val = 0;
-	val = *data_p;
-	val = val + (*(data_p+1)<<8);
-	data_p += 2;
+	val = *iff->data_p;
+	val = val + (*(iff->data_p+1)<<8);
+	iff->data_p += 2;
 	return val;
 }
 
-int GetLittleLong(void)
+static int GetLittleLong(iffparse_t *iff)
 {
 	int val = 0;
-	val = *data_p;
-	val = val + (*(data_p+1)<<8);
-	val = val + (*(data_p+2)<<16);
-	val = val + (*(data_p+3)<<24);
-	data_p += 4;
+	val = *iff->data_p;
+	val = val + (*(iff->data_p+1)<<8);
+	val = val + (*(iff->data_p+2)<<16);
+	val = val + (*(iff->data_p+3)<<24);
+	iff->data_p += 4;
 	return val;
 }
 
-void FindNextChunk(char *name)
+static void FindNextChunk(iffparse_t *iff, char *name)
 {
 	while (1)
 	{
-		data_p=last_chunk;
+		iff->data_p=iff->last_chunk;
 
-		if (data_p >= iff_end)
+		if (iff->data_p >= iff->iff_end)
 		{	// didn't find the chunk
-			data_p = NULL;
+			iff->data_p = NULL;
 			return;
 		}
-		
-		data_p += 4;
-		iff_chunk_len = GetLittleLong();
-		if (iff_chunk_len < 0)
+
+		iff->data_p += 4;
+		iff->iff_chunk_len = GetLittleLong(iff);
+		if (iff->iff_chunk_len < 0)
 		{
-			data_p = NULL;
+			iff->data_p = NULL;
 			return;
 		}
 //		if (iff_chunk_len > 1024*1024)
 //			Sys_Error ("FindNextChunk: %i length is past the 1 meg sanity limit", iff_chunk_len);
-		data_p -= 8;
-		last_chunk = data_p + 8 + ( (iff_chunk_len + 1) & ~1 );
-		if (!strncmp(data_p, name, 4))
+		iff->data_p -= 8;
+		iff->last_chunk = iff->data_p + 8 + ( (iff->iff_chunk_len + 1) & ~1 );
+		if (!strncmp(iff->data_p, name, 4))
 			return;
 	}
 }
 
-void FindChunk(char *name)
-{
-	last_chunk = iff_data;
-	FindNextChunk (name);
-}
-
-
-void DumpChunks(void)
+static void FindChunk(iffparse_t *iff, char *name)
 {
-	char	str[5];
-	
-	str[4] = 0;
-	data_p=iff_data;
-	do
-	{
-		memcpy (str, data_p, 4);
-		data_p += 4;
-		iff_chunk_len = GetLittleLong();
-		Com_Printf ("0x%x : %s (%d)\n", (int)(data_p - 4), str, iff_chunk_len);
-		data_p += (iff_chunk_len + 1) & ~1;
-	} while (data_p < iff_end);
+	iff->last_chunk = iff->iff_data;
+	FindNextChunk (iff, name);
 }
 
 /*
 ============
 GetWavinfo
+
+Thread safe, problems are written to error instead of the console
 ============
 */
-wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
+static qboolean GetWavinfo (char *name, byte *wav, int wavlength, wavinfo_t *info, char *error, int errorsize)
 {
-	wavinfo_t	info;
+	iffparse_t	iff;
 	int     i;
 	int     format;
 	int		samples;
 
-	memset (&info, 0, sizeof(info));
+	memset (info, 0, sizeof(*info));
 
 	if (!wav)
-		return info;
-		
-	iff_data = wav;
-	iff_end = wav + wavlength;
+	{
+		Com_sprintf (error, errorsize, "no data");
+		return false;
+	}
+
+	iff.iff_data = wav;
+	iff.iff_end = wav + wavlength;
 
 // find "RIFF" chunk
-	FindChunk("RIFF");
-	if (!(data_p && !strncmp(data_p+8, "WAVE", 4)))
+	FindChunk(&iff, "RIFF");
+	if (!(iff.data_p && !strncmp(iff.data_p+8, "WAVE", 4)))
 	{
-		Com_Printf("Missing RIFF/WAVE chunks\n");
-		return info;
+		Com_sprintf (error, errorsize, "Missing RIFF/WAVE chunks");
+		return false;
 	}
 
 // get "fmt " chunk
-	iff_data = data_p + 12;
-// DumpChunks ();
+	iff.iff_data = iff.data_p + 12;
 
-	FindChunk("fmt ");
-	if (!data_p)
+	FindChunk(&iff, "fmt ");
+	if (!iff.data_p)
 	{
-		Com_Printf("Missing fmt chunk\n");
-		return info;
+		Com_sprintf (error, errorsize, "Missing fmt chunk");
+		return false;
 	}
-	data_p += 8;
-	format = GetLittleShort();
+	iff.data_p += 8;
+	format = GetLittleShort(&iff);
 	if (format != 1)
 	{
-		Com_Printf("Microsoft PCM format only\n");
-		return info;
+		Com_sprintf (error, errorsize, "Microsoft PCM format only");
+		return false;
 	}
 
-	info.channels = GetLittleShort();
-	info.rate = GetLittleLong();
-	data_p += 4+2;
-	info.width = GetLittleShort() / 8;
+	info->channels = GetLittleShort(&iff);
+	info->rate = GetLittleLong(&iff);
+	iff.data_p += 4+2;
+	info->width = GetLittleShort(&iff) / 8;
 
 // get cue chunk
-	FindChunk("cue ");
-	if (data_p)
+	FindChunk(&iff, "cue ");
+	if (iff.data_p)
 	{
-		data_p += 32;
-		info.loopstart = GetLittleLong();
-//		Com_Printf("loopstart=%d\n", sfx->loopstart);
+		iff.data_p += 32;
+		info->loopstart = GetLittleLong(&iff);
 
 	// if the next chunk is a LIST chunk, look for a cue length marker
-		FindNextChunk ("LIST");
-		if (data_p)
+		FindNextChunk (&iff, "LIST");
+		if (iff.data_p)
 		{
-			if (!strncmp (data_p + 28, "mark", 4))
+			if (!strncmp (iff.data_p + 28, "mark", 4))
 			{	// this is not a proper parse, but it works with cooledit...
-				data_p += 24;
-				i = GetLittleLong ();	// samples in loop
-				info.samples = info.loopstart + i;
-//				Com_Printf("looped length: %i\n", i);
+				iff.data_p += 24;
+				i = GetLittleLong (&iff);	// samples in loop
+				info->samples = info->loopstart + i;
 			}
 		}
 	}
 	else
-		info.loopstart = -1;
+		info->loopstart = -1;
 
 // find data chunk
-	FindChunk("data");
-	if (!data_p)
+	FindChunk(&iff, "data");
+	if (!iff.data_p)
 	{
-		Com_Printf("Missing data chunk\n");
-		return info;
+		Com_sprintf (error, errorsize, "Missing data chunk");
+		return false;
 	}
 
-	data_p += 4;
-	samples = GetLittleLong () / info.width;
+	if (!info->width)
+	{
+		Com_sprintf (error, errorsize, "bad sample width");
+		return false;
+	}
+
+	iff.data_p += 4;
+	samples = GetLittleLong (&iff) / info->width;
 
-	if (info.samples)
+	if (info->samples)
 	{
-		if (samples < info.samples)
-			Com_Error (ERR_DROP, "Sound %s has a bad loop length", name);
+		if (samples < info->samples)
+		{
+			Com_sprintf (error, errorsize, "Sound %s has a bad loop length", name);
+			return false;
+		}
 	}
 	else
-		info.samples = samples;
+		info->samples = samples;
+
+	info->dataofs = iff.data_p - wav;
 
-	info.dataofs = data_p - wav;
-	
-	return info;
+	return true;
 }
 
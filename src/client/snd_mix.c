@@ -13,38 +13,284 @@ See the attached GNU General Public License v2 for more details.
 #include "client.h"
 #include "snd_loc.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define SND_SIMD_X86 1
+	#include <immintrin.h>
+	#if defined(__GNUC__) || defined(__clang__)
+		#define SND_TARGET(x) __attribute__((target(x)))
+	#else
+		#define SND_TARGET(x)
+	#endif
+#endif
+
 #define	PAINTBUFFER_SIZE	2048
 portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE];
 int		snd_scaletable[32][256];
 int 	*snd_p, snd_linear_count, snd_vol;
 short	*snd_out;
 
-void S_WriteLinearBlastStereo16 (void);
+/*
+===============================================================================
 
-#if !(defined __linux__ && defined __i386__)
-void S_WriteLinearBlastStereo16 (void)
+MIXING KERNELS
+
+Every kernel set must produce output bit-exact with the scalar reference,
+s_mixbench verifies this. The 8 bit kernels receive a snd_scaletable row,
+SIMD versions only use lscale[1] which is the row's volume scale.
+
+===============================================================================
+*/
+
+typedef struct
 {
-	int		i;
-	int		val;
+	char	*name;
+	int		cpuflags; // CPU_* required
+
+	// adds count 8 bit samples scaled by lscale/rscale to samp
+	void	(*paint8)(portable_samplepair_t *samp, const unsigned char *sfx, int count, const int *lscale, const int *rscale);
 
-	for (i=0 ; i<snd_linear_count ; i+=2)
+	// adds count 16 bit samples scaled by (leftvol,rightvol)>>8 to samp
+	void	(*paint16)(portable_samplepair_t *samp, const short *sfx, int count, int leftvol, int rightvol);
+
+	// writes count samples of in>>8 clamped to 16 bits into out
+	void	(*clip16)(short *out, const int *in, int count);
+} mixkernels_t;
+
+static void S_Paint8_C(portable_samplepair_t *samp, const unsigned char *sfx, int count, const int *lscale, const int *rscale)
+{
+	int		i, data;
+
+	for (i = 0; i < count; i++, samp++)
 	{
-		val = snd_p[i]>>8;
-		if (val > 0x7fff)
-			snd_out[i] = 0x7fff;
-		else if (val < (short)0x8000)
-			snd_out[i] = (short)0x8000;
-		else
-			snd_out[i] = val;
+		data = sfx[i];
+		samp->left += lscale[data];
+		samp->right += rscale[data];
+	}
+}
+
+static void S_Paint16_C(portable_samplepair_t *samp, const short *sfx, int count, int leftvol, int rightvol)
+{
+	int		i, data;
 
-		val = snd_p[i+1]>>8;
+	for (i = 0; i < count; i++, samp++)
+	{
+		data = sfx[i];
+		samp->left += (data * leftvol) >> 8;
+		samp->right += (data * rightvol) >> 8;
+	}
+}
+
+static void S_Clip16_C(short *out, const int *in, int count)
+{
+	int		i, val;
+
+	for (i = 0; i < count; i++)
+	{
+		val = in[i] >> 8;
 		if (val > 0x7fff)
-			snd_out[i+1] = 0x7fff;
+			out[i] = 0x7fff;
 		else if (val < (short)0x8000)
-			snd_out[i+1] = (short)0x8000;
+			out[i] = (short)0x8000;
 		else
-			snd_out[i+1] = val;
+			out[i] = val;
+	}
+}
+
+#ifdef SND_SIMD_X86
+/*
+SSE2 has no 32 bit mullo, the low halves of two 32x32->64 multiplies are
+recombined instead, which is the same modulo 2^32 as the scalar code
+*/
+SND_TARGET("sse2") static __m128i S_MulLo32_SSE2(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// d holds 4 mono samples, adds them scaled by vol (L,R,L,R) to 4 stereo pairs
+SND_TARGET("sse2") static void S_Accumulate4_SSE2(portable_samplepair_t *samp, __m128i d, __m128i vol, int shift)
+{
+	__m128i lo, hi;
+
+	lo = S_MulLo32_SSE2(_mm_unpacklo_epi32(d, d), vol);
+	hi = S_MulLo32_SSE2(_mm_unpackhi_epi32(d, d), vol);
+	if (shift)
+	{
+		lo = _mm_srai_epi32(lo, 8);
+		hi = _mm_srai_epi32(hi, 8);
+	}
+
+	lo = _mm_add_epi32(lo, _mm_loadu_si128((__m128i*)samp));
+	hi = _mm_add_epi32(hi, _mm_loadu_si128((__m128i*)(samp + 2)));
+	_mm_storeu_si128((__m128i*)samp, lo);
+	_mm_storeu_si128((__m128i*)(samp + 2), hi);
+}
+
+SND_TARGET("sse2") static void S_Paint8_SSE2(portable_samplepair_t *samp, const unsigned char *sfx, int count, const int *lscale, const int *rscale)
+{
+	__m128i	vol, d;
+	int		i, packed;
+
+	vol = _mm_setr_epi32(lscale[1], rscale[1], lscale[1], rscale[1]);
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		memcpy(&packed, sfx + i, 4);
+		d = _mm_cvtsi32_si128(packed);
+		d = _mm_unpacklo_epi8(d, d);
+		d = _mm_unpacklo_epi16(d, d);
+		d = _mm_srai_epi32(d, 24); // sign extend
+		S_Accumulate4_SSE2(samp + i, d, vol, 0);
+	}
+	S_Paint8_C(samp + i, sfx + i, count - i, lscale, rscale);
+}
+
+SND_TARGET("sse2") static void S_Paint16_SSE2(portable_samplepair_t *samp, const short *sfx, int count, int leftvol, int rightvol)
+{
+	__m128i	vol, d;
+	int		i;
+
+	vol = _mm_setr_epi32(leftvol, rightvol, leftvol, rightvol);
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		d = _mm_loadl_epi64((const __m128i*)(sfx + i));
+		d = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16); // sign extend
+		S_Accumulate4_SSE2(samp + i, d, vol, 1);
+	}
+	S_Paint16_C(samp + i, sfx + i, count - i, leftvol, rightvol);
+}
+
+SND_TARGET("sse2") static void S_Clip16_SSE2(short *out, const int *in, int count)
+{
+	__m128i	a, b;
+	int		i;
+
+	// packs saturates exactly like the scalar clamp
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(in + i)), 8);
+		b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(in + i + 4)), 8);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+	}
+	S_Clip16_C(out + i, in + i, count - i);
+}
+
+// d holds 8 mono samples, adds them scaled by vol (L,R,...) to 8 stereo pairs
+SND_TARGET("avx2") static void S_Accumulate8_AVX2(portable_samplepair_t *samp, __m256i d, __m256i vol, int shift)
+{
+	__m256i lo, hi;
+
+	lo = _mm256_permutevar8x32_epi32(d, _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+	hi = _mm256_permutevar8x32_epi32(d, _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7));
+	lo = _mm256_mullo_epi32(lo, vol);
+	hi = _mm256_mullo_epi32(hi, vol);
+	if (shift)
+	{
+		lo = _mm256_srai_epi32(lo, 8);
+		hi = _mm256_srai_epi32(hi, 8);
 	}
+
+	lo = _mm256_add_epi32(lo, _mm256_loadu_si256((__m256i*)samp));
+	hi = _mm256_add_epi32(hi, _mm256_loadu_si256((__m256i*)(samp + 4)));
+	_mm256_storeu_si256((__m256i*)samp, lo);
+	_mm256_storeu_si256((__m256i*)(samp + 4), hi);
+}
+
+SND_TARGET("avx2") static void S_Paint8_AVX2(portable_samplepair_t *samp, const unsigned char *sfx, int count, const int *lscale, const int *rscale)
+{
+	__m256i	vol, d;
+	int		i;
+
+	vol = _mm256_setr_epi32(lscale[1], rscale[1], lscale[1], rscale[1], lscale[1], rscale[1], lscale[1], rscale[1]);
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		d = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(sfx + i)));
+		S_Accumulate8_AVX2(samp + i, d, vol, 0);
+	}
+	S_Paint8_C(samp + i, sfx + i, count - i, lscale, rscale);
+}
+
+SND_TARGET("avx2") static void S_Paint16_AVX2(portable_samplepair_t *samp, const short *sfx, int count, int leftvol, int rightvol)
+{
+	__m256i	vol, d;
+	int		i;
+
+	vol = _mm256_setr_epi32(leftvol, rightvol, leftvol, rightvol, leftvol, rightvol, leftvol, rightvol);
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		d = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(sfx + i)));
+		S_Accumulate8_AVX2(samp + i, d, vol, 1);
+	}
+	S_Paint16_C(samp + i, sfx + i, count - i, leftvol, rightvol);
+}
+
+SND_TARGET("avx2") static void S_Clip16_AVX2(short *out, const int *in, int count)
+{
+	__m256i	a, b;
+	int		i;
+
+	// packs works within 128 bit lanes, the permute restores sample order
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		a = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(in + i)), 8);
+		b = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(in + i + 8)), 8);
+		a = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)(out + i), a);
+	}
+	S_Clip16_SSE2(out + i, in + i, count - i);
+}
+#endif /*SND_SIMD_X86*/
+
+// ordered from slowest to fastest, scalar must stay first
+static const mixkernels_t mixKernels[] =
+{
+	{ "scalar", 0, S_Paint8_C, S_Paint16_C, S_Clip16_C },
+#ifdef SND_SIMD_X86
+	{ "sse2", CPU_SSE2, S_Paint8_SSE2, S_Paint16_SSE2, S_Clip16_SSE2 },
+	{ "avx2", CPU_SSE2 | CPU_AVX2, S_Paint8_AVX2, S_Paint16_AVX2, S_Clip16_AVX2 },
+#endif
+};
+#define NUM_MIX_KERNELS (int)(sizeof(mixKernels) / sizeof(mixKernels[0]))
+
+static const mixkernels_t *mix = &mixKernels[0];
+
+/*
+===================
+S_SelectMixKernels
+
+s_simd 0 forces the scalar mixer, 1 picks the fastest set this CPU supports
+===================
+*/
+void S_SelectMixKernels(void)
+{
+	int		i, cpu;
+
+	s_simd->modified = false;
+
+	cpu = COM_CPUFeatures();
+	mix = &mixKernels[0];
+	if (s_simd->value)
+	{
+		for (i = NUM_MIX_KERNELS - 1; i > 0; i--)
+		{
+			if ((cpu & mixKernels[i].cpuflags) == mixKernels[i].cpuflags)
+			{
+				mix = &mixKernels[i];
+				break;
+			}
+		}
+	}
+
+	Com_DPrintf(DP_SND, "sound mixer: %s\n", mix->name);
+}
+
+void S_WriteLinearBlastStereo16 (void);
+
+#if !(defined __linux__ && defined __i386__)
+void S_WriteLinearBlastStereo16 (void)
+{
+	mix->clip16(snd_out, snd_p, snd_linear_count);
 }
 #endif
 
@@ -173,8 +419,6 @@ void S_PaintChannels(int endtime)
 	int		ltime, count;
 	playsound_t	*ps;
 
-	snd_vol = s_volume->value*256;
-
 //Com_Printf ("%i to %i\n", paintedtime, endtime);
 	while (paintedtime < endtime)
 	{
@@ -248,7 +492,9 @@ void S_PaintChannels(int endtime)
 				if (ch->end - ltime < count)
 					count = ch->end - ltime;
 		
-				sc = S_LoadSound (ch->sfx);
+				// never load from the mixer, S_StartSound holds
+				// plays back until their sound is cached
+				sc = ch->sfx->cache;
 				if (!sc)
 					break;
 
@@ -290,29 +536,31 @@ void S_PaintChannels(int endtime)
 	}
 }
 
-void S_InitScaletable (void)
+static void S_BuildScaletable (int table[32][256], float volume)
 {
 	int		i, j;
 	int		scale;
 
-	s_volume->modified = false;
 	for (i=0 ; i<32 ; i++)
 	{
-		scale = i * 8 * 256 * s_volume->value;
+		scale = i * 8 * 256 * volume;
 		for (j=0 ; j<256 ; j++)
-			snd_scaletable[i][j] = ((signed char)j) * scale;
+			table[i][j] = ((signed char)j) * scale;
 	}
 }
 
+void S_InitScaletable (float volume)
+{
+	snd_vol = volume*256;
+	S_BuildScaletable (snd_scaletable, volume);
+}
+
 
 #if !(defined __linux__ && defined __i386__)
 void S_PaintChannelFrom8 (channel_t *ch, sfxcache_t *sc, int count, int offset)
 {
-	int 	data;
 	int		*lscale, *rscale;
 	unsigned char *sfx;
-	int		i;
-	portable_samplepair_t	*samp;
 
 	if (ch->leftvol > 255)
 		ch->leftvol = 255;
@@ -321,16 +569,9 @@ void S_PaintChannelFrom8 (channel_t *ch, sfxcache_t *sc, int count, int offset)
 		
 	lscale = snd_scaletable[ ch->leftvol >> 11];
 	rscale = snd_scaletable[ ch->rightvol >> 11];
-	sfx = (signed char *)sc->data + ch->pos;
-
-	samp = &paintbuffer[offset];
+	sfx = (unsigned char *)sc->data + ch->pos;
 
-	for (i=0 ; i<count ; i++, samp++)
-	{
-		data = sfx[i];
-		samp->left += lscale[data];
-		samp->right += rscale[data];
-	}
+	mix->paint8(&paintbuffer[offset], sfx, count, lscale, rscale);
 	
 	ch->pos += count;
 }
@@ -338,27 +579,136 @@ void S_PaintChannelFrom8 (channel_t *ch, sfxcache_t *sc, int count, int offset)
 
 void S_PaintChannelFrom16 (channel_t *ch, sfxcache_t *sc, int count, int offset)
 {
-	int data;
-	int left, right;
 	int leftvol, rightvol;
 	signed short *sfx;
-	int	i;
-	portable_samplepair_t	*samp;
 
 	leftvol = ch->leftvol*snd_vol;
 	rightvol = ch->rightvol*snd_vol;
 	sfx = (signed short *)sc->data + ch->pos;
 
-	samp = &paintbuffer[offset];
-	for (i=0 ; i<count ; i++, samp++)
+	mix->paint16(&paintbuffer[offset], sfx, count, leftvol, rightvol);
+
+	ch->pos += count;
+}
+
+
+/*
+===============================================================================
+
+MIXING BENCHMARK
+
+===============================================================================
+*/
+
+#define MIXBENCH_SAMPLES	(PAINTBUFFER_SIZE + 7) // odd length exercises the scalar tails
+
+/*
+===================
+S_MixBenchRun
+
+Mixes MAX_CHANNELS synthetic voices, half 8 bit and half 16 bit, with
+varying volumes into paint and clips it to out, returns microseconds
+===================
+*/
+static long long S_MixBenchRun(const mixkernels_t *k, int iterations, int scaletable[32][256], int vol16, const unsigned char *sfx8, const short *sfx16, portable_samplepair_t *paint, short *out)
+{
+	int			i, ch, vol;
+	long long	start;
+
+	start = Sys_Microseconds();
+	for (i = 0; i < iterations; i++)
 	{
-		data = sfx[i];
-		left = (data * leftvol)>>8;
-		right = (data * rightvol)>>8;
-		samp->left += left;
-		samp->right += right;
+		memset(paint, 0, MIXBENCH_SAMPLES * sizeof(*paint));
+		for (ch = 0; ch < MAX_CHANNELS; ch++)
+		{
+			vol = (ch * 37 + i) & 255;
+			if (ch & 1)
+				k->paint8(paint, sfx8 + ch, MIXBENCH_SAMPLES, scaletable[vol >> 3], scaletable[(255 - vol) >> 3]);
+			else
+				k->paint16(paint, sfx16 + ch, MIXBENCH_SAMPLES, vol * vol16, (255 - vol) * vol16);
+		}
+		k->clip16(out, (int*)paint, MIXBENCH_SAMPLES * 2);
 	}
+	return Sys_Microseconds() - start;
+}
 
-	ch->pos += count;
+/*
+===================
+S_MixBench_f
+
+s_mixbench [iterations]
+Runs every kernel set the CPU supports through the same mix and checks the
+result is bit-exact with the scalar mixer, works without a sound device
+===================
+*/
+void S_MixBench_f(void)
+{
+	unsigned char			*sfx8;
+	short					*sfx16;
+	portable_samplepair_t	*refpaint, *paint;
+	short					*refout, *out;
+	long long				time, reftime = 0;
+	int						(*scaletable)[256];
+	int						i, iterations, cpu, seed, vol16;
+	qboolean				exact;
+
+	iterations = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 200;
+	if (iterations < 1)
+		iterations = 1;
+
+	// a private table, the mixer thread may be reading snd_scaletable and snd_vol
+	scaletable = Z_Malloc(sizeof(snd_scaletable));
+	S_BuildScaletable(scaletable, s_volume->value);
+	vol16 = s_volume->value * 256;
+
+	sfx8 = Z_Malloc(MIXBENCH_SAMPLES + MAX_CHANNELS);
+	sfx16 = Z_Malloc((MIXBENCH_SAMPLES + MAX_CHANNELS) * sizeof(short));
+	refpaint = Z_Malloc(MIXBENCH_SAMPLES * sizeof(portable_samplepair_t));
+	paint = Z_Malloc(MIXBENCH_SAMPLES * sizeof(portable_samplepair_t));
+	refout = Z_Malloc(MIXBENCH_SAMPLES * 2 * sizeof(short));
+	out = Z_Malloc(MIXBENCH_SAMPLES * 2 * sizeof(short));
+
+	// full scale noise so the clipper saturates too
+	seed = 0x1234567;
+	for (i = 0; i < MIXBENCH_SAMPLES + MAX_CHANNELS; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		sfx8[i] = (seed >> 16) & 255;
+		sfx16[i] = (short)(seed >> 8);
+	}
+
+	cpu = COM_CPUFeatures();
+	Com_Printf("mixing %i channels x %i samples, %i iterations\n", MAX_CHANNELS, MIXBENCH_SAMPLES, iterations);
+	for (i = 0; i < NUM_MIX_KERNELS; i++)
+	{
+		if ((cpu & mixKernels[i].cpuflags) != mixKernels[i].cpuflags)
+		{
+			Com_Printf("%8s: not supported by this CPU\n", mixKernels[i].name);
+			continue;
+		}
+
+		if (i == 0)
+		{
+			reftime = S_MixBenchRun(&mixKernels[i], iterations, scaletable, vol16, sfx8, sfx16, refpaint, refout);
+			time = reftime;
+			exact = true;
+		}
+		else
+		{
+			time = S_MixBenchRun(&mixKernels[i], iterations, scaletable, vol16, sfx8, sfx16, paint, out);
+			exact = !memcmp(paint, refpaint, MIXBENCH_SAMPLES * sizeof(portable_samplepair_t)) && !memcmp(out, refout, MIXBENCH_SAMPLES * 2 * sizeof(short));
+		}
+
+		Com_Printf("%8s: %8.3f ms, %5.2fx %s%s\n", mixKernels[i].name, time / 1000.0, time ? (double)reftime / time : 0.0,
+			exact ? "bit-exact" : "MISMATCH", &mixKernels[i] == mix ? " (active)" : "");
+	}
+
+	Z_Free(sfx8);
+	Z_Free(sfx16);
+	Z_Free(refpaint);
+	Z_Free(paint);
+	Z_Free(refout);
+	Z_Free(out);
+	Z_Free(scaletable);
 }
 
@@ -60,7 +60,7 @@ void UI_AddAction(char* cmd_name, xcommand_t function, scr_func_t progfunc)
 	}
 
 	cmd = Z_Malloc(sizeof(ui_action_t));
-	cmd->name = cmd_name;
+	cmd->name = CopyString(cmd_name); // may be a temporary qc string
 
 	cmd->function = function;
 	cmd->progsFunc = progfunc;
@@ -79,6 +79,7 @@ void UI_RemoveActions()
 {
 	for (int i = 0; i < ui_actions_count; i++)
 	{
+		Z_Free(ui_actions[i]->name);
 		Z_Free(ui_actions[i]);
 		ui_actions[i] = NULL;
 	}
@@ -292,6 +292,8 @@ void UI_Draw()
 				Scr_Execute(VM_GUI, ui.script_globals->Callback_GenericItemDraw, __FUNCTION__);
 		}
 	}
+
+	Scr_CollectStrings(VM_GUI);
 }
 
 /*
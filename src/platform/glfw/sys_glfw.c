@@ -89,10 +89,81 @@ int		Sys_Milliseconds (void)
 	return 0;
 }
 
+long long	Sys_Microseconds (void)
+{
+	return 0;
+}
+
+void	*Sys_CreateThread (threadfunc_t func, void *arg)
+{
+	return NULL;
+}
+
+void	Sys_WaitThread (void *thread)
+{
+}
+
+void	*Sys_CreateMutex (void)
+{
+	return NULL;
+}
+
+void	Sys_DestroyMutex (void *mutex)
+{
+}
+
+void	Sys_LockMutex (void *mutex)
+{
+}
+
+void	Sys_UnlockMutex (void *mutex)
+{
+}
+
+void	*Sys_CreateSemaphore (int count)
+{
+	return NULL;
+}
+
+void	Sys_DestroySemaphore (void *sem)
+{
+}
+
+void	Sys_PostSemaphore (void *sem)
+{
+}
+
+void	Sys_WaitSemaphore (void *sem)
+{
+}
+
+int		Sys_AtomicAdd (volatile int *value, int add)
+{
+	return *value += add;
+}
+
+void	Sys_Sleep (int msec)
+{
+}
+
 void	Sys_Mkdir (char *path)
 {
 }
 
+void	*Sys_LoadLibrary (const char *path)
+{
+	return NULL;
+}
+
+void	*Sys_GetProcAddress (void *lib, const char *name)
+{
+	return NULL;
+}
+
+void	Sys_FreeLibrary (void *lib)
+{
+}
+
 char	*Sys_FindFirst (char *path, unsigned musthave, unsigned canthave)
 {
 	return NULL;
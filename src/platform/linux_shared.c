@@ -27,7 +27,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/time.h>
+#include <time.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <dlfcn.h>
 
 //#include "../linux/glob.h"
 
@@ -282,11 +286,174 @@ int Sys_Milliseconds (void)
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+long long Sys_Microseconds (void)
+{
+	struct timespec	ts;
+	static long long	base;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	if (!base)
+		base = (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 - base;
+}
+
+/*
+===============================================================================
+
+THREADS
+
+===============================================================================
+*/
+
+typedef struct
+{
+	threadfunc_t	func;
+	void			*arg;
+} threadstart_t;
+
+static void *Sys_ThreadStart (void *param)
+{
+	threadstart_t	start;
+
+	start = *(threadstart_t *)param;
+	free (param);
+
+	start.func (start.arg);
+	return NULL;
+}
+
+void *Sys_CreateThread (threadfunc_t func, void *arg)
+{
+	threadstart_t	*start;
+	pthread_t		*thread;
+
+	start = malloc (sizeof(*start));
+	thread = malloc (sizeof(*thread));
+	if (!start || !thread)
+	{
+		free (start);
+		free (thread);
+		return NULL;
+	}
+	start->func = func;
+	start->arg = arg;
+
+	if (pthread_create (thread, NULL, Sys_ThreadStart, start))
+	{
+		free (start);
+		free (thread);
+		return NULL;
+	}
+	return thread;
+}
+
+void Sys_WaitThread (void *thread)
+{
+	pthread_join (*(pthread_t *)thread, NULL);
+	free (thread);
+}
+
+void *Sys_CreateMutex (void)
+{
+	pthread_mutex_t	*mutex;
+
+	mutex = malloc (sizeof(*mutex));
+	if (mutex && pthread_mutex_init (mutex, NULL))
+	{
+		free (mutex);
+		return NULL;
+	}
+	return mutex;
+}
+
+void Sys_DestroyMutex (void *mutex)
+{
+	pthread_mutex_destroy ((pthread_mutex_t *)mutex);
+	free (mutex);
+}
+
+void Sys_LockMutex (void *mutex)
+{
+	pthread_mutex_lock ((pthread_mutex_t *)mutex);
+}
+
+void Sys_UnlockMutex (void *mutex)
+{
+	pthread_mutex_unlock ((pthread_mutex_t *)mutex);
+}
+
+void *Sys_CreateSemaphore (int count)
+{
+	sem_t	*sem;
+
+	sem = malloc (sizeof(*sem));
+	if (sem && sem_init (sem, 0, count))
+	{
+		free (sem);
+		return NULL;
+	}
+	return sem;
+}
+
+void Sys_DestroySemaphore (void *sem)
+{
+	sem_destroy ((sem_t *)sem);
+	free (sem);
+}
+
+void Sys_PostSemaphore (void *sem)
+{
+	sem_post ((sem_t *)sem);
+}
+
+void Sys_WaitSemaphore (void *sem)
+{
+	while (sem_wait ((sem_t *)sem) && errno == EINTR)
+		;
+}
+
+int Sys_AtomicAdd (volatile int *value, int add)
+{
+	return __atomic_add_fetch (value, add, __ATOMIC_SEQ_CST);
+}
+
+void Sys_Sleep (int msec)
+{
+	struct timespec	ts;
+
+	ts.tv_sec = msec / 1000;
+	ts.tv_nsec = (msec % 1000) * 1000000;
+	while (nanosleep (&ts, &ts) && errno == EINTR)
+		;
+}
+
 void Sys_Mkdir (char *path)
 {
     mkdir (path, 0777);
 }
 
+void *Sys_LoadLibrary (const char *path)
+{
+	return dlopen (path, RTLD_NOW);
+}
+
+void *Sys_GetProcAddress (void *lib, const char *name)
+{
+	return dlsym (lib, name);
+}
+
+void Sys_FreeLibrary (void *lib)
+{
+	dlclose (lib);
+}
+
 char *strlwr (char *s)
 {
 	while (*s) {
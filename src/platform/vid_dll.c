@@ -530,6 +530,19 @@ unsigned int _GetBSPElementSize(bspDataType type, qboolean extendedbsp)
 	bExtendedBSP = old;
 	return ret;
 }
+
+/*
+==============
+VID_MemAlloc
+
+Everything the renderer allocates is counted under one tag
+==============
+*/
+static void *VID_MemAlloc (int size)
+{
+	return Z_TagMalloc (size, TAG_RENDERER);
+}
+
 /*
 ==============
 VID_LoadRefresh
@@ -555,7 +568,7 @@ qboolean VID_LoadRefresh( char *name )
 		return false;
 	}
 
-	ri.MemAlloc = Z_Malloc;
+	ri.MemAlloc = VID_MemAlloc;
 	ri.MemFree = Z_Free;
 
 	ri.AddCommand = Cmd_AddCommand;
@@ -133,11 +133,156 @@ int Sys_Milliseconds (void)
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+long long Sys_Microseconds (void)
+{
+	static LARGE_INTEGER	freq, base;
+	LARGE_INTEGER			now;
+	long long				delta;
+
+	if (!freq.QuadPart)
+	{
+		QueryPerformanceFrequency (&freq);
+		QueryPerformanceCounter (&base);
+	}
+	QueryPerformanceCounter (&now);
+
+	// split so it doesn't overflow on long running servers
+	delta = now.QuadPart - base.QuadPart;
+	return (delta / freq.QuadPart) * 1000000 + (delta % freq.QuadPart) * 1000000 / freq.QuadPart;
+}
+
+/*
+===============================================================================
+
+THREADS
+
+===============================================================================
+*/
+
+typedef struct
+{
+	threadfunc_t	func;
+	void			*arg;
+} threadstart_t;
+
+static DWORD WINAPI Sys_ThreadStart (LPVOID param)
+{
+	threadstart_t	start;
+
+	start = *(threadstart_t *)param;
+	free (param);
+
+	start.func (start.arg);
+	return 0;
+}
+
+void *Sys_CreateThread (threadfunc_t func, void *arg)
+{
+	threadstart_t	*start;
+	HANDLE			thread;
+
+	start = malloc (sizeof(*start));
+	if (!start)
+		return NULL;
+	start->func = func;
+	start->arg = arg;
+
+	thread = CreateThread (NULL, 0, Sys_ThreadStart, start, 0, NULL);
+	if (!thread)
+	{
+		free (start);
+		return NULL;
+	}
+	return thread;
+}
+
+void Sys_WaitThread (void *thread)
+{
+	WaitForSingleObject ((HANDLE)thread, INFINITE);
+	CloseHandle ((HANDLE)thread);
+}
+
+void *Sys_CreateMutex (void)
+{
+	CRITICAL_SECTION	*cs;
+
+	cs = malloc (sizeof(*cs));
+	if (cs)
+		InitializeCriticalSection (cs);
+	return cs;
+}
+
+void Sys_DestroyMutex (void *mutex)
+{
+	DeleteCriticalSection ((CRITICAL_SECTION *)mutex);
+	free (mutex);
+}
+
+void Sys_LockMutex (void *mutex)
+{
+	EnterCriticalSection ((CRITICAL_SECTION *)mutex);
+}
+
+void Sys_UnlockMutex (void *mutex)
+{
+	LeaveCriticalSection ((CRITICAL_SECTION *)mutex);
+}
+
+void *Sys_CreateSemaphore (int count)
+{
+	return CreateSemaphore (NULL, count, 0x7fffffff, NULL);
+}
+
+void Sys_DestroySemaphore (void *sem)
+{
+	CloseHandle ((HANDLE)sem);
+}
+
+void Sys_PostSemaphore (void *sem)
+{
+	ReleaseSemaphore ((HANDLE)sem, 1, NULL);
+}
+
+void Sys_WaitSemaphore (void *sem)
+{
+	WaitForSingleObject ((HANDLE)sem, INFINITE);
+}
+
+int Sys_AtomicAdd (volatile int *value, int add)
+{
+	return InterlockedExchangeAdd ((volatile LONG *)value, add) + add;
+}
+
+void Sys_Sleep (int msec)
+{
+	Sleep (msec);
+}
+
 void Sys_Mkdir (char *path)
 {
 	_mkdir (path);
 }
 
+void *Sys_LoadLibrary (const char *path)
+{
+	return LoadLibrary (path);
+}
+
+void *Sys_GetProcAddress (void *lib, const char *name)
+{
+	return (void *)GetProcAddress ((HMODULE)lib, name);
+}
+
+void Sys_FreeLibrary (void *lib)
+{
+	FreeLibrary ((HMODULE)lib);
+}
+
 //============================================
 
 static char		findbase[MAX_OSPATH];
@@ -734,7 +734,7 @@ void Cmd_AddCommandCG(char* cmd_name, scr_func_t function)
 	}
 
 	cmd = Z_Malloc(sizeof(cmd_function_t));
-	cmd->name = cmd_name;
+	cmd->name = CopyString(cmd_name); // may be a temporary qc string
 	cmd->prfunction = function;
 	cmd->next = cmd_functions;
 	cmd_functions = cmd;
@@ -758,9 +758,11 @@ void	Cmd_RemoveCommand (char *cmd_name)
 			Com_Printf ("Cmd_RemoveCommand: %s not added\n", cmd_name);
 			return;
 		}
-		if (cmd->prfunction == -1 && !strcmp (cmd_name, cmd->name)) // workaround for crash when name is set to progstring but qcvm is already destroyed
+		if (!strcmp (cmd_name, cmd->name))
 		{
 			*back = cmd->next;
+			if (cmd->prfunction != -1)
+				Z_Free (cmd->name); // copied by Cmd_AddCommandCG
 			Z_Free (cmd);
 			return;
 		}
@@ -789,8 +791,9 @@ void Cmd_RemoveClientGameCommands()
 		if(cmd->prfunction != -1)
 		{
 			*back = cmd->next;
+			Z_Free(cmd->name);
 			Z_Free(cmd);
-			return;
+			continue;
 		}
 		back = &cmd->next;
 	}
@@ -87,10 +87,13 @@ static int			checkcount;
 static mapsurface_t	nullsurface;
 static int			emptyleaf, solidleaf;
 
-static int			leaf_count, leaf_maxcount;
-static int			*leaf_list;
-static float		*leaf_mins, *leaf_maxs;
-static int			leaf_topnode;
+typedef struct
+{
+	int			count, maxcount;
+	int			*list;
+	float		*mins, *maxs;
+	int			topnode;
+} cmleafs_t;
 
 static cmodel_t		null_inline_model; // for cinematic servers
 
@@ -108,22 +111,22 @@ typedef struct
 	mapsurface_t* surfaceInfos;	//[MAX_MAP_TEXINFO_QBSP]
 
 	int			numPlanes;
-	cplane_t	*planes;		//[MAX_MAP_PLANES_QBSP] + 12 extra for box hull
+	cplane_t	*planes;		//[MAX_MAP_PLANES_QBSP] + 12 extra for each box hull
 
 	int			numNodes;
-	cnode_t		*nodes;			//[MAX_MAP_NODES_QBSP] + 6 extra for box hull
+	cnode_t		*nodes;			//[MAX_MAP_NODES_QBSP] + 6 extra for each box hull
 
 	int			numLeafs;
-	cleaf_t		*leafs;			//[MAX_MAP_LEAFS_QBSP]
+	cleaf_t		*leafs;			//[MAX_MAP_LEAFS_QBSP] + 1 extra for each box hull
 
 	int			numLeafBrushes;
-	unsigned int* leafBrushes;	//[MAX_MAP_LEAFBRUSHES_QBSP] + 1 extra for box hull
+	unsigned int* leafBrushes;	//[MAX_MAP_LEAFBRUSHES_QBSP] + 1 extra for each box hull
 
 	int			numInlineModels;
 	cmodel_t	*inlineModels;	//[MAX_MAP_MODELS_QBSP]
 
 	int			numBrushes;
-	cbrush_t	*brushes;		//[MAX_MAP_BRUSHES_QBSP] + 1 extra for box hull
+	cbrush_t	*brushes;		//[MAX_MAP_BRUSHES_QBSP] + 1 extra for each box hull
 
 	int			visibilitySize;
 	byte		*visibility;	//[MAX_MAP_VISIBILITY_QBSP]
@@ -300,7 +303,7 @@ static void CMod_LoadNodes(lump_t *l)
 
 	CMod_ValidateBSPLump(l, BSP_NODES, &count, 1, "nodes", __FUNCTION__);
 
-	out = Hunk_Alloc((count + 6) * sizeof(*out)); // 6 extra for box hull
+	out = Hunk_Alloc((count + 6 * CM_MAX_BOXHULLS) * sizeof(*out)); // 6 extra for each box hull
 	cm_world.nodes = out;
 	cm_world.numNodes = count;
 
@@ -345,7 +348,7 @@ static void CMod_LoadBrushes(lump_t *l)
 	
 	CMod_ValidateBSPLump(l, BSP_BRUSHES, &count, 1, "brushes", __FUNCTION__);
 	
-	out = Hunk_Alloc((count + 1) * sizeof(*out)); // 1 extra for box hull
+	out = Hunk_Alloc((count + CM_MAX_BOXHULLS) * sizeof(*out)); // 1 extra for each box hull
 	cm_world.brushes = out;
 	cm_world.numBrushes = count;
 
@@ -372,7 +375,7 @@ static void CMod_LoadLeafs(lump_t *l)
 	
 	CMod_ValidateBSPLump(l, BSP_LEAFS, &count, 1, "leafs", __FUNCTION__);
 	
-	out = Hunk_Alloc(count * sizeof(*out));
+	out = Hunk_Alloc((count + CM_MAX_BOXHULLS) * sizeof(*out)); // 1 extra for each box hull
 	cm_world.leafs = out;
 	cm_world.numLeafs = count;
 	cm_world.numClusters = 0;
@@ -440,7 +443,7 @@ static void CMod_LoadPlanes(lump_t *l)
 	CMod_ValidateBSPLump(l, BSP_PLANES, &count, 1, "planes", __FUNCTION__);
 
 	in = (void *)(cmod_base + l->fileofs);
-	out = Hunk_Alloc((count+12) * sizeof(cplane_t)); // 12 extra for box hull
+	out = Hunk_Alloc((count + 12 * CM_MAX_BOXHULLS) * sizeof(cplane_t)); // 12 extra for each box hull
 	cm_world.planes = out;	
 	cm_world.numPlanes = count;
 
@@ -472,7 +475,7 @@ static void CMod_LoadLeafBrushes(lump_t* l)
 
 	CMod_ValidateBSPLump(l, BSP_LEAFBRUSHES, &count, 1, "leaf brushes", __FUNCTION__);
 
-	cm_world.leafBrushes = Hunk_Alloc((count+1) * sizeof(*cm_world.leafBrushes)); // 1 extra for box hull
+	cm_world.leafBrushes = Hunk_Alloc((count + CM_MAX_BOXHULLS) * sizeof(*cm_world.leafBrushes)); // 1 extra for each box hull
 	cm_world.numLeafBrushes = count;
 
 	if (bExtendedBSP)
@@ -502,7 +505,7 @@ static void CMod_LoadBrushSides(lump_t* l)
 
 	CMod_ValidateBSPLump(l, BSP_BRUSHSIDES, &count, 1, "brush sides", __FUNCTION__);
 
-	cm_world.brushsides = Hunk_Alloc((count+12) * sizeof(cbrushside_t)); // 12 extra for box hull
+	cm_world.brushsides = Hunk_Alloc((count + 6 * CM_MAX_BOXHULLS) * sizeof(cbrushside_t)); // 6 extra for each box hull
 	cm_world.numBrushSides = count;
 
 	if (bExtendedBSP) // Qbism BSP
@@ -811,10 +814,8 @@ int		CM_LeafArea (int leafnum)
 //=======================================================================
 
 
-static cplane_t		*box_planes;
-static int			box_headnode;
-static cbrush_t		*box_brush;
-static cleaf_t		*box_leaf;
+static cplane_t		*box_planes;		// 12 for each slot
+static int			box_headnode;		// the hull of slot 0, each slot has 6 nodes after it
 
 /*
 ===================
@@ -822,97 +823,125 @@ CM_InitBoxHull
 
 Set up the planes and nodes so that the six floats of a bounding box
 can just be stored out and get a proper clipping hull structure.
+There is one hull for each slot so threads tracing at the same time
+don't overwrite each other's box.
 ===================
 */
 static void CM_InitBoxHull (void)
 {
-	int			i;
+	int			i, slot;
 	int			side;
+	int			headnode, brushnum, leafnum, firstside;
 	cnode_t		*c;
-	cplane_t	*p;
+	cplane_t	*p, *planes;
 	cbrushside_t	*s;
+	cbrush_t	*brush;
+	cleaf_t		*leaf;
 
 	box_headnode = cm_world.numNodes;
 	box_planes = &cm_world.planes[cm_world.numPlanes];
-	if (cm_world.numNodes+6 > GetBSPLimit(BSP_NODES)
-		|| cm_world.numBrushes+1 > GetBSPLimit(BSP_BRUSHES)
-		|| cm_world.numLeafBrushes+1 > GetBSPLimit(BSP_LEAFBRUSHES)
-		|| cm_world.numBrushSides+6 > GetBSPLimit(BSP_BRUSHSIDES)
-		|| cm_world.numPlanes+12 > GetBSPLimit(BSP_PLANES) )
+	if (cm_world.numNodes+6*CM_MAX_BOXHULLS > GetBSPLimit(BSP_NODES)
+		|| cm_world.numBrushes+CM_MAX_BOXHULLS > GetBSPLimit(BSP_BRUSHES)
+		|| cm_world.numLeafBrushes+CM_MAX_BOXHULLS > GetBSPLimit(BSP_LEAFBRUSHES)
+		|| cm_world.numBrushSides+6*CM_MAX_BOXHULLS > GetBSPLimit(BSP_BRUSHSIDES)
+		|| cm_world.numPlanes+12*CM_MAX_BOXHULLS > GetBSPLimit(BSP_PLANES) )
 		Com_Error (ERR_DROP, "CM_InitBoxHull: Not enough room for box tree");
 
-	box_brush = &cm_world.brushes[cm_world.numBrushes];
-	box_brush->numsides = 6;
-	box_brush->firstbrushside = cm_world.numBrushSides;
-	box_brush->contents = CONTENTS_MONSTER;
+	for (slot = 0; slot < CM_MAX_BOXHULLS; slot++)
+	{
+		headnode = box_headnode + slot*6;
+		planes = box_planes + slot*12;
+		brushnum = cm_world.numBrushes + slot;
+		leafnum = cm_world.numLeafs + slot;
+		firstside = cm_world.numBrushSides + slot*6;
 
-	box_leaf = &cm_world.leafs[cm_world.numLeafs];
-	box_leaf->contents = CONTENTS_MONSTER;
-	box_leaf->firstleafbrush = cm_world.numLeafBrushes;
-	box_leaf->numleafbrushes = 1;
+		brush = &cm_world.brushes[brushnum];
+		brush->numsides = 6;
+		brush->firstbrushside = firstside;
+		brush->contents = CONTENTS_MONSTER;
 
-	cm_world.leafBrushes[cm_world.numLeafBrushes] = cm_world.numBrushes;
+		leaf = &cm_world.leafs[leafnum];
+		leaf->contents = CONTENTS_MONSTER;
+		leaf->firstleafbrush = cm_world.numLeafBrushes + slot;
+		leaf->numleafbrushes = 1;
 
-	for (i = 0; i < 6; i++)
-	{
-		side = i&1;
+		cm_world.leafBrushes[cm_world.numLeafBrushes + slot] = brushnum;
 
-		// brush sides
-		s = &cm_world.brushsides[cm_world.numBrushSides+i];
-		s->plane = cm_world.planes + (cm_world.numPlanes+i*2+side);
+		for (i = 0; i < 6; i++)
+		{
+			side = i&1;
 
-		s->surface = &nullsurface;
+			// brush sides
+			s = &cm_world.brushsides[firstside+i];
+			s->plane = planes + (i*2+side);
 
-		// nodes
-		c = &cm_world.nodes[box_headnode+i];
-		//c->plane = cm_world.planes + (cm_world.numPlanes + i);
-		c->plane = cm_world.planes + (cm_world.numPlanes+i*2);
-		c->children[side] = -1 - emptyleaf;
-		if (i != 5)
-			c->children[side^1] = box_headnode+i + 1;
-		else
-			c->children[side^1] = -1 - cm_world.numLeafs;
-
-		// planes
-		p = &box_planes[i*2];
-		p->type = i>>1;
-		p->signbits = 0;
-		VectorClear (p->normal);
-		p->normal[i>>1] = 1;
-
-		p = &box_planes[i*2+1];
-		p->type = 3 + (i>>1);
-		p->signbits = 0;
-		VectorClear (p->normal);
-		p->normal[i>>1] = -1;
-	}	
+			s->surface = &nullsurface;
+
+			// nodes
+			c = &cm_world.nodes[headnode+i];
+			c->plane = planes + i*2;
+			c->children[side] = -1 - emptyleaf;
+			if (i != 5)
+				c->children[side^1] = headnode+i + 1;
+			else
+				c->children[side^1] = -1 - leafnum;
+
+			// planes
+			p = &planes[i*2];
+			p->type = i>>1;
+			p->signbits = 0;
+			VectorClear (p->normal);
+			p->normal[i>>1] = 1;
+
+			p = &planes[i*2+1];
+			p->type = 3 + (i>>1);
+			p->signbits = 0;
+			VectorClear (p->normal);
+			p->normal[i>>1] = -1;
+		}
+	}
 }
 
 
 /*
 ===================
-CM_HeadnodeForBox
+CM_HeadnodeForBoxSlot
 
 To keep everything totally uniform, bounding boxes are turned into small
 BSP trees instead of being compared directly.
+The hull stays valid until the next call for the same slot.
+===================
+*/
+int	CM_HeadnodeForBoxSlot (vec3_t mins, vec3_t maxs, int slot)
+{
+	cplane_t	*planes;
+
+	planes = box_planes + slot*12;
+
+	planes[0].dist = maxs[0];
+	planes[1].dist = -maxs[0];
+	planes[2].dist = mins[0];
+	planes[3].dist = -mins[0];
+	planes[4].dist = maxs[1];
+	planes[5].dist = -maxs[1];
+	planes[6].dist = mins[1];
+	planes[7].dist = -mins[1];
+	planes[8].dist = maxs[2];
+	planes[9].dist = -maxs[2];
+	planes[10].dist = mins[2];
+	planes[11].dist = -mins[2];
+
+	return box_headnode + slot*6;
+}
+
+/*
+===================
+CM_HeadnodeForBox
 ===================
 */
 int	CM_HeadnodeForBox (vec3_t mins, vec3_t maxs)
 {
-	box_planes[0].dist = maxs[0];
-	box_planes[1].dist = -maxs[0];
-	box_planes[2].dist = mins[0];
-	box_planes[3].dist = -mins[0];
-	box_planes[4].dist = maxs[1];
-	box_planes[5].dist = -maxs[1];
-	box_planes[6].dist = mins[1];
-	box_planes[7].dist = -mins[1];
-	box_planes[8].dist = maxs[2];
-	box_planes[9].dist = -maxs[2];
-	box_planes[10].dist = mins[2];
-	box_planes[11].dist = -mins[2];
-
-	return box_headnode;
+	return CM_HeadnodeForBoxSlot (mins, maxs, 0);
 }
 
 
@@ -970,7 +999,7 @@ CM_BoxLeafnums_r
 Fills in a list of all the leafs touched
 =============
 */
-static void CM_BoxLeafnums_r (int nodenum)
+static void CM_BoxLeafnums_r (cmleafs_t *lw, int nodenum)
 {
 	cplane_t	*plane;
 	cnode_t		*node;
@@ -980,28 +1009,28 @@ static void CM_BoxLeafnums_r (int nodenum)
 	{
 		if (nodenum < 0)
 		{
-			if (leaf_count >= leaf_maxcount)
+			if (lw->count >= lw->maxcount)
 			{
 //				Com_Printf ("CM_BoxLeafnums_r: overflow\n");
 				return;
 			}
-			leaf_list[leaf_count++] = -1 - nodenum;
+			lw->list[lw->count++] = -1 - nodenum;
 			return;
 		}
 	
 		node = &cm_world.nodes[nodenum];
 		plane = node->plane;
-//		s = BoxOnPlaneSide (leaf_mins, leaf_maxs, plane);
-		s = BOX_ON_PLANE_SIDE(leaf_mins, leaf_maxs, plane);
+//		s = BoxOnPlaneSide (lw->mins, lw->maxs, plane);
+		s = BOX_ON_PLANE_SIDE(lw->mins, lw->maxs, plane);
 		if (s == 1)
 			nodenum = node->children[0];
 		else if (s == 2)
 			nodenum = node->children[1];
 		else
 		{	// go down both
-			if (leaf_topnode == -1)
-				leaf_topnode = nodenum;
-			CM_BoxLeafnums_r (node->children[0]);
+			if (lw->topnode == -1)
+				lw->topnode = nodenum;
+			CM_BoxLeafnums_r (lw, node->children[0]);
 			nodenum = node->children[1];
 		}
 
@@ -1015,20 +1044,22 @@ CM_BoxLeafnums_headnode
 */
 static int	CM_BoxLeafnums_headnode (vec3_t mins, vec3_t maxs, int *list, int listsize, int headnode, int *topnode)
 {
-	leaf_list = list;
-	leaf_count = 0;
-	leaf_maxcount = listsize;
-	leaf_mins = mins;
-	leaf_maxs = maxs;
+	cmleafs_t	lw;
+
+	lw.list = list;
+	lw.count = 0;
+	lw.maxcount = listsize;
+	lw.mins = mins;
+	lw.maxs = maxs;
 
-	leaf_topnode = -1;
+	lw.topnode = -1;
 
-	CM_BoxLeafnums_r (headnode);
+	CM_BoxLeafnums_r (&lw, headnode);
 
 	if (topnode)
-		*topnode = leaf_topnode;
+		*topnode = lw.topnode;
 
-	return leaf_count;
+	return lw.count;
 }
 
 /*
@@ -1080,7 +1111,7 @@ int	CM_TransformedPointContents (vec3_t p, int headnode, vec3_t origin, vec3_t a
 	VectorSubtract (p, origin, p_l);
 
 	// rotate start and end into the models frame of reference
-	if (headnode != box_headnode && 
+	if (headnode < box_headnode && 
 	(angles[0] || angles[1] || angles[2]) )
 	{
 		AngleVectors (angles, forward, right, up);
@@ -1108,19 +1139,24 @@ BOX TRACING
 // 1/32 epsilon to keep floating point happy
 #define DIST_EPSILON    (1 / 32.f)
 
-static vec3_t	trace_start, trace_end;
-static vec3_t	trace_mins, trace_maxs;
-static vec3_t	trace_extents;
-static trace_t	trace_trace;
-static int		trace_contents;
-static qboolean	trace_ispoint;		// optimized case
+// everything a trace works with lives here so traces can run on several threads
+typedef struct
+{
+	vec3_t		start, end;
+	vec3_t		mins, maxs;
+	vec3_t		extents;
+	trace_t		trace;
+	int			contents;
+	qboolean	ispoint;		// optimized case
+	qboolean	multicheck;		// brush checkcounts are only kept on slot 0, other slots may clip a brush twice
+} cmtrace_t;
 
 /*
 ================
 CM_ClipBoxToBrush
 ================
 */
-static void CM_ClipBoxToBrush (vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t *trace, cbrush_t *brush)
+static void CM_ClipBoxToBrush (cmtrace_t *tw, vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t *trace, cbrush_t *brush)
 {
 	int			i, j;
 	cplane_t	*plane, *clipplane;
@@ -1139,7 +1175,8 @@ static void CM_ClipBoxToBrush (vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, t
 	if (!brush->numsides)
 		return;
 
-	c_brush_traces++;
+	if (tw->multicheck)
+		c_brush_traces++;
 
 	getout = false;
 	startout = false;
@@ -1152,7 +1189,7 @@ static void CM_ClipBoxToBrush (vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, t
 
 		// FIXME: special case for axial
 
-		if (!trace_ispoint)
+		if (!tw->ispoint)
 		{	// general box case
 
 			// push the plane out apropriately for mins/maxs
@@ -1299,7 +1336,7 @@ static void CM_TestBoxInBrush (vec3_t mins, vec3_t maxs, vec3_t p1, trace_t *tra
 CM_TraceToLeaf
 ================
 */
-static void CM_TraceToLeaf (int leafnum)
+static void CM_TraceToLeaf (cmtrace_t *tw, int leafnum)
 {
 	int			k;
 	int			brushnum;
@@ -1307,21 +1344,24 @@ static void CM_TraceToLeaf (int leafnum)
 	cbrush_t	*b;
 
 	leaf = &cm_world.leafs[leafnum];
-	if ( !(leaf->contents & trace_contents))
+	if ( !(leaf->contents & tw->contents))
 		return;
 	// trace line against all brushes in the leaf
 	for (k=0 ; k<leaf->numleafbrushes ; k++)
 	{
 		brushnum = cm_world.leafBrushes[leaf->firstleafbrush+k];
 		b = &cm_world.brushes[brushnum];
-		if (b->checkcount == checkcount)
-			continue;	// already checked this brush in another leaf
-		b->checkcount = checkcount;
+		if (tw->multicheck)
+		{
+			if (b->checkcount == checkcount)
+				continue;	// already checked this brush in another leaf
+			b->checkcount = checkcount;
+		}
 
-		if ( !(b->contents & trace_contents))
+		if ( !(b->contents & tw->contents))
 			continue;
-		CM_ClipBoxToBrush (trace_mins, trace_maxs, trace_start, trace_end, &trace_trace, b);
-		if (!trace_trace.fraction)
+		CM_ClipBoxToBrush (tw, tw->mins, tw->maxs, tw->start, tw->end, &tw->trace, b);
+		if (!tw->trace.fraction)
 			return;
 	}
 
@@ -1333,7 +1373,7 @@ static void CM_TraceToLeaf (int leafnum)
 CM_TestInLeaf
 ================
 */
-static void CM_TestInLeaf (int leafnum)
+static void CM_TestInLeaf (cmtrace_t *tw, int leafnum)
 {
 	int			k;
 	int			brushnum;
@@ -1341,21 +1381,24 @@ static void CM_TestInLeaf (int leafnum)
 	cbrush_t	*b;
 
 	leaf = &cm_world.leafs[leafnum];
-	if ( !(leaf->contents & trace_contents))
+	if ( !(leaf->contents & tw->contents))
 		return;
 	// trace line against all brushes in the leaf
 	for (k=0 ; k<leaf->numleafbrushes ; k++)
 	{
 		brushnum = cm_world.leafBrushes[leaf->firstleafbrush+k];
 		b = &cm_world.brushes[brushnum];
-		if (b->checkcount == checkcount)
-			continue;	// already checked this brush in another leaf
-		b->checkcount = checkcount;
+		if (tw->multicheck)
+		{
+			if (b->checkcount == checkcount)
+				continue;	// already checked this brush in another leaf
+			b->checkcount = checkcount;
+		}
 
-		if ( !(b->contents & trace_contents))
+		if ( !(b->contents & tw->contents))
 			continue;
-		CM_TestBoxInBrush (trace_mins, trace_maxs, trace_start, &trace_trace, b);
-		if (!trace_trace.fraction)
+		CM_TestBoxInBrush (tw->mins, tw->maxs, tw->start, &tw->trace, b);
+		if (!tw->trace.fraction)
 			return;
 	}
 
@@ -1368,7 +1411,7 @@ CM_RecursiveHullCheck
 
 ==================
 */
-static void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
+static void CM_RecursiveHullCheck (cmtrace_t *tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
 {
 	cnode_t		*node;
 	cplane_t	*plane;
@@ -1380,13 +1423,13 @@ static void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec
 	int			side;
 	float		midf;
 
-	if (trace_trace.fraction <= p1f)
+	if (tw->trace.fraction <= p1f)
 		return;		// already hit something nearer
 
 	// if < 0, we are in a leaf node
 	if (num < 0)
 	{
-		CM_TraceToLeaf (-1-num);
+		CM_TraceToLeaf (tw, -1-num);
 		return;
 	}
 
@@ -1401,29 +1444,29 @@ static void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec
 	{
 		t1 = p1[plane->type] - plane->dist;
 		t2 = p2[plane->type] - plane->dist;
-		offset = trace_extents[plane->type];
+		offset = tw->extents[plane->type];
 	}
 	else
 	{
 		t1 = DotProduct (plane->normal, p1) - plane->dist;
 		t2 = DotProduct (plane->normal, p2) - plane->dist;
-		if (trace_ispoint)
+		if (tw->ispoint)
 			offset = 0;
 		else
-			offset = fabs(trace_extents[0]*plane->normal[0]) +
-				fabs(trace_extents[1]*plane->normal[1]) +
-				fabs(trace_extents[2]*plane->normal[2]);
+			offset = fabs(tw->extents[0]*plane->normal[0]) +
+				fabs(tw->extents[1]*plane->normal[1]) +
+				fabs(tw->extents[2]*plane->normal[2]);
 	}
 
 	// see which sides we need to consider
 	if (t1 >= offset && t2 >= offset)
 	{
-		CM_RecursiveHullCheck (node->children[0], p1f, p2f, p1, p2);
+		CM_RecursiveHullCheck (tw, node->children[0], p1f, p2f, p1, p2);
 		return;
 	}
 	if (t1 < -offset && t2 < -offset)
 	{
-		CM_RecursiveHullCheck (node->children[1], p1f, p2f, p1, p2);
+		CM_RecursiveHullCheck (tw, node->children[1], p1f, p2f, p1, p2);
 		return;
 	}
 
@@ -1459,7 +1502,7 @@ static void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec
 	for (i=0 ; i<3 ; i++)
 		mid[i] = p1[i] + frac*(p2[i] - p1[i]);
 
-	CM_RecursiveHullCheck (node->children[side], p1f, midf, p1, mid);
+	CM_RecursiveHullCheck (tw, node->children[side], p1f, midf, p1, mid);
 
 
 	// go past the node
@@ -1472,7 +1515,7 @@ static void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec
 	for (i=0 ; i<3 ; i++)
 		mid[i] = p1[i] + frac2*(p2[i] - p1[i]);
 
-	CM_RecursiveHullCheck (node->children[side^1], midf, p2f, mid, p2);
+	CM_RecursiveHullCheck (tw, node->children[side^1], midf, p2f, mid, p2);
 }
 
 
@@ -1481,29 +1524,43 @@ static void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec
 
 /*
 ==================
-CM_BoxTrace
+CM_BoxTraceSlot
+
+Slot 0 belongs to the main thread, other slots can trace at the same time
+as long as each thread keeps to its own slot
 ==================
 */
-trace_t CM_BoxTrace(vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int headnode, int brushmask)
+trace_t CM_BoxTraceSlot(vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int headnode, int brushmask, int slot)
 {
+	cmtrace_t	tw;
 	int		i;
 
-	checkcount++;		// for multi-check avoidance
-	c_traces++;			// for statistics, may be zeroed
+	if (!slot)
+	{
+		PROF_BEGIN ("CM_BoxTrace");
+
+		checkcount++;		// for multi-check avoidance
+		c_traces++;			// for statistics, may be zeroed
+	}
+	tw.multicheck = !slot;
 
 	// fill in a default trace
-	memset (&trace_trace, 0, sizeof(trace_trace));
-	trace_trace.fraction = 1;
-	trace_trace.surface = &(nullsurface.c);
+	memset (&tw.trace, 0, sizeof(tw.trace));
+	tw.trace.fraction = 1;
+	tw.trace.surface = &(nullsurface.c);
 
 	if (!cm_world.numNodes)	// map not loaded
-		return trace_trace;
+	{
+		if (!slot)
+			PROF_END ();
+		return tw.trace;
+	}
 
-	trace_contents = brushmask;
-	VectorCopy (start, trace_start);
-	VectorCopy (end, trace_end);
-	VectorCopy (mins, trace_mins);
-	VectorCopy (maxs, trace_maxs);
+	tw.contents = brushmask;
+	VectorCopy (start, tw.start);
+	VectorCopy (end, tw.end);
+	VectorCopy (mins, tw.mins);
+	VectorCopy (maxs, tw.maxs);
 
 	//
 	// check for position test special case
@@ -1526,12 +1583,14 @@ trace_t CM_BoxTrace(vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int head
 		numleafs = CM_BoxLeafnums_headnode (c1, c2, leafs, 1024, headnode, &topnode);
 		for (i=0 ; i<numleafs ; i++)
 		{
-			CM_TestInLeaf (leafs[i]);
-			if (trace_trace.allsolid)
+			CM_TestInLeaf (&tw, leafs[i]);
+			if (tw.trace.allsolid)
 				break;
 		}
-		VectorCopy (start, trace_trace.endpos);
-		return trace_trace;
+		VectorCopy (start, tw.trace.endpos);
+		if (!slot)
+			PROF_END ();
+		return tw.trace;
 	}
 
 	//
@@ -1540,38 +1599,50 @@ trace_t CM_BoxTrace(vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int head
 	if (mins[0] == 0 && mins[1] == 0 && mins[2] == 0
 		&& maxs[0] == 0 && maxs[1] == 0 && maxs[2] == 0)
 	{
-		trace_ispoint = true;
-		VectorClear (trace_extents);
+		tw.ispoint = true;
+		VectorClear (tw.extents);
 	}
 	else
 	{
-		trace_ispoint = false;
-		trace_extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
-		trace_extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
-		trace_extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
+		tw.ispoint = false;
+		tw.extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
+		tw.extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
+		tw.extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
 	}
 
 	//
 	// general sweeping through world
 	//
-	CM_RecursiveHullCheck (headnode, 0, 1, start, end);
+	CM_RecursiveHullCheck (&tw, headnode, 0, 1, start, end);
 
-	if (trace_trace.fraction == 1)
+	if (tw.trace.fraction == 1)
 	{
-		VectorCopy (end, trace_trace.endpos);
+		VectorCopy (end, tw.trace.endpos);
 	}
 	else
 	{
 		for (i=0 ; i<3 ; i++)
-			trace_trace.endpos[i] = start[i] + trace_trace.fraction * (end[i] - start[i]);
+			tw.trace.endpos[i] = start[i] + tw.trace.fraction * (end[i] - start[i]);
 	}
-	return trace_trace;
+	if (!slot)
+		PROF_END ();
+	return tw.trace;
+}
+
+/*
+==================
+CM_BoxTrace
+==================
+*/
+trace_t CM_BoxTrace(vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int headnode, int brushmask)
+{
+	return CM_BoxTraceSlot (start, end, mins, maxs, headnode, brushmask, 0);
 }
 
 
 /*
 ==================
-CM_TransformedBoxTrace
+CM_TransformedBoxTraceSlot
 
 Handles offseting and rotation of the end points for moving and
 rotating entities
@@ -1582,7 +1653,7 @@ rotating entities
 #endif
 
 
-trace_t	CM_TransformedBoxTrace (vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int headnode, int brushmask, vec3_t origin, vec3_t angles)
+trace_t	CM_TransformedBoxTraceSlot (vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int headnode, int brushmask, vec3_t origin, vec3_t angles, int slot)
 {
 	trace_t		trace;
 	vec3_t		start_l, end_l;
@@ -1596,7 +1667,7 @@ trace_t	CM_TransformedBoxTrace (vec3_t start, vec3_t end, vec3_t mins, vec3_t ma
 	VectorSubtract (end, origin, end_l);
 
 	// rotate start and end into the models frame of reference
-	if (headnode != box_headnode && (angles[0] || angles[1] || angles[2]) )
+	if (headnode < box_headnode && (angles[0] || angles[1] || angles[2]) )
 		rotated = true;
 	else
 		rotated = false;
@@ -1617,7 +1688,7 @@ trace_t	CM_TransformedBoxTrace (vec3_t start, vec3_t end, vec3_t mins, vec3_t ma
 	}
 
 	// sweep the box through the model
-	trace = CM_BoxTrace (start_l, end_l, mins, maxs, headnode, brushmask);
+	trace = CM_BoxTraceSlot (start_l, end_l, mins, maxs, headnode, brushmask, slot);
 
 	if (rotated && trace.fraction != 1.0)
 	{
@@ -1638,6 +1709,16 @@ trace_t	CM_TransformedBoxTrace (vec3_t start, vec3_t end, vec3_t mins, vec3_t ma
 	return trace;
 }
 
+/*
+==================
+CM_TransformedBoxTrace
+==================
+*/
+trace_t	CM_TransformedBoxTrace (vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, int headnode, int brushmask, vec3_t origin, vec3_t angles)
+{
+	return CM_TransformedBoxTraceSlot (start, end, mins, maxs, headnode, brushmask, origin, angles, 0);
+}
+
 #ifdef _WIN32
 #pragma optimize( "", on )
 #endif
@@ -1867,6 +1948,37 @@ void CM_ReadPortalState (FILE *f)
 	FloodAreaConnections ();
 }
 
+/*
+===================
+CM_WritePortalStateToBuffer
+
+Same as CM_WritePortalState but to memory, returns the size and only that when out is NULL
+===================
+*/
+int CM_WritePortalStateToBuffer (byte *out)
+{
+	if (out)
+		memcpy (out, cm_world.openAreaPortalsList, sizeof(cm_world.openAreaPortalsList));
+	return sizeof(cm_world.openAreaPortalsList);
+}
+
+/*
+===================
+CM_ReadPortalStateFromBuffer
+
+Returns false if the buffer isn't a portal state of this build
+===================
+*/
+qboolean CM_ReadPortalStateFromBuffer (const byte *in, int size)
+{
+	if (size != sizeof(cm_world.openAreaPortalsList))
+		return false;
+
+	memcpy (cm_world.openAreaPortalsList, in, sizeof(cm_world.openAreaPortalsList));
+	FloodAreaConnections ();
+	return true;
+}
+
 /*
 =============
 CM_HeadnodeVisible
@@ -12,6 +12,15 @@ See the attached GNU General Public License v2 for more details.
 #include "qcommon.h"
 #include <setjmp.h>
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define CPUID_X86 1
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
 #define	MAXPRINTMSG	4096
 
 #define MAX_NUM_ARGVS	50
@@ -1250,25 +1259,208 @@ void Info_Print (char *s)
 
 						ZONE MEMORY ALLOCATION
 
-just cleared malloc with counters now...
+Untagged blocks up to Z_POOL_MAX bytes come from size class free lists,
+tagged blocks are bumped out of a per tag arena that Z_FreeTags resets
+without walking anything. Everything else is a cleared malloc linked
+into its tag's chain. z_pools 0, or building with ZONE_MALLOC, puts every
+new block on the malloc path to make it easier to chase overruns with
+the usual tools.
+
+Every tag and every Z_Malloc call site keeps live, peak and total
+counters for z_stats, zone_report and the z_snapshot csv. Tags that
+are not freed as a group stay out of the arenas and are only counted.
 
 ==============================================================================
 */
 
 #define	Z_MAGIC		0x1d1d
+#define	Z_FREEMAGIC	0x1d1e	// a pool block sitting on its free list
 
+typedef enum
+{
+	ZK_HEAP,		// malloced, linked into its tag's chain
+	ZK_ARENA,		// bumped out of its tag's arena
+	ZK_POOL			// size class block
+} zkind_t;
 
 typedef struct zhead_s
 {
-	struct zhead_s	*prev, *next;
+	struct zhead_s	*prev, *next;	// heap blocks, next links free pool blocks
 	short		magic;
+	byte		kind;			// zkind_t
+	byte		pool;			// size class of pool blocks
 	memtag_t	tag;			// for group free
-	int			size;
+	int			size;			// requested size + header
+	int			site;			// index in z_sites
 } zhead_t;
 
-zhead_t		z_chain;
+#define	Z_ALIGN(x)		(((x) + 15) & ~15)
+
+// arenas grow in chunks, a reset keeps up to Z_ARENA_KEEP bytes of them
+#define	Z_ARENA_CHUNK	(256*1024)
+#define	Z_ARENA_KEEP	(1024*1024)
+
+typedef struct zchunk_s
+{
+	struct zchunk_s	*next;
+	int			size;
+	int			used;
+} zchunk_t;
+
+#define	Z_ChunkData(c)	((byte *)(c) + Z_ALIGN(sizeof(zchunk_t)))
+
+// pool classes hold the header too, slabs are never given back
+#define	Z_NUM_POOLS		4
+#define	Z_POOL_MAX		(512 - (int)sizeof(zhead_t))
+#define	Z_POOL_SLAB		(64*1024)
+
+static const int	z_poolsizes[Z_NUM_POOLS] = { 64, 128, 256, 512 };
+
+typedef struct
+{
+	zhead_t		*free;
+	int			slabs;
+} zpool_t;
+
+#define	Z_NUM_TAGS			(NUM_MEMORY_TAGS - TAG_GUI + 1)
+#define	Z_TagIndex(tag)		((tag) == TAG_NONE ? 0 : (tag) - TAG_GUI + 1)
+
+typedef struct
+{
+	memtag_t	tag;
+	char		*name;
+	qboolean	arena;			// only ever freed with Z_FreeTags
+} ztaginfo_t;
+
+static const ztaginfo_t	z_taginfo[] =
+{
+	{ TAG_NONE,				"none",				false },
+	{ TAG_GUI,				"gui",				true },
+	{ TAG_FX,				"fx",				true },
+	{ TAG_NAV_NODES,		"nav_nodes",		true },
+	{ TAG_SERVER_MODELDATA,	"server_modeldata",	true },
+	{ TAG_SERVER_GAME,		"server_game",		true },
+	{ TAG_RENDERER,			"renderer",			false },
+	{ TAG_SOUND,			"sound",			false },
+	{ TAG_SCRIPT,			"script",			false }
+};
+
+typedef struct
+{
+	char		*name;
+	qboolean	arena;
+	zhead_t		chain;			// heap blocks
+	zchunk_t	*chunks;		// arena, current chunk first
+	int			count, bytes;	// live blocks
+	int			peak;			// most live bytes
+	int			allocs;			// ever made, for the rate
+	int			lastallocs;		// at the previous z_stats
+} ztag_t;
+
+// allocation sites, found by the address of their __FILE__ string
+#define	Z_MAX_SITES		2048	// must be a power of two
+
+typedef struct
+{
+	const char	*file;			// NULL for an empty slot
+	int			line;
+	memtag_t	tag;
+	int			count, bytes;
+	int			peak;
+	int			allocs;
+} zsite_t;
+
+static ztag_t	z_tags[Z_NUM_TAGS];
+static zpool_t	z_pools[Z_NUM_POOLS];
+static zsite_t	z_sites[Z_MAX_SITES];	// 0 collects untracked blocks
+static int		z_numsites;
+static int		z_lastStatsTime;
+
 int		z_count, z_bytes;
 
+static cvar_t	*z_usepools;
+static cvar_t	*z_snapshot;
+static FILE		*z_snapshotfile;
+static int		z_lastSnapshotTime;
+
+/*
+========================
+Z_Init
+========================
+*/
+static void Z_Init (void)
+{
+	int		i;
+	ztag_t	*t;
+
+	for (i = 0 ; i < Z_NUM_TAGS ; i++)
+	{
+		t = &z_tags[i];
+		t->chain.next = t->chain.prev = &t->chain;
+		t->name = "?";
+	}
+
+	for (i = 0 ; i < sizeof(z_taginfo) / sizeof(z_taginfo[0]) ; i++)
+	{
+		t = &z_tags[Z_TagIndex(z_taginfo[i].tag)];
+		t->name = z_taginfo[i].name;
+		t->arena = z_taginfo[i].arena;
+	}
+
+	z_sites[0].file = "untracked";
+	z_numsites = 1;
+}
+
+/*
+========================
+Z_Tag
+========================
+*/
+static ztag_t *Z_Tag (memtag_t tag)
+{
+	if (tag != TAG_NONE && (tag < TAG_GUI || tag >= NUM_MEMORY_TAGS))
+		Com_Error (ERR_FATAL, "Z_TagMalloc: bad tag %i", tag);
+
+	return &z_tags[Z_TagIndex(tag)];
+}
+
+/*
+========================
+Z_FindSite
+========================
+*/
+static int Z_FindSite (const char *file, int line, memtag_t tag)
+{
+	int			i;
+	zsite_t		*site;
+
+	if (!file)
+		return 0;
+
+	i = (int)(((unsigned)((size_t)file >> 3) * 31 + line) & (Z_MAX_SITES-1));
+	for ( ; ; i = (i + 1) & (Z_MAX_SITES-1))
+	{
+		if (!i)
+			continue;	// reserved
+
+		site = &z_sites[i];
+		if (site->file == file && site->line == line && site->tag == tag)
+			return i;
+		if (!site->file)
+			break;
+	}
+
+	// keep the table from filling up so probing stays short
+	if (z_numsites >= Z_MAX_SITES / 2)
+		return 0;
+
+	site->file = file;
+	site->line = line;
+	site->tag = tag;
+	z_numsites++;
+	return i;
+}
+
 /*
 ========================
 Z_Free
@@ -1276,21 +1468,48 @@ Z_Free
 */
 void Z_Free (void *ptr)
 {
-	zhead_t	*z;
+	zhead_t		*z;
+	ztag_t		*t;
+	zchunk_t	*c;
+	zpool_t		*p;
 
 	z = ((zhead_t *)ptr) - 1;
 
 	if (z->magic != Z_MAGIC)
 		Com_Error (ERR_FATAL, "Z_Free: bad magic");
 
-	z->prev->next = z->next;
-	z->next->prev = z->prev;
-
+	t = &z_tags[Z_TagIndex(z->tag)];
+	t->count--;
+	t->bytes -= z->size;
+	z_sites[z->site].count--;
+	z_sites[z->site].bytes -= z->size;
 	z_count--;
 	z_bytes -= z->size;
-	free (z);
-}
 
+	switch (z->kind)
+	{
+	case ZK_POOL:
+		p = &z_pools[z->pool];
+		z->magic = Z_FREEMAGIC;
+		z->next = p->free;
+		p->free = z;
+		break;
+
+	case ZK_ARENA:
+		// the space comes back with Z_FreeTags, unless it was the last bump
+		c = t->chunks;
+		if (c && (byte *)z + Z_ALIGN(z->size) == Z_ChunkData(c) + c->used)
+			c->used -= Z_ALIGN(z->size);
+		z->magic = 0;
+		break;
+
+	default:
+		z->prev->next = z->next;
+		z->next->prev = z->prev;
+		free (z);
+		break;
+	}
+}
 
 /*
 ========================
@@ -1299,7 +1518,41 @@ Z_Stats_f
 */
 void Z_Stats_f (void)
 {
+	int			i, j, msec, arena, pooled, free;
+	ztag_t		*t;
+	zchunk_t	*c;
+	zhead_t		*z;
+
+	msec = Sys_Milliseconds() - z_lastStatsTime;
+	if (msec < 1)
+		msec = 1;
+
+	Com_Printf ("tag               blocks      bytes       peak      arena  allocs/s\n");
+	for (i = 0, t = z_tags ; i < Z_NUM_TAGS ; i++, t++)
+	{
+		arena = 0;
+		for (c = t->chunks ; c ; c = c->next)
+			arena += c->size;
+
+		Com_Printf ("%-16s %7i %10i %10i %10i %9.1f\n", t->name, t->count, t->bytes, t->peak, arena,
+			(t->allocs - t->lastallocs) * 1000.0f / msec);
+		t->lastallocs = t->allocs;
+	}
+
+	pooled = free = 0;
+	for (i = 0 ; i < Z_NUM_POOLS ; i++)
+	{
+		pooled += z_pools[i].slabs * Z_POOL_SLAB;
+		for (j = 0, z = z_pools[i].free ; z ; z = z->next)
+			j++;
+		free += j * z_poolsizes[i];
+	}
+
 	Com_Printf ("%i bytes in %i blocks\n", z_bytes, z_count);
+	Com_Printf ("%i bytes in pool slabs, %i free\n", pooled, free);
+	if (z_lastStatsTime)
+		Com_Printf ("allocation rates over the last %.1f seconds\n", msec / 1000.0f);
+	z_lastStatsTime = Sys_Milliseconds();
 }
 
 /*
@@ -1309,59 +1562,362 @@ Z_FreeTags
 */
 void Z_FreeTags (memtag_t tag)
 {
-	zhead_t	*z, *next;
+	zhead_t		*z, *next;
+	zchunk_t	*c, *keep, *nextchunk;
+	ztag_t		*t;
+	int			i, kept;
 
-	for (z=z_chain.next ; z != &z_chain ; z=next)
+	t = Z_Tag (tag);
+	if (!t->arena)
+		Com_Error (ERR_FATAL, "Z_FreeTags: %s blocks are freed one by one", t->name);
+
+	// fallback blocks
+	for (z=t->chain.next ; z != &t->chain ; z=next)
 	{
 		next = z->next;
-		if (z->tag == tag)
-			Z_Free ((void *)(z+1));
+		Z_Free ((void *)(z+1));
 	}
+
+	// everything left is in the arena
+	z_count -= t->count;
+	z_bytes -= t->bytes;
+	t->count = t->bytes = 0;
+
+	for (i = 1 ; i < Z_MAX_SITES ; i++)
+	{
+		if (z_sites[i].tag == tag && z_sites[i].file)
+			z_sites[i].count = z_sites[i].bytes = 0;
+	}
+
+	keep = NULL;
+	kept = 0;
+	for (c = t->chunks ; c ; c = nextchunk)
+	{
+		nextchunk = c->next;
+		if (kept + c->size > Z_ARENA_KEEP)
+		{
+			free (c);
+			continue;
+		}
+		kept += c->size;
+		c->used = 0;
+		c->next = keep;
+		keep = c;
+	}
+	t->chunks = keep;
 }
 
 /*
 ========================
-Z_TagMalloc
+Z_ArenaAlloc
+========================
+*/
+static zhead_t *Z_ArenaAlloc (ztag_t *t, int size)
+{
+	zchunk_t	*c, *prev;
+	zhead_t		*z;
+	int			chunksize;
+
+	size = Z_ALIGN(size);
+
+	// the current chunk is first, look for room in the ones kept by a reset
+	for (prev = NULL, c = t->chunks ; c ; prev = c, c = c->next)
+	{
+		if (c->size - c->used >= size)
+			break;
+	}
+
+	if (c)
+	{
+		if (prev)
+		{	// make it current, the one it replaces still has its data
+			prev->next = c->next;
+			c->next = t->chunks;
+			t->chunks = c;
+		}
+	}
+	else
+	{
+		chunksize = size > Z_ARENA_CHUNK ? size : Z_ARENA_CHUNK;
+		c = malloc (Z_ALIGN(sizeof(zchunk_t)) + chunksize);
+		if (!c)
+			return NULL;
+		c->size = chunksize;
+		c->used = 0;
+		c->next = t->chunks;
+		t->chunks = c;
+	}
+
+	z = (zhead_t *)(Z_ChunkData(c) + c->used);
+	c->used += size;
+	memset (z, 0, size);
+	z->kind = ZK_ARENA;
+
+	return z;
+}
+
+/*
+========================
+Z_PoolAlloc
+========================
+*/
+static zhead_t *Z_PoolAlloc (int size)
+{
+	zpool_t		*p;
+	zhead_t		*z;
+	byte		*slab;
+	int			i, n;
+
+	for (i = 0 ; z_poolsizes[i] < size ; i++)
+		;
+	p = &z_pools[i];
+
+	if (!p->free)
+	{
+		slab = malloc (Z_POOL_SLAB);
+		if (!slab)
+			return NULL;
+		p->slabs++;
+
+		for (n = Z_POOL_SLAB / z_poolsizes[i] - 1 ; n >= 0 ; n--)
+		{
+			z = (zhead_t *)(slab + n * z_poolsizes[i]);
+			z->magic = Z_FREEMAGIC;
+			z->next = p->free;
+			p->free = z;
+		}
+	}
+
+	z = p->free;
+	if (z->magic != Z_FREEMAGIC)
+		Com_Error (ERR_FATAL, "Z_Malloc: pool free list corrupted");
+	p->free = z->next;
+
+	memset (z, 0, z_poolsizes[i]);
+	z->kind = ZK_POOL;
+	z->pool = i;
+
+	return z;
+}
+
+/*
+========================
+Z_TagMallocSite
 ========================
 */
-void *Z_TagMalloc (int size, memtag_t tag)
+void *Z_TagMallocSite (int size, memtag_t tag, const char *file, int line)
 {
 	zhead_t	*z;
-	
+	ztag_t	*t;
+	zsite_t	*site;
+	qboolean	pools;
+
+	t = Z_Tag (tag);
 	size = size + sizeof(zhead_t);
-	z = malloc(size);
+
+#ifdef ZONE_MALLOC
+	pools = false;
+#else
+	pools = !z_usepools || z_usepools->value;
+#endif
+
+	if (!pools)
+		z = NULL;
+	else if (t->arena)
+		z = Z_ArenaAlloc (t, size);
+	else if (size <= Z_POOL_MAX + (int)sizeof(zhead_t))
+		z = Z_PoolAlloc (size);
+	else
+		z = NULL;
 
 	if (!z)
 	{
-		Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes", size);
-		return NULL; //msvc..
-	}
+		z = malloc(size);
+		if (!z)
+		{
+			Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes", size);
+			return NULL; //msvc..
+		}
 
-	memset (z, 0, size);
+		memset (z, 0, size);
+		z->kind = ZK_HEAP;
+		z->next = t->chain.next;
+		z->prev = &t->chain;
+		t->chain.next->prev = z;
+		t->chain.next = z;
+	}
 
+	t->count++;
+	t->bytes += size;
+	if (t->bytes > t->peak)
+		t->peak = t->bytes;
+	t->allocs++;
 	z_count++;
 	z_bytes += size;
 
 	z->magic = Z_MAGIC;
 	z->tag = tag;
 	z->size = size;
+	z->site = Z_FindSite (file, line, tag);
 
-	z->next = z_chain.next;
-	z->prev = &z_chain;
-	z_chain.next->prev = z;
-	z_chain.next = z;
+	site = &z_sites[z->site];
+	site->count++;
+	site->bytes += size;
+	if (site->bytes > site->peak)
+		site->peak = site->bytes;
+	site->allocs++;
 
 	return (void *)(z+1);
 }
 
+/*
+========================
+Z_TagMalloc
+
+For callers that need a function, the site is not tracked
+========================
+*/
+void *(Z_TagMalloc) (int size, memtag_t tag)
+{
+	return Z_TagMallocSite (size, tag, NULL, 0);
+}
+
 /*
 ========================
 Z_Malloc
 ========================
 */
-void *Z_Malloc (int size)
+void *(Z_Malloc) (int size)
 {
-	return Z_TagMalloc (size, 0);
+	return Z_TagMallocSite (size, TAG_NONE, NULL, 0);
+}
+
+/*
+========================
+Z_SiteName
+
+__FILE__ may hold the whole path
+========================
+*/
+static const char *Z_SiteName (const zsite_t *site)
+{
+	const char	*s, *name;
+
+	name = site->file;
+	for (s = name ; *s ; s++)
+	{
+		if (*s == '/' || *s == '\\')
+			name = s + 1;
+	}
+	return name;
+}
+
+/*
+========================
+Z_Report_f
+
+zone_report [count] [tag]
+Lists the allocation sites holding the most memory
+========================
+*/
+void Z_Report_f (void)
+{
+	static short	order[Z_MAX_SITES];
+	int			i, j, k, num, count, tag;
+	zsite_t		*site;
+
+	count = Cmd_Argc() > 1 ? atoi (Cmd_Argv(1)) : 20;
+	if (count < 1)
+		count = 20;
+
+	tag = -1;
+	if (Cmd_Argc() > 2)
+	{
+		for (i = 0 ; i < Z_NUM_TAGS ; i++)
+		{
+			if (!Q_stricmp (Cmd_Argv(2), z_tags[i].name))
+				tag = i;
+		}
+		if (tag == -1)
+		{
+			Com_Printf ("zone_report: unknown tag %s\n", Cmd_Argv(2));
+			return;
+		}
+	}
+
+	// insertion sort by live bytes, there are only a few hundred sites
+	num = 0;
+	for (i = 0 ; i < Z_MAX_SITES ; i++)
+	{
+		site = &z_sites[i];
+		if (!site->file || !site->allocs)
+			continue;
+		if (tag != -1 && Z_TagIndex(site->tag) != tag)
+			continue;
+
+		for (j = num ; j > 0 && z_sites[order[j-1]].bytes < site->bytes ; j--)
+			order[j] = order[j-1];
+		order[j] = i;
+		num++;
+	}
+
+	Com_Printf ("site                               tag               blocks      bytes       peak     allocs\n");
+	for (k = 0 ; k < num && k < count ; k++)
+	{
+		site = &z_sites[order[k]];
+		Com_Printf ("%-28s %5i %-16s %7i %10i %10i %10i\n", Z_SiteName(site), site->line,
+			z_tags[Z_TagIndex(site->tag)].name, site->count, site->bytes, site->peak, site->allocs);
+	}
+	Com_Printf ("%i of %i sites, %i bytes in %i blocks\n", k, num, z_bytes, z_count);
+}
+
+/*
+========================
+Z_Snapshot
+
+Appends every tag's counters to zone.csv each z_snapshot seconds,
+next to stats.log, to follow the growth over long server runs
+========================
+*/
+static void Z_Snapshot (void)
+{
+	int		i, now;
+	ztag_t	*t;
+
+	if (!z_snapshot->value)
+	{
+		if (z_snapshotfile)
+		{
+			fclose (z_snapshotfile);
+			z_snapshotfile = NULL;
+		}
+		return;
+	}
+
+	now = Sys_Milliseconds();
+	if (z_snapshotfile && now - z_lastSnapshotTime < z_snapshot->value * 1000)
+		return;
+	z_lastSnapshotTime = now;
+
+	if (!z_snapshotfile)
+	{
+		z_snapshotfile = fopen ("zone.csv", "a");
+		if (!z_snapshotfile)
+		{
+			Com_Printf ("Z_Snapshot: couldn't open zone.csv\n");
+			Cvar_Set ("z_snapshot", "0");
+			return;
+		}
+		fprintf (z_snapshotfile, "time,tag,blocks,bytes,peak,allocs\n");
+	}
+
+	for (i = 0, t = z_tags ; i < Z_NUM_TAGS ; i++, t++)
+	{
+		if (!t->allocs)
+			continue;
+		fprintf (z_snapshotfile, "%i,%s,%i,%i,%i,%i\n", now / 1000, t->name, t->count, t->bytes, t->peak, t->allocs);
+	}
+	fflush (z_snapshotfile);
 }
 
 //====================================================================================
@@ -1630,6 +2186,72 @@ float	crand(void)
 	return (rand()&32767)* (2.0/32767) - 1;
 }
 
+/*
+=============
+COM_CPUFeatures
+
+Returns CPU_* flags for SIMD code paths that are chosen at runtime,
+AVX is only reported when the OS also saves the YMM registers
+=============
+*/
+int COM_CPUFeatures(void)
+{
+	static int	features = -1;
+#ifdef CPUID_X86
+	unsigned int regs[4] = { 0, 0, 0, 0 }; // eax, ebx, ecx, edx
+	unsigned int maxleaf;
+	unsigned long long xcr0 = 0;
+#endif
+
+	if (features != -1)
+		return features;
+
+	features = 0;
+
+#ifdef CPUID_X86
+#ifdef _MSC_VER
+	__cpuid((int*)regs, 0);
+	maxleaf = regs[0];
+	__cpuid((int*)regs, 1);
+#else
+	maxleaf = __get_cpuid_max(0, NULL);
+	__get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+
+	if (regs[3] & (1 << 26))
+		features |= CPU_SSE2;
+	if (regs[2] & (1 << 19))
+		features |= CPU_SSE41;
+
+	// OSXSAVE and AVX
+	if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)))
+	{
+#ifdef _MSC_VER
+		xcr0 = _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+		if ((xcr0 & 6) == 6)
+			features |= CPU_AVX;
+	}
+
+	if ((features & CPU_AVX) && maxleaf >= 7)
+	{
+#ifdef _MSC_VER
+		__cpuidex((int*)regs, 7, 0);
+#else
+		__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+		if (regs[1] & (1 << 5))
+			features |= CPU_AVX2;
+	}
+#endif /*CPUID_X86*/
+
+	return features;
+}
+
 void Key_Init (void);
 void SCR_EndLoadingPlaque (void);
 
@@ -1672,7 +2294,7 @@ void Qcommon_Init (int argc, char **argv)
 	if (setjmp (abortframe) )
 		Sys_Error ("Error during initialization");
 
-	z_chain.next = z_chain.prev = &z_chain;
+	Z_Init ();
 
 	// prepare enough of the subsystems to handle
 	// cvar and command buffer management
@@ -1709,7 +2331,11 @@ void Qcommon_Init (int argc, char **argv)
 	// init commands and vars
 	//
     Cmd_AddCommand ("z_stats", Z_Stats_f);
+	z_usepools = Cvar_Get ("z_pools", "1", 0, "Serve zone memory from tag arenas and size class pools, 0 uses plain malloc for new blocks.");
+	z_snapshot = Cvar_Get ("z_snapshot", "0", 0, "Seconds between zone memory snapshots appended to zone.csv, 0 disables them.");
+    Cmd_AddCommand ("zone_report", Z_Report_f);
     Cmd_AddCommand ("error", Com_Error_f);
+	Prof_Init ();
 
 #ifndef DEDICATED_ONLY
 	host_speeds = Cvar_Get ("host_speeds", "0", 0, NULL);
@@ -1811,6 +2437,8 @@ void Qcommon_Frame (int msec)
 	if (setjmp (abortframe) )
 		return;			// an ERR_DROP was thrown
 
+	Prof_BeginFrame ();
+
 #ifndef DEDICATED_ONLY
 	if ( log_stats->modified )
 	{
@@ -1837,6 +2465,8 @@ void Qcommon_Frame (int msec)
 	}
 #endif /*DEDICATED_ONLY*/
 
+	Z_Snapshot ();
+
 	if (fixedtime->value)
 	{
 		msec = fixedtime->value;
@@ -1871,11 +2501,15 @@ void Qcommon_Frame (int msec)
 	time_before = Sys_Milliseconds ();
 #endif /*DEDICATED_ONLY*/
 
+	PROF_BEGIN ("SV_Frame");
 	SV_Frame (msec);
+	PROF_END ();
 
 #ifndef DEDICATED_ONLY
 	time_between = Sys_Milliseconds ();		
+	PROF_BEGIN ("CL_Frame");
 	CL_Frame (msec);
+	PROF_END ();
 
 	time_after = Sys_Milliseconds ();		
 
@@ -1896,6 +2530,8 @@ void Qcommon_Frame (int msec)
 	}	
 	frame_time = time_after - time_before;
 #endif /*DEDICATED_ONLY*/
+
+	Prof_EndFrame ();
 }
 
 /*
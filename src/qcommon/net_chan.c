@@ -215,6 +215,8 @@ void Netchan_Transmit (netchan_t *chan, int length, byte *data)
 		return;
 	}
 
+	PROF_BEGIN ("Netchan_Transmit");
+
 	send_reliable = Netchan_NeedReliable (chan);
 
 	if (!chan->reliable_length && chan->message.cursize)
@@ -274,6 +276,8 @@ void Netchan_Transmit (netchan_t *chan, int length, byte *data)
 				, chan->incoming_sequence
 				, chan->incoming_reliable_sequence);
 	}
+
+	PROF_END ();
 }
 
 /*
@@ -0,0 +1,328 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// profile.c -- scoped timers and trace_capture
+
+/*
+Code that wants to show up in a capture brackets itself with PROF_BEGIN and
+PROF_END, when nothing is being captured both are only a test of
+prof_capturing.
+
+trace_capture <frames> [name] records the scopes of the next frames with
+microsecond timestamps and writes them to traces/<name>.json in the game
+directory as Chrome trace events, chrome://tracing and ui.perfetto.dev open
+it as it is. Captures start and stop between frames, scopes an ERR_DROP
+jumped out of are closed at the start of the next frame.
+
+Only the main thread may record.
+*/
+
+#include "qcommon.h"
+#include <time.h>
+
+#define	PROF_MAX_EVENTS		(1<<19)
+#define	PROF_MAX_DEPTH		64
+#define	PROF_MAX_NAMES		4096		// power of two
+#define	PROF_NAMEPOOL_SIZE	(128*1024)
+
+typedef struct
+{
+	const char	*name;
+	long long	start;
+	int			duration;
+} profevent_t;
+
+qboolean			prof_capturing;
+
+static int			prof_armedFrames;			// trace_capture waiting for the next frame
+static int			prof_framesLeft;
+static int			prof_numFrames;
+static char			prof_name[MAX_QPATH];
+
+static profevent_t	*prof_events;
+static int			prof_numEvents;
+static int			prof_dropped;
+static int			prof_stack[PROF_MAX_DEPTH];
+static int			prof_depth;
+static long long	prof_startTime;
+
+// copies of names that may be gone by the time the capture is written
+static const char	**prof_names;
+static int			prof_numNames;
+static char			*prof_namePool;
+static int			prof_namePoolUsed;
+
+/*
+============
+Prof_Begin
+
+Name must stay valid until the capture is written, use Prof_BeginCopy otherwise
+============
+*/
+void Prof_Begin(const char *name)
+{
+	profevent_t	*ev;
+	int			index = -1;
+
+	if (prof_numEvents < PROF_MAX_EVENTS)
+	{
+		index = prof_numEvents++;
+		ev = &prof_events[index];
+		ev->name = name;
+		ev->duration = 0;
+		ev->start = Sys_Microseconds();
+	}
+	else
+		prof_dropped++;
+
+	if (prof_depth < PROF_MAX_DEPTH)
+		prof_stack[prof_depth] = index;
+	prof_depth++;
+}
+
+/*
+============
+Prof_CopyName
+============
+*/
+static const char *Prof_CopyName(const char *name)
+{
+	unsigned	hash;
+	const char	*s;
+	char		*copy;
+	int			i, len;
+
+	hash = 0;
+	for (s = name; *s; s++)
+		hash = hash * 31 + (byte)*s;
+
+	for (i = hash & (PROF_MAX_NAMES - 1); prof_names[i]; i = (i + 1) & (PROF_MAX_NAMES - 1))
+	{
+		if (!strcmp(prof_names[i], name))
+			return prof_names[i];
+	}
+
+	len = (int)(s - name) + 1;
+	if (prof_numNames >= PROF_MAX_NAMES / 2 || prof_namePoolUsed + len > PROF_NAMEPOOL_SIZE)
+		return "?";
+
+	copy = prof_namePool + prof_namePoolUsed;
+	memcpy(copy, name, len);
+	prof_namePoolUsed += len;
+	prof_names[i] = copy;
+	prof_numNames++;
+	return copy;
+}
+
+/*
+============
+Prof_BeginCopy
+
+Same as Prof_Begin for names that don't outlive the capture, like progs function names
+============
+*/
+void Prof_BeginCopy(const char *name)
+{
+	Prof_Begin(Prof_CopyName(name ? name : "?"));
+}
+
+/*
+============
+Prof_End
+============
+*/
+void Prof_End(void)
+{
+	int		index;
+
+	if (prof_depth <= 0)
+		return;
+
+	prof_depth--;
+	if (prof_depth >= PROF_MAX_DEPTH)
+		return;
+
+	index = prof_stack[prof_depth];
+	if (index >= 0)
+		prof_events[index].duration = (int)(Sys_Microseconds() - prof_events[index].start);
+}
+
+/*
+============
+Prof_WriteName
+============
+*/
+static void Prof_WriteName(FILE *f, const char *name)
+{
+	for (; *name; name++)
+	{
+		if (*name == '"' || *name == '\\')
+			fprintf(f, "\\%c", *name);
+		else if ((byte)*name < ' ')
+			fprintf(f, "\\u%04x", (byte)*name);
+		else
+			fputc(*name, f);
+	}
+}
+
+/*
+============
+Prof_FinishCapture
+============
+*/
+static void Prof_FinishCapture(void)
+{
+	char		path[MAX_OSPATH];
+	profevent_t	*ev;
+	FILE		*f;
+	int			i;
+
+	prof_capturing = false;
+
+	Com_sprintf(path, sizeof(path), "%s/traces/%s.json", FS_Gamedir(), prof_name);
+	FS_CreatePath(path);
+	f = fopen(path, "w");
+	if (!f)
+		Com_Printf("ERROR: couldn't write %s\n", path);
+	else
+	{
+		fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"pragma\"}},\n");
+		fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}");
+
+		for (i = 0, ev = prof_events; i < prof_numEvents; i++, ev++)
+		{
+			fprintf(f, ",\n{\"name\":\"");
+			Prof_WriteName(f, ev->name);
+			fprintf(f, "\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%i,\"pid\":1,\"tid\":1}", ev->start - prof_startTime, ev->duration);
+		}
+
+		fprintf(f, "\n]}\n");
+		fclose(f);
+
+		Com_Printf("Captured %i frames, %i events to %s\n", prof_numFrames, prof_numEvents, path);
+	}
+
+	if (prof_dropped)
+		Com_Printf("WARNING: %i events didn't fit in the capture\n", prof_dropped);
+
+	Z_Free(prof_events);
+	prof_events = NULL;
+	prof_names = NULL;
+	prof_namePool = NULL;
+}
+
+/*
+============
+Prof_EndFrame
+
+Closes whatever is still open and ends the capture after its last frame
+============
+*/
+void Prof_EndFrame(void)
+{
+	if (!prof_capturing)
+		return;
+
+	while (prof_depth)
+		Prof_End();
+
+	prof_numFrames++;
+	if (--prof_framesLeft <= 0)
+		Prof_FinishCapture();
+}
+
+/*
+============
+Prof_BeginFrame
+============
+*/
+void Prof_BeginFrame(void)
+{
+	// the previous frame was cut short by an error
+	if (prof_capturing && prof_depth)
+		Prof_EndFrame();
+
+	if (prof_armedFrames && !prof_capturing)
+	{
+		prof_events = Z_Malloc(PROF_MAX_EVENTS * sizeof(profevent_t) + PROF_MAX_NAMES * sizeof(char*) + PROF_NAMEPOOL_SIZE);
+		prof_names = (const char**)(prof_events + PROF_MAX_EVENTS);
+		prof_namePool = (char*)(prof_names + PROF_MAX_NAMES);
+
+		prof_numEvents = prof_dropped = prof_depth = 0;
+		prof_numNames = prof_namePoolUsed = 0;
+		prof_numFrames = 0;
+		prof_framesLeft = prof_armedFrames;
+		prof_armedFrames = 0;
+		prof_startTime = Sys_Microseconds();
+		prof_capturing = true;
+	}
+
+	if (prof_capturing)
+		Prof_Begin("frame");
+}
+
+/*
+============
+Prof_Capture_f
+
+trace_capture <frames> [name]
+============
+*/
+static void Prof_Capture_f(void)
+{
+	char	*name;
+	int		frames;
+
+	if (Cmd_Argc() < 2)
+	{
+		Com_Printf("USAGE: trace_capture <frames> [name]\n");
+		return;
+	}
+
+	if (prof_capturing || prof_armedFrames)
+	{
+		Com_Printf("A capture is already running.\n");
+		return;
+	}
+
+	frames = atoi(Cmd_Argv(1));
+	if (frames < 1)
+		frames = 1;
+
+	if (Cmd_Argc() > 2)
+	{
+		name = Cmd_Argv(2);
+		if (strstr(name, "..") || strstr(name, "/") || strstr(name, "\\"))
+		{
+			Com_Printf("Bad name.\n");
+			return;
+		}
+		Com_sprintf(prof_name, sizeof(prof_name), "%s", name);
+	}
+	else
+	{
+		time_t		now = time(NULL);
+		strftime(prof_name, sizeof(prof_name), "trace_%Y%m%d_%H%M%S", localtime(&now));
+	}
+
+	prof_armedFrames = frames;
+	Com_Printf("Capturing the next %i frames.\n", frames);
+}
+
+/*
+============
+Prof_Init
+============
+*/
+void Prof_Init(void)
+{
+	Cmd_AddCommand("trace_capture", Prof_Capture_f);
+}
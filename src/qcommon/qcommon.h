@@ -72,6 +72,11 @@ typedef enum memtag_s
 	TAG_SERVER_MODELDATA,
 	TAG_SERVER_GAME,
 
+	// accounting only, blocks are freed one by one
+	TAG_RENDERER,
+	TAG_SOUND,
+	TAG_SCRIPT,
+
 	NUM_MEMORY_TAGS
 } memtag_t;
 
@@ -280,7 +285,7 @@ PROTOCOL
 
 // protocol.h -- communications protocols
 
-#define PROTOCOL_REVISION 4
+#define PROTOCOL_REVISION 5
 #ifdef PROTOCOL_EXTENDED_ASSETS
 	#define	PROTOCOL_VERSION	('B'+'X'+PROTOCOL_REVISION)
 #else
@@ -345,7 +350,9 @@ enum svc_ops_e
 	SVC_PACKET_ENTITIES,		// [...]
 	SVC_DELTA_PACKET_ENTITIES,	// [...]
 
-	SVC_FRAME
+	SVC_FRAME,
+
+	SVC_DOWNLOAD_WINDOWED		// [long] id [long] size [long] offset, fragments follow out-of-band
 };
 
 //==============================================
@@ -359,11 +366,19 @@ enum clc_ops_e
 	clc_nop, 		
 	clc_move,				// [[usercmd_t]
 	clc_userinfo,			// [[userinfo string]
-	clc_stringcmd			// [string] message
+	clc_stringcmd,			// [string] message
+	clc_download_ack		// [long] id [long] first missing fragment [long] received fragments past it
 };
 
 //==============================================
 
+// windowed downloads send file fragments as out-of-band "dlfrag" packets
+// [long] id [long] fragment [short] size [size bytes], acknowledged with clc_download_ack
+#define	DOWNLOAD_FRAGMENT_SIZE	1200	// must leave room for the out-of-band header in MAX_MSGLEN
+#define	MAX_DOWNLOAD_WINDOW		32		// fragments in flight, limited by the ack bitmask
+
+//==============================================
+
 #define	PS_FX_BLEND			(1<<0)
 #define	PS_FX_BLUR			(1<<1)
 #define	PS_FX_CONTRAST		(1<<2)
@@ -769,6 +784,12 @@ char		*CM_EntityString (void);
 // creates a clipping hull for an arbitrary box
 int			CM_HeadnodeForBox (vec3_t mins, vec3_t maxs);
 
+// re-entrant collision, threads tracing at the same time each use their own
+// slot for box hulls and traces, slot 0 is the main thread's and what the
+// calls without a slot use
+#define	CM_MAX_BOXHULLS		9
+int			CM_HeadnodeForBoxSlot (vec3_t mins, vec3_t maxs, int slot);
+
 
 // returns an ORed contents mask
 int			CM_PointContents (vec3_t p, int headnode);
@@ -781,6 +802,13 @@ trace_t		CM_TransformedBoxTrace (vec3_t start, vec3_t end,
 						  vec3_t mins, vec3_t maxs,
 						  int headnode, int brushmask,
 						  vec3_t origin, vec3_t angles);
+trace_t		CM_BoxTraceSlot (vec3_t start, vec3_t end,
+						  vec3_t mins, vec3_t maxs,
+						  int headnode, int brushmask, int slot);
+trace_t		CM_TransformedBoxTraceSlot (vec3_t start, vec3_t end,
+						  vec3_t mins, vec3_t maxs,
+						  int headnode, int brushmask,
+						  vec3_t origin, vec3_t angles, int slot);
 
 byte		*CM_ClusterPVS (int cluster);
 byte		*CM_ClusterPHS (int cluster);
@@ -804,6 +832,8 @@ qboolean	CM_HeadnodeVisible (int headnode, byte *visbits);
 
 void		CM_WritePortalState (FILE *f);
 void		CM_ReadPortalState (FILE *f);
+int			CM_WritePortalStateToBuffer (byte *out);
+qboolean	CM_ReadPortalStateFromBuffer (const byte *in, int size);
 
 /*
 ==============================================================
@@ -876,6 +906,12 @@ byte		COM_BlockSequenceCRCByte (byte *base, int length, int sequence);
 float	frand(void);	// 0 ti 1
 float	crand(void);	// -1 to 1
 
+#define CPU_SSE2	1
+#define CPU_SSE41	2
+#define CPU_AVX		4
+#define CPU_AVX2	8
+int		COM_CPUFeatures(void);
+
 extern	cvar_t	*developer;
 extern	cvar_t	*dedicated;
 
@@ -891,11 +927,30 @@ extern	int		time_after_game;
 extern	int		time_before_ref;
 extern	int		time_after_ref;
 
+// scoped timers for trace_capture, see profile.c
+extern	qboolean	prof_capturing;
+
+void	Prof_Init (void);
+void	Prof_BeginFrame (void);
+void	Prof_EndFrame (void);
+void	Prof_Begin (const char *name);		// name must be a literal or outlive the capture
+void	Prof_BeginCopy (const char *name);
+void	Prof_End (void);
+
+#define	PROF_BEGIN(name)		do { if (prof_capturing) Prof_Begin (name); } while (0)
+#define	PROF_BEGIN_COPY(name)	do { if (prof_capturing) Prof_BeginCopy (name); } while (0)
+#define	PROF_END()				do { if (prof_capturing) Prof_End (); } while (0)
+
 void Z_Free (void *ptr);
 void *Z_Malloc (int size);			// returns 0 filled memory
 void *Z_TagMalloc (int size, memtag_t tag);
+void *Z_TagMallocSite (int size, memtag_t tag, const char *file, int line);
 void Z_FreeTags (memtag_t tag);
 
+// record the allocation site for zone_report
+#define	Z_Malloc(size)			Z_TagMallocSite (size, TAG_NONE, __FILE__, __LINE__)
+#define	Z_TagMalloc(size, tag)	Z_TagMallocSite (size, tag, __FILE__, __LINE__)
+
 char* COM_NewString(char* string, memtag_t memtag);
 qboolean COM_ParseField(char* key, char* value, byte* basePtr, parsefield_t* f);
 
@@ -28,7 +28,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define	MAX_DLIGHTS				32		// was 32
 #define	MAX_VISIBLE_ENTITIES	1024	// max entities a renderer can process, was 128 [previously MAX_ENTITIES]
-#define	MAX_PARTICLES			4096	// can be much higher with the new renderer
+#define	MAX_PARTICLES			65536
 #define	MAX_LIGHTSTYLES			256
 #define MAX_DEBUG_PRIMITIVES	4096
 
@@ -59,6 +59,7 @@ typedef struct rentity_s
 	// misc
 	// 
 	int		index;
+	int		entnum;			// server entity number or 0, keys renderer's per-entity caches so must be unique in a frame
 	int		inheritLight;
 	float	shadelightpoint[3]; // value from R_LightPoint without any alterations (no applied efx, etc)
 
@@ -167,7 +168,7 @@ typedef struct
 } refdef_t;
 
 
-#define	API_VERSION		('B'+'X'+'I'+'6')
+#define	API_VERSION		('B'+'X'+'I'+'7')
 
 //
 // these are the functions exported by the refresh module
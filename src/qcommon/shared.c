@@ -760,4 +760,107 @@ void Info_SetValueForKey (char *s, char *key, char *value)
 
 //====================================================================
 
+/*
+=====================================================================
+
+  NAME INDEX
+
+=====================================================================
+*/
+
+/*
+==================
+Com_HashString
+
+FNV-1a
+==================
+*/
+unsigned Com_HashString (const char *s)
+{
+	unsigned	hash;
 
+	hash = 2166136261u;
+	while (*s)
+	{
+		hash ^= (byte)*s++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/*
+==================
+NameIndex_Clear
+==================
+*/
+void NameIndex_Clear (nameindex_t *ni)
+{
+	memset (ni->names, 0, sizeof(ni->names));
+	memset (ni->buckets, 0, sizeof(ni->buckets));
+}
+
+/*
+==================
+NameIndex_Remove
+==================
+*/
+void NameIndex_Remove (nameindex_t *ni, int slot)
+{
+	short	*link;
+
+	if (slot < 0 || slot >= NAMEINDEX_MAX || !ni->names[slot])
+		return;
+
+	for (link = &ni->buckets[ni->hashes[slot] & (NAMEINDEX_BUCKETS-1)] ; *link ; link = &ni->next[*link - 1])
+	{
+		if (*link - 1 == slot)
+		{
+			*link = ni->next[slot];
+			break;
+		}
+	}
+	ni->names[slot] = NULL;
+}
+
+/*
+==================
+NameIndex_Add
+
+The name is not copied
+==================
+*/
+void NameIndex_Add (nameindex_t *ni, const char *name, int slot)
+{
+	short	*bucket;
+
+	if (slot < 0 || slot >= NAMEINDEX_MAX)
+		return;
+
+	NameIndex_Remove (ni, slot);
+
+	ni->names[slot] = name;
+	ni->hashes[slot] = Com_HashString (name);
+
+	bucket = &ni->buckets[ni->hashes[slot] & (NAMEINDEX_BUCKETS-1)];
+	ni->next[slot] = *bucket;
+	*bucket = slot + 1;
+}
+
+/*
+==================
+NameIndex_Find
+==================
+*/
+int NameIndex_Find (nameindex_t *ni, const char *name)
+{
+	unsigned	hash;
+	int			slot;
+
+	hash = Com_HashString (name);
+	for (slot = ni->buckets[hash & (NAMEINDEX_BUCKETS-1)] - 1 ; slot >= 0 ; slot = ni->next[slot] - 1)
+	{
+		if (ni->hashes[slot] == hash && !strcmp (ni->names[slot], name))
+			return slot;
+	}
+	return -1;
+}
@@ -208,6 +208,32 @@ void Info_RemoveKey (char *s, char *key);
 void Info_SetValueForKey (char *s, char *key, char *value);
 qboolean Info_Validate (char *s);
 
+//=============================================
+
+//
+// name index, finds the slot of a name in a fixed size registry
+// (configstrings, model and sound lists) without comparing against
+// every slot. The names stay in the registry and must not change
+// while indexed, a registry that rewrites names in place clears it.
+//
+#define	NAMEINDEX_MAX		2048
+#define	NAMEINDEX_BUCKETS	1024
+
+typedef struct
+{
+	const char	*names[NAMEINDEX_MAX];		// NULL if the slot is not indexed
+	unsigned	hashes[NAMEINDEX_MAX];
+	short		buckets[NAMEINDEX_BUCKETS];	// first slot + 1
+	short		next[NAMEINDEX_MAX];		// next slot + 1 in the bucket
+} nameindex_t;
+
+unsigned Com_HashString (const char *s);
+
+void NameIndex_Clear (nameindex_t *ni);
+void NameIndex_Add (nameindex_t *ni, const char *name, int slot);
+void NameIndex_Remove (nameindex_t *ni, int slot);
+int NameIndex_Find (nameindex_t *ni, const char *name);	// -1 if not found
+
 /*
 ==============================================================
 
@@ -219,8 +245,30 @@ SYSTEM SPECIFIC
 extern	int	curtime;		// time returned by last Sys_Milliseconds, FIXME: 64BIT
 
 int		Sys_Milliseconds (void);
+long long	Sys_Microseconds (void);	// high resolution, for profiling only
 void	Sys_Mkdir (char *path);
 
+// native code modules, NULL when the library or symbol can't be found
+void	*Sys_LoadLibrary (const char *path);
+void	*Sys_GetProcAddress (void *lib, const char *name);
+void	Sys_FreeLibrary (void *lib);
+
+// threads, callers must keep working inline when Sys_CreateThread returns NULL
+typedef void (*threadfunc_t)(void *arg);
+
+void	*Sys_CreateThread (threadfunc_t func, void *arg);
+void	Sys_WaitThread (void *thread);
+void	*Sys_CreateMutex (void);
+void	Sys_DestroyMutex (void *mutex);
+void	Sys_LockMutex (void *mutex);
+void	Sys_UnlockMutex (void *mutex);
+void	*Sys_CreateSemaphore (int count);
+void	Sys_DestroySemaphore (void *sem);
+void	Sys_PostSemaphore (void *sem);
+void	Sys_WaitSemaphore (void *sem);
+int		Sys_AtomicAdd (volatile int *value, int add);	// returns the new value, full barrier
+void	Sys_Sleep (int msec);
+
 // large block stack allocation routines
 void	*Hunk_Begin (int maxsize, char *name);
 void	*Hunk_Alloc (int size);
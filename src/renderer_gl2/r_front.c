@@ -0,0 +1,552 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// r_front.c -- renderer front-end
+
+// The front-end decides what is drawn this frame: it culls world chunks, decides
+// entity visibility, lights entities and builds particle billboards into r_front.
+// It never touches GL, jobs are split into slices and spread across worker
+// threads, the back-end (R_DrawWorld, R_DrawEntitiesOnList, R_DrawParticles)
+// only submits what the front-end left in r_front.
+
+#include "r_local.h"
+
+#define MAX_FRONT_WORKERS	8
+
+#define WORLD_GRAIN		256	// chunks per slice
+#define ENTITY_GRAIN	32	// entities per slice, R_EntityLightPoint is the heavy part
+#define PARTICLE_GRAIN	2048
+
+typedef void (*frontjob_t)(int first, int count);
+
+typedef struct
+{
+	void			*threads[MAX_FRONT_WORKERS];
+	int				numWorkers;
+
+	void			*wake;	// posted once per worker for each job
+	void			*done;	// posted by each worker when there are no slices left
+	volatile int	quit;
+
+	frontjob_t		job;
+	int				total;
+	int				grain;
+	volatile int	next;	// first element of the next slice
+} frontpool_t;
+
+static frontpool_t	frontpool;
+static int			front_entpass;	// 0 lights entities, 1 entities inheriting their light
+
+rfrontframe_t		r_front;
+cvar_t				*r_frontthreads;
+
+/*
+===============
+R_Front_RunSlices
+
+Grab slices until the job is exhausted, called by workers and the main thread
+===============
+*/
+static void R_Front_RunSlices()
+{
+	int first, count;
+
+	for (;;)
+	{
+		first = Sys_AtomicAdd(&frontpool.next, frontpool.grain) - frontpool.grain;
+		if (first >= frontpool.total)
+			break;
+
+		count = frontpool.total - first;
+		if (count > frontpool.grain)
+			count = frontpool.grain;
+
+		frontpool.job(first, count);
+	}
+}
+
+/*
+===============
+R_Front_Worker
+===============
+*/
+static void R_Front_Worker(void* arg)
+{
+	for (;;)
+	{
+		Sys_WaitSemaphore(frontpool.wake);
+		if (frontpool.quit)
+			break;
+
+		R_Front_RunSlices();
+		Sys_PostSemaphore(frontpool.done);
+	}
+}
+
+/*
+===============
+R_Front_ParallelFor
+
+Run job over [0, total) in slices of grain, returns when all slices are done
+===============
+*/
+static void R_Front_ParallelFor(frontjob_t job, int total, int grain, qboolean threaded)
+{
+	int i;
+
+	if (total <= 0)
+		return;
+
+	if (!threaded || !frontpool.numWorkers || total <= grain)
+	{
+		job(0, total);
+		return;
+	}
+
+	frontpool.job = job;
+	frontpool.total = total;
+	frontpool.grain = grain;
+	frontpool.next = 0;
+
+	for (i = 0; i < frontpool.numWorkers; i++)
+		Sys_PostSemaphore(frontpool.wake);
+
+	R_Front_RunSlices();
+
+	for (i = 0; i < frontpool.numWorkers; i++)
+		Sys_WaitSemaphore(frontpool.done);
+}
+
+/*
+===============
+R_Front_StopWorkers
+===============
+*/
+static void R_Front_StopWorkers()
+{
+	int i;
+
+	if (frontpool.numWorkers)
+	{
+		frontpool.quit = true;
+		for (i = 0; i < frontpool.numWorkers; i++)
+			Sys_PostSemaphore(frontpool.wake);
+		for (i = 0; i < frontpool.numWorkers; i++)
+			Sys_WaitThread(frontpool.threads[i]);
+	}
+
+	if (frontpool.wake)
+		Sys_DestroySemaphore(frontpool.wake);
+	if (frontpool.done)
+		Sys_DestroySemaphore(frontpool.done);
+
+	memset(&frontpool, 0, sizeof(frontpool));
+}
+
+/*
+===============
+R_Front_StartWorkers
+
+Falls back to running the front-end inline when threads can't be created
+===============
+*/
+static void R_Front_StartWorkers(int count)
+{
+	void *thread;
+
+	R_Front_StopWorkers();
+
+	if (count > MAX_FRONT_WORKERS)
+		count = MAX_FRONT_WORKERS;
+	if (count <= 0)
+		return;
+
+	frontpool.wake = Sys_CreateSemaphore(0);
+	frontpool.done = Sys_CreateSemaphore(0);
+	if (!frontpool.wake || !frontpool.done)
+	{
+		ri.Printf(PRINT_ALL, "R_Front_StartWorkers: failed to create semaphores, front-end runs on main thread\n");
+		R_Front_StopWorkers();
+		return;
+	}
+
+	while (frontpool.numWorkers < count)
+	{
+		thread = Sys_CreateThread(R_Front_Worker, NULL);
+		if (!thread)
+			break;
+		frontpool.threads[frontpool.numWorkers++] = thread;
+	}
+
+	ri.Printf(PRINT_LOW, "Renderer front-end: %i worker threads\n", frontpool.numWorkers);
+}
+
+// ==============================================================================
+// JOBS
+// ==============================================================================
+
+/*
+=================
+R_Front_EntityVisible
+
+Decides whenever entity is visible and could be drawn
+=================
+*/
+static qboolean R_Front_EntityVisible(rentity_t* ent)
+{
+	model_t	*model = ent->model;
+	int		i;
+	vec3_t	mins, maxs, v;
+	float	scale = 1.0f;
+
+	if (!model) // this shouldn't really happen at this point!
+		return false;
+
+	if (model->type == MOD_SPRITE)
+		return true;
+
+	if (ent->alpha <= 0.01f && (ent->renderfx & RF_TRANSLUCENT))
+		return false; // back-end warns about these
+
+	if (ent->renderfx & RF_VIEW_MODEL)
+	{
+		// don't cull viwmodels unless its centered
+		return r_lefthand->value == 2 ? false : true;
+	}
+	else if (model->cullDist > 0.0f)
+	{
+		// cull objects based on distance TODO: account for scale or na?
+		VectorSubtract(r_newrefdef.view.origin, ent->origin, v); // FIXME: doesn't account for FOV
+		if (VectorLength(v) > model->cullDist)
+			return false;
+	}
+
+	if (model->type == MOD_MD3)
+	{
+		// technicaly this could be used for sprites, but it takes
+		// more cycles culling than actually rendering them lol
+
+		if ((ent->renderfx & RF_SCALE) && ent->scale != 1.0f && ent->scale > 0.0f)
+			scale = ent->scale;
+
+		if (ent->angles[0] || ent->angles[1] || ent->angles[2] || scale != 1.0)
+		{
+			for (i = 0; i < 3; i++)
+			{
+				mins[i] = ent->origin[i] - (model->radius * scale);
+				maxs[i] = ent->origin[i] + (model->radius * scale);
+			}
+		}
+		else
+		{
+			VectorAdd(ent->origin, model->mins, mins);
+			VectorAdd(ent->origin, model->maxs, maxs);
+		}
+
+		if (R_CullBox(mins, maxs))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+=================
+R_Front_EntityShadeLight
+
+get lighting information for entity
+=================
+*/
+static void R_Front_EntityShadeLight(rentity_t* ent, rfrontent_t* fe)
+{
+	float	scale;
+	float	min;
+	float	an;
+	int		i;
+
+	if ((ent->renderfx & RF_COLOR))
+	{
+		VectorCopy(ent->renderColor, fe->shadelight);
+	}
+	else if (ent->renderfx & RF_FULLBRIGHT || r_fullbright->value)
+	{
+		VectorSet(fe->shadelight, 1.0f, 1.0f, 1.0f);
+	}
+	else
+	{
+		if (ent->inheritLight > 0)
+		{
+			VectorCopy(r_newrefdef.entities[ent->inheritLight].shadelightpoint, fe->shadelight);
+		}
+		else
+		{
+			R_EntityLightPoint(ent, fe->shadelight);
+			VectorCopy(fe->shadelight, ent->shadelightpoint);
+		}
+	}
+
+	if (ent->renderfx & RF_MINLIGHT)
+	{
+		for (i = 0; i < 3; i++)
+			if (fe->shadelight[i] > 0.1)
+				break;
+
+		if (i == 3)
+		{
+			VectorSet(fe->shadelight, 0.1f, 0.1f, 0.1f);
+		}
+	}
+
+	if (ent->renderfx & RF_GLOW)
+	{
+		scale = 0.1 * sin(r_newrefdef.time * 7.0);
+		for (i = 0; i < 3; i++)
+		{
+			min = fe->shadelight[i] * 0.8;
+			fe->shadelight[i] += scale;
+			if (fe->shadelight[i] < min)
+				fe->shadelight[i] = min;
+		}
+	}
+
+	// this is uttery shit
+	an = ent->angles[1] / 180 * M_PI;
+	fe->shadevector[0] = cos(-an);
+	fe->shadevector[1] = sin(-an);
+	fe->shadevector[2] = -1;
+	VectorNormalize(fe->shadevector);
+}
+
+/*
+=================
+R_Front_EntityJob
+
+Entities which inherit light are done in a second pass, after
+the entities they inherit from have their shadelightpoint set
+=================
+*/
+static void R_Front_EntityJob(int first, int count)
+{
+	rentity_t	*ent;
+	rfrontent_t	*fe;
+	int			i;
+
+	for (i = first; i < first + count; i++)
+	{
+		ent = &r_newrefdef.entities[i];
+		fe = &r_front.entities[i];
+
+		if ((ent->inheritLight > 0) != (front_entpass == 1))
+			continue;
+
+		// beams and brushmodels are culled by the back-end
+		if ((ent->renderfx & RF_BEAM) || !ent->model || ent->model->type == MOD_BRUSH)
+		{
+			fe->visible = true;
+			continue;
+		}
+
+		fe->visible = R_Front_EntityVisible(ent);
+		if (fe->visible)
+			R_Front_EntityShadeLight(ent, fe);
+	}
+}
+
+/*
+=================
+R_Front_ParticleJob
+
+Particles from one effect mostly share size, only rescale the billboard when it changes
+=================
+*/
+static void R_Front_ParticleJob(int first, int count)
+{
+	const particle_t	*p;
+	glvert_t			*v;
+	int					i;
+	vec3_t				up, right;
+	vec2_t				size;
+
+	size[0] = size[1] = -1.0f;
+
+	p = r_newrefdef.particles + first;
+	v = r_front.particleVerts + first * 3;
+	for (i = 0; i < count; i++, p++, v += 3)
+	{
+		if (p->size[0] != size[0] || p->size[1] != size[1])
+		{
+			size[0] = p->size[0];
+			size[1] = p->size[1];
+			if (size[0] > 0.0f && size[1] > 0.0f)
+			{
+				VectorScale(vup, size[0], up);
+				VectorScale(vright, size[1], right);
+			}
+			else
+			{
+				VectorScale(vup, 3.0f, up);
+				VectorScale(vright, 3.0f, right);
+			}
+		}
+
+		Vector4Set(v[0].rgba, p->color[0], p->color[1], p->color[2], p->alpha);
+		Vector4Copy(v[0].rgba, v[1].rgba);
+		Vector4Copy(v[0].rgba, v[2].rgba);
+
+		VectorCopy(p->origin, v[0].xyz);
+		VectorAdd(p->origin, up, v[1].xyz);
+		VectorAdd(p->origin, right, v[2].xyz);
+	}
+}
+
+// ==============================================================================
+// FRONT-END
+// ==============================================================================
+
+/*
+=================
+R_Front_BuildFrame
+
+Fill r_front for r_newrefdef, frustum, view vectors and view clusters must be set.
+Particle billboards are written to particleVerts which must hold 3 * MAX_PARTICLES verts.
+=================
+*/
+void R_Front_BuildFrame(glvert_t* particleVerts, qboolean threaded)
+{
+	long long start;
+
+	if (r_frontthreads->modified)
+	{
+		r_frontthreads->modified = false;
+		R_Front_StartWorkers((int)r_frontthreads->value);
+	}
+
+	//
+	// world
+	//
+	start = Sys_Microseconds();
+	r_front.numWorldChunks = 0;
+	if (r_worldmodel && !(r_newrefdef.view.flags & RDF_NOWORLDMODEL))
+	{
+		r_front.numWorldChunks = R_World_PrepareFrontChunks();
+		R_Front_ParallelFor(R_World_CullFrontChunks, r_front.numWorldChunks, WORLD_GRAIN, threaded);
+	}
+	r_front.stageUsec[FRONT_WORLD] = Sys_Microseconds() - start;
+
+	//
+	// entities
+	//
+	start = Sys_Microseconds();
+	r_front.numEntities = r_newrefdef.num_entities;
+	if (r_front.numEntities > MAX_VISIBLE_ENTITIES)
+		r_front.numEntities = MAX_VISIBLE_ENTITIES;
+
+	if (r_drawentities->value)
+	{
+		for (front_entpass = 0; front_entpass < 2; front_entpass++)
+			R_Front_ParallelFor(R_Front_EntityJob, r_front.numEntities, ENTITY_GRAIN, threaded);
+	}
+	r_front.stageUsec[FRONT_ENTITIES] = Sys_Microseconds() - start;
+
+	//
+	// particles
+	//
+	start = Sys_Microseconds();
+	r_front.particleVerts = particleVerts;
+	r_front.numParticles = r_newrefdef.num_particles;
+	if (r_front.numParticles > MAX_PARTICLES)
+		r_front.numParticles = MAX_PARTICLES;
+	if (r_front.numParticles < 0 || !particleVerts)
+		r_front.numParticles = 0;
+
+	R_Front_ParallelFor(R_Front_ParticleJob, r_front.numParticles, PARTICLE_GRAIN, threaded);
+	r_front.stageUsec[FRONT_PARTICLES] = Sys_Microseconds() - start;
+}
+
+/*
+=================
+R_Front_Bench_f
+
+r_frontbench [frames]
+
+Run only the front-end on the last rendered view, first inline and then on
+workers. Nothing is submitted to GL, the results of the last frame are kept.
+=================
+*/
+static void R_Front_Bench_f()
+{
+	static const char	*stagenames[NUM_FRONT_STAGES] = { "world", "entities", "particles" };
+	long long			total[2][NUM_FRONT_STAGES];
+	glvert_t			*verts;
+	int					frames, i, j, pass;
+
+	if (!r_worldmodel || !r_newrefdef.width)
+	{
+		ri.Printf(PRINT_ALL, "r_frontbench: no view has been rendered yet\n");
+		return;
+	}
+
+	frames = ri.Cmd_Argc() > 1 ? atoi(ri.Cmd_Argv(1)) : 100;
+	if (frames < 1)
+		frames = 1;
+
+	verts = malloc(sizeof(glvert_t) * 3 * MAX_PARTICLES);
+	if (!verts)
+	{
+		ri.Printf(PRINT_ALL, "r_frontbench: out of memory\n");
+		return;
+	}
+
+	memset(total, 0, sizeof(total));
+	for (pass = 0; pass < 2; pass++)
+	{
+		for (i = 0; i < frames; i++)
+		{
+			R_Front_BuildFrame(verts, pass == 1);
+			for (j = 0; j < NUM_FRONT_STAGES; j++)
+				total[pass][j] += r_front.stageUsec[j];
+		}
+	}
+	free(verts);
+
+	ri.Printf(PRINT_ALL, "front-end over %i frames: %i world chunks, %i entities, %i particles, %i workers\n",
+		frames, r_front.numWorldChunks, r_front.numEntities, r_front.numParticles, frontpool.numWorkers);
+	for (j = 0; j < NUM_FRONT_STAGES; j++)
+	{
+		ri.Printf(PRINT_ALL, "%10s: %7.3f ms inline, %7.3f ms threaded\n", stagenames[j],
+			total[0][j] / 1000.0 / frames, total[1][j] / 1000.0 / frames);
+	}
+}
+
+/*
+=================
+R_Front_Init
+=================
+*/
+void R_Front_Init()
+{
+	r_frontthreads = ri.Cvar_Get("r_frontthreads", "2", CVAR_ARCHIVE, "Number of worker threads for renderer front-end, 0 runs it on main thread.");
+	r_frontthreads->modified = false;
+
+	R_Front_StartWorkers((int)r_frontthreads->value);
+
+	ri.AddCommand("r_frontbench", R_Front_Bench_f);
+}
+
+/*
+=================
+R_Front_Shutdown
+=================
+*/
+void R_Front_Shutdown()
+{
+	ri.RemoveCommand("r_frontbench");
+	R_Front_StopWorkers();
+}
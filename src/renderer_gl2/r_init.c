@@ -43,6 +43,7 @@ cvar_t* r_texturemode;
 cvar_t* r_texturealphamode;
 cvar_t* r_texturesolidmode;
 cvar_t* r_lockpvs;
+cvar_t* r_worldlists;
 
 cvar_t* r_fullscreen;
 cvar_t* r_intensity;
@@ -62,6 +63,7 @@ void GL_Strings_f(void);
 extern vertexbuffer_t vb_gui;
 extern vertexbuffer_t vb_sky;
 extern vertexbuffer_t *vb_particles;
+void R_InitParticles(void);
 /*
 ==================
 R_RegisterCvarsAndCommands
@@ -83,6 +85,7 @@ void R_RegisterCvarsAndCommands(void)
 	r_novis = ri.Cvar_Get("r_novis", "0", CVAR_CHEAT, "Do not cull by VIS data.");
 	r_nocull = ri.Cvar_Get("r_nocull", "0", CVAR_CHEAT, "Disable frustum culling.");
 	r_lockpvs = ri.Cvar_Get("r_lockpvs", "0", CVAR_CHEAT, "Lock PVS.");
+	r_worldlists = ri.Cvar_Get("r_worldlists", "1", CVAR_ARCHIVE, "Draw world from precomputed per-cluster surface lists instead of walking BSP tree.");
 
 	r_lerpmodels = ri.Cvar_Get("r_lerpmodels", "1", CVAR_CHEAT, "Smooth model animations.");
 
@@ -351,7 +354,10 @@ int R_Init(void* hinstance, void* hWnd)
 	R_InitSprites();
 	R_LoadFonts();
 
-	vb_particles = R_AllocVertexBuffer((V_UV | V_COLOR | V_NOFREE), (3 * MAX_PARTICLES), 0);
+	R_InitParticles();
+	R_Front_Init();
+	R_LightGrid_Init();
+	R_Instance_Init();
 
 	err = glGetError();
 	if (err != GL_NO_ERROR)
@@ -372,6 +378,9 @@ void R_Shutdown(void)
 	ri.RemoveCommand("imagelist");
 	ri.RemoveCommand("gl_strings");
 
+	R_Front_Shutdown();
+	R_Instance_Shutdown();
+
 	R_FreeFrameBuffer();
 	R_FreePrograms();
 
@@ -0,0 +1,468 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// r_instance.c -- instanced md3 rendering
+
+// Opaque md3 entities sharing model, frame pair and hidden parts are drawn with one
+// instanced draw per surface instead of one draw per surface per entity. Frames are
+// picked with attribute offsets into the model vertex buffer so the frame pair is part
+// of the batch key, matrix, lighting and lerp of each instance come from a per-instance
+// vertex buffer instead of uniforms.
+//
+// Needs GL_ARB_instanced_arrays, GL_ARB_draw_instanced and shaders/model_alias_instanced,
+// a copy of model_alias which reads inInstanceMatrix (localmodelview), inInstanceShade
+// (shade_light, lerpFrac) and inInstanceShadeVector (shade_vector) attributes. Without
+// them every entity goes through R_DrawEntityModel like before.
+//
+// R_Instance_BuildBatches and R_Instance_CountDraws never touch GL so batching can be
+// checked on a list of entities alone, r_instancestats prints them for the last frame.
+
+#include "r_local.h"
+
+#define BUFFER_OFFSET(i) ((char*)NULL + (i))
+
+typedef void (APIENTRY *vertexattribdivisorproc_t)(GLuint index, GLuint divisor);
+typedef void (APIENTRY *drawarraysinstancedproc_t)(GLenum mode, GLint first, GLsizei count, GLsizei primcount);
+
+typedef struct
+{
+	float		matrix[16];
+	float		shade[4];		// shadelight, lerp
+	float		shadevector[4];
+} md3instance_t;
+
+static vertexattribdivisorproc_t	qglVertexAttribDivisorARB;
+static drawarraysinstancedproc_t	qglDrawArraysInstancedARB;
+
+static unsigned int		instanceBuf;
+static md3instance_t	instanceData[MAX_VISIBLE_ENTITIES];
+static qboolean			instanceCandidates[MAX_VISIBLE_ENTITIES];
+static rentity_t		*sortEnts;
+
+md3batchlist_t	r_md3batches;
+cvar_t			*r_instancing;
+
+/*
+=================
+R_Instance_SameBatch
+=================
+*/
+static qboolean R_Instance_SameBatch(const rentity_t* a, const rentity_t* b)
+{
+	return a->model == b->model && a->frame == b->frame && a->oldframe == b->oldframe && a->hiddenPartsBits == b->hiddenPartsBits;
+}
+
+/*
+=================
+R_Instance_SortCmp
+
+Groups entities by batch key, ties are kept in list order
+=================
+*/
+static int R_Instance_SortCmp(const void* a, const void* b)
+{
+	const rentity_t *ea = &sortEnts[*(const int*)a];
+	const rentity_t *eb = &sortEnts[*(const int*)b];
+
+	if (ea->model != eb->model)
+		return ea->model->index - eb->model->index;
+	if (ea->frame != eb->frame)
+		return ea->frame - eb->frame;
+	if (ea->oldframe != eb->oldframe)
+		return ea->oldframe - eb->oldframe;
+	if (ea->hiddenPartsBits != eb->hiddenPartsBits)
+		return ea->hiddenPartsBits - eb->hiddenPartsBits;
+	return *(const int*)a - *(const int*)b;
+}
+
+/*
+=================
+R_Instance_BuildBatches
+
+Sorts candidate entities by model, frame pair and hidden parts, runs of two or more become
+batches. Entities left out (batched[i] == false) are drawn one by one. Returns number of batches
+=================
+*/
+int R_Instance_BuildBatches(rentity_t* ents, const qboolean* candidates, int numEnts, md3batchlist_t* list)
+{
+	md3batch_t	*batch;
+	rentity_t	*ent;
+	int			i, run, count, numCandidates;
+
+	list->numBatches = 0;
+	list->numInstances = 0;
+	memset(list->batched, 0, sizeof(list->batched[0]) * numEnts);
+
+	numCandidates = 0;
+	for (i = 0; i < numEnts; i++)
+	{
+		if (candidates[i])
+			list->instances[numCandidates++] = i;
+	}
+
+	if (numCandidates < 2)
+		return 0;
+
+	sortEnts = ents;
+	qsort(list->instances, numCandidates, sizeof(list->instances[0]), R_Instance_SortCmp);
+
+	// compact runs into batches, instances are only ever moved towards the front
+	for (i = 0; i < numCandidates; i += count)
+	{
+		ent = &ents[list->instances[i]];
+		for (count = 1; i + count < numCandidates; count++)
+		{
+			if (!R_Instance_SameBatch(ent, &ents[list->instances[i + count]]))
+				break;
+		}
+
+		if (count < 2)
+			continue;
+
+		batch = &list->batches[list->numBatches++];
+		batch->model = ent->model;
+		batch->frame = ent->frame;
+		batch->oldframe = ent->oldframe;
+		batch->hiddenPartsBits = ent->hiddenPartsBits;
+		batch->firstInstance = list->numInstances;
+		batch->numInstances = count;
+
+		for (run = 0; run < count; run++)
+		{
+			list->batched[list->instances[i + run]] = true;
+			list->instances[list->numInstances++] = list->instances[i + run];
+		}
+	}
+
+	return list->numBatches;
+}
+
+/*
+=================
+R_Instance_SurfaceDraws
+
+Draw calls R_DrawMD3Model would issue for entity
+=================
+*/
+static int R_Instance_SurfaceDraws(rentity_t* ent)
+{
+	md3Header_t	*pModel = ent->model->md3[LOD_HIGH];
+	int			surf, draws;
+
+	draws = 0;
+	for (surf = 0; surf < pModel->numSurfaces; surf++)
+	{
+		if (!(ent->hiddenPartsBits & (1 << surf)))
+			draws++;
+	}
+	return draws;
+}
+
+/*
+=================
+R_Instance_CountDraws
+
+Surface draw calls for candidate entities without and with batching
+=================
+*/
+void R_Instance_CountDraws(rentity_t* ents, const qboolean* candidates, int numEnts, const md3batchlist_t* list, int* individual, int* instanced)
+{
+	int i;
+
+	*individual = *instanced = 0;
+	for (i = 0; i < numEnts; i++)
+	{
+		if (!candidates[i])
+			continue;
+
+		*individual += R_Instance_SurfaceDraws(&ents[i]);
+		if (!list->batched[i])
+			*instanced += R_Instance_SurfaceDraws(&ents[i]);
+	}
+
+	for (i = 0; i < list->numBatches; i++)
+		*instanced += R_Instance_SurfaceDraws(&ents[list->instances[list->batches[i].firstInstance]]);
+}
+
+/*
+=================
+R_Instance_Candidate
+
+Entity can be drawn by a batch, anything with per entity state stays on the regular path
+=================
+*/
+static qboolean R_Instance_Candidate(rentity_t* ent, int index)
+{
+	model_t *mod = ent->model;
+
+	if (!mod || mod->type != MOD_MD3 || !mod->md3[LOD_HIGH] || !mod->vb[0])
+		return false;
+
+	if (ent->renderfx & (RF_BEAM | RF_TRANSLUCENT | RF_DEPTHHACK | RF_VIEW_MODEL | RF_FULLBRIGHT))
+		return false;
+
+	if (index >= r_front.numEntities || !r_front.entities[index].visible)
+		return false;
+
+	// broken frames are reported and fixed by R_DrawEntityModel
+	if (ent->frame < 0 || ent->frame >= mod->numframes || ent->oldframe < 0 || ent->oldframe >= mod->numframes)
+		return false;
+
+	return true;
+}
+
+/*
+=================
+R_Instance_Available
+=================
+*/
+static qboolean R_Instance_Available()
+{
+	glprog_t *prog = R_ProgramIndex(GLPROG_ALIAS_INSTANCED);
+
+	return r_instancing->value && qglVertexAttribDivisorARB && qglDrawArraysInstancedARB && instanceBuf && prog && prog->isValid;
+}
+
+/*
+=================
+R_Instance_Attrib
+=================
+*/
+static void R_Instance_Attrib(glprogLoc_t attrib, int size, int stride, int offset, qboolean perInstance)
+{
+	int loc = R_GetProgAttribLoc(attrib);
+
+	if (loc == -1)
+		return;
+
+	glEnableVertexAttribArray(loc);
+	glVertexAttribPointer(loc, size, GL_FLOAT, GL_FALSE, stride, BUFFER_OFFSET(offset));
+	qglVertexAttribDivisorARB(loc, perInstance ? 1 : 0);
+}
+
+/*
+=================
+R_Instance_DisableAttribs
+=================
+*/
+static void R_Instance_DisableAttribs()
+{
+	int i, j, loc;
+
+	for (i = 0; i < NUM_VALOCS; i++)
+	{
+		loc = R_GetProgAttribLoc(i);
+		if (loc == -1)
+			continue;
+
+		// divisors stick to attribute locations, reset them for other programs
+		for (j = 0; j < (i == VALOC_INSTANCE_MATRIX ? 4 : 1); j++)
+		{
+			glDisableVertexAttribArray(loc + j);
+			qglVertexAttribDivisorARB(loc + j, 0);
+		}
+	}
+}
+
+/*
+=================
+R_Instance_DrawBatch
+=================
+*/
+static void R_Instance_DrawBatch(md3batch_t* batch)
+{
+	model_t			*mod = batch->model;
+	md3Header_t		*pModel = mod->md3[LOD_HIGH];
+	vertexbuffer_t	*vbo;
+	int				surf, surfverts, framesize, instofs, loc, col;
+
+	instofs = batch->firstInstance * sizeof(md3instance_t);
+
+	for (surf = 0; surf < pModel->numSurfaces; surf++)
+	{
+		if (batch->hiddenPartsBits & (1 << surf))
+			continue; // surface is hidden
+
+		vbo = mod->vb[surf];
+		surfverts = vbo->numVerts / pModel->numFrames;
+		framesize = sizeof(glvert_t) * vbo->numVerts / mod->numframes;
+
+		R_MultiTextureBind(TMU_DIFFUSE, mod->images[surf]->texnum);
+
+		glBindBuffer(GL_ARRAY_BUFFER, vbo->vboBuf);
+		R_Instance_Attrib(VALOC_OLD_POS, 3, sizeof(glvert_t), batch->oldframe * framesize, false);
+		R_Instance_Attrib(VALOC_POS, 3, sizeof(glvert_t), batch->frame * framesize, false);
+		R_Instance_Attrib(VALOC_OLD_NORMAL, 3, sizeof(glvert_t), 12 + batch->oldframe * framesize, false);
+		R_Instance_Attrib(VALOC_NORMAL, 3, sizeof(glvert_t), 12 + batch->frame * framesize, false);
+		R_Instance_Attrib(VALOC_TEXCOORD, 2, sizeof(glvert_t), 24 + batch->frame * framesize, false);
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuf);
+		loc = R_GetProgAttribLoc(VALOC_INSTANCE_MATRIX);
+		if (loc != -1)
+		{
+			for (col = 0; col < 4; col++)
+			{
+				glEnableVertexAttribArray(loc + col);
+				glVertexAttribPointer(loc + col, 4, GL_FLOAT, GL_FALSE, sizeof(md3instance_t), BUFFER_OFFSET(instofs + col * 4 * sizeof(float)));
+				qglVertexAttribDivisorARB(loc + col, 1);
+			}
+		}
+		R_Instance_Attrib(VALOC_INSTANCE_SHADE, 4, sizeof(md3instance_t), instofs + 16 * sizeof(float), true);
+		R_Instance_Attrib(VALOC_INSTANCE_SHADEVECTOR, 4, sizeof(md3instance_t), instofs + 20 * sizeof(float), true);
+
+		qglDrawArraysInstancedARB(GL_TRIANGLES, 0, surfverts, batch->numInstances);
+
+		R_Instance_DisableAttribs();
+
+		if (r_speeds->value)
+			rperf.alias_tris += (surfverts / 3) * batch->numInstances;
+	}
+}
+
+/*
+=================
+R_Instance_DrawBatches
+
+Batches this frame's opaque md3 entities and draws them, R_DrawEntitiesOnList skips batched ones
+=================
+*/
+void R_Instance_DrawBatches()
+{
+	md3batchlist_t	*list = &r_md3batches;
+	md3instance_t	*inst;
+	rfrontent_t		*fe;
+	rentity_t		*ent;
+	int				i;
+
+	list->numBatches = list->numInstances = 0;
+	memset(list->batched, 0, sizeof(list->batched));
+
+	if (!R_Instance_Available())
+		return;
+
+	for (i = 0; i < r_newrefdef.num_entities; i++)
+		instanceCandidates[i] = R_Instance_Candidate(&r_newrefdef.entities[i], i);
+
+	if (!R_Instance_BuildBatches(r_newrefdef.entities, instanceCandidates, r_newrefdef.num_entities, list))
+		return;
+
+	for (i = 0, inst = instanceData; i < list->numInstances; i++, inst++)
+	{
+		ent = &r_newrefdef.entities[list->instances[i]];
+		fe = &r_front.entities[list->instances[i]];
+
+		R_SetEntityLocalMatrix(ent);
+		memcpy(inst->matrix, r_local_matrix, sizeof(inst->matrix));
+
+		VectorCopy(fe->shadelight, inst->shade);
+		if (!r_lerpmodels->value || ent->renderfx & RF_NOANIMLERP)
+			inst->shade[3] = 1.0f;
+		else
+			inst->shade[3] = 1.0f - ent->animbacklerp;
+
+		VectorCopy(fe->shadevector, inst->shadevector);
+		inst->shadevector[3] = 0.0f;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuf);
+	glBufferData(GL_ARRAY_BUFFER, list->numInstances * sizeof(md3instance_t), instanceData, GL_STREAM_DRAW);
+
+	R_BindProgram(GLPROG_ALIAS_INSTANCED);
+	R_ProgUniform1f(LOC_PARM0, r_fullbright->value ? 1 : 0);
+	R_ProgUniform4f(LOC_COLOR4, 1, 1, 1, 1);
+
+	for (i = 0; i < list->numBatches; i++)
+		R_Instance_DrawBatch(&list->batches[i]);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (r_speeds->value)
+	{
+		rperf.alias_drawcalls += list->numBatches; // one instanced draw each
+		rperf.alias_instanced += list->numInstances;
+		rperf.alias_batches += list->numBatches;
+	}
+}
+
+/*
+=================
+R_Instance_Stats_f
+
+Prints how many draw calls batching saves on the last rendered view
+=================
+*/
+static void R_Instance_Stats_f()
+{
+	static md3batchlist_t	list;
+	int						i, numCandidates, individual, instanced;
+
+	if (!r_worldmodel || !r_newrefdef.entities)
+	{
+		ri.Printf(PRINT_ALL, "no view rendered yet\n");
+		return;
+	}
+
+	numCandidates = 0;
+	for (i = 0; i < r_newrefdef.num_entities; i++)
+	{
+		instanceCandidates[i] = R_Instance_Candidate(&r_newrefdef.entities[i], i);
+		numCandidates += instanceCandidates[i];
+	}
+
+	R_Instance_BuildBatches(r_newrefdef.entities, instanceCandidates, r_newrefdef.num_entities, &list);
+	R_Instance_CountDraws(r_newrefdef.entities, instanceCandidates, r_newrefdef.num_entities, &list, &individual, &instanced);
+
+	ri.Printf(PRINT_ALL, "%i entities, %i can be instanced, %i in %i batches\n", r_newrefdef.num_entities, numCandidates, list.numInstances, list.numBatches);
+	ri.Printf(PRINT_ALL, "%i md3 surface draws, %i with instancing (%s)\n", individual, instanced, R_Instance_Available() ? "enabled" : "unavailable");
+}
+
+/*
+=================
+R_Instance_Init
+=================
+*/
+void R_Instance_Init()
+{
+	r_instancing = ri.Cvar_Get("r_instancing", "1", CVAR_ARCHIVE, "Draw repeated md3 models with instancing when supported.");
+
+	qglVertexAttribDivisorARB = NULL;
+	qglDrawArraysInstancedARB = NULL;
+
+#ifdef _WIN32
+	if (strstr(gl_config.extensions_string, "GL_ARB_instanced_arrays") && strstr(gl_config.extensions_string, "GL_ARB_draw_instanced"))
+	{
+		qglVertexAttribDivisorARB = (vertexattribdivisorproc_t)qwglGetProcAddress("glVertexAttribDivisorARB");
+		qglDrawArraysInstancedARB = (drawarraysinstancedproc_t)qwglGetProcAddress("glDrawArraysInstancedARB");
+		ri.Printf(PRINT_ALL, "...enabling GL_ARB_instanced_arrays\n");
+	}
+	else
+	{
+		ri.Printf(PRINT_ALL, "...GL_ARB_instanced_arrays not found\n");
+	}
+#endif
+
+	glGenBuffers(1, &instanceBuf);
+
+	ri.AddCommand("r_instancestats", R_Instance_Stats_f);
+}
+
+/*
+=================
+R_Instance_Shutdown
+=================
+*/
+void R_Instance_Shutdown()
+{
+	ri.RemoveCommand("r_instancestats");
+
+	if (instanceBuf && glDeleteBuffers)
+		glDeleteBuffers(1, &instanceBuf);
+	instanceBuf = 0;
+}
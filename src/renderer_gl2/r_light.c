@@ -187,11 +187,8 @@ LIGHT SAMPLING
 =============================================================================
 */
 
-static vec3_t		pointcolor;
-static cplane_t		*lightplane;	// used as shadow plane
-static vec3_t		lightspot;
-
-static int R_RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
+// the sample is passed down instead of kept in a global so front-end workers can light entities in parallel
+static int R_RecursiveLightPoint(model_t *mod, mnode_t *node, vec3_t start, vec3_t end, lightsample_t *sample)
 {
 	float		front, back, frac;
 	int			side, maps, r, i;
@@ -216,7 +213,7 @@ static int R_RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
 	side = front < 0;
 	
 	if ( (back < 0) == side)
-		return R_RecursiveLightPoint (node->children[side], start, end);
+		return R_RecursiveLightPoint (mod, node->children[side], start, end, sample);
 	
 	frac = front / (front - back);
 	mid[0] = start[0] + (end[0] - start[0]) * frac;
@@ -226,7 +223,7 @@ static int R_RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
 	//
 	// go down front side	
 	//
-	r = R_RecursiveLightPoint (node->children[side], start, mid);
+	r = R_RecursiveLightPoint (mod, node->children[side], start, mid, sample);
 	if (r >= 0)
 		return r; // hit something
 		
@@ -236,10 +233,7 @@ static int R_RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
 	//
 	// check for impact on this node
 	//
-	VectorCopy (mid, lightspot);
-	lightplane = plane;
-
-	surf = r_worldmodel->surfaces + node->firstsurface;
+	surf = mod->surfaces + node->firstsurface;
 	for (i = 0; i < node->numsurfaces; i++, surf++)
 	{
 		if (surf->flags & (SURF_DRAWTURB|SURF_DRAWSKY)) 
@@ -276,30 +270,18 @@ static int R_RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
 		ds >>= surf->lmshift;
 		dt >>= surf->lmshift;
 		
-		VectorCopy (vec3_origin, pointcolor);
+		sample->numstyles = 0;
 		if (lightmap)
 		{
-			vec3_t scale;
-
 			lightmap += 3 * (dt * ((surf->extents[0] >> surf->lmshift) + 1) + ds);
 
 			for (maps = 0 ; maps < MAX_LIGHTMAPS_PER_SURFACE && surf->styles[maps] != 255 ; maps++)
 			{
-				if (r_dynamic->value)
-				{
-					for (i = 0; i < 3; i++)
-						scale[i] = r_modulate->value * r_newrefdef.lightstyles[surf->styles[maps]].rgb[i];
-
-					pointcolor[0] += lightmap[0] * scale[0] * (1.0 / 255);
-					pointcolor[1] += lightmap[1] * scale[1] * (1.0 / 255);
-					pointcolor[2] += lightmap[2] * scale[2] * (1.0 / 255);
-				}
-				else
-				{
-					pointcolor[0] += lightmap[0] * r_modulate->value * (1.0 / 255);
-					pointcolor[1] += lightmap[1] * r_modulate->value * (1.0 / 255);
-					pointcolor[2] += lightmap[2] * r_modulate->value * (1.0 / 255);
-				}
+				sample->styles[maps] = surf->styles[maps];
+				sample->rgb[maps][0] = lightmap[0] * (1.0 / 255);
+				sample->rgb[maps][1] = lightmap[1] * (1.0 / 255);
+				sample->rgb[maps][2] = lightmap[2] * (1.0 / 255);
+				sample->numstyles++;
 
 				lightmap += 3 * ((surf->extents[0] >> surf->lmshift) + 1) * ((surf->extents[1] >> surf->lmshift) + 1);
 			}
@@ -308,7 +290,55 @@ static int R_RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
 	}
 
 // go down back side
-	return R_RecursiveLightPoint (node->children[!side], mid, end);
+	return R_RecursiveLightPoint (mod, node->children[!side], mid, end, sample);
+}
+
+/*
+===============
+R_LightSampleTrace
+
+Finds the lightmap pixel under p and keeps its color for each lightstyle,
+returns false when there's nothing below
+===============
+*/
+qboolean R_LightSampleTrace(model_t *mod, vec3_t p, lightsample_t *sample)
+{
+	vec3_t		end;
+
+	end[0] = p[0];
+	end[1] = p[1];
+	end[2] = p[2] - 2048; // go this far down
+
+	sample->numstyles = 0;
+	return R_RecursiveLightPoint (mod, mod->nodes, p, end, sample) != -1;
+}
+
+/*
+===============
+R_LightSampleColor
+
+Mixes a light sample with the current lightstyles
+===============
+*/
+void R_LightSampleColor(const lightsample_t *sample, vec3_t color)
+{
+	float		scale;
+	int			maps, i;
+
+	VectorClear (color);
+	for (maps = 0; maps < sample->numstyles; maps++)
+	{
+		for (i = 0; i < 3; i++)
+		{
+			scale = r_modulate->value;
+			if (r_dynamic->value)
+				scale *= r_newrefdef.lightstyles[sample->styles[maps]].rgb[i];
+			color[i] += sample->rgb[maps][i] * scale;
+		}
+	}
+
+	// scale the light color with r_modulate cvar
+	VectorScale (color, r_modulate->value, color);
 }
 
 /*
@@ -320,29 +350,17 @@ Returns the lightmap pixel color under p
 */
 void R_LightPoint(vec3_t p, vec3_t color)
 {
-	vec3_t		end;
-	float		r;
+	lightsample_t	sample;
 	
 	if (!r_worldmodel->lightdata || r_worldmodel->lightdatasize <= 0)
 	{
 		VectorSet(color, 1.0f, 1.0f, 1.0f); // fullbright
 		return;
 	}
-	
-	end[0] = p[0];
-	end[1] = p[1];
-	end[2] = p[2] - 2048; // go this far down
 
 	//
 	// find lightmap pixel color underneath p
 	//
-	r = R_RecursiveLightPoint (r_worldmodel->nodes, p, end);
-	
-	if (r == -1) // nothing was found
-		VectorCopy (vec3_origin, color);
-	else
-		VectorCopy (pointcolor, color);
-
-	// scale the light color with r_modulate cvar
-	VectorScale (color, r_modulate->value, color);
+	R_LightSampleTrace (r_worldmodel, p, &sample);
+	R_LightSampleColor (&sample, color);
 }
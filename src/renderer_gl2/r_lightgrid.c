@@ -0,0 +1,470 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// r_lightgrid.c -- entity lighting from a light grid
+
+// Entities used to be lit by the lightmap pixel under their origin, a BSP descent
+// for every model every frame which is also wrong for anything in the air.
+// Maps compiled with a LIGHTGRID_OCTREE BSPX lump get their grid loaded in r_model.c,
+// for other maps a regular grid is baked from the lightmaps at load and cached in
+// <gamedir>/cache/<map>.lightgrid. Grid and lightmap samples keep a color per lightstyle
+// so each entity keeps its sample until it moves further than r_lightcachedist.
+
+#include "r_local.h"
+
+#define LIGHTGRID_BAKE_STEP			64		// units between baked points, doubled until under LIGHTGRID_BAKE_MAXPOINTS
+#define LIGHTGRID_BAKE_MAXPOINTS	65536	// keeps the baked grid (17 bytes a point) well inside the bsp hunk
+
+#define LIGHTGRID_CACHE_IDENT		(('D'<<24)+('R'<<16)+('G'<<8)+'L') // little-endian "LGRD"
+#define LIGHTGRID_CACHE_VERSION		1
+
+typedef struct
+{
+	int			ident;
+	int			version;
+	unsigned	checksum;		// of the whole bsp file
+	int			size[3];
+	vec3_t		mins;
+	vec3_t		step;
+} lightgridcache_t;
+
+typedef struct
+{
+	int				sequence;	// registration_sequence and settings the sample was taken with
+	vec3_t			origin;
+	lightsample_t	sample;
+} entlightcache_t;
+
+// indexed by rentity_t->entnum, which is unique for each entity in a frame so
+// front-end workers never write to the same slot
+static entlightcache_t	r_entlightcache[MAX_GENTITIES];
+static int				r_entlightsequence = 1;
+static int				r_entlightregistration = -1;
+
+cvar_t	*r_lightgrid;
+cvar_t	*r_lightcachedist;
+
+/*
+===============
+R_LightGrid_PointIndex
+
+Finds a grid point in the octree, returns -1 for points outside of grid or inside solid
+===============
+*/
+static int R_LightGrid_PointIndex(const mlightgrid_t* grid, const int p[3])
+{
+	const mlightgridnode_t	*node;
+	const mlightgridleaf_t	*leaf;
+	unsigned int			child;
+	int						i, depth, local[3];
+
+	for (i = 0; i < 3; i++)
+	{
+		if (p[i] < 0 || p[i] >= grid->size[i])
+			return -1;
+	}
+
+	child = grid->rootnode;
+	for (depth = 0; !(child & (LIGHTGRID_NODE_LEAF | LIGHTGRID_NODE_MISSING)); depth++)
+	{
+		if (depth == LIGHTGRID_MAX_DEPTH)
+			return -1; // the lump links nodes in a loop
+		node = &grid->nodes[child];
+		child = node->children[((p[0] >= node->mid[0]) << 2) | ((p[1] >= node->mid[1]) << 1) | (p[2] >= node->mid[2])];
+	}
+
+	if (child & LIGHTGRID_NODE_MISSING)
+		return -1;
+
+	leaf = &grid->leafs[child & ~LIGHTGRID_NODE_LEAF];
+	for (i = 0; i < 3; i++)
+	{
+		local[i] = p[i] - leaf->mins[i];
+		if (local[i] < 0 || local[i] >= leaf->size[i])
+			return -1;
+	}
+
+	i = leaf->firstpoint + (local[2] * leaf->size[1] + local[1]) * leaf->size[0] + local[0];
+	if (grid->pointstyles[i] == LIGHTGRID_POINT_MISSING)
+		return -1;
+	return i;
+}
+
+/*
+===============
+R_LightGrid_Sample
+
+Blends the eight grid points around p, points in solid are left out and the remaining weights renormalized.
+Returns false when p isn't surrounded by any valid point
+===============
+*/
+static qboolean R_LightGrid_Sample(const mlightgrid_t* grid, const vec3_t p, lightsample_t* sample)
+{
+	const mlightgridsample_t	*in;
+	int			base[3], corner[3];
+	int			i, j, k, point;
+	float		pos, frac[3], weight, totalweight;
+
+	for (i = 0; i < 3; i++)
+	{
+		pos = (p[i] - grid->mins[i]) * grid->invstep[i];
+		base[i] = (int)floor(pos);
+		frac[i] = pos - base[i];
+	}
+
+	memset(sample, 0, sizeof(*sample));
+	totalweight = 0.0f;
+
+	for (i = 0; i < 8; i++)
+	{
+		weight = 1.0f;
+		for (j = 0; j < 3; j++)
+		{
+			if (i & (4 >> j))
+			{
+				corner[j] = base[j] + 1;
+				weight *= frac[j];
+			}
+			else
+			{
+				corner[j] = base[j];
+				weight *= 1.0f - frac[j];
+			}
+		}
+
+		if (weight <= 0.0f)
+			continue;
+
+		point = R_LightGrid_PointIndex(grid, corner);
+		if (point == -1)
+			continue;
+
+		// accumulate per style, a blend of points can touch more styles than fit so the rest is dropped
+		in = grid->samples + point * grid->numstyles;
+		for (j = 0; j < grid->pointstyles[point]; j++, in++)
+		{
+			for (k = 0; k < sample->numstyles; k++)
+			{
+				if (sample->styles[k] == in->style)
+					break;
+			}
+
+			if (k == sample->numstyles)
+			{
+				if (k == MAX_LIGHTMAPS_PER_SURFACE)
+					continue;
+				sample->styles[k] = in->style;
+				sample->numstyles++;
+			}
+
+			sample->rgb[k][0] += in->rgb[0] * weight * (1.0f / 255);
+			sample->rgb[k][1] += in->rgb[1] * weight * (1.0f / 255);
+			sample->rgb[k][2] += in->rgb[2] * weight * (1.0f / 255);
+		}
+		totalweight += weight;
+	}
+
+	if (totalweight <= 0.0f)
+		return false;
+
+	totalweight = 1.0f / totalweight;
+	for (i = 0; i < sample->numstyles; i++)
+		VectorScale(sample->rgb[i], totalweight, sample->rgb[i]);
+	return true;
+}
+
+/*
+===============
+R_EntityLightPoint
+
+Light color at entity origin, the grid (or lightmap) sample is kept
+per entity until it moves further than r_lightcachedist
+===============
+*/
+void R_EntityLightPoint(rentity_t* ent, vec3_t color)
+{
+	entlightcache_t	*cache;
+	lightsample_t	local, *sample;
+	vec3_t			delta;
+	float			dist;
+
+	if (!r_worldmodel->lightdata || r_worldmodel->lightdatasize <= 0)
+	{
+		VectorSet(color, 1.0f, 1.0f, 1.0f); // fullbright
+		return;
+	}
+
+	cache = NULL;
+	sample = &local;
+	dist = r_lightcachedist->value;
+	if (dist > 0.0f && ent->entnum > 0 && ent->entnum < MAX_GENTITIES)
+	{
+		cache = &r_entlightcache[ent->entnum];
+		sample = &cache->sample;
+
+		VectorSubtract(ent->origin, cache->origin, delta);
+		if (cache->sequence == r_entlightsequence && DotProduct(delta, delta) <= dist * dist)
+		{
+			R_LightSampleColor(sample, color);
+			return;
+		}
+	}
+
+	if (!r_lightgrid->value || !r_worldmodel->lightgrid || !R_LightGrid_Sample(r_worldmodel->lightgrid, ent->origin, sample))
+		R_LightSampleTrace(r_worldmodel, ent->origin, sample);
+
+	if (cache)
+	{
+		VectorCopy(ent->origin, cache->origin);
+		cache->sequence = r_entlightsequence;
+	}
+
+	R_LightSampleColor(sample, color);
+}
+
+/*
+===============
+R_LightGrid_BeginFrame
+
+Drops cached entity samples when map or lighting settings change, called before the front-end runs
+===============
+*/
+void R_LightGrid_BeginFrame()
+{
+	if (r_entlightregistration != registration_sequence || r_lightgrid->modified || r_lightcachedist->modified)
+	{
+		r_entlightregistration = registration_sequence;
+		r_lightgrid->modified = false;
+		r_lightcachedist->modified = false;
+		r_entlightsequence++;
+	}
+}
+
+/*
+===============
+R_LightGrid_Checksum
+===============
+*/
+static unsigned int R_LightGrid_Checksum(byte* data, int len)
+{
+	unsigned int	hash = 2166136261u; // FNV-1a
+	int				i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ data[i]) * 16777619u;
+	return hash;
+}
+
+/*
+===============
+R_LightGrid_CachePath
+===============
+*/
+static void R_LightGrid_CachePath(model_t* mod, char* path, int size)
+{
+	char	base[MAX_QPATH];
+
+	COM_FileBase(mod->name, base);
+	Com_sprintf(path, size, "%s/cache/%s.lightgrid", ri.GetGameDir(), base);
+}
+
+/*
+===============
+R_LightGrid_LoadCache
+
+Reads a previously baked grid, false if there is none or it was baked for a different bsp
+===============
+*/
+static qboolean R_LightGrid_LoadCache(model_t* mod, mlightgrid_t* grid, unsigned int checksum)
+{
+	lightgridcache_t	header;
+	char				path[MAX_OSPATH];
+	FILE				*f;
+	qboolean			ok;
+
+	R_LightGrid_CachePath(mod, path, sizeof(path));
+	f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	ok = fread(&header, sizeof(header), 1, f) == 1
+		&& header.ident == LIGHTGRID_CACHE_IDENT
+		&& header.version == LIGHTGRID_CACHE_VERSION
+		&& header.checksum == checksum
+		&& !memcmp(header.size, grid->size, sizeof(header.size))
+		&& VectorCompare(header.mins, grid->mins)
+		&& VectorCompare(header.step, grid->step)
+		&& fread(grid->pointstyles, grid->numpoints, 1, f) == 1
+		&& fread(grid->samples, sizeof(*grid->samples) * grid->numpoints * grid->numstyles, 1, f) == 1;
+
+	fclose(f);
+	return ok;
+}
+
+/*
+===============
+R_LightGrid_WriteCache
+===============
+*/
+static void R_LightGrid_WriteCache(model_t* mod, mlightgrid_t* grid, unsigned int checksum)
+{
+	lightgridcache_t	header;
+	char				path[MAX_OSPATH];
+	FILE				*f;
+
+	Com_sprintf(path, sizeof(path), "%s/cache", ri.GetGameDir());
+	Sys_Mkdir(path);
+
+	R_LightGrid_CachePath(mod, path, sizeof(path));
+	f = fopen(path, "wb");
+	if (!f)
+	{
+		ri.Printf(PRINT_DEVELOPER, "%s: couldn't write %s\n", __FUNCTION__, path);
+		return;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.ident = LIGHTGRID_CACHE_IDENT;
+	header.version = LIGHTGRID_CACHE_VERSION;
+	header.checksum = checksum;
+	memcpy(header.size, grid->size, sizeof(header.size));
+	VectorCopy(grid->mins, header.mins);
+	VectorCopy(grid->step, header.step);
+
+	fwrite(&header, sizeof(header), 1, f);
+	fwrite(grid->pointstyles, grid->numpoints, 1, f);
+	fwrite(grid->samples, sizeof(*grid->samples) * grid->numpoints * grid->numstyles, 1, f);
+	fclose(f);
+}
+
+/*
+===============
+R_LightGrid_Bake
+
+Samples the lightmap under every grid point like R_LightPoint would
+===============
+*/
+static void R_LightGrid_Bake(model_t* mod, mlightgrid_t* grid)
+{
+	mlightgridsample_t	*out;
+	lightsample_t		sample;
+	vec3_t				pos;
+	int					x, y, z, i, j, point;
+
+	point = 0;
+	for (z = 0; z < grid->size[2]; z++)
+	{
+		for (y = 0; y < grid->size[1]; y++)
+		{
+			for (x = 0; x < grid->size[0]; x++, point++)
+			{
+				pos[0] = grid->mins[0] + x * grid->step[0];
+				pos[1] = grid->mins[1] + y * grid->step[1];
+				pos[2] = grid->mins[2] + z * grid->step[2];
+
+				if (Mod_BSP_PointInLeaf(pos, mod)->contents & CONTENTS_SOLID)
+				{
+					grid->pointstyles[point] = LIGHTGRID_POINT_MISSING;
+					continue;
+				}
+
+				R_LightSampleTrace(mod, pos, &sample);
+
+				grid->pointstyles[point] = sample.numstyles;
+				out = grid->samples + point * grid->numstyles;
+				for (i = 0; i < sample.numstyles; i++, out++)
+				{
+					out->style = sample.styles[i];
+					for (j = 0; j < 3; j++)
+						out->rgb[j] = (byte)(min(sample.rgb[i][j], 1.0f) * 255 + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+/*
+===============
+R_LightGrid_Build
+
+Builds a regular light grid for maps without LIGHTGRID_OCTREE lump, it's a single octree leaf
+so lookups don't care where the grid came from. Called from Mod_LoadBSP once leafs and nodes are loaded
+===============
+*/
+void R_LightGrid_Build(model_t* mod, byte* filedata, int filelen)
+{
+	mlightgrid_t	*grid;
+	unsigned int	checksum;
+	long long		start, numpoints;
+	float			step;
+	int				i;
+
+	if (!mod->lightdata || mod->lightdatasize <= 0)
+		return; // fullbright map
+
+	start = Sys_Microseconds();
+
+	grid = Hunk_Alloc(sizeof(*grid));
+
+	step = LIGHTGRID_BAKE_STEP;
+	do
+	{
+		numpoints = 1;
+		for (i = 0; i < 3; i++)
+		{
+			grid->step[i] = step;
+			grid->size[i] = (int)ceil((mod->nodes[0].maxs[i] - mod->nodes[0].mins[i]) / step) + 1;
+			numpoints *= grid->size[i];
+		}
+		step *= 2;
+	} while (numpoints > LIGHTGRID_BAKE_MAXPOINTS);
+
+	for (i = 0; i < 3; i++)
+	{
+		grid->mins[i] = mod->nodes[0].mins[i];
+		grid->invstep[i] = 1.0f / grid->step[i];
+	}
+
+	grid->numstyles = MAX_LIGHTMAPS_PER_SURFACE;
+	grid->numpoints = (int)numpoints;
+	grid->rootnode = LIGHTGRID_NODE_LEAF | 0;
+	grid->numleafs = 1;
+	grid->leafs = Hunk_Alloc(sizeof(*grid->leafs));
+	memcpy(grid->leafs[0].size, grid->size, sizeof(grid->size));
+
+	grid->pointstyles = Hunk_Alloc(grid->numpoints);
+	grid->samples = Hunk_Alloc(sizeof(*grid->samples) * grid->numpoints * grid->numstyles);
+
+	checksum = R_LightGrid_Checksum(filedata, filelen);
+	if (R_LightGrid_LoadCache(mod, grid, checksum))
+	{
+		ri.Printf(PRINT_LOW, "Loaded cached light grid for %s (%ix%ix%i points).\n", mod->name, grid->size[0], grid->size[1], grid->size[2]);
+	}
+	else
+	{
+		R_LightGrid_Bake(mod, grid);
+		R_LightGrid_WriteCache(mod, grid, checksum);
+		ri.Printf(PRINT_ALL, "Baked light grid for %s (%ix%ix%i points) in %.1f ms.\n", mod->name,
+			grid->size[0], grid->size[1], grid->size[2], (Sys_Microseconds() - start) / 1000.0);
+	}
+
+	mod->lightgrid = grid;
+}
+
+/*
+===============
+R_LightGrid_Init
+===============
+*/
+void R_LightGrid_Init()
+{
+	r_lightgrid = ri.Cvar_Get("r_lightgrid", "1", CVAR_ARCHIVE, "Light entities from BSPX or baked light grid instead of lightmap below them, loading and baking happens on map load.");
+	r_lightcachedist = ri.Cvar_Get("r_lightcachedist", "4", CVAR_ARCHIVE, "Entities keep their light sample until they move this far, 0 samples every frame.");
+}
@@ -105,6 +105,7 @@ enum
 	GLPROG_POSTFX,
 	GLPROG_DEBUGSTRING,
 	GLPROG_DEBUGLINE,
+	GLPROG_ALIAS_INSTANCED,
 	MAX_GLPROGS
 };
 typedef enum
@@ -156,6 +157,9 @@ typedef enum
 	VALOC_COLOR,
 	VALOC_OLD_POS,
 	VALOC_OLD_NORMAL,
+	VALOC_INSTANCE_MATRIX,		// mat4, takes four locations
+	VALOC_INSTANCE_SHADE,
+	VALOC_INSTANCE_SHADEVECTOR,
 	NUM_VALOCS
 } glprogLoc_t;
 
@@ -306,6 +310,7 @@ extern	cvar_t	*r_texturemode;
 extern	cvar_t	*r_texturealphamode;
 extern	cvar_t	*r_texturesolidmode;
 extern  cvar_t  *r_lockpvs;
+extern	cvar_t	*r_worldlists;
 
 extern	cvar_t	*r_fullscreen;
 extern	cvar_t	*r_gamma;
@@ -348,6 +353,9 @@ void GL_UpdateSwapInterval(void);
 //===================================================================
 void R_DrawWorld();
 void R_World_MarkLeaves();
+void R_World_EnsureBuffers();
+int R_World_PrepareFrontChunks();
+void R_World_CullFrontChunks(int first, int count);
 void R_World_DrawAlphaSurfaces(); //old rendering path
 void R_DrawBrushModel(rentity_t* e);
 
@@ -366,18 +374,117 @@ void R_DrawSkyBox();
 void R_RenderView(refdef_t* fd);
 void R_BeginFrame(float camera_separation);
 void R_RotateForEntity(rentity_t* e);
+void R_SetEntityLocalMatrix(rentity_t* ent);
 qboolean R_CullBox(vec3_t mins, vec3_t maxs);
 void R_DrawBeam(rentity_t* e);
 
+//===================================================================
+// r_front.c
+//===================================================================
+
+// per entity results, indexed the same as r_newrefdef.entities
+typedef struct
+{
+	qboolean	visible;
+	vec3_t		shadelight;
+	vec3_t		shadevector;
+} rfrontent_t;
+
+typedef enum
+{
+	FRONT_WORLD,
+	FRONT_ENTITIES,
+	FRONT_PARTICLES,
+	NUM_FRONT_STAGES
+} frontstage_t;
+
+// everything the back-end needs from the front-end for one view, the
+// front-end never touches GL so it can run on workers or without a context
+typedef struct
+{
+	int			numWorldChunks;		// frame chunks culled by R_World_CullFrontChunks
+
+	int			numEntities;
+	rfrontent_t	entities[MAX_VISIBLE_ENTITIES];
+
+	int			numParticles;
+	glvert_t	*particleVerts;		// billboards, 3 verts per particle
+
+	long long	stageUsec[NUM_FRONT_STAGES];
+} rfrontframe_t;
+
+extern rfrontframe_t r_front;
+extern cvar_t *r_frontthreads;
+
+void R_Front_Init();
+void R_Front_Shutdown();
+void R_Front_BuildFrame(glvert_t* particleVerts, qboolean threaded);
+
 //===================================================================
 // r_light.c
 //===================================================================
+
+// lightmap or light grid color for each lightstyle, resolved against
+// the current lightstyles every frame so it can be cached
+typedef struct
+{
+	int		numstyles;
+	byte	styles[MAX_LIGHTMAPS_PER_SURFACE];
+	vec3_t	rgb[MAX_LIGHTMAPS_PER_SURFACE];	// 0-1, before lightstyle and r_modulate scaling
+} lightsample_t;
+
 void R_MarkLights(dlight_t* light, vec3_t lightorg, int bit, mnode_t* node);
 void R_LightPoint(vec3_t p, vec3_t color);
+qboolean R_LightSampleTrace(model_t* mod, vec3_t p, lightsample_t* sample);
+void R_LightSampleColor(const lightsample_t* sample, vec3_t color);
 void R_PushDlights(void);
 void R_SendDynamicLightsToCurrentProgram();
 void R_RenderDlights(void); // development aid
 
+//===================================================================
+// r_lightgrid.c
+//===================================================================
+extern cvar_t *r_lightgrid;
+extern cvar_t *r_lightcachedist;
+
+void R_LightGrid_Init();
+void R_LightGrid_Build(model_t* mod, byte* filedata, int filelen);
+void R_LightGrid_BeginFrame();
+void R_EntityLightPoint(rentity_t* ent, vec3_t color);
+
+//===================================================================
+// r_instance.c
+//===================================================================
+
+// opaque md3 entities sharing model, frame pair and hidden parts, drawn with one instanced draw per surface
+typedef struct
+{
+	model_t		*model;
+	int			frame, oldframe;
+	int			hiddenPartsBits;
+	int			firstInstance;
+	int			numInstances;
+} md3batch_t;
+
+typedef struct
+{
+	int			numBatches;
+	md3batch_t	batches[MAX_VISIBLE_ENTITIES / 2];
+
+	int			numInstances;
+	int			instances[MAX_VISIBLE_ENTITIES];	// entity index of each instance, grouped by batch
+	qboolean	batched[MAX_VISIBLE_ENTITIES];		// entity is drawn by a batch
+} md3batchlist_t;
+
+extern md3batchlist_t r_md3batches;
+extern cvar_t *r_instancing;
+
+void R_Instance_Init();
+void R_Instance_Shutdown();
+int R_Instance_BuildBatches(rentity_t* ents, const qboolean* candidates, int numEnts, md3batchlist_t* list);
+void R_Instance_CountDraws(rentity_t* ents, const qboolean* candidates, int numEnts, const md3batchlist_t* list, int* individual, int* instanced);
+void R_Instance_DrawBatches();
+
 //===================================================================
 // shared.c
 //===================================================================
@@ -508,7 +615,12 @@ typedef struct
 	int	brush_textures;
 
 	int alias_tris;
-	int alias_drawcalls;
+	int alias_drawcalls;	// models drawn one by one plus instanced batches
+	int alias_instanced;	// models drawn by instanced batches
+	int alias_batches;
+
+	int world_chunks;
+	long long world_usec; // cpu time spent marking, culling and submitting world
 
 	int	texture_binds[MIN_TEXTURE_MAPPING_UNITS];
 } rperfcounters_t;
@@ -114,6 +114,27 @@ void R_RotateForEntity (rentity_t *e)
 #endif
 }
 
+/*
+=================
+R_SetEntityLocalMatrix
+
+Moves, rotates and scales r_local_matrix for a model entity
+=================
+*/
+void R_SetEntityLocalMatrix(rentity_t* ent)
+{
+#ifndef FIX_SQB
+	ent->angles[PITCH] = -ent->angles[PITCH]; // stupid quake bug
+#endif
+	R_RotateForEntity(ent);
+#ifndef FIX_SQB
+	ent->angles[PITCH] = -ent->angles[PITCH]; // stupid quake bug
+#endif
+
+	if (ent->renderfx & RF_SCALE && ent->scale > 0.0f)
+		Mat4Scale(r_local_matrix, ent->scale, ent->scale, ent->scale);
+}
+
 
 /*
 =============
@@ -199,13 +220,17 @@ void R_DrawEntitiesOnList (void)
 	if (!r_drawentities->value)
 		return;
 
-	// draw non-transparent first
+	// draw non-transparent first, repeated md3 models go in instanced batches
+	R_Instance_DrawBatches();
+
 	for (i = 0; i < r_newrefdef.num_entities; i++)
 	{
 		pCurrentRefEnt = &r_newrefdef.entities[i];
 		pCurrentModel = pCurrentRefEnt->model;
 		if ((pCurrentRefEnt->renderfx & RF_TRANSLUCENT))
 			continue;	// reject transparent
+		if (r_md3batches.batched[i])
+			continue;	// already drawn
 		R_DrawCurrentEntity();
 	}
 
@@ -227,46 +252,39 @@ void R_DrawEntitiesOnList (void)
 
 /*
 ===============
-R_DrawParticles
+R_InitParticles
+
+Particles are triangles with fixed texture coords, those are set once here
 ===============
 */
-void R_DrawParticles( int num_particles, const particle_t particles[] )
+void R_InitParticles(void)
 {
-	const particle_t *p;
-	int				i;
-	vec3_t			up, right;
-	int vertcnt = 0;
+	glvert_t	*v;
+	int			i;
 
-	for (p = particles, i = 0; i < num_particles ; i++, p++)
-	{
-		if (p->size[0] > 0.0f && p->size[1] > 0.0f)
-		{
-			VectorScale(vup, p->size[0], up);
-			VectorScale(vright, p->size[1], right);
-		}
-		else
-		{
-			VectorScale(vup, 3.0f, up);
-			VectorScale(vright, 3.0f, right);
-		}
+	vb_particles = R_AllocVertexBuffer((V_UV | V_COLOR | V_NOFREE), (3 * MAX_PARTICLES), 0);
 
-		Vector4Set(vb_particles->verts[vertcnt].rgba, p->color[0], p->color[1], p->color[2], p->alpha);
-		Vector2Set(vb_particles->verts[vertcnt].st, 0.0625, 0.0625 );
-		VectorCopy(p->origin, vb_particles->verts[vertcnt].xyz);
-		vertcnt++;
+	for (i = 0, v = vb_particles->verts; i < MAX_PARTICLES; i++, v += 3)
+	{
+		Vector2Set(v[0].st, 0.0625, 0.0625);
+		Vector2Set(v[1].st, 1.0625, 0.0625);
+		Vector2Set(v[2].st, 0.0625, 1.0625);
+	}
+}
 
-		Vector4Set(vb_particles->verts[vertcnt].rgba, p->color[0], p->color[1], p->color[2], p->alpha);
-		Vector2Set(vb_particles->verts[vertcnt].st, 1.0625, 0.0625 );
-		VectorSet(vb_particles->verts[vertcnt].xyz, p->origin[0] + up[0], p->origin[1] + up[1], p->origin[2] + up[2]);
-		vertcnt++;
+/*
+===============
+R_DrawParticles
 
-		Vector4Set(vb_particles->verts[vertcnt].rgba, p->color[0], p->color[1], p->color[2], p->alpha);
-		Vector2Set(vb_particles->verts[vertcnt].st, 0.0625, 1.0625 );
-		VectorSet(vb_particles->verts[vertcnt].xyz, p->origin[0] + right[0], p->origin[1] + right[1], p->origin[2] + right[2]);
-		vertcnt++;
-	}
+Billboards were built by the front-end straight into vb_particles
+===============
+*/
+void R_DrawParticles()
+{
+	if (r_front.numParticles <= 0 || r_front.particleVerts != vb_particles->verts)
+		return;
 
-	R_UpdateVertexBuffer(vb_particles, NULL, vertcnt, (V_UV|V_COLOR|V_NOFREE));
+	R_UpdateVertexBuffer(vb_particles, NULL, r_front.numParticles * 3, (V_UV|V_COLOR|V_NOFREE));
 
 	R_BindProgram(GLPROG_PARTICLE);
 	R_MultiTextureBind(TMU_DIFFUSE, r_texture_particle->texnum);
@@ -505,6 +523,8 @@ r_newrefdef must be set before the first call
 */
 void R_RenderView (refdef_t *fd)
 {
+	long long worldstart;
+
 	if (r_norefresh->value)
 		return;
 
@@ -519,6 +539,10 @@ void R_RenderView (refdef_t *fd)
 	rperf.brush_drawcalls = 0;
 	rperf.alias_tris = 0;
 	rperf.alias_drawcalls = 0;
+	rperf.alias_instanced = 0;
+	rperf.alias_batches = 0;
+	rperf.world_chunks = 0;
+	rperf.world_usec = 0;
 
 	for(int i = 0; i < MIN_TEXTURE_MAPPING_UNITS; i++)
 		rperf.texture_binds[i] = 0;
@@ -535,7 +559,15 @@ void R_RenderView (refdef_t *fd)
 
 	R_SetupGL ();
 
+	worldstart = Sys_Microseconds();
 	R_World_MarkLeaves ();	// done here so we know if we're in water
+	rperf.world_usec += Sys_Microseconds() - worldstart;
+
+	R_World_EnsureBuffers();
+	R_LightGrid_BeginFrame();
+
+	// decide what to draw, from here on we only submit to GL
+	R_Front_BuildFrame(vb_particles->verts, true);
 
 	R_UpdateCommonProgUniforms(false);
 
@@ -556,7 +588,7 @@ void R_RenderView (refdef_t *fd)
 	R_World_DrawAlphaSurfaces();
 	R_ProfileAtStage(STAGE_ALPHASURFS);
 
-	R_DrawParticles(r_newrefdef.num_particles, r_newrefdef.particles);
+	R_DrawParticles();
 	R_ProfileAtStage(STAGE_PARTICLES);
 
 	R_RenderToFBO(false); // end rendering to fbo
@@ -606,7 +638,7 @@ static void R_DrawPerfCounters()
 	Vector4Set(color, 0, 0, 0, 0.35f);
 	
 	R_ProgUniform4f(LOC_COLOR4, 0, 0, 0, 0.5);
-	R_DrawFill(vid.width-175, 42, 175, 220);
+	R_DrawFill(vid.width-175, 42, 175, 260);
 
 	fontscale = 0.25;
 	x = vid.width - 10;
@@ -629,6 +661,10 @@ static void R_DrawPerfCounters()
 	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%i textures in chain", rperf.brush_textures));
 	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%i lightmap binds", rperf.texture_binds[TMU_LIGHTMAP]));
 	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%i texture binds", rperf.texture_binds[TMU_DIFFUSE]));
+	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%i world chunks", rperf.world_chunks));
+	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%.3f ms world cpu", rperf.world_usec / 1000.0));
+	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%.2f/%.2f/%.2f ms front w/e/p", r_front.stageUsec[FRONT_WORLD] / 1000.0,
+		r_front.stageUsec[FRONT_ENTITIES] / 1000.0, r_front.stageUsec[FRONT_PARTICLES] / 1000.0));
 
 	Vector4Set(color, 0.8, 0.8, 1, 1.0);
 	R_DrawText(x, y += h*2, 2, 0, fontscale, color, va("%i dynamic lights", r_newrefdef.num_dlights));
@@ -636,7 +672,8 @@ static void R_DrawPerfCounters()
 	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%i particles count", r_newrefdef.num_particles));
 
 	Vector4Set(color, 1, 1, 1, 1.0);
-	R_DrawText(x, y += h * 2, 2, 0, fontscale, color, va("%i rendered models", rperf.alias_drawcalls));
+	R_DrawText(x, y += h * 2, 2, 0, fontscale, color, va("%i model draws", rperf.alias_drawcalls));
+	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%i instanced in %i batches", rperf.alias_instanced, rperf.alias_batches));
 	R_DrawText(x, y += h, 2, 0, fontscale, color, va("%i model tris total", rperf.alias_tris));
 
 	R_DrawProfilingReport();
@@ -225,6 +225,9 @@ void Mod_LoadMD3(model_t* mod, void* buffer, lod_t lod)
 			tag->axis[2][j] = LittleFloat(tag->axis[2][j]);
 		}	
 		_strlwr(tag->name); // lowercase the tag name so search compares are faster
+
+		if (lod == LOD_HIGH && i < mod->md3[lod]->numTags && i < MD3_MAX_TAGS)
+			mod->tagHashes[i] = Com_HashString(tag->name);
 	}
 
 	// swap all the surfaces
@@ -358,15 +361,21 @@ R_TagIndexForName
 int R_TagIndexForName(struct model_s *model, const char* tagName)
 {
 	md3Tag_t* tag;
+	unsigned	hash;
 	int			i;
 
 	if (!model->md3[0])
 		return -1;
 
+	// cgame asks for the same few tags every frame, compare hashes first
+	hash = Com_HashString(tagName);
+
 	md3Header_t *mod = model->md3[LOD_HIGH];
 	tag = (md3Tag_t*)((byte*)mod + mod->ofsTags);
 	for (i = 0; i < mod->numTags; i++, tag++)
 	{
+		if (i < MD3_MAX_TAGS && model->tagHashes[i] != hash)
+			continue;
 		if (!strcmp(tag->name, tagName))
 		{
 			return i;	// found it
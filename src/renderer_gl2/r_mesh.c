@@ -19,138 +19,19 @@ vec3_t	model_shadelight;
 void R_DrawMD3Model(rentity_t* ent, lod_t lod, float animlerp); // r_md3.c
 void R_DrawSprite(rentity_t* ent); // r_sprite.c
 
-/*
-=================
-R_EntityShouldRender
-
-Decides whenever entity is visible and could be drawn
-=================
-*/
-static qboolean R_EntityShouldRender(rentity_t* ent)
-{
-	int i;
-	vec3_t mins, maxs, v;
-	float scale = 1.0f;
-
-	if (!ent->model) // this shouldn't really happen at this point!
-		return false;
-
-	if (ent->model->type == MOD_SPRITE)
-		return true;
-
-	if (ent->alpha <= 0.01f && (ent->renderfx & RF_TRANSLUCENT))
-	{
-		ri.Printf(PRINT_LOW, "%s: %f alpha!\n", __FUNCTION__, ent->alpha);
-		return false;
-	}
-	if (ent->renderfx & RF_VIEW_MODEL)
-	{
-		// don't cull viwmodels unless its centered
-		return r_lefthand->value == 2 ? false : true;
-	}
-	else if(pCurrentModel->cullDist > 0.0f)
-	{
-		// cull objects based on distance TODO: account for scale or na?
-		VectorSubtract(r_newrefdef.view.origin, ent->origin, v); // FIXME: doesn't account for FOV
-		if (VectorLength(v) > pCurrentModel->cullDist)
-			return false;
-	}
-
-	if (ent->model->type == MOD_MD3) 
-	{
-		// technicaly this could be used for sprites, but it takes 
-		// more cycles culling than actually rendering them lol
-
-		if ((ent->renderfx & RF_SCALE) && ent->scale != 1.0f && ent->scale > 0.0f)
-			scale = ent->scale;
-
-		if (ent->angles[0] || ent->angles[1] || ent->angles[2] || scale != 1.0)
-		{
-			for (i = 0; i < 3; i++)
-			{
-				mins[i] = ent->origin[i] - (pCurrentModel->radius * scale);
-				maxs[i] = ent->origin[i] + (pCurrentModel->radius * scale);
-			}
-		}
-		else
-		{
-			VectorAdd(ent->origin, pCurrentModel->mins, mins);
-			VectorAdd(ent->origin, pCurrentModel->maxs, maxs);
-		}
-
-
-		if (R_CullBox(mins, maxs))
-			return false;
-	}
-
-	return true;
-}
-
 /*
 =================
 R_SetEntityShadeLight
 
-get lighting information for entity
+get lighting information for entity, computed by the front-end
 =================
 */
 void R_SetEntityShadeLight(rentity_t* ent)
 {
-	float	scale;
-	float	min;
-	float	an;
-	int		i;
-
-	if ((ent->renderfx & RF_COLOR))
-	{
-		VectorCopy(ent->renderColor, model_shadelight);
-	}
-	else if (pCurrentRefEnt->renderfx & RF_FULLBRIGHT || r_fullbright->value)
-	{
-		VectorSet(model_shadelight, 1.0f, 1.0f, 1.0f);
-	}
-	else 
-	{
-		if (ent->inheritLight > 0)
-		{
-			VectorCopy(r_newrefdef.entities[ent->inheritLight].shadelightpoint, model_shadelight);
-		}
-		else
-		{
-			R_LightPoint(pCurrentRefEnt->origin, model_shadelight);
-			VectorCopy(model_shadelight, ent->shadelightpoint);
-		}
-	}
-
-	if (ent->renderfx & RF_MINLIGHT)
-	{
-		for (i = 0; i < 3; i++)
-			if (model_shadelight[i] > 0.1)
-				break;
+	rfrontent_t* fe = &r_front.entities[ent - r_newrefdef.entities];
 
-		if (i == 3)
-		{
-			VectorSet(model_shadelight, 0.1f, 0.1f, 0.1f);
-		}
-	}
-
-	if (ent->renderfx & RF_GLOW)
-	{
-		scale = 0.1 * sin(r_newrefdef.time * 7.0);
-		for (i = 0; i < 3; i++)
-		{
-			min = model_shadelight[i] * 0.8;
-			model_shadelight[i] += scale;
-			if (model_shadelight[i] < min)
-				model_shadelight[i] = min;
-		}
-	}
-
-	// this is uttery shit
-	an = ent->angles[1] / 180 * M_PI;
-	model_shadevector[0] = cos(-an);
-	model_shadevector[1] = sin(-an);
-	model_shadevector[2] = -1;
-	VectorNormalize(model_shadevector);
+	VectorCopy(fe->shadelight, model_shadelight);
+	VectorCopy(fe->shadevector, model_shadevector);
 }
 
 static void R_EntityAnim(rentity_t* ent, char* func)
@@ -183,8 +64,12 @@ void R_DrawEntityModel(rentity_t* ent)
 	lod_t		lod;
 
 	// don't bother if we're not visible
-	if (!R_EntityShouldRender(ent))
+	if (ent - r_newrefdef.entities >= r_front.numEntities || !r_front.entities[ent - r_newrefdef.entities].visible)
+	{
+		if (ent->model && ent->model->type != MOD_SPRITE && ent->alpha <= 0.01f && (ent->renderfx & RF_TRANSLUCENT))
+			ri.Printf(PRINT_LOW, "%s: %f alpha!\n", __FUNCTION__, ent->alpha);
 		return;
+	}
 
 	// check if the animation is correct and set lerp
 	R_EntityAnim(ent, __FUNCTION__);
@@ -202,16 +87,7 @@ void R_DrawEntityModel(rentity_t* ent)
 		glDepthRange(gldepthmin, gldepthmin + 0.3f * (gldepthmax - gldepthmin));
 
 	// move, rotate and scale
-#ifndef FIX_SQB
-	ent->angles[PITCH] = -ent->angles[PITCH]; // stupid quake bug
-#endif
-	R_RotateForEntity(ent);
-#ifndef FIX_SQB
-	ent->angles[PITCH] = -ent->angles[PITCH]; // stupid quake bug
-#endif
-
-	if (ent->renderfx & RF_SCALE && ent->scale > 0.0f)
-		Mat4Scale(r_local_matrix, ent->scale, ent->scale, ent->scale);
+	R_SetEntityLocalMatrix(ent);
 
 	// if its a view model and we chose to keep it in left hand 
 	if ((ent->renderfx & RF_VIEW_MODEL) && (r_lefthand->value == 1.0F))
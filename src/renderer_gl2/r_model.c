@@ -33,6 +33,7 @@ static byte *mod_base = NULL;
 #define	RD_MAX_MODELS	1024
 static model_t	r_models[RD_MAX_MODELS];
 static int		r_models_count;
+static nameindex_t	r_modelindex;	// r_models names
 static model_t	r_inlineModels[RD_MAX_MODELS]; // the inline * brush models from the current map are kept seperate
 
 extern void Mod_LoadSP2(model_t* mod, void* buffer);
@@ -101,13 +102,9 @@ model_t* R_ModelForName(char* name, qboolean crash)
 	//
 	// search the currently loaded models
 	//
-	for (i = 0, mod = r_models; i < r_models_count; i++, mod++)
-	{
-		if (!mod->name[0])
-			continue;
-		if (!strcmp(mod->name, name))
-			return mod;
-	}
+	i = NameIndex_Find(&r_modelindex, name);
+	if (i >= 0)
+		return &r_models[i];
 
 	//
 	// find a free model slot spot
@@ -127,6 +124,7 @@ model_t* R_ModelForName(char* name, qboolean crash)
 
 	strcpy(mod->name, name);
 	mod->index = i;
+	NameIndex_Add(&r_modelindex, mod->name, i);
 
 	//
 	// load the file
@@ -136,6 +134,7 @@ model_t* R_ModelForName(char* name, qboolean crash)
 	{
 		if (crash)
 			ri.Error(ERR_DROP, "R_ModelForName: %s not found", mod->name);
+		NameIndex_Remove(&r_modelindex, mod->index);
 		memset(mod->name, 0, sizeof(mod->name));
 		return NULL;
 	}
@@ -199,6 +198,9 @@ void R_FreeModel(model_t* mod)
 	if (mod->extradata)
 		Hunk_Free(mod->extradata);
 
+	if (mod >= r_models && mod < r_models + RD_MAX_MODELS)
+		NameIndex_Remove(&r_modelindex, mod - r_models);
+
 	memset(mod, 0, sizeof(*mod));
 }
 
@@ -1218,9 +1220,9 @@ qboolean Mod_BSP_FindExtLump(char* name, bspx_lump_t *out)
 	out->fileofs = out->filelen = 0;
 	for (i = 0; i < bspx_lumps_count; i++)
 	{
-		in = (void*)(mod_base + bspx_lumps_offset);
+		in = (void*)(mod_base + offset);
 
-		if (!strcmp(in->name, name))
+		if (!strncmp(in->name, name, sizeof(in->name)))
 		{
 			out->fileofs = LittleLong(in->fileofs);
 			out->filelen = LittleLong(in->filelen);
@@ -1315,6 +1317,201 @@ static qboolean Mod_BSP_EXT_LoadDecoupledLM()
 
 
 
+static unsigned int Mod_BSP_EXT_ReadLong(byte** p)
+{
+	unsigned int v;
+
+	memcpy(&v, *p, 4);
+	*p += 4;
+	return LittleLong(v);
+}
+
+static float Mod_BSP_EXT_ReadFloat(byte** p)
+{
+	float v;
+
+	memcpy(&v, *p, 4);
+	*p += 4;
+	return LittleFloat(v);
+}
+
+/*
+=================
+Mod_BSP_EXT_ValidLightGridChild
+=================
+*/
+static qboolean Mod_BSP_EXT_ValidLightGridChild(mlightgrid_t* grid, unsigned int child)
+{
+	if (child & LIGHTGRID_NODE_MISSING)
+		return true;
+	if (child & LIGHTGRID_NODE_LEAF)
+		return (int)(child & ~LIGHTGRID_NODE_LEAF) < grid->numleafs;
+	return (int)child < grid->numnodes;
+}
+
+/*
+=================
+Mod_BSP_EXT_LoadLightGrid
+
+Loads the LIGHTGRID_OCTREE lump, a sparse octree of light grid leafs with per-style samples.
+Returns false for missing or broken lumps so a grid can be baked from lightmaps instead
+=================
+*/
+static qboolean Mod_BSP_EXT_LoadLightGrid()
+{
+	bspx_lump_t		lump;
+	mlightgrid_t	*grid;
+	mlightgridnode_t *node;
+	mlightgridleaf_t *leaf;
+	mlightgridsample_t *sample;
+	byte			*in, *end, *leafdata;
+	int				i, j, k, style, numpoints, count, numstyles;
+
+	if (Mod_BSP_FindExtLump("LIGHTGRID_OCTREE", &lump) == false)
+		return false;
+
+	if (lump.fileofs < 0 || lump.filelen < 45 || lump.fileofs + lump.filelen > modelFileLength)
+		goto badlump;
+
+	in = mod_base + lump.fileofs;
+	end = in + lump.filelen;
+
+	grid = Hunk_Alloc(sizeof(*grid));
+	for (i = 0; i < 3; i++)
+		grid->step[i] = Mod_BSP_EXT_ReadFloat(&in);
+	for (i = 0; i < 3; i++)
+		grid->size[i] = Mod_BSP_EXT_ReadLong(&in);
+	for (i = 0; i < 3; i++)
+		grid->mins[i] = Mod_BSP_EXT_ReadFloat(&in);
+	numstyles = *in++;
+	grid->rootnode = Mod_BSP_EXT_ReadLong(&in);
+	grid->numnodes = Mod_BSP_EXT_ReadLong(&in);
+
+	for (i = 0; i < 3; i++)
+	{
+		if (grid->step[i] <= 0.0f || grid->size[i] <= 0)
+			goto badlump;
+		grid->invstep[i] = 1.0f / grid->step[i];
+	}
+	grid->numstyles = min(max(numstyles, 1), MAX_LIGHTMAPS_PER_SURFACE);
+
+	if (grid->numnodes < 0 || (end - in) / 44 < grid->numnodes)
+		goto badlump;
+
+	grid->nodes = Hunk_Alloc(sizeof(*grid->nodes) * max(grid->numnodes, 1));
+	for (i = 0, node = grid->nodes; i < grid->numnodes; i++, node++)
+	{
+		for (j = 0; j < 3; j++)
+			node->mid[j] = Mod_BSP_EXT_ReadLong(&in);
+		for (j = 0; j < 8; j++)
+			node->children[j] = Mod_BSP_EXT_ReadLong(&in);
+	}
+
+	if (end - in < 4)
+		goto badlump;
+	grid->numleafs = Mod_BSP_EXT_ReadLong(&in);
+	if (grid->numleafs <= 0 || (end - in) / 24 < grid->numleafs)
+		goto badlump;
+
+	//
+	// first pass validates leafs and counts points, they're variable length
+	//
+	leafdata = in;
+	numpoints = 0;
+	for (i = 0; i < grid->numleafs; i++)
+	{
+		int size[3];
+
+		if (end - in < 24)
+			goto badlump;
+		in += 12; // mins
+		for (j = 0; j < 3; j++)
+		{
+			size[j] = Mod_BSP_EXT_ReadLong(&in);
+			if (size[j] <= 0 || size[j] > grid->size[j])
+				goto badlump;
+		}
+
+		if ((long long)size[0] * size[1] * size[2] > end - in) // every point takes at least a byte
+			goto badlump;
+		count = size[0] * size[1] * size[2];
+
+		for (j = 0; j < count; j++)
+		{
+			if (in >= end)
+				goto badlump;
+			k = *in++;
+			if (k == LIGHTGRID_POINT_MISSING)
+				continue;
+			if (end - in < k * 4)
+				goto badlump;
+			in += k * 4;
+		}
+		numpoints += count;
+	}
+
+	for (i = 0; i < grid->numnodes; i++)
+	{
+		for (j = 0; j < 8; j++)
+			if (!Mod_BSP_EXT_ValidLightGridChild(grid, grid->nodes[i].children[j]))
+				goto badlump;
+	}
+	if (!Mod_BSP_EXT_ValidLightGridChild(grid, grid->rootnode))
+		goto badlump;
+
+	//
+	// second pass copies samples, styles above grid->numstyles are dropped
+	//
+	grid->numpoints = numpoints;
+	grid->leafs = Hunk_Alloc(sizeof(*grid->leafs) * grid->numleafs);
+	grid->pointstyles = Hunk_Alloc(numpoints);
+	grid->samples = Hunk_Alloc(sizeof(*grid->samples) * numpoints * grid->numstyles);
+
+	in = leafdata;
+	numpoints = 0;
+	for (i = 0, leaf = grid->leafs; i < grid->numleafs; i++, leaf++)
+	{
+		for (j = 0; j < 3; j++)
+			leaf->mins[j] = Mod_BSP_EXT_ReadLong(&in);
+		for (j = 0; j < 3; j++)
+			leaf->size[j] = Mod_BSP_EXT_ReadLong(&in);
+		leaf->firstpoint = numpoints;
+
+		count = leaf->size[0] * leaf->size[1] * leaf->size[2];
+		for (j = 0; j < count; j++, numpoints++)
+		{
+			sample = grid->samples + numpoints * grid->numstyles;
+
+			k = *in++;
+			if (k == LIGHTGRID_POINT_MISSING)
+			{
+				grid->pointstyles[numpoints] = LIGHTGRID_POINT_MISSING;
+				continue;
+			}
+
+			grid->pointstyles[numpoints] = min(k, grid->numstyles);
+			for (style = 0; style < k; style++, in += 4)
+			{
+				if (style >= grid->numstyles)
+					continue;
+				sample[style].style = in[0];
+				sample[style].rgb[0] = in[1];
+				sample[style].rgb[1] = in[2];
+				sample[style].rgb[2] = in[3];
+			}
+		}
+	}
+
+	pLoadModel->lightgrid = grid;
+	ri.Printf(PRINT_ALL, "%s compiled with LIGHTGRID_OCTREE lump (%i points in %i leafs).\n", pLoadModel->name, grid->numpoints, grid->numleafs);
+	return true;
+
+badlump:
+	ri.Printf(PRINT_ALL, "%s: broken LIGHTGRID_OCTREE lump in %s, ignored\n", __FUNCTION__, pLoadModel->name);
+	return false;
+}
+
+
 /*
 =================
 Mod_BSP_FindExtLumps
@@ -1414,6 +1611,9 @@ void Mod_LoadBSP(model_t *mod, void *buffer)
 	Mod_BSP_LoadVisibility (&header->lumps[LUMP_VISIBILITY]);
 	Mod_BSP_LoadLeafs (&header->lumps[LUMP_LEAFS]);
 	Mod_BSP_LoadNodes (&header->lumps[LUMP_NODES]);
+
+	if (r_lightgrid->value && !Mod_BSP_EXT_LoadLightGrid())
+		R_LightGrid_Build(pLoadModel, mod_base, modelFileLength);
 	Mod_BSP_LoadInlineModels (&header->lumps[LUMP_MODELS]);
 
 	//
@@ -172,6 +172,54 @@ typedef struct mleaf_s
 } mleaf_t;
 
 
+//
+// light grid for lighting entities, loaded from BSPX LIGHTGRID_OCTREE or baked from lightmaps
+//
+#define LIGHTGRID_NODE_LEAF		0x80000000
+#define LIGHTGRID_NODE_MISSING	0x40000000
+#define LIGHTGRID_POINT_MISSING	255		// point is inside solid and is skipped when blending
+#define LIGHTGRID_MAX_DEPTH		32		// grid sizes are ints so a real octree is never deeper, stops lumps with cycles
+
+typedef struct
+{
+	int				mid[3];			// child = (x >= mid[0]) << 2 | (y >= mid[1]) << 1 | (z >= mid[2])
+	unsigned int	children[8];	// node index or leaf index | LIGHTGRID_NODE_LEAF
+} mlightgridnode_t;
+
+typedef struct
+{
+	int			mins[3];		// in grid points
+	int			size[3];
+	int			firstpoint;
+} mlightgridleaf_t;
+
+typedef struct
+{
+	byte		style;
+	byte		rgb[3];
+} mlightgridsample_t;
+
+typedef struct
+{
+	vec3_t		mins;
+	vec3_t		step;
+	vec3_t		invstep;
+	int			size[3];
+	int			numstyles;		// samples stored per point, at most MAX_LIGHTMAPS_PER_SURFACE
+
+	unsigned int	rootnode;
+	int			numnodes;
+	mlightgridnode_t	*nodes;
+
+	int			numleafs;
+	mlightgridleaf_t	*leafs;
+
+	int			numpoints;
+	byte		*pointstyles;	// styles used by each point or LIGHTGRID_POINT_MISSING
+	mlightgridsample_t	*samples;	// [numpoints * numstyles]
+} mlightgrid_t;
+
+
 //===================================================================
 
 typedef struct model_s
@@ -242,6 +290,8 @@ typedef struct model_s
 	byte		*lightdata;
 	int			lightdatasize;
 
+	mlightgrid_t	*lightgrid;	// NULL when r_lightgrid was off at load
+
 //
 // for alias models and sprites
 //
@@ -253,6 +303,7 @@ typedef struct model_s
 	int			cullDist;	// don't draw if farther than this
 
 	md3Header_t	*md3[MD3_MAX_LODS];	// only if type == MOD_MD3
+	unsigned	tagHashes[MD3_MAX_TAGS];	// Com_HashString of md3[LOD_HIGH] tag names
 	vertexbuffer_t *vb[MD3_MAX_SURFACES];
 } model_t;
 
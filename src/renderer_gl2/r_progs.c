@@ -81,14 +81,20 @@ static glprogloc_t progVertAtrribLocs[NUM_VALOCS] =
 
 	/*md3 rendering only*/
 	{ VALOC_OLD_POS,		"inOldVertPos",		F_VECTOR3 }, // MD3 ONLY
-	{ VALOC_OLD_NORMAL,		"inOldNormal",		F_VECTOR3 } // MD3 ONLY
+	{ VALOC_OLD_NORMAL,		"inOldNormal",		F_VECTOR3 }, // MD3 ONLY
+
+	/*instanced md3 rendering only, one value per instance*/
+	{ VALOC_INSTANCE_MATRIX,		"inInstanceMatrix",		F_VECTOR4 }, // mat4, localmodelview
+	{ VALOC_INSTANCE_SHADE,			"inInstanceShade",		F_VECTOR4 }, // shade_light and lerpFrac
+	{ VALOC_INSTANCE_SHADEVECTOR,	"inInstanceShadeVector", F_VECTOR4 } // shade_vector
 };
 
 //Program metadata.
 //This is used to class shaders based on what data needs to be updated. 
 typedef enum
 {
-	PF_ORTHO = 1	//update with ortho projection
+	PF_ORTHO = 1,	//update with ortho projection
+	PF_OPTIONAL = 2	//missing shader files only disable the program
 } progflags_t;
 
 typedef struct
@@ -108,7 +114,8 @@ static proginfo_t proginfo[] =
 	{GLPROG_GUI,			"gui",				PF_ORTHO},
 	{GLPROG_POSTFX,			"postfx",			PF_ORTHO},
 	{GLPROG_DEBUGSTRING,	"debug_string"},
-	{GLPROG_DEBUGLINE,		"debug_line"}
+	{GLPROG_DEBUGLINE,		"debug_line"},
+	{GLPROG_ALIAS_INSTANCED,	"model_alias_instanced",	PF_OPTIONAL}
 };
 
 #define NUM_PROGINFO sizeof(proginfo) / sizeof(proginfo[0])
@@ -405,7 +412,7 @@ static qboolean R_CheckShaderObject(glprog_t *prog, unsigned int shaderObject, c
 R_CompileShader
 =================
 */
-static qboolean R_CompileShader(glprog_t* glprog, qboolean isfrag)
+static qboolean R_CompileShader(glprog_t* glprog, qboolean isfrag, qboolean optional)
 {
 	char	fileName[MAX_OSPATH];
 	char	*data = NULL;
@@ -416,6 +423,11 @@ static qboolean R_CompileShader(glprog_t* glprog, qboolean isfrag)
 	len = ri.LoadTextFile(fileName, (void**)&data);
 	if (!len || len == -1 || data == NULL)
 	{
+		if (optional)
+		{
+			ri.Printf(PRINT_LOW, "Optional shader %s not found, program \"%s\" disabled.\n", fileName, glprog->name);
+			return false;
+		}
 		ri.Error(ERR_FATAL, "failed to load shader: %s\n", fileName);
 		return false;
 	}
@@ -498,6 +510,8 @@ void R_UpdateCommonProgUniforms(qboolean orthoonly)
 	for (i = 0; i < NUM_PROGINFO; i++)
 	{
 		info = &proginfo[i];
+		if (proginfolookup[i] == -1)
+			continue; // optional program which didn't load
 		prog = &glprogs[proginfolookup[i]];
 		if (!prog->isValid)
 			continue;
@@ -633,10 +647,13 @@ static int R_LoadProgram(int id)
 
 	strcpy(prog->name, info->name);
 
-	if (!R_CompileShader(prog, true))
+	if (!R_CompileShader(prog, true, info->flags & PF_OPTIONAL))
 		return -1;
-	if (!R_CompileShader(prog, false))
+	if (!R_CompileShader(prog, false, info->flags & PF_OPTIONAL))
+	{
+		R_FreeProgram(prog);
 		return -1;
+	}
 	if (!R_LinkProgram(prog))
 		return -1;
 
@@ -25,6 +25,82 @@ extern int registration_sequence; // experimental nature heh
 
 #define MAX_INDICES 16384 // build indices untill this
 
+// static world draw lists, world surfaces are sorted by pass, material, cluster and area
+// and grouped into chunks that own a range of the static index buffer, every cluster
+// keeps a sorted list of chunks it can see so a frame only merges, culls and draws them
+typedef enum
+{
+	WPASS_OPAQUE,
+	WPASS_WARP,
+	WPASS_SKY,
+	WPASS_ALPHA
+} worldpass_t;
+
+typedef struct
+{
+	int			pass;
+	int			image;		// texnum, or -(texinfo + 1) for animated textures
+	int			lightmap;
+	unsigned	styles;		// packed lightstyle indices
+	int			uniformflags;
+	int			cluster;
+	int			area;		// -1 when surface is shared by leafs in different areas
+	int			surfnum;
+} wsortsurf_t;
+
+typedef struct
+{
+	int			pass;
+	msurface_t	*surf;		// first surface, used to pick textures, styles and uniforms
+} wmaterial_t;
+
+typedef struct
+{
+	int			material;
+	int			area;
+
+	int			firstIndex, numIndices;	// range in index buffer
+	int			firstSurf, numSurfs;	// range in surfs
+	vec3_t		mins, maxs;
+} wchunk_t;
+
+typedef struct
+{
+	float		dist;
+	msurface_t	*surf;
+} walphasurf_t;
+
+typedef struct
+{
+	qboolean	built;
+	GLuint		ibo;
+
+	int			numMaterials;
+	wmaterial_t	*materials;
+
+	int			numChunks;
+	wchunk_t	*chunks;
+	int			*surfChunk;		// chunk for each world surface, -1 if not in any leaf
+	msurface_t	**surfs;		// surfaces sorted by chunk
+	vec3_t		*surfCenters;
+
+	int			numClusters;
+	int			**clusterChunks;	// sorted list of chunks visible from cluster, built on first visit
+	int			*clusterNumChunks;	// -1 if not built yet
+
+	int			*chunkMark;
+	int			markStamp;
+
+	int			*frameChunks;		// merged lists for the current frame
+	byte		*frameVisible;		// set by front-end for each frame chunk that passed culling
+	int			numFrameChunks;
+	int			viewcluster, viewcluster2;
+
+	GLsizei		*rangeCounts;
+	GLvoid		**rangeOffsets;
+	walphasurf_t *alphaSurfs;
+} worldlists_t;
+
 // gfx world stores the current state for batching drawcalls, if any 
 // of them change we draw what we have so far and begin building indices again
 typedef struct gfx_world_s
@@ -48,6 +124,8 @@ typedef struct gfx_world_s
 
 	qboolean	isRenderingWorld;
 	int			registration_sequence; // hackery
+
+	worldlists_t lists;
 } gfx_world_t;
 
 static gfx_world_t gfx_world = { 0 };
@@ -144,6 +222,45 @@ void R_BuildPolygonFromSurface(model_t* mod, msurface_t* surf)
 // VERTEX BUFFER MANAGMENT
 // ==============================================================================
 
+/*
+=================
+R_World_FreeStaticLists
+=================
+*/
+static void R_World_FreeStaticLists()
+{
+	worldlists_t* wl = &gfx_world.lists;
+	int i;
+
+	if (!wl->built)
+		return;
+
+	if (wl->ibo)
+		glDeleteBuffers(1, &wl->ibo);
+
+	for (i = 0; i < wl->numClusters; i++)
+	{
+		if (wl->clusterChunks[i])
+			free(wl->clusterChunks[i]);
+	}
+
+	free(wl->clusterChunks);
+	free(wl->clusterNumChunks);
+	free(wl->materials);
+	free(wl->chunks);
+	free(wl->surfChunk);
+	free(wl->surfs);
+	free(wl->surfCenters);
+	free(wl->chunkMark);
+	free(wl->frameChunks);
+	free(wl->frameVisible);
+	free(wl->rangeCounts);
+	free(wl->rangeOffsets);
+	free(wl->alphaSurfs);
+
+	memset(wl, 0, sizeof(*wl));
+}
+
 /*
 =================
 R_DestroyWorldVertexBuffer
@@ -156,6 +273,7 @@ static void R_DestroyWorldVertexBuffer()
 	if (!gfx_world.vbo)
 		return;
 
+	R_World_FreeStaticLists();
 	glDeleteBuffers(1, &gfx_world.vbo);
 
 	ri.Printf(PRINT_LOW, "Freed world surface cache.\n");
@@ -241,6 +359,383 @@ static void R_BuildVertexBufferForWorld()
 	ri.Printf(PRINT_LOW, "World surface cache is %i kb (%i verts in %i surfaces)\n", bufsize / 1024, gfx_world.totalVertCount, r_worldmodel->numsurfaces);
 }
 
+/*
+=================
+R_World_SurfSortKey
+
+Fill in the material part of the sort key, surfaces with equal material can be drawn with one state
+=================
+*/
+static void R_World_SurfSortKey(msurface_t* surf, wsortsurf_t* key)
+{
+	mtexinfo_t* texinfo = surf->texinfo;
+	int i;
+
+	key->lightmap = 0;
+	key->styles = 0;
+	key->uniformflags = texinfo->flags & (SURF_WARP | SURF_FLOWING | SURF_SCROLLX | SURF_SCROLLY | SURF_SCROLLFLIP);
+
+	if (texinfo->next)
+		key->image = -(int)(texinfo - r_worldmodel->texinfo) - 1;
+	else
+		key->image = texinfo->image ? texinfo->image->texnum : 0;
+
+	if (texinfo->flags & SURF_SKY)
+		key->pass = WPASS_SKY;
+	else if (texinfo->flags & (SURF_TRANS33 | SURF_TRANS66))
+		key->pass = WPASS_ALPHA;
+	else if (surf->flags & SURF_DRAWTURB)
+		key->pass = WPASS_WARP;
+	else
+	{
+		key->pass = WPASS_OPAQUE;
+		key->lightmap = surf->lightMapTextureNum;
+		for (i = 0; i < MAX_LIGHTMAPS_PER_SURFACE; i++)
+			key->styles |= (unsigned)surf->styles[i] << (i * 8);
+	}
+}
+
+/*
+=================
+R_World_SortSurfCmp
+=================
+*/
+static int R_World_SortSurfCmp(const void* a, const void* b)
+{
+	const wsortsurf_t* sa = (const wsortsurf_t*)a;
+	const wsortsurf_t* sb = (const wsortsurf_t*)b;
+
+	if (sa->pass != sb->pass)
+		return sa->pass - sb->pass;
+	if (sa->image != sb->image)
+		return sa->image < sb->image ? -1 : 1;
+	if (sa->lightmap != sb->lightmap)
+		return sa->lightmap - sb->lightmap;
+	if (sa->styles != sb->styles)
+		return sa->styles < sb->styles ? -1 : 1;
+	if (sa->uniformflags != sb->uniformflags)
+		return sa->uniformflags - sb->uniformflags;
+	if (sa->cluster != sb->cluster)
+		return sa->cluster - sb->cluster;
+	if (sa->area != sb->area)
+		return sa->area - sb->area;
+	return sa->surfnum - sb->surfnum;
+}
+
+/*
+=================
+R_World_SameMaterial
+=================
+*/
+static qboolean R_World_SameMaterial(const wsortsurf_t* a, const wsortsurf_t* b)
+{
+	return a->pass == b->pass && a->image == b->image && a->lightmap == b->lightmap && a->styles == b->styles && a->uniformflags == b->uniformflags;
+}
+
+/*
+=================
+R_World_BuildStaticLists
+
+Sort all world surfaces into material chunks and upload their indices as one static
+index buffer. Surfaces are owned by the cluster of the first leaf that marks them,
+per cluster visibility lists are built on demand in R_World_ClusterChunks.
+Must be called after R_BuildVertexBufferForWorld as it relies on surf->firstvert.
+=================
+*/
+static void R_World_BuildStaticLists()
+{
+	worldlists_t	*wl = &gfx_world.lists;
+	wsortsurf_t		*sorted, *ss;
+	int				*owner, *ownerArea;
+	GLuint			*indices;
+	msurface_t		*surf, **mark;
+	mleaf_t			*leaf;
+	wchunk_t		*chunk;
+	poly_t			*p;
+	int				i, j, k, numsorted, numIndices, totalIndices;
+
+	if (!r_worldmodel || !r_worldmodel->vis || wl->built)
+		return;
+
+	owner = malloc(sizeof(int) * r_worldmodel->numsurfaces);
+	ownerArea = malloc(sizeof(int) * r_worldmodel->numsurfaces);
+	sorted = malloc(sizeof(wsortsurf_t) * r_worldmodel->numsurfaces);
+	wl->surfChunk = malloc(sizeof(int) * r_worldmodel->numsurfaces);
+	wl->surfs = malloc(sizeof(msurface_t*) * r_worldmodel->numsurfaces);
+	wl->surfCenters = malloc(sizeof(vec3_t) * r_worldmodel->numsurfaces);
+	wl->alphaSurfs = malloc(sizeof(walphasurf_t) * r_worldmodel->numsurfaces);
+	if (!owner || !ownerArea || !sorted || !wl->surfChunk || !wl->surfs || !wl->surfCenters || !wl->alphaSurfs)
+		ri.Error(ERR_FATAL, "failed to allocate world draw lists for %i surfaces", r_worldmodel->numsurfaces);
+
+	for (i = 0; i < r_worldmodel->numsurfaces; i++)
+	{
+		owner[i] = -1;
+		wl->surfChunk[i] = -1;
+	}
+
+	//
+	// find the owner leaf of each surface, surfaces seen from leafs in different areas are never area culled
+	//
+	for (i = 0, leaf = r_worldmodel->leafs; i < r_worldmodel->numleafs; i++, leaf++)
+	{
+		if (leaf->cluster == -1)
+			continue;
+
+		for (j = 0, mark = leaf->firstmarksurface; j < leaf->nummarksurfaces; j++, mark++)
+		{
+			k = *mark - r_worldmodel->surfaces;
+			if (owner[k] == -1)
+			{
+				owner[k] = i;
+				ownerArea[k] = leaf->area;
+			}
+			else if (ownerArea[k] != leaf->area)
+				ownerArea[k] = -1;
+		}
+	}
+
+	for (i = 0, numsorted = 0, totalIndices = 0; i < r_worldmodel->numsurfaces; i++)
+	{
+		if (owner[i] == -1)
+			continue; // brushmodel surface
+
+		surf = &r_worldmodel->surfaces[i];
+		ss = &sorted[numsorted++];
+
+		R_World_SurfSortKey(surf, ss);
+		ss->cluster = r_worldmodel->leafs[owner[i]].cluster;
+		ss->area = ownerArea[i];
+		ss->surfnum = i;
+
+		if (ss->pass == WPASS_OPAQUE || ss->pass == WPASS_WARP)
+			totalIndices += (surf->numedges - 2) * 3;
+	}
+
+	qsort(sorted, numsorted, sizeof(wsortsurf_t), R_World_SortSurfCmp);
+
+	//
+	// count materials and chunks
+	//
+	for (i = 0; i < numsorted; i++)
+	{
+		if (!i || !R_World_SameMaterial(&sorted[i], &sorted[i - 1]))
+		{
+			wl->numMaterials++;
+			wl->numChunks++;
+		}
+		else if (sorted[i].cluster != sorted[i - 1].cluster || sorted[i].area != sorted[i - 1].area)
+			wl->numChunks++;
+	}
+
+	wl->materials = malloc(sizeof(wmaterial_t) * (wl->numMaterials + 1));
+	wl->chunks = malloc(sizeof(wchunk_t) * (wl->numChunks + 1));
+	wl->chunkMark = calloc(wl->numChunks + 1, sizeof(int));
+	wl->frameChunks = malloc(sizeof(int) * (wl->numChunks + 1));
+	wl->frameVisible = malloc(wl->numChunks + 1);
+	wl->rangeCounts = malloc(sizeof(GLsizei) * (wl->numChunks + 1));
+	wl->rangeOffsets = malloc(sizeof(GLvoid*) * (wl->numChunks + 1));
+	indices = malloc(sizeof(GLuint) * (totalIndices + 1));
+	if (!wl->materials || !wl->chunks || !wl->chunkMark || !wl->frameChunks || !wl->frameVisible || !wl->rangeCounts || !wl->rangeOffsets || !indices)
+		ri.Error(ERR_FATAL, "failed to allocate world draw lists for %i chunks", wl->numChunks);
+
+	//
+	// fill in chunks and indices
+	//
+	chunk = NULL;
+	wl->numMaterials = wl->numChunks = 0;
+	for (i = 0, numIndices = 0; i < numsorted; i++)
+	{
+		ss = &sorted[i];
+		surf = &r_worldmodel->surfaces[ss->surfnum];
+
+		if (!i || !R_World_SameMaterial(ss, &sorted[i - 1]))
+		{
+			wl->materials[wl->numMaterials].pass = ss->pass;
+			wl->materials[wl->numMaterials].surf = surf;
+			wl->numMaterials++;
+			chunk = NULL;
+		}
+		else if (ss->cluster != sorted[i - 1].cluster || ss->area != sorted[i - 1].area)
+			chunk = NULL;
+
+		if (!chunk)
+		{
+			chunk = &wl->chunks[wl->numChunks++];
+			chunk->material = wl->numMaterials - 1;
+			chunk->area = ss->area;
+			chunk->firstIndex = numIndices;
+			chunk->numIndices = 0;
+			chunk->firstSurf = i;
+			chunk->numSurfs = 0;
+			ClearBounds(chunk->mins, chunk->maxs);
+		}
+
+		wl->surfs[i] = surf;
+		wl->surfChunk[ss->surfnum] = wl->numChunks - 1;
+		chunk->numSurfs++;
+
+		VectorClear(wl->surfCenters[ss->surfnum]);
+		for (p = surf->polys, k = 0; p; p = p->next)
+		{
+			for (j = 0; j < p->numverts; j++, k++)
+			{
+				AddPointToBounds(p->verts[j].pos, chunk->mins, chunk->maxs);
+				VectorAdd(wl->surfCenters[ss->surfnum], p->verts[j].pos, wl->surfCenters[ss->surfnum]);
+			}
+		}
+		if (k)
+			VectorScale(wl->surfCenters[ss->surfnum], 1.0f / k, wl->surfCenters[ss->surfnum]);
+
+		if (ss->pass != WPASS_OPAQUE && ss->pass != WPASS_WARP)
+			continue;
+
+		// same triangle fan as R_World_NewDrawSurface
+		for (j = 0; j < surf->numedges - 2; j++)
+		{
+			indices[numIndices++] = surf->firstvert;
+			indices[numIndices++] = surf->firstvert + (j + 1);
+			indices[numIndices++] = surf->firstvert + (j + 2);
+		}
+		chunk->numIndices = numIndices - chunk->firstIndex;
+	}
+
+	glGenBuffers(1, &wl->ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wl->ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * numIndices, indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	free(indices);
+	free(sorted);
+	free(ownerArea);
+	free(owner);
+
+	wl->numClusters = r_worldmodel->vis->numclusters;
+	wl->clusterChunks = calloc(wl->numClusters + 1, sizeof(int*));
+	wl->clusterNumChunks = malloc(sizeof(int) * (wl->numClusters + 1));
+	if (!wl->clusterChunks || !wl->clusterNumChunks)
+		ri.Error(ERR_FATAL, "failed to allocate world draw lists for %i clusters", wl->numClusters);
+	for (i = 0; i < wl->numClusters; i++)
+		wl->clusterNumChunks[i] = -1;
+
+	wl->viewcluster = wl->viewcluster2 = -1;
+	wl->built = true;
+
+	ri.Printf(PRINT_LOW, "World draw lists: %i materials, %i chunks, %i indices for %i clusters\n", wl->numMaterials, wl->numChunks, numIndices, wl->numClusters);
+}
+
+/*
+=================
+R_World_IntCmp
+=================
+*/
+static int R_World_IntCmp(const void* a, const void* b)
+{
+	return *(const int*)a - *(const int*)b;
+}
+
+/*
+=================
+R_World_ClusterChunks
+
+Returns sorted list of chunks potentially visible from cluster, builds it on first visit
+=================
+*/
+static int* R_World_ClusterChunks(int cluster, int* numChunks)
+{
+	worldlists_t	*wl = &gfx_world.lists;
+	mleaf_t			*leaf;
+	msurface_t		**mark;
+	byte			*vis;
+	int				*list, i, j, c, leafcluster, count;
+
+	*numChunks = 0;
+	if (cluster < 0 || cluster >= wl->numClusters)
+		return NULL;
+
+	if (wl->clusterNumChunks[cluster] >= 0)
+	{
+		*numChunks = wl->clusterNumChunks[cluster];
+		return wl->clusterChunks[cluster];
+	}
+
+	vis = Mod_BSP_ClusterPVS(cluster, r_worldmodel);
+	wl->markStamp++;
+
+	// frameChunks is free to use as a scratch buffer here
+	list = wl->frameChunks;
+	count = 0;
+	for (i = 0, leaf = r_worldmodel->leafs; i < r_worldmodel->numleafs; i++, leaf++)
+	{
+		leafcluster = leaf->cluster;
+		if (leafcluster == -1 || !(vis[leafcluster >> 3] & (1 << (leafcluster & 7))))
+			continue;
+
+		for (j = 0, mark = leaf->firstmarksurface; j < leaf->nummarksurfaces; j++, mark++)
+		{
+			c = wl->surfChunk[*mark - r_worldmodel->surfaces];
+			if (c == -1 || wl->chunkMark[c] == wl->markStamp)
+				continue;
+			wl->chunkMark[c] = wl->markStamp;
+			list[count++] = c;
+		}
+	}
+
+	qsort(list, count, sizeof(int), R_World_IntCmp);
+
+	wl->clusterChunks[cluster] = malloc(sizeof(int) * (count + 1));
+	if (!wl->clusterChunks[cluster])
+		ri.Error(ERR_FATAL, "failed to allocate world draw list for cluster %i", cluster);
+	memcpy(wl->clusterChunks[cluster], list, sizeof(int) * count);
+	wl->clusterNumChunks[cluster] = count;
+
+	*numChunks = count;
+	return wl->clusterChunks[cluster];
+}
+
+/*
+=================
+R_World_UpdateFrameChunks
+
+Merge chunk lists of both view clusters, a camera may be in two PVS areas
+=================
+*/
+static void R_World_UpdateFrameChunks()
+{
+	worldlists_t	*wl = &gfx_world.lists;
+	int				*a, *b, na, nb, i, j, n;
+
+	// development aid to let you run around and see exactly where the pvs ends
+	if (r_lockpvs->value && wl->viewcluster != -1)
+		return;
+
+	if (wl->viewcluster == r_viewcluster && wl->viewcluster2 == r_viewcluster2)
+		return;
+
+	wl->viewcluster = r_viewcluster;
+	wl->viewcluster2 = r_viewcluster2;
+
+	// note: R_World_ClusterChunks uses frameChunks as scratch so lists are resolved before merging
+	b = NULL;
+	nb = 0;
+	a = R_World_ClusterChunks(r_viewcluster, &na);
+	if (r_viewcluster2 != r_viewcluster)
+		b = R_World_ClusterChunks(r_viewcluster2, &nb);
+
+	for (i = j = n = 0; i < na || j < nb; )
+	{
+		if (j >= nb || (i < na && a[i] < b[j]))
+			wl->frameChunks[n++] = a[i++];
+		else if (i >= na || b[j] < a[i])
+			wl->frameChunks[n++] = b[j++];
+		else
+		{
+			wl->frameChunks[n++] = a[i++];
+			j++;
+		}
+	}
+	wl->numFrameChunks = n;
+}
+
 // ==============================================================================
 // RENDERING
 // ==============================================================================
@@ -453,6 +948,36 @@ change:
 	return hasChanged;
 }
 
+/*
+=======================
+R_World_SetSurfaceUniforms
+
+Warp and flow uniforms for surface texinfo flags
+=======================
+*/
+static void R_World_SetSurfaceUniforms(int texflags)
+{
+	float scrollx = 0, scrolly = 0;
+
+	if (texflags & SURF_WARP)
+		R_ProgUniform1f(LOC_WARPSTRENGTH, 1.f);
+	else
+		R_ProgUniform1f(LOC_WARPSTRENGTH, 0.f);
+
+	if (texflags & SURF_FLOWING)
+		scrollx = -64;
+	else if (texflags & SURF_SCROLLX)
+		scrollx = -32;
+	if (texflags & SURF_SCROLLY)
+		scrolly = -32;
+	if (texflags & SURF_SCROLLFLIP)
+	{
+		scrollx = -scrollx; scrolly = -scrolly;
+	}
+
+	R_ProgUniform2f(LOC_FLOWSTRENGTH, scrollx, scrolly);
+}
+
 /*
 =======================
 R_World_NewDrawSurface
@@ -484,25 +1009,7 @@ static void R_World_NewDrawSurface(msurface_t* surf, qboolean lightmapped)
 	{
 		R_World_DrawAndFlushBufferedGeo();
 		//Only when starting a new batch should uniforms be updated, since they will persist across all of the batch's draws
-		
-		if (surf->texinfo->flags & SURF_WARP)
-			R_ProgUniform1f(LOC_WARPSTRENGTH, 1.f);
-		else
-			R_ProgUniform1f(LOC_WARPSTRENGTH, 0.f);
-		
-		float scrollx = 0, scrolly = 0;
-		if (surf->texinfo->flags & SURF_FLOWING)
-			scrollx = -64;
-		else if (surf->texinfo->flags & SURF_SCROLLX)
-			scrollx = -32;
-		if (surf->texinfo->flags & SURF_SCROLLY)
-			scrolly = -32;
-		if (surf->texinfo->flags & SURF_SCROLLFLIP)
-		{
-			scrollx = -scrollx; scrolly = -scrolly;
-		}
-
-		R_ProgUniform2f(LOC_FLOWSTRENGTH, scrollx, scrolly);
+		R_World_SetSurfaceUniforms(surf->texinfo->flags);
 	}
 
 	if (stylechanged)
@@ -752,6 +1259,246 @@ static void R_World_DrawSortedByDiffuseMap()
 	R_World_EndRendering();
 }
 
+/*
+================
+R_World_UseStaticLists
+
+Static lists replace leaf marking and texture chains, development
+tools that rely on them fall back to the BSP walk
+================
+*/
+static qboolean R_World_UseStaticLists()
+{
+	if (!r_worldlists->value || r_novis->value || r_showtris->value)
+		return false;
+
+	if (!r_worldmodel || !r_worldmodel->vis || r_viewcluster == -1)
+		return false;
+
+	return true;
+}
+
+/*
+================
+R_World_PrepareFrontChunks
+
+Front-end: resolve chunk lists for current view clusters, returns the number
+of chunks to cull or 0 when world is drawn by walking BSP tree.
+Must run on the main thread as cluster lists are built on demand.
+================
+*/
+int R_World_PrepareFrontChunks()
+{
+	if (!R_World_UseStaticLists() || !gfx_world.lists.built)
+		return 0;
+
+	R_World_UpdateFrameChunks();
+	return gfx_world.lists.numFrameChunks;
+}
+
+/*
+================
+R_World_CullFrontChunks
+
+Front-end job: areabits and frustum test a range of frame chunks, safe to run on workers
+================
+*/
+void R_World_CullFrontChunks(int first, int count)
+{
+	worldlists_t	*wl = &gfx_world.lists;
+	wchunk_t		*chunk;
+	int				i;
+
+	for (i = first; i < first + count; i++)
+	{
+		chunk = &wl->chunks[wl->frameChunks[i]];
+		wl->frameVisible[i] = false;
+
+		// check for door connected areas
+		if (r_newrefdef.areabits && chunk->area != -1)
+		{
+			if (!(r_newrefdef.areabits[chunk->area >> 3] & (1 << (chunk->area & 7))))
+				continue;	// not visible
+		}
+
+		if (R_CullBox(chunk->mins, chunk->maxs))
+			continue;
+
+		wl->frameVisible[i] = true;
+	}
+}
+
+/*
+================
+R_World_SurfFacesView
+================
+*/
+static qboolean R_World_SurfFacesView(msurface_t* surf)
+{
+	float dot = DotProduct(modelorg, surf->plane->normal) - surf->plane->dist;
+
+	if (surf->flags & SURF_PLANEBACK)
+		return dot < 0;
+	return dot >= 0;
+}
+
+/*
+================
+R_World_AlphaSurfCmp
+================
+*/
+static int R_World_AlphaSurfCmp(const void* a, const void* b)
+{
+	float da = ((const walphasurf_t*)a)->dist;
+	float db = ((const walphasurf_t*)b)->dist;
+
+	if (da == db)
+		return 0;
+	return da < db ? -1 : 1;
+}
+
+/*
+================
+R_World_FlushStaticRanges
+
+Draw all merged index ranges of a material with one call
+================
+*/
+static void R_World_FlushStaticRanges(wmaterial_t* mat, int numRanges)
+{
+	worldlists_t	*wl = &gfx_world.lists;
+	int				tex_diffuse, tex_lightmap, i;
+	qboolean		lightmapped;
+
+	if (!numRanges)
+		return;
+
+	lightmapped = (mat->pass == WPASS_OPAQUE);
+
+	R_World_GrabSurfaceTextures(mat->surf, &tex_diffuse, &tex_lightmap);
+	R_World_UpdateLightStylesForSurf((r_fullbright->value > 0.0f || !lightmapped) ? NULL : mat->surf);
+	for (i = 0; i < MAX_LIGHTMAPS_PER_SURFACE; i++)
+		VectorCopy(gfx_world.new_styles[i], gfx_world.styles[i]);
+
+	R_World_SetSurfaceUniforms(mat->surf->texinfo->flags);
+
+	R_MultiTextureBind(TMU_DIFFUSE, tex_diffuse);
+	R_MultiTextureBind(TMU_LIGHTMAP, tex_lightmap);
+	R_ProgUniform3fv(LOC_LIGHTSTYLES, MAX_LIGHTMAPS_PER_SURFACE, gfx_world.styles[0]);
+
+	if (numRanges == 1)
+		glDrawElements(GL_TRIANGLES, wl->rangeCounts[0], GL_UNSIGNED_INT, wl->rangeOffsets[0]);
+	else
+		glMultiDrawElements(GL_TRIANGLES, wl->rangeCounts, GL_UNSIGNED_INT, (const void* const*)wl->rangeOffsets, numRanges);
+
+	rperf.brush_drawcalls++;
+	rperf.brush_textures++;
+}
+
+/*
+================
+R_World_DrawStaticLists
+
+Draw the world from the chunk lists of current view clusters culled by the front-end.
+Chunks are sorted by material so consecutive visible chunks collapse into a few
+index ranges per material.
+Sky surfaces are added to sky bounds and alpha surfaces are sorted into
+the translucent chain back to front.
+================
+*/
+static void R_World_DrawStaticLists()
+{
+	worldlists_t	*wl = &gfx_world.lists;
+	wchunk_t		*chunk;
+	wmaterial_t		*mat;
+	msurface_t		*surf;
+	walphasurf_t	*as;
+	int				i, j, curMaterial, numRanges, rangeEnd, numAlpha;
+	vec3_t			delta;
+
+	rperf.brush_textures = 0;
+	rperf.world_chunks = 0;
+
+	R_World_BeginRendering();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wl->ibo);
+
+	curMaterial = -1;
+	numRanges = 0;
+	rangeEnd = -1;
+	numAlpha = 0;
+
+	for (i = 0; i < r_front.numWorldChunks; i++)
+	{
+		if (!wl->frameVisible[i])
+			continue;
+
+		chunk = &wl->chunks[wl->frameChunks[i]];
+		rperf.world_chunks++;
+		mat = &wl->materials[chunk->material];
+
+		if (mat->pass == WPASS_SKY || mat->pass == WPASS_ALPHA)
+		{
+			for (j = 0; j < chunk->numSurfs; j++)
+			{
+				surf = wl->surfs[chunk->firstSurf + j];
+				if (!R_World_SurfFacesView(surf))
+					continue;
+
+				if (mat->pass == WPASS_SKY)
+				{
+					R_AddSkySurface(surf);
+					continue;
+				}
+
+				as = &wl->alphaSurfs[numAlpha++];
+				as->surf = surf;
+				VectorSubtract(wl->surfCenters[surf - r_worldmodel->surfaces], modelorg, delta);
+				as->dist = DotProduct(delta, delta);
+			}
+			continue;
+		}
+
+		if (chunk->material != curMaterial)
+		{
+			if (curMaterial != -1)
+				R_World_FlushStaticRanges(&wl->materials[curMaterial], numRanges);
+			curMaterial = chunk->material;
+			numRanges = 0;
+			rangeEnd = -1;
+		}
+
+		// chunks of a material are contiguous in index buffer so neighbours merge into one range
+		if (chunk->firstIndex == rangeEnd)
+			wl->rangeCounts[numRanges - 1] += chunk->numIndices;
+		else
+		{
+			wl->rangeCounts[numRanges] = chunk->numIndices;
+			wl->rangeOffsets[numRanges] = (GLvoid*)(sizeof(GLuint) * chunk->firstIndex);
+			numRanges++;
+		}
+		rangeEnd = chunk->firstIndex + chunk->numIndices;
+
+		rperf.brush_polys += chunk->numSurfs;
+		rperf.brush_tris += chunk->numIndices / 3;
+	}
+
+	if (curMaterial != -1)
+		R_World_FlushStaticRanges(&wl->materials[curMaterial], numRanges);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	R_ProgUniform1f(LOC_WARPSTRENGTH, 0.f);
+	R_World_EndRendering();
+
+	// push nearest first so the farthest surface ends up at the head of the chain
+	qsort(wl->alphaSurfs, numAlpha, sizeof(walphasurf_t), R_World_AlphaSurfCmp);
+	for (i = 0; i < numAlpha; i++)
+	{
+		surf = wl->alphaSurfs[i].surf;
+		surf->texturechain = r_alpha_surfaces;
+		r_alpha_surfaces = surf;
+	}
+}
+
 /*
 ================
 R_World_DrawAlphaSurfaces_NEW
@@ -806,6 +1553,13 @@ void R_World_MarkLeaves()
 	mleaf_t* leaf;
 	int		cluster;
 
+	if (R_World_UseStaticLists())
+	{
+		// static lists don't use leaf marks, force a full mark when going back to BSP walk
+		r_oldviewcluster = r_oldviewcluster2 = -1;
+		return;
+	}
+
 	if (r_oldviewcluster == r_viewcluster && r_oldviewcluster2 == r_viewcluster2 && !r_novis->value && r_viewcluster != -1)
 		return;
 
@@ -1094,6 +1848,33 @@ static void R_World_DrawTriangleOutlines()
 	R_WriteToDepthBuffer(true);
 }
 
+/*
+================
+R_World_EnsureBuffers
+
+Build world vertex buffer and static lists for a new map, called
+before the front-end so it can cull chunks for the first frame
+================
+*/
+void R_World_EnsureBuffers()
+{
+	if (!r_worldmodel || (r_newrefdef.view.flags & RDF_NOWORLDMODEL))
+		return;
+
+	// should move this to Mod_LoadFaces or Mod_LoadBSP
+	if (registration_sequence != gfx_world.registration_sequence)
+	{
+		R_DestroyWorldVertexBuffer();
+		gfx_world.registration_sequence = registration_sequence;
+	}
+
+	if (!gfx_world.vbo) 
+	{
+		R_BuildVertexBufferForWorld();
+		R_World_BuildStaticLists();
+	}
+}
+
 /*
 ================
 R_DrawWorld
@@ -1104,6 +1885,7 @@ Draws world and skybox
 void R_DrawWorld()
 {
 	rentity_t	ent;
+	long long	start;
 
 	if (!r_drawworld->value)
 		return;
@@ -1123,8 +1905,7 @@ void R_DrawWorld()
 
 	R_ClearSkyBox();
 
-	// build texture chains
-	R_World_RecursiveNode(r_worldmodel->nodes);
+	start = Sys_Microseconds();
 
 	//no local transform needed for world. 
 	memcpy(r_local_matrix, mat4_identity, sizeof(mat4_t));
@@ -1134,19 +1915,18 @@ void R_DrawWorld()
 	// DRAW THE WORLD
 	// 
 	
-	// should move this to Mod_LoadFaces or Mod_LoadBSP
-	if (registration_sequence != gfx_world.registration_sequence)
+	if (R_World_UseStaticLists() && gfx_world.lists.built)
 	{
-		R_DestroyWorldVertexBuffer();
-		gfx_world.registration_sequence = registration_sequence;
+		R_World_DrawStaticLists();
 	}
-
-	if (!gfx_world.vbo) 
+	else
 	{
-		R_BuildVertexBufferForWorld();
+		// build texture chains
+		R_World_RecursiveNode(r_worldmodel->nodes);
+		R_World_DrawSortedByDiffuseMap();
 	}
 
-	R_World_DrawSortedByDiffuseMap();
+	rperf.world_usec += Sys_Microseconds() - start;
 
 	// 
 	// DRAW SKYBOX
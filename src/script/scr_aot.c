@@ -0,0 +1,293 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// scr_aot.c -- running progs translated to native code ahead of time
+
+/*
+src/tools/qc2c turns a .dat into C, one function per dfunction_t. Built into
+a module in the install directory (basedir/progs/svgame_aot.dll or .so, never
+a game directory downloads can write to) it is picked up when
+the qcvm is created, but only if it was generated from progs with the very
+same CRC, otherwise everything silently stays in the interpreter.
+
+Translated code keeps using the qcvm globals and entities for everything but
+its own parms and locals, so it can call into the interpreter and the other
+way around at any call. Functions qc2c couldn't translate are NULL in the
+module and simply run interpreted.
+
+vm_aotverify 1 runs every translated leaf function (one that calls nothing)
+twice, natively and in the interpreter, from the same globals and entities
+and reports the first word they disagree on.
+*/
+
+#include "../qcommon/qcommon.h"
+#include "script_internals.h"
+
+#ifdef _WIN32
+	#define	SCR_AOT_LIBEXT	".dll"
+#else
+	#define	SCR_AOT_LIBEXT	".so"
+#endif
+
+extern ddef_t* ScrInternal_GlobalAtOfs(int ofs);
+extern ddef_t* ScrInternal_FieldAtOfs(int ofs);
+
+cvar_t* vm_aot;
+cvar_t* vm_aotverify;
+
+/*
+============
+ScrAOT_Call
+
+Module import, calls any function or builtin with parms already in globals
+============
+*/
+static void ScrAOT_Call(int func, int argc)
+{
+	qcvm_t* vm = active_qcvm;
+	dfunction_t* f;
+
+	if (!func || func >= vm->progs->numFunctions)
+		Scr_RunError("%s: NULL function in %s\n", __FUNCTION__, vmDefs[vm->progsType].filename);
+
+	f = &vm->functions[func];
+	vm->argc = argc;
+
+	if (f->first_statement < 0)
+		ScrInternal_CallBuiltin(vm, f);
+	else if (vm->aot->functions[func] && !vm->aotBypass)
+		ScrInternal_CallAOT(vm, func);
+	else
+		Scr_Execute(vm->progsType, func, vm->callFromFuncName);
+}
+
+/*
+============
+ScrAOT_Error
+============
+*/
+static void ScrAOT_Error(const char* fmt, ...)
+{
+	va_list		argptr;
+	char		string[1024];
+
+	va_start(argptr, fmt);
+	vsnprintf(string, sizeof(string), fmt, argptr);
+	va_end(argptr);
+
+	Scr_RunError("%s", string);
+}
+
+static int ScrAOT_StringsEqual(int a, int b)
+{
+	return ScrInternal_StringsEqual(active_qcvm, a, b);
+}
+
+static int ScrAOT_StringEmpty(int s)
+{
+	return !s || !*ScrInternal_VMString(active_qcvm, s);
+}
+
+/*
+============
+ScrAOT_State
+
+Module import for OP_STATE
+============
+*/
+static void ScrAOT_State(scr_aotword_t* frame, scr_aotword_t* think)
+{
+	extern void Scr_SV_OP(eval_t * a, eval_t * b, eval_t * c);
+
+	if (active_qcvm->progsType != VM_SVGAME)
+		Scr_RunError("OP_STATE not implemented for %s", vmDefs[active_qcvm->progsType].name);
+
+	Scr_SV_OP((eval_t*)frame, (eval_t*)think, NULL);
+}
+
+/*
+============
+ScrAOT_ReportMismatch
+
+Names the first word the two runs disagree on
+============
+*/
+static void ScrAOT_ReportMismatch(qcvm_t* vm, int fnum, int* native, int* interp, size_t words, size_t globalWords)
+{
+	ddef_t* def;
+	size_t	i, ofs;
+	int		ent;
+
+	for (i = 0; i < words; i++)
+	{
+		if (native[i] != interp[i])
+			break;
+	}
+
+	Com_Printf("WARNING: %s qcvm: %s differs between native and interpreted code, ", vmDefs[vm->progsType].name, ScrInternal_String(vm->functions[fnum].s_name));
+	if (i < globalWords)
+	{
+		def = ScrInternal_GlobalAtOfs(i);
+		Com_Printf("global %i (%s)", (int)i, def ? ScrInternal_String(def->s_name) : "?");
+	}
+	else
+	{
+		ofs = (i - globalWords) * 4;
+		ent = (int)(ofs / vm->entity_size);
+		ofs %= vm->entity_size;
+		def = ofs >= vm->offsetToEntVars ? ScrInternal_FieldAtOfs((int)(ofs - vm->offsetToEntVars) / 4) : NULL;
+		Com_Printf("entity %i field %s", ent, def ? ScrInternal_String(def->s_name) : "?");
+	}
+	Com_Printf(": 0x%08x native, 0x%08x interpreted\n", native[i], interp[i]);
+}
+
+/*
+============
+ScrAOT_Verify
+
+Runs a leaf function natively and in the interpreter from the same state and compares
+everything they could have written, the interpreted result is the one kept
+============
+*/
+static void ScrAOT_Verify(qcvm_t* vm, int fnum)
+{
+	size_t	globalSize, entitySize;
+	byte	*before, *native;
+
+	globalSize = vm->progs->numGlobals * sizeof(int);
+	entitySize = vm->num_entities * vm->entity_size;
+
+	before = Z_Malloc(2 * (globalSize + entitySize));
+	native = before + globalSize + entitySize;
+
+	memcpy(before, vm->globals, globalSize);
+	memcpy(before + globalSize, vm->entities, entitySize);
+
+	vm->aot->functions[fnum]();
+
+	memcpy(native, vm->globals, globalSize);
+	memcpy(native + globalSize, vm->entities, entitySize);
+	memcpy(vm->globals, before, globalSize);
+	memcpy(vm->entities, before + globalSize, entitySize);
+
+	vm->aotBypass = true;
+	Scr_Execute(vm->progsType, fnum, vm->callFromFuncName);
+	vm->aotBypass = false;
+
+	vm->aotVerified++;
+	if (memcmp(native, vm->globals, globalSize) || memcmp(native + globalSize, vm->entities, entitySize))
+	{
+		memcpy(before, vm->globals, globalSize);
+		memcpy(before + globalSize, vm->entities, entitySize);
+
+		vm->aotMismatches++;
+		ScrAOT_ReportMismatch(vm, fnum, (int*)native, (int*)before, (globalSize + entitySize) / 4, globalSize / 4);
+	}
+
+	Z_Free(before);
+}
+
+/*
+============
+ScrInternal_CallAOT
+
+Runs translated function, its parms are in OFS_PARM* and it returns in OFS_RETURN
+============
+*/
+void ScrInternal_CallAOT(qcvm_t* vm, int fnum)
+{
+	dfunction_t* oldf = vm->xfunction;
+
+	vm->xfunction = &vm->functions[fnum]; // for error messages
+
+	if (vm_aotverify->value && (vm->aot->flags[fnum] & SCR_AOT_LEAF))
+		ScrAOT_Verify(vm, fnum);
+	else
+		vm->aot->functions[fnum]();
+
+	vm->xfunction = oldf;
+}
+
+/*
+============
+Scr_LoadAOTModule
+
+Looks for a module generated from exactly these progs, must be called after the entities are allocated
+============
+*/
+void Scr_LoadAOTModule(qcvm_t* vm)
+{
+	char			base[MAX_QPATH], name[MAX_OSPATH];
+	void			*lib;
+	scr_aotentry_t	entry;
+	scr_aotmodule_t	*module;
+
+	if (!vm_aot->value)
+		return;
+
+	COM_StripExtension((char*)vmDefs[vm->progsType].filename, base);
+	Com_sprintf(name, sizeof(name), "%s/%s_aot%s", Cvar_VariableString("basedir"), base, SCR_AOT_LIBEXT);
+
+	lib = Sys_LoadLibrary(name);
+	if (!lib)
+	{
+		Com_DPrintf(DP_SCRIPT, "%s qcvm: no native module %s\n", vmDefs[vm->progsType].name, name);
+		return;
+	}
+
+	entry = (scr_aotentry_t)Sys_GetProcAddress(lib, SCR_AOT_ENTRYPOINT);
+	module = entry ? entry() : NULL;
+
+	if (!module || module->apiVersion != SCR_AOT_API_VERSION)
+	{
+		Com_Printf("WARNING: %s is not a compatible progs module, ignored\n", name);
+		Sys_FreeLibrary(lib);
+		return;
+	}
+
+	if (module->crc != vm->crc || module->numFunctions != vm->progs->numFunctions)
+	{
+		Com_Printf("WARNING: %s was generated from different progs (crc %i, progs are %i), run qc2c again\n", name, module->crc, vm->crc);
+		Sys_FreeLibrary(lib);
+		return;
+	}
+
+	memset(&vm->aotvm, 0, sizeof(vm->aotvm));
+	vm->aotvm.globals = (scr_aotword_t*)vm->globals;
+	vm->aotvm.entities = vm->entities;
+	vm->aotvm.offsetToEntVars = (int)vm->offsetToEntVars;
+	vm->aotvm.maxDepth = SCR_MAX_STACK_DEPTH;
+	vm->aotvm.runaway = (int)vm_runaway->value;
+
+	vm->aotvm.call = ScrAOT_Call;
+	vm->aotvm.error = ScrAOT_Error;
+	vm->aotvm.stringsEqual = ScrAOT_StringsEqual;
+	vm->aotvm.stringEmpty = ScrAOT_StringEmpty;
+	vm->aotvm.state = ScrAOT_State;
+
+	module->init(&vm->aotvm);
+
+	vm->aotLibrary = lib;
+	vm->aot = module;
+}
+
+/*
+============
+Scr_FreeAOTModule
+============
+*/
+void Scr_FreeAOTModule(qcvm_t* vm)
+{
+	if (vm->aotLibrary)
+		Sys_FreeLibrary(vm->aotLibrary);
+
+	vm->aotLibrary = NULL;
+	vm->aot = NULL;
+}
@@ -0,0 +1,71 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// scr_aot.h -- interface between the engine and progs translated to C by qc2c
+// this header is also included by the generated code, so it must not depend on anything else
+
+#pragma once
+
+#define	SCR_AOT_API_VERSION		1
+#define	SCR_AOT_ENTRYPOINT		"Scr_GetAOTModule"
+
+// per function flags written by qc2c
+#define	SCR_AOT_LEAF			1	// calls nothing, so it can be run twice by vm_aotverify
+
+#ifdef _WIN32
+	#define	SCR_AOT_EXPORT		__declspec(dllexport)
+#else
+	#define	SCR_AOT_EXPORT		__attribute__((visibility("default")))
+#endif
+
+// one global or entity field word, same layout as eval_t
+typedef union
+{
+	int		i;
+	float	f;
+} scr_aotword_t;
+
+// filled by the engine before the module runs anything, pointers stay valid for the life of the qcvm
+typedef struct
+{
+	scr_aotword_t	*globals;
+	unsigned char	*entities;			// entity and pointer values in progs are byte offsets from here
+	int				offsetToEntVars;
+
+	int				maxDepth;			// same limit as the interpreter stack
+	int				depth;
+	int				runaway;			// backward jumps left before a runaway loop error
+	int				direct;				// translated functions may call each other without going through call()
+	int				protectWorld;		// taking the address of a world field is an error
+
+	// none of these return when they fail
+	void			(*call)(int func, int argc);
+	void			(*error)(const char *fmt, ...);
+
+	int				(*stringsEqual)(int a, int b);
+	int				(*stringEmpty)(int s);
+	void			(*state)(scr_aotword_t *frame, scr_aotword_t *think);
+} scr_aotvm_t;
+
+typedef void (*scr_aotfunc_t)(void);
+
+typedef struct
+{
+	int						apiVersion;		// SCR_AOT_API_VERSION
+	unsigned short			crc;			// CRC_Block of the whole .dat the module was generated from
+	int						numFunctions;
+	int						numTranslated;
+
+	void					(*init)(scr_aotvm_t *vm);
+	const scr_aotfunc_t		*functions;		// [numFunctions], NULL runs in the interpreter
+	const unsigned char		*flags;			// [numFunctions], SCR_AOT_ flags
+} scr_aotmodule_t;
+
+typedef scr_aotmodule_t *(*scr_aotentry_t)(void);
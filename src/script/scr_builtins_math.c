@@ -19,19 +19,9 @@ PF_fabs
 float fabs(float)
 ===============
 */
-void PF_fabs(void)
+float PF_fabs(float f)
 {
-	float	f;
-
-	if (Scr_NumArgs() != 1)
-	{
-		Scr_RunError("called with %i arguments\n", Scr_NumArgs());
-		return;
-	}
-
-	f = Scr_GetParmFloat(0);
-
-	Scr_ReturnFloat( fabs(f) );
+	return fabs(f);
 }
 
 /*
@@ -40,21 +30,11 @@ PF_rint
 float rint(float)
 ===============
 */
-void PF_rint(void)
+float PF_rint(float f)
 {
-	float	f;
-
-	if (Scr_NumArgs() != 1)
-	{
-		Scr_RunError("called with %i arguments\n", Scr_NumArgs());
-		return;
-	}
-
-	f = Scr_GetParmFloat(0);
 	if (f > 0)
-		Scr_ReturnFloat((int)(f + 0.5));
-	else
-		Scr_ReturnFloat((int)(f - 0.5));
+		return (int)(f + 0.5);
+	return (int)(f - 0.5);
 }
 
 /*
@@ -63,10 +43,9 @@ PF_floor
 float floor(float)
 ===============
 */
-void PF_floor(void)
+float PF_floor(float val)
 {
-	float val = floor( Scr_GetParmFloat(0) );
-	Scr_ReturnFloat(val);
+	return floor(val);
 }
 
 /*
@@ -75,10 +54,9 @@ PF_ceil
 float ceil(float)
 ===============
 */
-void PF_ceil(void)
+float PF_ceil(float val)
 {
-	float val = ceil(Scr_GetParmFloat(0));
-	Scr_ReturnFloat(val);
+	return ceil(val);
 }
 
 /*
@@ -87,10 +65,9 @@ PF_sin
 float sin(float)
 ===============
 */
-void PF_sin(void)
+float PF_sin(float val)
 {
-	float val = sin(Scr_GetParmFloat(0));
-	Scr_ReturnFloat(val);
+	return sin(val);
 }
 
 /*
@@ -99,10 +76,9 @@ PF_cos
 float cos(float)
 ===============
 */
-void PF_cos(void)
+float PF_cos(float val)
 {
-	float val = cos(Scr_GetParmFloat(0));
-	Scr_ReturnFloat(val);
+	return cos(val);
 }
 
 /*
@@ -111,10 +87,9 @@ PF_ceil
 float sqrt(float)
 ===============
 */
-void PF_sqrt(void)
+float PF_sqrt(float val)
 {
-	float val = sqrt(Scr_GetParmFloat(0));
-	Scr_ReturnFloat(val);
+	return sqrt(val);
 }
 
 
@@ -125,14 +100,10 @@ PF_normalize
 vector normalize(vector)
 =================
 */
-void PF_normalize(void)
+void PF_normalize(float *invec, float *newvalue)
 {
-	float	*invec;
-	vec3_t	newvalue;
 	float	newv;
 
-	invec = Scr_GetParmVector(0);
-
 	newv = invec[0] * invec[0] + invec[1] * invec[1] + invec[2] * invec[2];
 	newv = sqrt(newv);
 
@@ -145,8 +116,6 @@ void PF_normalize(void)
 		newvalue[1] = invec[1] * newv;
 		newvalue[2] = invec[2] * newv;
 	}
-
-	Scr_ReturnVector(newvalue);
 }
 
 /*
@@ -156,17 +125,12 @@ PF_vlen
 float vlen(vector)
 =================
 */
-void PF_vlen(void)
+float PF_vlen(float *invec)
 {
-	float	*invec;
 	float	retval;
 
-	invec = Scr_GetParmVector(0);
-
 	retval = invec[0] * invec[0] + invec[1] * invec[1] + invec[2] * invec[2];
-	retval = sqrt(retval);
-
-	Scr_ReturnFloat(retval);
+	return sqrt(retval);
 }
 
 /*
@@ -176,13 +140,10 @@ PF_vectoyaw
 float vectoyaw(vector)
 =================
 */
-void PF_vectoyaw(void)
+float PF_vectoyaw(float *invec)
 {
-	float	*invec;
 	float	yaw;
 
-	invec = Scr_GetParmVector(0);
-
 	if (invec[1] == 0 && invec[0] == 0)
 		yaw = 0;
 	else
@@ -192,7 +153,7 @@ void PF_vectoyaw(void)
 			yaw += 360;
 	}
 
-	Scr_ReturnFloat(yaw);
+	return yaw;
 }
 
 
@@ -203,13 +164,8 @@ PF_vectoangles
 vector vectoangles(vector)
 =================
 */
-void PF_vectoangles(void)
+void PF_vectoangles(float *invec, float *out)
 {
-	float	*invec;
-	vec3_t	out;
-
-	invec = Scr_GetParmVector(0);
-
 #ifdef FIX_SQB
 	VectorAngles_Fixed(invec, out);
 #else
@@ -241,7 +197,6 @@ void PF_vectoangles(void)
 	out[2] = 0;
 
 #endif
-	Scr_ReturnVector(out);
 }
 
 
@@ -255,12 +210,10 @@ Returns a number from 0 <= num < 1
 float random()
 =================
 */
-void PF_random(void)
+float PF_random(void)
 {
-	float		num;
 	//num = (rand() & 0x7fff) / ((float)0x7fff);
-	num = scr_random();
-	Scr_ReturnFloat(num);
+	return scr_random();
 }
 
 /*
@@ -270,12 +223,10 @@ Returns a number between -1.0..1.0
 float crandom()
 =================
 */
-void PF_crandom(void)
+float PF_crandom(void)
 {
-	float		num;
 	//num = (rand() & 0x7fff) / ((float)0x7fff);
-	num = scr_crandom();
-	Scr_ReturnFloat(num);
+	return scr_crandom();
 }
 
 
@@ -288,20 +239,18 @@ Returns a integer number between 0 and num
 float randomint(float num)
 =================
 */
-void PF_randomint(void)
+float PF_randomint(float num)
 {
-	float	out;
 	int		in;
 
-	in = (int)Scr_GetParmFloat(0);
+	in = (int)num;
 	if (in <= 0)
 	{
 		Scr_RunError("randomint(%i) must be called with number greater than 0\n", in);
-		return;
+		return 0;
 	}
 
-	out = (rand() % in);
-	Scr_ReturnFloat(out);
+	return (rand() % in);
 }
 
 /*
@@ -339,11 +288,9 @@ PF_crossproduct
 vector cross = crossproduct(vector v1, vector v2)
 ==============
 */
-void PF_crossproduct(void)
+void PF_crossproduct(float *v1, float *v2, float *cross)
 {
-	vec3_t cross;
-	CrossProduct(Scr_GetParmVector(0), Scr_GetParmVector(1), cross);
-	Scr_ReturnVector(cross);
+	CrossProduct(v1, v2, cross);
 }
 
 /*
@@ -352,10 +299,9 @@ PF_dotproduct
 float dot = dotproduct(vector v1, vector v2)
 ==============
 */
-void PF_dotproduct(void)
+float PF_dotproduct(float *v1, float *v2)
 {
-	float dot = _DotProduct(Scr_GetParmVector(0), Scr_GetParmVector(1));
-	Scr_ReturnFloat(dot);
+	return _DotProduct(v1, v2);
 }
 
 /*
@@ -365,11 +311,9 @@ returns angle in range 0-360
 float angle = anglemod(float a)
 ==============
 */
-void PF_anglemod(void)
+float PF_anglemod(float a)
 {
-	float out;
-	out = anglemod(Scr_GetParmFloat(0));
-	Scr_ReturnFloat(out);
+	return anglemod(a);
 }
 
 /*
@@ -379,11 +323,9 @@ PF_lerpangle
 float smoothed_angle = lerpangle(float a2, float a1, float frac)
 ==============
 */
-void PF_lerpangle(void)
+float PF_lerpangle(float a2, float a1, float frac)
 {
-	float out;
-	out = LerpAngle(Scr_GetParmFloat(0), Scr_GetParmFloat(1), Scr_GetParmFloat(2));
-	Scr_ReturnFloat(out);
+	return LerpAngle(a2, a1, frac);
 }
 
 
@@ -396,26 +338,26 @@ Register mathlib builtins which can be shared by all QCVMs
 */
 void Scr_InitMathBuiltins()
 {
-	Scr_DefineBuiltin(PF_fabs, PF_ALL, "fabs", "float(float val)");
-	Scr_DefineBuiltin(PF_rint, PF_ALL, "rint", "float(float val)");
-	Scr_DefineBuiltin(PF_floor, PF_ALL, "floor", "float(float val)");
-	Scr_DefineBuiltin(PF_ceil, PF_ALL, "ceil", "float(float val)");
-	Scr_DefineBuiltin(PF_sin, PF_ALL, "sin", "float(float val)");
-	Scr_DefineBuiltin(PF_cos, PF_ALL, "cos", "float(float val)");
-	Scr_DefineBuiltin(PF_sqrt, PF_ALL, "sqrt", "float(float val)");
-
-	Scr_DefineBuiltin(PF_normalize, PF_ALL, "normalize", "vector(vector in)");
-	Scr_DefineBuiltin(PF_vlen, PF_ALL, "vectorlength", "float(vector in)");
-	Scr_DefineBuiltin(PF_vectoyaw, PF_ALL, "vectoyaw", "float(vector in)");
-	Scr_DefineBuiltin(PF_vectoangles, PF_ALL, "vectoangles", "vector(vector in)");
-
-	Scr_DefineBuiltin(PF_random, PF_ALL, "random", "float()");
-//	Scr_DefineBuiltin(PF_crandom, PF_ALL, false, "float() crandom");
-	Scr_DefineBuiltin(PF_randomint, PF_ALL, "randomint", "float(float n)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_fabs, SCRSIG_F_F, PF_ALL, "fabs", "float(float val)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_rint, SCRSIG_F_F, PF_ALL, "rint", "float(float val)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_floor, SCRSIG_F_F, PF_ALL, "floor", "float(float val)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_ceil, SCRSIG_F_F, PF_ALL, "ceil", "float(float val)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_sin, SCRSIG_F_F, PF_ALL, "sin", "float(float val)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_cos, SCRSIG_F_F, PF_ALL, "cos", "float(float val)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_sqrt, SCRSIG_F_F, PF_ALL, "sqrt", "float(float val)");
+
+	Scr_DefineNativeBuiltin((scr_native_t)PF_normalize, SCRSIG_V_V, PF_ALL, "normalize", "vector(vector in)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_vlen, SCRSIG_F_V, PF_ALL, "vectorlength", "float(vector in)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_vectoyaw, SCRSIG_F_V, PF_ALL, "vectoyaw", "float(vector in)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_vectoangles, SCRSIG_V_V, PF_ALL, "vectoangles", "vector(vector in)");
+
+	Scr_DefineNativeBuiltin((scr_native_t)PF_random, SCRSIG_F, PF_ALL, "random", "float()");
+//	Scr_DefineNativeBuiltin((scr_native_t)PF_crandom, SCRSIG_F, PF_ALL, "crandom", "float()");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_randomint, SCRSIG_F_F, PF_ALL, "randomint", "float(float n)");
 
 	Scr_DefineBuiltin(PF_anglevectors, PF_ALL, "anglevectors", "void(vector v1)");
-	Scr_DefineBuiltin(PF_crossproduct, PF_ALL, "crossproduct", "vector(vector v1, vector v2)");
-	Scr_DefineBuiltin(PF_dotproduct, PF_ALL, "dotproduct", "float(vector v1, vector v2)");
-	Scr_DefineBuiltin(PF_anglemod, PF_ALL, "anglemod", "float(float a)");
-	Scr_DefineBuiltin(PF_lerpangle, PF_ALL, "lerpangle", "float(float a2, float a1, float frac)");
-}
\ No newline at end of file
+	Scr_DefineNativeBuiltin((scr_native_t)PF_crossproduct, SCRSIG_V_VV, PF_ALL, "crossproduct", "vector(vector v1, vector v2)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_dotproduct, SCRSIG_F_VV, PF_ALL, "dotproduct", "float(vector v1, vector v2)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_anglemod, SCRSIG_F_F, PF_ALL, "anglemod", "float(float a)");
+	Scr_DefineNativeBuiltin((scr_native_t)PF_lerpangle, SCRSIG_F_FFF, PF_ALL, "lerpangle", "float(float a2, float a1, float frac)");
+}
@@ -14,29 +14,6 @@ extern void Scr_InitMathBuiltins();
 
 static char* retstr_none = "none"; // the 'none' string
 
-static char pr_temp_string[MAX_PARMS][128];
-static int pr_temp_string_num = -1;
-
-/*
-=================
-progstring()
-
-utility functions can use this to print up to 8 arguments when no quakeworld strings enabled, dirty af.
-FIXME someday
-=================
-*/
-static char* progstring()
-{
-	if (pr_temp_string_num == -1)
-		memset(&pr_temp_string, sizeof(pr_temp_string), 0);
-
-	pr_temp_string_num++;
-	if (pr_temp_string_num >= MAX_PARMS)
-		pr_temp_string_num = 0;
-
-	return pr_temp_string[pr_temp_string_num];
-}
-
 /*
 =================
 PF_none
@@ -364,12 +341,12 @@ string ftos(float)
 void PF_ftos(void)
 {
 	float	v;
-	char* string_temp = progstring();
+	char	string_temp[64];
 	v = Scr_GetParmFloat(0);
 	if (v == (int)v)
-		sprintf(string_temp, "%d", (int)v);
+		Com_sprintf(string_temp, sizeof(string_temp), "%d", (int)v);
 	else
-		sprintf(string_temp, "%f", v);
+		Com_sprintf(string_temp, sizeof(string_temp), "%f", v);
 //		sprintf(string_temp, "%5.1f", v);
 
 	Scr_ReturnString(string_temp);
@@ -426,7 +403,7 @@ void PF_strat(void)
 	size_t len;
 	int at;
 
-	static char tempchar[2];
+	char tempchar[2];
 
 	str = Scr_GetParmString(0);
 	at = (int)Scr_GetParmFloat(1);
@@ -474,8 +451,8 @@ string vtos(vector)
 void PF_vtos(void)
 {
 	float* vec = Scr_GetParmVector(0);
-	char* string_temp = progstring();
-	sprintf(string_temp, "%.3f %.3f %.3f", vec[0], vec[1], vec[2]);
+	char	string_temp[128];
+	Com_sprintf(string_temp, sizeof(string_temp), "%.3f %.3f %.3f", vec[0], vec[1], vec[2]);
 	Scr_ReturnString(string_temp);
 }
 
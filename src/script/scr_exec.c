@@ -29,35 +29,85 @@ Scr_GetEntityFieldValue
 */
 eval_t* Scr_GetEntityFieldValue(vm_entity_t *ent, char* field)
 {
-	ddef_t* def = NULL;
-	int				i;
-	static int		rep = 0;
+	ddef_t* def;
 
 	CheckScriptVM(__FUNCTION__);
-	for (i = 0; i < SCR_GEFV_CACHESIZE; i++)
-	{
-		if (!strcmp(field, active_qcvm->gefvCache[i].field))
-		{
-			def = active_qcvm->gefvCache[i].pcache;
-			goto Done;
-		}
-	}
 
 	def = Scr_FindEntityField(field);
-	if (strlen(field) < SCR_MAX_FIELD_LEN)
-	{
-		active_qcvm->gefvCache[rep].pcache = def;
-		strcpy(active_qcvm->gefvCache[rep].field, field);
-		rep ^= 1;
-	}
-
-Done:
 	if (!def)
 		return NULL;
 
 	return (eval_t*)((char*)ENTVARSOFFSET(ent) + def->ofs * 4);
 }
 
+/*
+============
+ScrInternal_CallNative
+
+Calls typed builtin with parms unpacked straight from globals
+============
+*/
+const int scr_sigNumParms[NUM_SCRSIGS] = { 0, 0, 1, 3, 1, 2, 1, 2 };
+
+void ScrInternal_CallNative(qcvm_t* vm, builtin_t* bi)
+{
+	float* g = vm->globals;
+
+	if (vm->argc != scr_sigNumParms[bi->sig])
+		Scr_RunError("%s: '%s' takes %i parms, called with %i\n", __FUNCTION__, bi->name, scr_sigNumParms[bi->sig], vm->argc);
+
+	switch (bi->sig)
+	{
+	case SCRSIG_F:
+		g[OFS_RETURN] = ((float (*)(void))bi->func)();
+		break;
+	case SCRSIG_F_F:
+		g[OFS_RETURN] = ((float (*)(float))bi->func)(g[OFS_PARM0]);
+		break;
+	case SCRSIG_F_FFF:
+		g[OFS_RETURN] = ((float (*)(float, float, float))bi->func)(g[OFS_PARM0], g[OFS_PARM1], g[OFS_PARM2]);
+		break;
+	case SCRSIG_F_V:
+		g[OFS_RETURN] = ((float (*)(float*))bi->func)(&g[OFS_PARM0]);
+		break;
+	case SCRSIG_F_VV:
+		g[OFS_RETURN] = ((float (*)(float*, float*))bi->func)(&g[OFS_PARM0], &g[OFS_PARM1]);
+		break;
+	case SCRSIG_V_V:
+		((void (*)(float*, float*))bi->func)(&g[OFS_PARM0], &g[OFS_RETURN]);
+		break;
+	case SCRSIG_V_VV:
+		((void (*)(float*, float*, float*))bi->func)(&g[OFS_PARM0], &g[OFS_PARM1], &g[OFS_RETURN]);
+		break;
+	default:
+		bi->func();
+		break;
+	}
+}
+
+/*
+============
+ScrInternal_CallBuiltin
+
+Calls the builtin behind a negative first_statement, argc must already be set
+============
+*/
+void ScrInternal_CallBuiltin(qcvm_t* vm, dfunction_t* f)
+{
+	int i = -f->first_statement;
+
+	if (i >= scr_numBuiltins)
+		Scr_RunError("%s: unknown builtin function (funcnum = %i) in %s\n", __FUNCTION__, i, vmDefs[vm->progsType].filename);
+
+	if (scr_builtins[i].execon != PF_ALL && vm->progsType != scr_builtins[i].execon)
+		Scr_RunError("%s: call to '%s' builtin in %s VM not allowed\n", __FUNCTION__, scr_builtins[i].name, vmDefs[vm->progsType].name);
+
+	if (scr_builtins[i].sig != SCRSIG_NONE)
+		ScrInternal_CallNative(vm, &scr_builtins[i]);
+	else
+		scr_builtins[i].func();
+}
+
 /*
 ============
 Scr_RunError
@@ -90,6 +140,8 @@ void Scr_RunError(char* error, ...)
 
 	Com_Printf("\n**************************************\n" );
 	active_qcvm->stackDepth = 0;
+	active_qcvm->aotvm.depth = 0;
+	active_qcvm->aotBypass = false;
 
 #ifdef _DEBUG
 	printf("%s\n", string);
@@ -208,6 +260,7 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 {
 	eval_t			*a, *b, *c, *ptr;
 	int				s, i, exitdepth;
+	float			tempf;
 	dstatement_t	*st;
 	dfunction_t		*f, *newf;
 	qcvm_t			*vm;
@@ -234,10 +287,26 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 	}
 
 	f = &vm->functions[fnum];
+	PROF_BEGIN_COPY(ScrInternal_String(f->s_name));
 
 	vm->runawayCounter = (int)vm_runaway->value;
 	vm->traceEnabled = false;
 
+	if (vm->aot)
+	{
+		// native loops keep their budget across the interpreted functions they call
+		if (!vm->aotvm.depth && !vm->stackDepth)
+			vm->aotvm.runaway = vm->runawayCounter;
+		vm->aotvm.protectWorld = (vm->progsType == VM_SVGAME && Com_IsServerActive());
+		vm->aotvm.direct = !vm_aotverify->value;	// so every leaf call goes through ScrInternal_CallAOT
+		if (vm->aot->functions[fnum] && !vm->aotBypass)
+		{
+			ScrInternal_CallAOT(vm, fnum);
+			PROF_END();
+			return;
+		}
+	}
+
 	// make a stack frame
 	exitdepth = vm->stackDepth;
 
@@ -256,6 +325,7 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 			Scr_RunError("runaway loop error in function %s (%s)", ScrInternal_String(f->s_name), vmDefs[vm->progsType].filename);
 
 		vm->xfunction->profile++;
+		vm->numStatements++;
 		vm->xstatement = s;
 
 		if (vm->traceEnabled)
@@ -575,7 +645,7 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 			c->_float = !a->vector[0] && !a->vector[1] && !a->vector[2];
 			break;
 		case OP_NOT_S: // not string
-			c->_float = !a->string || !vm->strings[a->string];
+			c->_float = !a->string || !*ScrInternal_VMString(vm, a->string);
 			break;
 		case OP_NOT_FNC: // not function
 			c->_float = !a->function;
@@ -595,7 +665,7 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 			break;
 
 		case OP_EQ_S: // == string
-			c->_float = !strcmp(ScrInternal_String(a->string), ScrInternal_String(b->string));
+			c->_float = ScrInternal_StringsEqual(vm, a->string, b->string);
 			break;
 
 		case OP_EQ_E: // equal int
@@ -617,7 +687,7 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 			break;
 
 		case OP_NE_S: // not equal string
-			c->_float = strcmp(ScrInternal_String(a->string), ScrInternal_String(b->string));
+			c->_float = !ScrInternal_StringsEqual(vm, a->string, b->string);
 			break;
 
 		case OP_NE_E: // not equal int
@@ -736,6 +806,7 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 		case OP_CALL7:
 		case OP_CALL8:
 			vm->argc = st->op - OP_CALL0; //sets the number of arguments a function takes
+		call:
 			if (!a->function)
 				Scr_RunError("%s: NULL function in %s\n", __FUNCTION__, vmDefs[vm->progsType].filename);
 
@@ -743,20 +814,72 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 
 			if (newf->first_statement < 0)
 			{	// negative statements are built in functions
-				i = -newf->first_statement;
-				if (i >= scr_numBuiltins)
-					Scr_RunError("%s: unknown builtin function (funcnum = %i) in %s\n", __FUNCTION__, i, vmDefs[vm->progsType].filename);
-
-				if(scr_builtins[i].execon != PF_ALL && vm->progsType != scr_builtins[i].execon)
-					Scr_RunError("%s: call to '%s' builtin in %s VM not allowed\n", __FUNCTION__, scr_builtins[i].name, vmDefs[vm->progsType].name);
+				ScrInternal_CallBuiltin(vm, newf);
+				break;
+			}
 
-				scr_builtins[i].func();
+			if (vm->aot && vm->aot->functions[a->function] && !vm->aotBypass)
+			{	// translated functions take their parms from globals and leave the result in OFS_RETURN just like we do
+				ScrInternal_CallAOT(vm, a->function);
 				break;
 			}
 
 			s = ScrInternal_EnterFunction(newf);
 			break;
 
+		// the function variable could have been reassigned since load, so check it's still the builtin
+#define INTRINSIC_CHECK(numparms) \
+			if (a->function != vm->intrinsicFunc[st->op - OP_INTRINSIC_VLEN]) \
+			{ \
+				vm->argc = numparms; \
+				goto call; \
+			}
+
+		case OP_INTRINSIC_VLEN: // float vectorlength(vector)
+			INTRINSIC_CHECK(1);
+			b = (eval_t*)&vm->globals[OFS_PARM0];
+			vm->globals[OFS_RETURN] = sqrt(b->vector[0] * b->vector[0] + b->vector[1] * b->vector[1] + b->vector[2] * b->vector[2]);
+			break;
+
+		case OP_INTRINSIC_NORMALIZE: // vector normalize(vector)
+			INTRINSIC_CHECK(1);
+			b = (eval_t*)&vm->globals[OFS_PARM0];
+			c = (eval_t*)&vm->globals[OFS_RETURN];
+			tempf = sqrt(b->vector[0] * b->vector[0] + b->vector[1] * b->vector[1] + b->vector[2] * b->vector[2]);
+			if (tempf == 0)
+			{
+				c->vector[0] = c->vector[1] = c->vector[2] = 0;
+				break;
+			}
+			tempf = 1 / tempf;
+			c->vector[0] = b->vector[0] * tempf;
+			c->vector[1] = b->vector[1] * tempf;
+			c->vector[2] = b->vector[2] * tempf;
+			break;
+
+		case OP_INTRINSIC_DOTPRODUCT: // float dotproduct(vector, vector)
+			INTRINSIC_CHECK(2);
+			b = (eval_t*)&vm->globals[OFS_PARM0];
+			c = (eval_t*)&vm->globals[OFS_PARM1];
+			vm->globals[OFS_RETURN] = b->vector[0] * c->vector[0] + b->vector[1] * c->vector[1] + b->vector[2] * c->vector[2];
+			break;
+
+		case OP_INTRINSIC_FABS: // float fabs(float)
+			INTRINSIC_CHECK(1);
+			vm->globals[OFS_RETURN] = fabs(vm->globals[OFS_PARM0]);
+			break;
+
+		case OP_INTRINSIC_SQRT: // float sqrt(float)
+			INTRINSIC_CHECK(1);
+			vm->globals[OFS_RETURN] = sqrt(vm->globals[OFS_PARM0]);
+			break;
+
+		case OP_INTRINSIC_FLOOR: // float floor(float)
+			INTRINSIC_CHECK(1);
+			vm->globals[OFS_RETURN] = floor(vm->globals[OFS_PARM0]);
+			break;
+#undef INTRINSIC_CHECK
+
 		case OP_DONE:
 		case OP_RETURN:
 			vm->globals[OFS_RETURN] = vm->globals[st->a];
@@ -765,7 +888,10 @@ void Scr_Execute(vmType_t vmtype, scr_func_t fnum, char* callFromFuncName)
 
 			s = ScrInternal_LeaveFunction();
 			if (vm->stackDepth == exitdepth)
+			{
+				PROF_END();
 				return;		// all done
+			}
 			break;
 
 		case OP_STATE:
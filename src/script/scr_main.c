@@ -22,6 +22,9 @@ qcvm_t* active_qcvm; // qcvm currently in use
 builtin_t* scr_builtins;
 int scr_numBuiltins = 0;
 
+static scr_fieldbind_t scr_fieldBindings[SCR_MAX_FIELD_BINDINGS];
+static int scr_numFieldBindings = 0;
+
 const qcvmdef_t vmDefs[NUM_SCRIPT_VMS] =
 {
 	{VM_NONE, NULL, 0, "shared"},
@@ -103,7 +106,13 @@ ddef_t* Scr_FindEntityField(char* name)
 	int		i;
 
 	CheckScriptVM(__FUNCTION__);
-	for (i = 0; i < active_qcvm->progs->numFieldDefs; i++)
+
+	i = NameIndex_Find(active_qcvm->fieldIndex, name);
+	if (i != -1)
+		return &active_qcvm->fieldDefs[i];
+
+	// only the first NAMEINDEX_MAX defs are indexed
+	for (i = NAMEINDEX_MAX; i < active_qcvm->progs->numFieldDefs; i++)
 	{
 		def = &active_qcvm->fieldDefs[i];
 		if (!strcmp(ScrInternal_String(def->s_name), name))
@@ -114,6 +123,99 @@ ddef_t* Scr_FindEntityField(char* name)
 	return NULL;
 }
 
+/*
+============
+Scr_EntityFieldOffset
+
+Returns byte offset of a field from the start of an entity in active qcvm,
+-1 when there's no such field or it is of different type
+============
+*/
+scr_field_t Scr_EntityFieldOffset(char* name, scr_fieldtype_t type)
+{
+	ddef_t* def;
+
+	def = Scr_FindEntityField(name);
+	if (!def)
+		return -1;
+
+	if ((def->type & ~DEF_SAVEGLOBAL) != type)
+	{
+		Com_Printf("%s qcvm: field '%s' is of type %i, engine expects %i\n", vmDefs[active_qcvm->progsType].name, name, def->type & ~DEF_SAVEGLOBAL, type);
+		return -1;
+	}
+	return (scr_field_t)(active_qcvm->offsetToEntVars + def->ofs * 4);
+}
+
+/*
+============
+Scr_ResolveFieldBindings
+
+Updates all engine field bindings for a vm, call with NULL progs to unbind them
+============
+*/
+static void Scr_ResolveFieldBindings(qcvm_t* vm)
+{
+	qcvm_t	*oldvm = active_qcvm;
+	int		i;
+
+	active_qcvm = vm;
+	for (i = 0; i < scr_numFieldBindings; i++)
+	{
+		if (scr_fieldBindings[i].vmType != vm->progsType)
+			continue;
+
+		if (vm->progs)
+			*scr_fieldBindings[i].field = Scr_EntityFieldOffset(scr_fieldBindings[i].name, scr_fieldBindings[i].type);
+		else
+			*scr_fieldBindings[i].field = -1;
+	}
+	active_qcvm = oldvm;
+}
+
+/*
+============
+Scr_BindEntityField
+
+Registers an engine variable to hold the offset of a named entity field. It is
+resolved now if the vm is running and again every time its progs are loaded,
+so per frame code can read the field with SCR_FIELD_* and no lookups.
+============
+*/
+void Scr_BindEntityField(vmType_t vmType, scr_field_t* field, char* name, scr_fieldtype_t type)
+{
+	scr_fieldbind_t	*bind;
+	qcvm_t			*oldvm = active_qcvm;
+	int				i;
+
+	for (i = 0; i < scr_numFieldBindings; i++)
+	{
+		if (scr_fieldBindings[i].field == field)
+			break;
+	}
+
+	if (i == scr_numFieldBindings)
+	{
+		if (scr_numFieldBindings == SCR_MAX_FIELD_BINDINGS)
+			Com_Error(ERR_FATAL, "%s: increase SCR_MAX_FIELD_BINDINGS (%i)\n", __FUNCTION__, SCR_MAX_FIELD_BINDINGS);
+		scr_numFieldBindings++;
+	}
+
+	bind = &scr_fieldBindings[i];
+	bind->vmType = vmType;
+	bind->field = field;
+	bind->name = name;
+	bind->type = type;
+
+	*field = -1;
+	if (qcvm[vmType] && qcvm[vmType]->progs)
+	{
+		active_qcvm = qcvm[vmType];
+		*field = Scr_EntityFieldOffset(name, type);
+		active_qcvm = oldvm;
+	}
+}
+
 /*
 =============
 Scr_ParseEpair
@@ -135,7 +237,20 @@ qboolean Scr_ParseEpair(void* base, ddef_t* key, char* s, int memtag)
 	switch (key->type & ~DEF_SAVEGLOBAL)
 	{
 	case ev_string:
-		*(scr_string_t*)d = COM_NewString(s, memtag) - active_qcvm->strings;
+		// same \n escapes as COM_NewString, but the result is owned by the string heap
+		v = w = ScrInternal_TempBuffer(active_qcvm, strlen(s) + 1);
+		for (i = 0; s[i]; i++)
+		{
+			if (s[i] == '\\' && s[i + 1])
+			{
+				i++;
+				*w++ = (s[i] == 'n') ? '\n' : '\\';
+			}
+			else
+				*w++ = s[i];
+		}
+		*w = 0;
+		*(scr_string_t*)d = ScrInternal_InternString(active_qcvm, v);
 		break;
 
 	case ev_float:
@@ -385,6 +500,74 @@ void Scr_LoadProgs(qcvm_t *vm, char* filename)
 
 	for (i = 0; i < vm->progs->numGlobals; i++)
 		((int*)vm->globals)[i] = LittleLong(((int*)vm->globals)[i]);
+
+	// index field names, backwards so the first of duplicate defs wins like it did with a linear search
+	vm->fieldIndex = Z_TagMalloc(sizeof(nameindex_t), TAG_SCRIPT);
+	NameIndex_Clear(vm->fieldIndex);
+	for (i = vm->progs->numFieldDefs - 1; i >= 0; i--)
+		NameIndex_Add(vm->fieldIndex, vm->strings + vm->fieldDefs[i].s_name, i);
+}
+
+/*
+===============
+Scr_BindIntrinsics
+
+Rewrites direct calls to builtins which have intrinsic opcodes
+===============
+*/
+static const struct
+{
+	char	*builtin;
+	int		numparms;
+} scr_intrinsics[NUM_INTRINSICS] =
+{
+	{ "vectorlength", 1 },	// OP_INTRINSIC_VLEN
+	{ "normalize", 1 },		// OP_INTRINSIC_NORMALIZE
+	{ "dotproduct", 2 },	// OP_INTRINSIC_DOTPRODUCT
+	{ "fabs", 1 },			// OP_INTRINSIC_FABS
+	{ "sqrt", 1 },			// OP_INTRINSIC_SQRT
+	{ "floor", 1 }			// OP_INTRINSIC_FLOOR
+};
+
+static void Scr_BindIntrinsics(qcvm_t* vm)
+{
+	dstatement_t	*st;
+	int				i, j, func, builtin;
+
+	memset(vm->intrinsicFunc, 0, sizeof(vm->intrinsicFunc));
+	vm->numIntrinsicCalls = 0;
+
+	for (i = 1; i < vm->progs->numFunctions; i++)
+	{
+		builtin = -vm->functions[i].first_statement;
+		if (builtin <= 0 || builtin >= scr_numBuiltins)
+			continue;
+
+		for (j = 0; j < NUM_INTRINSICS; j++)
+		{
+			if (!vm->intrinsicFunc[j] && !strcmp(scr_builtins[builtin].name, scr_intrinsics[j].builtin))
+				vm->intrinsicFunc[j] = i;
+		}
+	}
+
+	for (i = 0; i < vm->progs->numStatements; i++)
+	{
+		st = &vm->statements[i];
+		if (st->op < OP_CALL0 || st->op > OP_CALL8)
+			continue;
+
+		// only calls through a function's own global, its value is checked again at runtime
+		func = ((int*)vm->globals)[st->a];
+		for (j = 0; j < NUM_INTRINSICS; j++)
+		{
+			if (vm->intrinsicFunc[j] && func == vm->intrinsicFunc[j] && st->op - OP_CALL0 == scr_intrinsics[j].numparms)
+			{
+				st->op = OP_INTRINSIC_VLEN + j;
+				vm->numIntrinsicCalls++;
+				break;
+			}
+		}
+	}
 }
 
 /*
@@ -437,7 +620,7 @@ void Scr_CreateScriptVM(vmType_t vmType, unsigned int numEntities, size_t entity
 //	if (qcvm[progsType] != NULL)
 //		Com_Error(ERR_FATAL, "Tried to create second instance of %s script VM\n", Scr_VMName(progsType));
 
-	qcvm[vmType] = Z_Malloc(sizeof(qcvm_t));
+	qcvm[vmType] = Z_TagMalloc(sizeof(qcvm_t), TAG_SCRIPT);
 	if (qcvm == NULL)
 		Com_Error(ERR_FATAL, "Couldn't allocate %s script VM\n", Scr_VMName(vmType));
 
@@ -451,12 +634,18 @@ void Scr_CreateScriptVM(vmType_t vmType, unsigned int numEntities, size_t entity
 
 	// load progs from file
 	Scr_LoadProgs(vm, vmDefs[vmType].filename);
+	Scr_InitStringHeap(vm);
+	Scr_ResolveFieldBindings(vm);
+	Scr_BindIntrinsics(vm);
 
 	// allocate entities
-	vm->entities = (vm_entity_t*)Z_Malloc(vm->num_entities * vm->entity_size);
+	vm->entities = (vm_entity_t*)Z_TagMalloc(vm->num_entities * vm->entity_size, TAG_SCRIPT);
 	if (vm->entities == NULL)
 		Com_Error(ERR_FATAL, "Couldn't allocate entities for %s script VM\n", Scr_VMName(vmType));
 
+	// prefer native code when there's a module built from these progs
+	Scr_LoadAOTModule(vm);
+
 	// add developer comands
 	Cmd_AddCommand("vm_printent", Cmd_PrintVMEntity_f);
 	Cmd_AddCommand("vm_printents", Cmd_PrintAllVMEntities_f);
@@ -473,6 +662,9 @@ void Scr_CreateScriptVM(vmType_t vmType, unsigned int numEntities, size_t entity
 	Com_Printf("         GlobalDefs: %i\n", progs->numGlobalDefs);
 	Com_Printf("            Globals: %i\n", progs->numGlobals);
 	Com_Printf("      Entity fields: %i\n", progs->numFieldDefs);
+	Com_Printf("    Intrinsic calls: %i\n", vm->numIntrinsicCalls);
+	if (vm->aot)
+		Com_Printf("   Native functions: %i\n", vm->aot->numTranslated);
 	Com_Printf(" Allocated entities: %i, %i bytes\n", vm->num_entities, vm->num_entities * Scr_GetEntitySize());
 	Com_Printf("        Entity size: %i bytes\n", Scr_GetEntitySize());
 	Com_Printf("\n");
@@ -498,8 +690,16 @@ void Scr_FreeScriptVM(vmType_t vmtype)
 	if (vm->entities)
 		Z_Free(vm->entities);
 
+	Scr_FreeStringHeap(vm);
+	Scr_FreeAOTModule(vm);
+
+	if (vm->fieldIndex)
+		Z_Free(vm->fieldIndex);
+
 	if (vm->progs)
 		Z_Free(vm->progs);
+	vm->progs = NULL;
+	Scr_ResolveFieldBindings(vm);
 
 	if (vm->logfile)
 	{
@@ -621,6 +821,66 @@ extern unsigned Scr_GetProgsCRC(vmType_t vmType)
 	return qcvm[vmType]->crc;
 }
 
+/*
+===============
+Scr_GetStatementCount
+
+Statements interpreted since the qcvm was created, translated code isn't counted
+===============
+*/
+long long Scr_GetStatementCount(vmType_t vmType)
+{
+	if (qcvm[vmType] == NULL)
+		return 0;
+	return qcvm[vmType]->numStatements;
+}
+
+/*
+===============
+Scr_WriteState
+
+Globals and string heap of a qcvm, entities are up to whoever owns them.
+Returns the size and only that when out is NULL.
+===============
+*/
+int Scr_WriteState(vmType_t vmType, byte* out)
+{
+	qcvm_t	*vm = qcvm[vmType];
+	int		size;
+
+	if (vm == NULL || vm->progs == NULL)
+		return 0;
+
+	size = vm->progs->numGlobals * sizeof(int);
+	if (out)
+		memcpy(out, vm->globals, size);
+
+	return size + ScrInternal_WriteStringHeap(vm, out ? out + size : NULL);
+}
+
+/*
+===============
+Scr_ReadState
+
+Restores what Scr_WriteState wrote with the same progs loaded
+===============
+*/
+qboolean Scr_ReadState(vmType_t vmType, const byte* in, int size)
+{
+	qcvm_t	*vm = qcvm[vmType];
+	int		globalSize;
+
+	if (vm == NULL || vm->progs == NULL || vm->stackDepth > 0)
+		return false;
+
+	globalSize = vm->progs->numGlobals * sizeof(int);
+	if (size < globalSize)
+		return false;
+
+	memcpy(vm->globals, in, globalSize);
+	return ScrInternal_ReadStringHeap(vm, in + globalSize, size - globalSize);
+}
+
 /*
 ===============
 Scr_GetEntityFieldsSize
@@ -654,6 +914,166 @@ void Cmd_VM_GenerateDefs_f(void)
 	}
 }
 
+/*
+===============
+Cmd_VM_FieldBench_f
+
+vm_fieldbench [passes] [field ...]
+Times reading svgame entity fields through a linear def search (what lookups
+used to fall back to), the hashed name lookup and a bound offset
+===============
+*/
+void Cmd_VM_FieldBench_f(void)
+{
+	static char	*defaultFields[] = { "classname", "origin", "angles", "velocity", "health", "nextthink", "model", "targetname" };
+	char		*names[16];
+	scr_field_t	offsets[16];
+	ddef_t		*defs[16];
+	qcvm_t		*oldvm = active_qcvm, *vm = qcvm[VM_SVGAME];
+	vm_entity_t	*ent;
+	long long	start, linear, byname, bound;
+	float		sum = 0;
+	int			numfields, passes, pass, i, j, k;
+
+	if (!vm)
+	{
+		Com_Printf("svgame qcvm is not running\n");
+		return;
+	}
+
+	passes = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 10;
+	if (passes < 1)
+		passes = 1;
+
+	numfields = 0;
+	for (i = 2; i < Cmd_Argc() && numfields < 16; i++)
+		names[numfields++] = Cmd_Argv(i);
+	if (!numfields)
+	{
+		for (i = 0; i < sizeof(defaultFields) / sizeof(defaultFields[0]); i++)
+			names[numfields++] = defaultFields[i];
+	}
+
+	active_qcvm = vm;
+	for (i = 0, j = 0; i < numfields; i++)
+	{
+		defs[j] = Scr_FindEntityField(names[i]);
+		if (!defs[j])
+		{
+			Com_Printf("no field '%s'\n", names[i]);
+			continue;
+		}
+		offsets[j] = (scr_field_t)(vm->offsetToEntVars + defs[j]->ofs * 4);
+		names[j++] = names[i];
+	}
+	numfields = j;
+
+	linear = byname = bound = 0;
+	for (pass = 0; pass < passes && numfields; pass++)
+	{
+		start = Sys_Microseconds();
+		for (i = 0; i < vm->num_entities; i++)
+		{
+			ent = vm->entities + i * vm->entity_size;
+			for (j = 0; j < numfields; j++)
+			{
+				for (k = 0; k < vm->progs->numFieldDefs; k++)
+				{
+					if (!strcmp(vm->strings + vm->fieldDefs[k].s_name, names[j]))
+						break;
+				}
+				sum += ((float*)(ent + vm->offsetToEntVars))[vm->fieldDefs[k].ofs];
+			}
+		}
+		linear += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for (i = 0; i < vm->num_entities; i++)
+		{
+			ent = vm->entities + i * vm->entity_size;
+			for (j = 0; j < numfields; j++)
+				sum += Scr_GetEntityFieldValue(ent, names[j])->_float;
+		}
+		byname += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for (i = 0; i < vm->num_entities; i++)
+		{
+			ent = vm->entities + i * vm->entity_size;
+			for (j = 0; j < numfields; j++)
+				sum += SCR_FIELD_FLOAT(ent, offsets[j]);
+		}
+		bound += Sys_Microseconds() - start;
+	}
+	active_qcvm = oldvm;
+
+	if (!numfields)
+		return;
+
+	k = vm->num_entities * numfields * passes;
+	Com_Printf("%i entities, %i fields, %i passes (%i reads, checksum %g)\n", vm->num_entities, numfields, passes, k, sum);
+	Com_Printf("linear: %.3f ms (%.1f ns per read)\n", linear / 1000.0, linear * 1000.0 / k);
+	Com_Printf("hashed: %.3f ms (%.1f ns per read)\n", byname / 1000.0, byname * 1000.0 / k);
+	Com_Printf(" bound: %.3f ms (%.1f ns per read)\n", bound / 1000.0, bound * 1000.0 / k);
+}
+
+/*
+===============
+Cmd_VM_BuiltinBench_f
+
+vm_builtinbench [calls]
+Times every typed builtin called through the same dispatch OP_CALL uses
+===============
+*/
+void Cmd_VM_BuiltinBench_f(void)
+{
+	float		saved[RESERVED_OFS];
+	qcvm_t		*oldvm = active_qcvm, *vm = NULL;
+	builtin_t	*bi;
+	long long	start, time;
+	int			calls, i, j;
+
+	for (i = 1; i < NUM_SCRIPT_VMS && !vm; i++)
+		vm = qcvm[i];
+	if (!vm)
+	{
+		Com_Printf("no qcvm is running\n");
+		return;
+	}
+
+	calls = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 1000000;
+	if (calls < 1)
+		calls = 1;
+
+	active_qcvm = vm;
+	memcpy(saved, vm->globals, sizeof(saved));
+
+	Com_Printf("%s qcvm, %i calls each:\n", vmDefs[vm->progsType].name, calls);
+	for (i = 1; i < scr_numBuiltins; i++)
+	{
+		bi = &scr_builtins[i];
+		if (bi->sig == SCRSIG_NONE)
+			continue;
+
+		vm->argc = scr_sigNumParms[bi->sig];
+		start = Sys_Microseconds();
+		for (j = 0; j < calls; j++)
+		{
+			// refresh parms as a caller would, normalize & co. must not see their own output
+			vm->globals[OFS_PARM0] = vm->globals[OFS_PARM1] = 3.0f;
+			vm->globals[OFS_PARM0 + 1] = vm->globals[OFS_PARM1 + 1] = 4.0f;
+			vm->globals[OFS_PARM0 + 2] = vm->globals[OFS_PARM1 + 2] = vm->globals[OFS_PARM2] = 5.0f;
+			ScrInternal_CallNative(vm, bi);
+		}
+		time = Sys_Microseconds() - start;
+
+		Com_Printf("%16s: %.1f ns per call\n", bi->name, time * 1000.0 / calls);
+	}
+
+	memcpy(vm->globals, saved, sizeof(saved));
+	active_qcvm = oldvm;
+}
+
 /*
 ===============
 Scr_PreInitVMs
@@ -670,15 +1090,21 @@ void Scr_PreInitVMs()
 		qcvm[type] = NULL;
 
 	scr_numBuiltins = 0;
+	scr_numFieldBindings = 0;
 	Scr_InitSharedBuiltins();
 	CG_InitScriptBuiltins();
 	UI_InitScriptBuiltins();
 	SV_InitScriptBuiltins();
 
 	vm_runaway = Cvar_Get("vm_runaway", va("%i", VM_DEFAULT_RUNAWAY), 0, "Count of executed QC instructions to trigger runaway error.");
+	vm_aot = Cvar_Get("vm_aot", "1", 0, "Run progs translated to native code by qc2c when a module matching the progs CRC is found, takes effect when progs are loaded.");
+	vm_aotverify = Cvar_Get("vm_aotverify", "0", 0, "Run every native leaf function in the interpreter too and report differences.");
 
 //	Cmd_AddCommand("vm_reload", cmd_vm_reload_f);
 	Cmd_AddCommand("vm_generatedefs", Cmd_VM_GenerateDefs_f);
+	Cmd_AddCommand("vm_strings", Cmd_VM_Strings_f);
+	Cmd_AddCommand("vm_fieldbench", Cmd_VM_FieldBench_f);
+	Cmd_AddCommand("vm_builtinbench", Cmd_VM_BuiltinBench_f);
 }
 
 /*
@@ -0,0 +1,703 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// scr_strings.c -- managed, interned string heap for qcvms
+
+/*
+Every string a qcvm can see is owned by its string heap, and every distinct
+content has exactly one canonical handle:
+
+	handle >= 0		offset into the progs string table (immutable)
+	handle < 0		-(1 + (slot | serial << SCRSTR_SLOT_BITS)), a heap copy
+
+Progs strings are hashed in at load time, so interning something that already
+exists in progs returns its offset and the heap only ever holds new content.
+Compiler tail-merged offsets (pointing into the middle of another string) are
+valid handles but not canonical ones, string compares fall back to strcmp
+for those.
+
+Strings made by builtins and the engine are born young. At the end of each
+frame the young generation is swept: anything still referenced from globals
+or entity string fields is promoted, the rest is freed. Old strings are only
+swept by a full collection once the old generation has doubled in size.
+Freed slots bump their serial so stale handles resolve to "" instead of
+whatever reused the slot.
+*/
+
+#include "../qcommon/qcommon.h"
+#include "script_internals.h"
+
+#define	SCRSTR_MIN_MAJOR	1024	// don't bother with full collections below this many old strings
+
+/*
+============
+ScrStr_Hash
+============
+*/
+static unsigned ScrStr_Hash(const char* str, int *length)
+{
+	unsigned	hash = 2166136261u;
+	const char	*s;
+
+	for (s = str; *s; s++)
+		hash = (hash ^ (byte)*s) * 16777619u;
+
+	*length = (int)(s - str);
+	return hash;
+}
+
+/*
+============
+ScrStr_Handle
+============
+*/
+static int ScrStr_Handle(qcvm_t* vm, int slot)
+{
+	scrstr_t* s = &vm->strheap.slots[slot];
+
+	if (s->gen == SCRSTR_STATIC)
+		return (int)(s->str - vm->strings);
+	return -(1 + (slot | (s->serial << SCRSTR_SLOT_BITS)));
+}
+
+/*
+============
+ScrStr_SlotForHandle
+
+Returns heap slot for a negative handle or -1 when the handle is stale or invalid
+============
+*/
+static int ScrStr_SlotForHandle(qcvm_t* vm, int handle)
+{
+	unsigned	h;
+	int			slot;
+	scrstr_t	*s;
+
+	if (handle >= 0)
+		return -1;
+
+	h = (unsigned)(-(handle + 1));
+	slot = h & (SCRSTR_MAX_SLOTS - 1);
+	if (slot >= vm->strheap.numslots)
+		return -1;
+
+	s = &vm->strheap.slots[slot];
+	if (s->gen == SCRSTR_FREE || s->gen == SCRSTR_STATIC || (h >> SCRSTR_SLOT_BITS) != s->serial)
+		return -1;
+	return slot;
+}
+
+/*
+============
+ScrStr_AllocSlot
+============
+*/
+static int ScrStr_AllocSlot(qcvm_t* vm)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	scrstr_t		*newslots;
+	int				slot;
+
+	if (heap->freeslot != -1)
+	{
+		slot = heap->freeslot;
+		heap->freeslot = heap->slots[slot].next;
+		return slot;
+	}
+
+	if (heap->numslots == heap->maxslots)
+	{
+		if (heap->maxslots == SCRSTR_MAX_SLOTS)
+			Com_Error(ERR_DROP, "%s qcvm: string heap is full (%i strings)\n", vmDefs[vm->progsType].name, SCRSTR_MAX_SLOTS);
+
+		heap->maxslots = heap->maxslots ? heap->maxslots * 2 : 1024;
+		if (heap->maxslots > SCRSTR_MAX_SLOTS)
+			heap->maxslots = SCRSTR_MAX_SLOTS;
+
+		newslots = Z_TagMalloc(heap->maxslots * sizeof(scrstr_t), TAG_SCRIPT);
+		if (heap->slots)
+		{
+			memcpy(newslots, heap->slots, heap->numslots * sizeof(scrstr_t));
+			Z_Free(heap->slots);
+		}
+		heap->slots = newslots;
+	}
+	return heap->numslots++;
+}
+
+/*
+============
+ScrStr_Link
+============
+*/
+static void ScrStr_Link(qcvm_t* vm, int slot, char *str, int length, unsigned hash, scrstrgen_t gen)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	scrstr_t		*s = &heap->slots[slot];
+
+	s->str = str;
+	s->length = length;
+	s->hash = hash;
+	s->gen = gen;
+	s->mark = heap->markSequence;
+	s->next = heap->hash[hash & (SCRSTR_HASH_SIZE - 1)];
+	heap->hash[hash & (SCRSTR_HASH_SIZE - 1)] = slot;
+}
+
+/*
+============
+ScrStr_FreeSlot
+
+Unlinks heap string from its hash chain and returns the slot to the free list
+============
+*/
+static void ScrStr_FreeSlot(qcvm_t* vm, int slot)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	scrstr_t		*s = &heap->slots[slot];
+	int				*link;
+
+	for (link = &heap->hash[s->hash & (SCRSTR_HASH_SIZE - 1)]; *link != -1; link = &heap->slots[*link].next)
+	{
+		if (*link == slot)
+		{
+			*link = s->next;
+			break;
+		}
+	}
+
+	heap->heapBytes -= s->length + 1;
+	Z_Free(s->str);
+
+	s->str = NULL;
+	s->gen = SCRSTR_FREE;
+	s->serial = (s->serial + 1) & SCRSTR_SERIAL_MASK;
+	s->next = heap->freeslot;
+	heap->freeslot = slot;
+}
+
+/*
+============
+ScrStr_AddYoung
+============
+*/
+static void ScrStr_AddYoung(qcvm_t* vm, int slot)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	int				*newyoung;
+
+	if (heap->numyoung == heap->maxyoung)
+	{
+		heap->maxyoung = heap->maxyoung ? heap->maxyoung * 2 : 256;
+		newyoung = Z_TagMalloc(heap->maxyoung * sizeof(int), TAG_SCRIPT);
+		if (heap->young)
+		{
+			memcpy(newyoung, heap->young, heap->numyoung * sizeof(int));
+			Z_Free(heap->young);
+		}
+		heap->young = newyoung;
+	}
+	heap->young[heap->numyoung++] = slot;
+}
+
+/*
+============
+ScrStr_Find
+============
+*/
+static int ScrStr_Find(qcvm_t* vm, const char* str, int length, unsigned hash)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	scrstr_t		*s;
+	int				slot;
+
+	for (slot = heap->hash[hash & (SCRSTR_HASH_SIZE - 1)]; slot != -1; slot = s->next)
+	{
+		s = &heap->slots[slot];
+		if (s->hash == hash && s->length == length && !memcmp(s->str, str, length))
+			return slot;
+	}
+	return -1;
+}
+
+/*
+============
+Scr_InitStringHeap
+
+Hashes progs string table so heap strings never duplicate progs content
+============
+*/
+void Scr_InitStringHeap(qcvm_t* vm)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	int				ofs, length, slot, i;
+	unsigned		hash;
+
+	memset(heap, 0, sizeof(*heap));
+	heap->freeslot = -1;
+	for (i = 0; i < SCRSTR_HASH_SIZE; i++)
+		heap->hash[i] = -1;
+
+	heap->canonical = Z_TagMalloc(vm->progs->numstrings + 1, TAG_SCRIPT);
+
+	for (ofs = 0; ofs < vm->progs->numstrings; ofs += length + 1)
+	{
+		if (!memchr(vm->strings + ofs, 0, vm->progs->numstrings - ofs))
+			Com_Error(ERR_FATAL, "%s: unterminated string at %i in %s\n", __FUNCTION__, ofs, vmDefs[vm->progsType].filename);
+
+		hash = ScrStr_Hash(vm->strings + ofs, &length);
+		if (ScrStr_Find(vm, vm->strings + ofs, length, hash) != -1)
+			continue;
+
+		slot = ScrStr_AllocSlot(vm);
+		ScrStr_Link(vm, slot, vm->strings + ofs, length, hash, SCRSTR_STATIC);
+		heap->canonical[ofs] = 1;
+		heap->numstatic++;
+	}
+
+	// precompute the roots: all string fields of an entity
+	heap->stringFields = Z_TagMalloc((vm->progs->numFieldDefs + 1) * sizeof(int), TAG_SCRIPT);
+	for (i = 0; i < vm->progs->numFieldDefs; i++)
+	{
+		if ((vm->fieldDefs[i].type & ~DEF_SAVEGLOBAL) == ev_string)
+			heap->stringFields[heap->numStringFields++] = vm->fieldDefs[i].ofs;
+	}
+}
+
+/*
+============
+Scr_FreeStringHeap
+============
+*/
+void Scr_FreeStringHeap(qcvm_t* vm)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	int				i;
+
+	for (i = 0; i < heap->numslots; i++)
+	{
+		if (heap->slots[i].gen == SCRSTR_YOUNG || heap->slots[i].gen == SCRSTR_OLD)
+			Z_Free(heap->slots[i].str);
+	}
+
+	if (heap->slots)
+		Z_Free(heap->slots);
+	if (heap->young)
+		Z_Free(heap->young);
+	if (heap->canonical)
+		Z_Free(heap->canonical);
+	if (heap->stringFields)
+		Z_Free(heap->stringFields);
+	if (heap->scratch)
+		Z_Free(heap->scratch);
+
+	memset(heap, 0, sizeof(*heap));
+}
+
+/*
+============
+ScrInternal_VMString
+
+Resolves a string handle, stale or invalid handles give an empty string
+============
+*/
+char* ScrInternal_VMString(qcvm_t* vm, int handle)
+{
+	int slot;
+
+	if (handle >= 0)
+	{
+		if (handle >= vm->progs->numstrings)
+			return "";
+		return vm->strings + handle;
+	}
+
+	slot = ScrStr_SlotForHandle(vm, handle);
+	if (slot == -1)
+		return "";
+	return vm->strheap.slots[slot].str;
+}
+
+/*
+============
+ScrInternal_InternString
+
+Returns canonical handle for string contents, copying it into the heap as a young string when it's new
+============
+*/
+int ScrInternal_InternString(qcvm_t* vm, const char* str)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	int				length, slot;
+	unsigned		hash;
+	char			*copy;
+
+	if (!str)
+		return 0;
+
+	// strings from the progs table are already immutable
+	if (str >= vm->strings && str < vm->strings + vm->progs->numstrings)
+		return (int)(str - vm->strings);
+
+	hash = ScrStr_Hash(str, &length);
+	slot = ScrStr_Find(vm, str, length, hash);
+	if (slot != -1)
+		return ScrStr_Handle(vm, slot);
+
+	copy = Z_TagMalloc(length + 1, TAG_SCRIPT);
+	memcpy(copy, str, length + 1);
+
+	slot = ScrStr_AllocSlot(vm);
+	ScrStr_Link(vm, slot, copy, length, hash, SCRSTR_YOUNG);
+	heap->heapBytes += length + 1;
+	heap->allocated++;
+
+	ScrStr_AddYoung(vm, slot);
+
+	return ScrStr_Handle(vm, slot);
+}
+
+/*
+============
+ScrInternal_StringsEqual
+
+Two canonical handles are equal only when they are the same handle
+============
+*/
+qboolean ScrInternal_StringsEqual(qcvm_t* vm, int a, int b)
+{
+	if (a == b)
+		return true;
+
+	if ((a < 0 ? ScrStr_SlotForHandle(vm, a) != -1 : (a < vm->progs->numstrings && vm->strheap.canonical[a])) &&
+		(b < 0 ? ScrStr_SlotForHandle(vm, b) != -1 : (b < vm->progs->numstrings && vm->strheap.canonical[b])))
+		return false;
+
+	return !strcmp(ScrInternal_VMString(vm, a), ScrInternal_VMString(vm, b));
+}
+
+/*
+============
+ScrInternal_TempBuffer
+
+Scratch memory for building strings before they are interned
+============
+*/
+char* ScrInternal_TempBuffer(qcvm_t* vm, int size)
+{
+	scrstrheap_t* heap = &vm->strheap;
+
+	if (size > heap->scratchSize)
+	{
+		if (heap->scratch)
+			Z_Free(heap->scratch);
+		heap->scratchSize = (size + 255) & ~255;
+		heap->scratch = Z_TagMalloc(heap->scratchSize, TAG_SCRIPT);
+	}
+	return heap->scratch;
+}
+
+/*
+============
+ScrInternal_WriteStringHeap
+
+Writes every heap slot, free ones included, so that handles stored in globals and
+entities stay valid when the heap is read back. Returns the size and only that
+when out is NULL.
+============
+*/
+int ScrInternal_WriteStringHeap(qcvm_t* vm, byte* out)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	scrstr_t		*s;
+	byte			*p = out;
+	int				slot, size;
+
+	size = 2 * sizeof(int);
+	if (out)
+	{
+		memcpy(p, &heap->numstatic, sizeof(int));
+		memcpy(p + sizeof(int), &heap->numslots, sizeof(int));
+		p += size;
+	}
+
+	for (slot = heap->numstatic; slot < heap->numslots; slot++)
+	{
+		s = &heap->slots[slot];
+		size += sizeof(s->serial) + 1;
+		if (s->gen != SCRSTR_FREE)
+			size += s->length + 1;
+
+		if (!out)
+			continue;
+
+		memcpy(p, &s->serial, sizeof(s->serial));
+		p += sizeof(s->serial);
+		*p++ = s->gen;
+		if (s->gen != SCRSTR_FREE)
+		{
+			memcpy(p, s->str, s->length + 1);
+			p += s->length + 1;
+		}
+	}
+	return size;
+}
+
+/*
+============
+ScrInternal_ReadStringHeap
+
+Replaces all heap strings with the ones from ScrInternal_WriteStringHeap, slot for slot.
+Must be the same progs, returns false and leaves the heap empty if the data is bad.
+============
+*/
+qboolean ScrInternal_ReadStringHeap(qcvm_t* vm, const byte* in, int size)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	scrstr_t		*s, *newslots;
+	const byte		*p = in, *end = in + size;
+	int				numstatic, numslots, slot, length, i;
+	unsigned		hash;
+	char			*copy;
+
+	if (size < 2 * (int)sizeof(int))
+		return false;
+	memcpy(&numstatic, p, sizeof(int));
+	memcpy(&numslots, p + sizeof(int), sizeof(int));
+	p += 2 * sizeof(int);
+
+	if (numstatic != heap->numstatic || numslots < numstatic || numslots > SCRSTR_MAX_SLOTS)
+		return false;
+
+	// drop every heap string, the static ones are relinked as they were after Scr_InitStringHeap
+	for (slot = heap->numstatic; slot < heap->numslots; slot++)
+	{
+		if (heap->slots[slot].gen == SCRSTR_YOUNG || heap->slots[slot].gen == SCRSTR_OLD)
+			Z_Free(heap->slots[slot].str);
+	}
+
+	if (numslots > heap->maxslots)
+	{
+		newslots = Z_TagMalloc(numslots * sizeof(scrstr_t), TAG_SCRIPT);
+		if (heap->slots)
+		{
+			memcpy(newslots, heap->slots, heap->numstatic * sizeof(scrstr_t));
+			Z_Free(heap->slots);
+		}
+		heap->slots = newslots;
+		heap->maxslots = numslots;
+	}
+
+	for (i = 0; i < SCRSTR_HASH_SIZE; i++)
+		heap->hash[i] = -1;
+	for (slot = 0; slot < heap->numstatic; slot++)
+	{
+		s = &heap->slots[slot];
+		ScrStr_Link(vm, slot, s->str, s->length, s->hash, SCRSTR_STATIC);
+	}
+
+	heap->numslots = heap->numstatic;
+	heap->freeslot = -1;
+	heap->numyoung = heap->numold = heap->oldAfterMajor = 0;
+	heap->heapBytes = 0;
+
+	for (slot = numstatic; slot < numslots; slot++)
+	{
+		s = &heap->slots[slot];
+		memset(s, 0, sizeof(*s));
+		heap->numslots++;
+
+		if (end - p < (int)sizeof(s->serial) + 1)
+			goto bad;
+		memcpy(&s->serial, p, sizeof(s->serial));
+		p += sizeof(s->serial);
+		s->gen = *p++;
+
+		if (s->gen == SCRSTR_FREE)
+		{
+			s->next = heap->freeslot;
+			heap->freeslot = slot;
+			continue;
+		}
+
+		if ((s->gen != SCRSTR_YOUNG && s->gen != SCRSTR_OLD) || !memchr(p, 0, end - p))
+		{
+			s->gen = SCRSTR_FREE;
+			goto bad;
+		}
+
+		hash = ScrStr_Hash((const char*)p, &length);
+		copy = Z_TagMalloc(length + 1, TAG_SCRIPT);
+		memcpy(copy, p, length + 1);
+		p += length + 1;
+
+		ScrStr_Link(vm, slot, copy, length, hash, s->gen);
+		heap->heapBytes += length + 1;
+
+		if (s->gen == SCRSTR_YOUNG)
+			ScrStr_AddYoung(vm, slot);
+		else
+			heap->numold++;
+	}
+	heap->oldAfterMajor = heap->numold;
+
+	if (p != end)
+		goto bad;
+	return true;
+
+bad:
+	for (slot = heap->numstatic; slot < heap->numslots; slot++)
+	{
+		if (heap->slots[slot].gen == SCRSTR_YOUNG || heap->slots[slot].gen == SCRSTR_OLD)
+			ScrStr_FreeSlot(vm, slot);
+	}
+	heap->numyoung = heap->numold = heap->oldAfterMajor = 0;
+	return false;
+}
+
+/*
+============
+ScrStr_MarkHandle
+============
+*/
+static void ScrStr_MarkHandle(qcvm_t* vm, int handle)
+{
+	int slot;
+
+	if (handle >= 0)
+		return;
+
+	slot = ScrStr_SlotForHandle(vm, handle);
+	if (slot != -1)
+		vm->strheap.slots[slot].mark = vm->strheap.markSequence;
+}
+
+/*
+============
+ScrStr_MarkRoots
+
+Globals are scanned conservatively (string arrays have no defs past their first element),
+entities only through their string fields. A float that happens to look like a live
+handle can only keep a string alive, never free one.
+============
+*/
+static void ScrStr_MarkRoots(qcvm_t* vm)
+{
+	scrstrheap_t	*heap = &vm->strheap;
+	int				*globals = (int*)vm->globals;
+	int				*entvars;
+	unsigned int	i;
+	int				j;
+
+	heap->markSequence++;
+
+	for (i = 0; i < (unsigned int)vm->progs->numGlobals; i++)
+	{
+		if (globals[i] < 0)
+			ScrStr_MarkHandle(vm, globals[i]);
+	}
+
+	for (i = 0; i < vm->num_entities; i++)
+	{
+		entvars = (int*)(vm->entities + i * vm->entity_size + vm->offsetToEntVars);
+		for (j = 0; j < heap->numStringFields; j++)
+		{
+			if (entvars[heap->stringFields[j]] < 0)
+				ScrStr_MarkHandle(vm, entvars[heap->stringFields[j]]);
+		}
+	}
+}
+
+/*
+============
+Scr_CollectStrings
+
+Frees unreferenced temporary strings, call once at the end of a frame with no qc running
+============
+*/
+void Scr_CollectStrings(vmType_t vmType)
+{
+	qcvm_t			*vm = qcvm[vmType];
+	scrstrheap_t	*heap;
+	scrstr_t		*s;
+	int				i, slot, freed = 0;
+	qboolean		major;
+
+	if (!vm || !vm->progs || vm->stackDepth > 0)
+		return;
+
+	heap = &vm->strheap;
+	major = heap->numold > SCRSTR_MIN_MAJOR && heap->numold > heap->oldAfterMajor * 2;
+
+	if (!heap->numyoung && !major)
+		return;
+
+	ScrStr_MarkRoots(vm);
+
+	// minor: promote referenced young strings, free the rest
+	for (i = 0; i < heap->numyoung; i++)
+	{
+		slot = heap->young[i];
+		s = &heap->slots[slot];
+		if (s->mark == heap->markSequence)
+		{
+			s->gen = SCRSTR_OLD;
+			heap->numold++;
+			continue;
+		}
+		ScrStr_FreeSlot(vm, slot);
+		freed++;
+	}
+	heap->numyoung = 0;
+	heap->minorCollections++;
+
+	if (major)
+	{
+		for (slot = 0; slot < heap->numslots; slot++)
+		{
+			s = &heap->slots[slot];
+			if (s->gen != SCRSTR_OLD || s->mark == heap->markSequence)
+				continue;
+
+			ScrStr_FreeSlot(vm, slot);
+			heap->numold--;
+			freed++;
+		}
+		heap->oldAfterMajor = heap->numold;
+		heap->majorCollections++;
+	}
+
+	heap->freed += freed;
+}
+
+/*
+============
+Cmd_VM_Strings_f
+
+vm_strings command, prints string heap statistics
+============
+*/
+void Cmd_VM_Strings_f(void)
+{
+	scrstrheap_t	*heap;
+	vmType_t		type;
+
+	for (type = 1; type < NUM_SCRIPT_VMS; type++)
+	{
+		if (!qcvm[type] || !qcvm[type]->progs)
+			continue;
+
+		heap = &qcvm[type]->strheap;
+		Com_Printf("%s qcvm strings:\n", vmDefs[type].name);
+		Com_Printf("  progs: %i unique in %i bytes\n", heap->numstatic, qcvm[type]->progs->numstrings);
+		Com_Printf("   heap: %i young, %i old, %i bytes, %i slots\n", heap->numyoung, heap->numold, heap->heapBytes, heap->numslots);
+		Com_Printf("  total: %i allocated, %i freed, %i minor / %i major collections\n", heap->allocated, heap->freed, heap->minorCollections, heap->majorCollections);
+	}
+}
@@ -15,7 +15,7 @@ See the attached GNU General Public License v2 for more details.
 #define	G_INT(o)			(*(int *)&active_qcvm->globals[o])
 #define	G_EDICT(o)			((gentity_t *)((byte *)active_qcvm->entities + *(int *)&active_qcvm->globals[o]))
 #define	G_FLOAT(o)			(active_qcvm->globals[o])
-#define	G_STRING(o)			(active_qcvm->strings + *(scr_string_t *)&active_qcvm->globals[o])
+#define	G_STRING(o)			(ScrInternal_VMString(active_qcvm, *(scr_string_t *)&active_qcvm->globals[o]))
 #define	G_VECTOR(o)			(&active_qcvm->globals[o])
 #define	RETURN_EDICT(e)		(((int *)active_qcvm->globals)[OFS_RETURN] = ENT_TO_VM(e))
 
@@ -33,7 +33,7 @@ void Scr_DefineBuiltin(void (*function)(void), pb_t type, char* fname, char* qcs
 
 	if (scr_numBuiltins == 0)
 	{
-		scr_builtins = Z_Malloc(sizeof(builtin_t) * SCRIPTVM_MAXBUILTINS);
+		scr_builtins = Z_TagMalloc(sizeof(builtin_t) * SCRIPTVM_MAXBUILTINS, TAG_SCRIPT);
 	}
 
 	if (scr_numBuiltins == (SCRIPTVM_MAXBUILTINS - 1))
@@ -42,11 +42,26 @@ void Scr_DefineBuiltin(void (*function)(void), pb_t type, char* fname, char* qcs
 	func = &scr_builtins[scr_numBuiltins];
 	func->execon = type;
 	func->func = function;
+	func->sig = SCRSIG_NONE;
 	func->name = fname;
 	func->qcstring = qcstring;
 	scr_numBuiltins++;
 }
 
+/*
+============
+Scr_DefineNativeBuiltin
+
+Adds new builtin with typed signature, the vm calls it directly with
+parms unpacked from globals so there is no Scr_GetParm/Scr_Return overhead
+============
+*/
+void Scr_DefineNativeBuiltin(scr_native_t function, scr_builtinsig_t sig, pb_t type, char* fname, char* qcstring)
+{
+	Scr_DefineBuiltin(function, type, fname, qcstring);
+	scr_builtins[scr_numBuiltins - 1].sig = sig;
+}
+
 dfunction_t* ScrInternal_FindFunction(char* name);
 
 /*
@@ -78,7 +93,7 @@ Returns string from script
 */
 char* ScrInternal_String(int str)
 {
-	return active_qcvm->strings + str;
+	return ScrInternal_VMString(active_qcvm, str);
 }
 
 /*
@@ -90,19 +105,20 @@ Returns string from script
 */
 char* Scr_GetString(int str)
 {
-	return active_qcvm->strings + str;
+	return ScrInternal_VMString(active_qcvm, str);
 }
 
 /*
 ============
 Scr_SetString
 
-Sets string in script
+Returns interned handle for a string, the contents are copied so str doesn't need to outlive the call
 ============
 */
 int Scr_SetString(char* str)
 {
-	return (int)(str - active_qcvm->strings);
+	CheckScriptVM(__FUNCTION__);
+	return ScrInternal_InternString(active_qcvm, str);
 }
 
 /*
@@ -123,29 +139,29 @@ static int ScrInternal_GetParmOffset(unsigned int parm)
 /*
 ============
 Scr_VarString
+
+Concatenates string args starting at first, the result stays valid until the end of frame
 ============
 */
-#define TEMP_VARSTRINGS 8
-static int vstr = 0;
 char* Scr_VarString(int first)
 {
-	static char out[TEMP_VARSTRINGS][256];
-	int		i, param;
-
-	vstr++;
-	if (vstr >= TEMP_VARSTRINGS)
-		vstr = 0;
-
-	out[vstr][0] = 0;
+	int		i, len, total;
+	char	*out, *parm;
 
+	total = 1;
 	for (i = first; i < Scr_NumArgs(); i++)
+		total += strlen(G_STRING(ScrInternal_GetParmOffset(i)));
+
+	out = ScrInternal_TempBuffer(active_qcvm, total);
+	for (i = first, len = 0; i < Scr_NumArgs(); i++)
 	{
-		param = ScrInternal_GetParmOffset(i);
-		strcat(out[vstr], G_STRING(param));
+		parm = G_STRING(ScrInternal_GetParmOffset(i));
+		strcpy(out + len, parm);
+		len += strlen(parm);
 	}
+	out[len] = 0;
 
-
-	return out[vstr];
+	return ScrInternal_VMString(active_qcvm, ScrInternal_InternString(active_qcvm, out));
 }
 
 /*
@@ -286,7 +302,7 @@ Returns string to script
 */
 void Scr_ReturnString(char* str)
 {
-	G_INT(OFS_RETURN) = (str - active_qcvm->strings);
+	G_INT(OFS_RETURN) = Scr_SetString(str);
 }
 
 /*
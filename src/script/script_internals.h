@@ -30,8 +30,7 @@ typedef enum
 } 
 etype_t;
 
-#define	SCR_MAX_FIELD_LEN		64
-#define SCR_GEFV_CACHESIZE		2
+#define	SCR_MAX_FIELD_BINDINGS	128
 #define	SCR_MAX_STACK_DEPTH		32
 #define	SCR_LOCALSTACK_SIZE		2048
 
@@ -57,6 +56,19 @@ enum
 #include "qc_opcodes.h"
 };
 
+// pragma only opcodes, Scr_LoadProgs rewrites direct calls to the hottest math builtins into these
+enum
+{
+	OP_INTRINSIC_VLEN = 0x1000,
+	OP_INTRINSIC_NORMALIZE,
+	OP_INTRINSIC_DOTPRODUCT,
+	OP_INTRINSIC_FABS,
+	OP_INTRINSIC_SQRT,
+	OP_INTRINSIC_FLOOR,
+	OP_INTRINSIC_END
+};
+#define	NUM_INTRINSICS		(OP_INTRINSIC_END - OP_INTRINSIC_VLEN)
+
 // =============================================================
 
 #define	MAX_PARMS		8
@@ -92,6 +104,7 @@ typedef struct
 typedef struct
 {
 	void		(*func)(void);
+	scr_builtinsig_t sig;		// SCRSIG_NONE calls func, anything else is a native with unpacked parms
 	qboolean	devmode;
 	pb_t		execon; // client, server or both
 	char*		qcstring;
@@ -128,9 +141,11 @@ typedef struct
 
 typedef struct
 {
-	ddef_t* pcache;
-	char	field[SCR_MAX_FIELD_LEN];
-} gefv_cache;
+	vmType_t		vmType;
+	scr_field_t		*field;		// engine variable updated whenever progs are loaded or freed
+	char			*name;
+	scr_fieldtype_t	type;
+} scr_fieldbind_t;
 
 typedef struct
 {
@@ -140,6 +155,56 @@ typedef struct
 
 
 
+#define	SCRSTR_HASH_SIZE	16384
+#define	SCRSTR_SLOT_BITS	20
+#define	SCRSTR_MAX_SLOTS	(1<<SCRSTR_SLOT_BITS)
+#define	SCRSTR_SERIAL_MASK	1023
+
+typedef enum
+{
+	SCRSTR_FREE,
+	SCRSTR_STATIC,	// lives in progs string table
+	SCRSTR_YOUNG,	// created since the last collection
+	SCRSTR_OLD		// survived a collection
+} scrstrgen_t;
+
+typedef struct
+{
+	char			*str;
+	int				length;
+	unsigned		hash;
+	int				next;		// hash chain, or free list when SCRSTR_FREE
+	int				mark;		// markSequence of the last collection that reached it
+	unsigned short	serial;		// bumped on free so stale handles don't alias reused slots
+	byte			gen;		// scrstrgen_t
+} scrstr_t;
+
+typedef struct
+{
+	scrstr_t		*slots;
+	int				numslots, maxslots;
+	int				freeslot;
+	int				hash[SCRSTR_HASH_SIZE];
+	byte			*canonical;		// per progs string offset, true when it's the only copy of its contents
+
+	int				*young;
+	int				numyoung, maxyoung;
+	int				numold, oldAfterMajor;
+	int				markSequence;
+
+	int				*stringFields;	// ofs of every ev_string entity field
+	int				numStringFields;
+
+	char			*scratch;		// for building strings before interning them
+	int				scratchSize;
+
+	int				numstatic, heapBytes;
+	int				allocated, freed;
+	int				minorCollections, majorCollections;
+} scrstrheap_t;
+
+#include "scr_aot.h"
+
 typedef struct qcvm_s
 {
 	vmType_t		progsType;		// SCRVM_
@@ -164,7 +229,17 @@ typedef struct qcvm_s
 
 	unsigned short	crc;			// crc checksum of entire progs file
 
-	gefv_cache		gefvCache[SCR_GEFV_CACHESIZE];
+	nameindex_t		*fieldIndex;	// field def name -> def number, for the first NAMEINDEX_MAX defs
+
+	int				intrinsicFunc[NUM_INTRINSICS];	// function the intrinsic replaced, 0 if progs don't call it
+	int				numIntrinsicCalls;				// statements rewritten at load
+
+	// progs translated to native code by qc2c, see scr_aot.c
+	void			*aotLibrary;
+	scr_aotmodule_t	*aot;			// NULL when everything runs in the interpreter
+	scr_aotvm_t		aotvm;
+	qboolean		aotBypass;		// vm_aotverify is running the interpreter side
+	int				aotVerified, aotMismatches;
 
 	qboolean		traceEnabled;
 
@@ -179,11 +254,14 @@ typedef struct qcvm_s
 	int				argc;
 
 	int				runawayCounter;	// runaway loop counter
+	long long		numStatements;	// interpreted so far, for svbench
 	int				pr_numparms;
 
 	char			*callFromFuncName;			// printtrace
 
 	FILE			*logfile;
+
+	scrstrheap_t	strheap;
 }qcvm_t;
 
 typedef struct
@@ -196,9 +274,33 @@ typedef struct
 
 extern builtin_t	*scr_builtins;
 extern int			scr_numBuiltins;
+extern qcvm_t		*qcvm[NUM_SCRIPT_VMS];
 extern qcvm_t		*active_qcvm;
 extern const qcvmdef_t vmDefs[NUM_SCRIPT_VMS];
 
 extern char* ScrInternal_String(int str);
+
+// scr_exec.c
+extern const int scr_sigNumParms[NUM_SCRSIGS];
+extern void ScrInternal_CallNative(qcvm_t* vm, builtin_t* bi);
+extern void ScrInternal_CallBuiltin(qcvm_t* vm, dfunction_t* f);
+
+// scr_aot.c
+extern cvar_t* vm_aot;
+extern cvar_t* vm_aotverify;
+extern void Scr_LoadAOTModule(qcvm_t* vm);
+extern void Scr_FreeAOTModule(qcvm_t* vm);
+extern void ScrInternal_CallAOT(qcvm_t* vm, int fnum);
+
+// scr_strings.c
+extern void Scr_InitStringHeap(qcvm_t* vm);
+extern void Scr_FreeStringHeap(qcvm_t* vm);
+extern char* ScrInternal_VMString(qcvm_t* vm, int handle);
+extern int ScrInternal_InternString(qcvm_t* vm, const char* str);
+extern qboolean ScrInternal_StringsEqual(qcvm_t* vm, int a, int b);
+extern char* ScrInternal_TempBuffer(qcvm_t* vm, int size);
+extern int ScrInternal_WriteStringHeap(qcvm_t* vm, byte* out);
+extern qboolean ScrInternal_ReadStringHeap(qcvm_t* vm, const byte* in, int size);
+extern void Cmd_VM_Strings_f(void);
 extern void Scr_InitSharedBuiltins();
 extern void CheckScriptVM(const char* func);
\ No newline at end of file
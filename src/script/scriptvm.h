@@ -71,8 +71,36 @@ extern vm_entity_t* Scr_GetEntityPtr();
 extern void* Scr_GetGlobals();
 extern int Scr_GetEntityFieldsSize();
 extern unsigned Scr_GetProgsCRC(vmType_t vmType);
+extern long long Scr_GetStatementCount(vmType_t vmType);
+extern int Scr_WriteState(vmType_t vmType, byte* out);
+extern qboolean Scr_ReadState(vmType_t vmType, const byte* in, int size);
+
+// entity field bindings, resolved by name once per progs load instead of on every read
+typedef enum
+{
+	SCRFIELD_STRING = 1,	// these match progs ev_ types
+	SCRFIELD_FLOAT,
+	SCRFIELD_VECTOR,
+	SCRFIELD_ENTITY,
+	SCRFIELD_FUNCTION = 6
+} scr_fieldtype_t;
+
+typedef int scr_field_t;	// byte offset from the start of a vm entity, -1 when progs don't define the field
+
+extern void Scr_BindEntityField(vmType_t vmType, scr_field_t* field, char* name, scr_fieldtype_t type);
+extern scr_field_t Scr_EntityFieldOffset(char* name, scr_fieldtype_t type);
+
+#define	SCR_FIELD(ent, f)			((eval_t*)((byte*)(ent) + (f)))
+#define	SCR_FIELD_FLOAT(ent, f)		(SCR_FIELD(ent, f)->_float)
+#define	SCR_FIELD_VECTOR(ent, f)	(SCR_FIELD(ent, f)->vector)
+#define	SCR_FIELD_STRING(ent, f)	(Scr_GetString(SCR_FIELD(ent, f)->string))
+#define	SCR_FIELD_ENTITY(ent, f)	(SCR_FIELD(ent, f)->edict)
 
 extern void Scr_PreInitVMs();
+
+// scr_strings.c
+extern void Scr_CollectStrings(vmType_t vmType);
+
 extern void Scr_Shutdown();
 
 // scr_debug.c
@@ -82,11 +110,28 @@ void Scr_StackTrace();
 extern void Scr_RunError(char* error, ...);
 extern void Scr_Execute(vmType_t vm, scr_func_t fnum, char* callFromFuncName);
 extern int Scr_NumArgs();
-extern eval_t* Scr_GetEntityFieldValue(vm_entity_t* ent, char* field); // FIXME 
+extern eval_t* Scr_GetEntityFieldValue(vm_entity_t* ent, char* field); // slow, bind fields read every frame
+
 
+// typed builtins, the vm unpacks parms and stores the result itself
+typedef enum
+{
+	SCRSIG_NONE,	// void(void), reads parms with Scr_GetParm* and returns with Scr_Return*
+	SCRSIG_F,		// float f(void)
+	SCRSIG_F_F,		// float f(float a)
+	SCRSIG_F_FFF,	// float f(float a, float b, float c)
+	SCRSIG_F_V,		// float f(float *a)
+	SCRSIG_F_VV,	// float f(float *a, float *b)
+	SCRSIG_V_V,		// void f(float *a, float *out)
+	SCRSIG_V_VV,	// void f(float *a, float *b, float *out)
+	NUM_SCRSIGS
+} scr_builtinsig_t;
+
+typedef void (*scr_native_t)(void);	// cast to the real type given by scr_builtinsig_t
 
 // scr_utils.c
 extern void Scr_DefineBuiltin(void (*function)(void), pb_t type, char* fname, char* qcstring);
+extern void Scr_DefineNativeBuiltin(scr_native_t function, scr_builtinsig_t sig, pb_t type, char* fname, char* qcstring);
 extern scr_func_t Scr_FindFunction(char* funcname);
 extern int Scr_SetString(char* str);
 extern char* Scr_GetString(int num);
@@ -44,6 +44,8 @@ typedef struct svmodel_s
 	// only if type == MOD_MD3
 	char			surfNames[MD3_MAX_SURFACES][MD3_MAX_NAME];
 	char			tagNames[MD3_MAX_TAGS][MD3_MAX_NAME];
+	int				surfIds[MD3_MAX_SURFACES];	// interned surfNames, see SV_InternName
+	int				tagIds[MD3_MAX_TAGS];		// interned tagNames
 	orientation_t	*tagFrames;	// numTags * numFrames
 
 	modeldef_t		def;
@@ -83,6 +85,12 @@ typedef struct
 	svmodel_t			models[MAX_MODELS];		// md3, sprites, brushmodels
 	int					num_models;
 
+	// md3 tag and surface names are interned at load so lookups compare ints,
+	// name id is the slot + 1 and stays valid until the level changes
+	char				internedNames[NAMEINDEX_MAX][MD3_MAX_NAME];
+	nameindex_t			internedIndex;
+	int					num_internedNames;
+
 	qboolean			qcvm_active;
 	sv_globalvars_t*	script_globals;			// qcvm globals
 	gentity_t			*edicts;				// allocated by qcvm
@@ -94,6 +102,9 @@ typedef struct
 	int					gameFrame;				
 	float				gameTime;
 
+	int					numAwake, numAsleep;	// entities that ran or skipped physics last frame
+	int					numSwept;				// moves that took their trace from the sweep last frame
+
 	char				configstrings[MAX_CONFIGSTRINGS][MAX_QPATH];
 	entity_state_t		baselines[MAX_GENTITIES];
 
@@ -166,6 +177,18 @@ typedef struct client_s
 	byte			*download;			// file being downloaded
 	int				downloadsize;		// total bytes (can't use EOF because of paks)
 	int				downloadcount;		// bytes sent
+	char			downloadname[MAX_QPATH];
+
+	// windowed downloads, fragments go out-of-band and are acknowledged selectively
+	qboolean		dl_windowed;
+	int				dl_id;				// so stale acks and fragments can be told apart
+	int				dl_numfrags;		// fragments from downloadcount to downloadsize
+	int				dl_base;			// first fragment not yet acknowledged
+	int				dl_next;			// next fragment that was never sent
+	int				dl_sendtime[MAX_DOWNLOAD_WINDOW];	// svs.realtime of last send, -1 once acknowledged
+	int				dl_budget;			// bytes that may be sent right now (sv_download_rate)
+	int				dl_lasttime;		// svs.realtime the budget was last refilled
+	int				dl_starttime;
 
 	int				lastmessage;		// sv.framenum when packet was last received
 	int				lastconnect;
@@ -175,6 +198,8 @@ typedef struct client_s
 //	float			persistant[MAX_PERS_FIELDS];		// persistant info thru levels
 
 	netchan_t		netchan;
+
+	qboolean		bot;				// svbench client, its messages are counted and dropped
 } client_t;
 
 // a client can leave the server in one of four ways:
@@ -222,6 +247,24 @@ typedef struct
 	float		saved[MAX_PERS_FIELDS];
 } server_static_t;
 
+// svbench counters, only gathered while a benchmark runs
+typedef struct
+{
+	qboolean	active;
+	FILE		*record;				// svbench_record, client 0 commands
+
+	long long	gameTime;				// SV_RunGameFrame
+	long long	sendTime;				// SV_SendClientMessages
+	long long	thinkTime;				// client commands, player movement
+	long long	physicsTime;			// entity loop of SV_RunWorldFrame
+	long long	traceTime;				// SV_Trace, also part of the above
+	int			traces;
+	int			sweptTraces;			// traces done ahead of physics, also counted in traces
+	int			pushes;					// SV_Push calls
+	int			pushChecks;				// entities SV_Push had to look at
+	long long	bytesSent;
+} svbench_t;
+
 //=============================================================================
 
 extern	netadr_t	net_from;
@@ -231,6 +274,7 @@ extern	netadr_t	master_adr[MAX_MASTER_SERVERS];	// address of the master server
 
 extern	server_static_t	svs;				// persistant server info
 extern	server_t		sv;					// local server
+extern	svbench_t		sv_bench;
 
 extern	cvar_t		*sv_paused;
 extern	cvar_t		*sv_password;
@@ -240,9 +284,12 @@ extern	cvar_t		*sv_maxclients;
 extern	cvar_t		*sv_maxentities;
 extern	cvar_t		*sv_noreload;			// don't reload level state when reentering, development tool
 extern	cvar_t		*sv_enforcetime;
+extern	cvar_t		*sv_savekeyframes;		// incremental saves into a slot before a full one
 	
 extern	cvar_t		*sv_maxvelocity;
 extern	cvar_t		*sv_gravity;
+extern	cvar_t		*sv_sleep;
+extern	cvar_t		*sv_physicsthreads;
 
 extern	client_t	*sv_client;
 extern	gentity_t	*sv_player;
@@ -258,11 +305,17 @@ int SV_SoundIndex(char* name);
 int SV_ImageIndex(char* name);
 svmodel_t* SV_ModelForNum(unsigned int index);
 svmodel_t* SV_ModelForName(char *name);
+void SV_ClearAssetIndex(void);
+int SV_InternName(const char* name);
+int SV_NameIdForString(const char* name);
 int SV_ModelSurfIndexForName(int modelindex, char* surfaceName);
 int SV_TagIndexForName(int modelindex, char* tagName);
+int SV_TagIndexForId(svmodel_t* mod, int tagId);
 orientation_t* SV_GetTag(int modelindex, int frame, char* tagName);
+orientation_t* SV_GetTagForId(int modelindex, int frame, int tagId);
 orientation_t* SV_PositionTag(vec3_t origin, vec3_t angles, int modelindex, int animframe, char* tagName);
 orientation_t* SV_PositionTagOnEntity(gentity_t* ent, char* tagName);
+orientation_t* SV_PositionTagOnEntityForId(gentity_t* ent, int tagId);
 
 
 //
@@ -292,6 +345,11 @@ void SV_Map (qboolean attractloop, char *levelstring, qboolean loadgame, qboolea
 //
 void SV_PrepWorldFrame (void);
 void SV_RunEntityPhysics(gentity_t* ent);
+void SV_CheckSleep(gentity_t* ent);
+qboolean SV_StaysAsleep(gentity_t* ent);
+void SV_RunAsleep(gentity_t* ent);
+void SV_WakeEntity(gentity_t* ent);
+void SV_LinkRiders(void);
 void SV_Physics_Pusher(gentity_t* ent);
 void SV_Physics_None(gentity_t* ent);
 void SV_Physics_Noclip(gentity_t* ent);
@@ -323,6 +381,8 @@ void SV_BroadcastCommand (char *fmt, ...);
 //
 void SV_Nextserver (void);
 void SV_ExecuteClientMessage (client_t *cl);
+void SV_SendDownloads (void);
+void SV_FreeDownload (client_t *cl);
 
 //
 // sv_ccmds.c
@@ -337,6 +397,29 @@ void SV_WriteFrameToClient (client_t *client, sizebuf_t *msg);
 void SV_RecordDemoMessage (void);
 void SV_BuildClientFrame (client_t *client);
 
+//
+// sv_save.c
+//
+void SV_WriteSnapshot(char* dir);
+qboolean SV_ReadSnapshot(char* dir, char* mapname, int mapnameSize);
+qboolean SV_RestoreSnapshot(void);
+void SV_FreePendingSnapshot(void);
+
+//
+// sv_bench.c
+//
+void SV_Bench_f(void);
+void SV_BenchRecord_f(void);
+void SV_BenchRecordCommand(client_t* cl, usercmd_t* cmd);
+
+//
+// sv_sweep.c
+//
+void SV_InitSweep(void);
+void SV_ShutdownSweep(void);
+void SV_SweepMovers(void);
+qboolean SV_SweptTrace(gentity_t* ent, vec3_t start, vec3_t end, int mask, trace_t* trace);
+
 //
 // sv_gentity.c
 //
@@ -385,6 +468,10 @@ int SV_AreaEdicts (vec3_t mins, vec3_t maxs, gentity_t **list, int maxcount, int
 // returns the number of pointers filled in
 // ??? does this always return the world?
 
+int SV_AreaLinked (vec3_t mins, vec3_t maxs, gentity_t **list, int maxcount);
+// same for every entity linked in the area, solid, trigger, pathnode and
+// ones made SOLID_NOT without relinking
+
 //===================================================================
 
 //
@@ -406,3 +493,8 @@ trace_t SV_Trace (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t
 
 // passedict is explicitly excluded from clipping checks (normally NULL)
 
+int SV_MoveEdicts (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t **list, int maxcount);
+qboolean SV_TraceSlot (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t *passedict, int contentmask, gentity_t **list, int num, int slot, trace_t *trace);
+// the two halves of SV_Trace for worker threads, each thread with its own
+// collision slot, only while no entity links
+
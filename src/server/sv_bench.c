@@ -0,0 +1,617 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// sv_bench.c -- headless server benchmark
+
+/*
+svbench <map> [bots] [ticks] [seed] [cmds]
+
+Starts a fresh game on the map, connects bots to every client slot they need
+and runs the given number of server frames back to back, without waiting for
+the clock or the network. Bots go through the same connect and begin code a
+real client does, their messages are built every frame but never sent.
+
+Bots either replay usercmds recorded with svbench_record, each from a
+different point of the stream, or when no stream is given they move, turn,
+jump and shoot from a random generator seeded by the seed. srand() gets the
+seed too, so the same build on the same map does the same work every run,
+the state hash at the end tells whether it did.
+
+The result is printed as a single line of JSON and written to svbench.json
+in the game directory, the server is shut down afterwards. Phase times are
+totals in milliseconds, traces are also part of physics and client think,
+swept traces are the ones physics got from sv_sweep.c without tracing, and
+vm statements are only counted for progs that run in the interpreter.
+
+With svbench_movers set the map also gets that many copies of its inline
+models going up and down, each with a crate riding on it, for runs that are
+about pushers. Pushes and push checks count the SV_Push calls and the
+entities they had to look at.
+*/
+
+#include "server.h"
+
+extern void SV_New_f(void);
+extern void SV_Begin_f(void);
+extern void SV_ClientThink(client_t* cl, usercmd_t* cmd);
+extern void SV_GiveMsec(void);
+extern void SV_RunGameFrame(void);
+qboolean Scr_ClientConnect(gentity_t* ent, char* userinfo);
+
+#define	SVBENCH_IDENT		(('C'<<24)+('B'<<16)+('V'<<8)+'S')	// "SVBC"
+#define	SVBENCH_VERSION		1
+#define	SVBENCH_MAXCMDS		32		// stop replaying commands with no time in them
+#define	SVBENCH_MAXMOVERS	512
+
+typedef struct
+{
+	int		ident;
+	int		version;
+	int		numcmds;
+} svbenchcmds_t;
+
+typedef struct
+{
+	unsigned	random;
+	int			cmdpos;		// next recorded command
+	usercmd_t	cmd;		// generated moves last a few frames
+} svbenchbot_t;
+
+svbench_t		sv_bench;
+
+static svbenchbot_t	bench_bots[MAX_CLIENTS];
+static usercmd_t	*bench_cmds;
+static int			bench_numcmds;
+static int			bench_numrecorded;
+static int			bench_movers[SVBENCH_MAXMOVERS];
+static int			bench_nummovers;
+
+/*
+==================
+SV_BenchRandom
+==================
+*/
+static unsigned SV_BenchRandom(svbenchbot_t *bot)
+{
+	// xorshift, so bots don't depend on the rand() of the platform
+	bot->random ^= bot->random << 13;
+	bot->random ^= bot->random >> 17;
+	bot->random ^= bot->random << 5;
+	return bot->random;
+}
+
+/*
+==================
+SV_BenchThink
+
+Runs this frame's commands for a bot
+==================
+*/
+static void SV_BenchThink(client_t *cl, svbenchbot_t *bot, int tick)
+{
+	usercmd_t	cmd;
+	unsigned	r;
+	int			msec, n;
+
+	sv_client = cl;
+	sv_player = cl->edict;
+
+	if (bench_cmds)
+	{
+		// a client sends its own framerate worth of commands
+		for (msec = n = 0; msec < SV_FRAMETIME_MSEC && n < SVBENCH_MAXCMDS; n++)
+		{
+			cmd = bench_cmds[bot->cmdpos++ % bench_numcmds];
+			SV_ClientThink (cl, &cmd);
+			cl->lastcmd = cmd;
+			msec += cmd.msec;
+		}
+		return;
+	}
+
+	r = SV_BenchRandom(bot);
+	if (!(tick % SERVER_FPS))
+	{
+		bot->cmd.forwardmove = (r & 3) ? 400 : -200;
+		bot->cmd.sidemove = ((r >> 2) & 3) == 3 ? 0 : (((r >> 2) & 3) - 1) * 300;
+	}
+
+	bot->cmd.msec = SV_FRAMETIME_MSEC;
+	bot->cmd.angles[YAW] += ((int)((r >> 8) % 21) - 10) * ANGLE2SHORT(3);
+	bot->cmd.upmove = ((r >> 16) & 15) ? 0 : 200;
+	bot->cmd.buttons = ((r >> 20) & 7) ? 0 : BUTTON_ATTACK;
+
+	SV_ClientThink (cl, &bot->cmd);
+	cl->lastcmd = bot->cmd;
+}
+
+/*
+==================
+SV_BenchConnect
+
+Brings a bot in the way SVC_DirectConnect, new and begin would
+==================
+*/
+static qboolean SV_BenchConnect(int num)
+{
+	client_t	*cl;
+	char		userinfo[MAX_INFO_STRING];
+	netadr_t	adr;
+
+	cl = &svs.clients[num];
+	memset (cl, 0, sizeof(*cl));
+	cl->bot = true;
+	cl->edict = EDICT_NUM(num + 1);
+	sv_client = cl;
+
+	Com_sprintf (userinfo, sizeof(userinfo), "\\name\\bot%02i", num);
+	if (*sv_password->string)
+		Info_SetValueForKey (userinfo, "password", sv_password->string);
+
+	if (!Scr_ClientConnect(cl->edict, userinfo))
+	{
+		Com_Printf ("svbench: game rejected bot %i %s\n", num, Info_ValueForKey(userinfo, "rejmsg"));
+		return false;
+	}
+
+	strncpy (cl->userinfo, userinfo, sizeof(cl->userinfo)-1);
+	SV_UserinfoChanged (cl);
+
+	memset (&adr, 0, sizeof(adr));
+	adr.type = NA_LOOPBACK;
+	Netchan_Setup (NS_SERVER, &cl->netchan, adr, num);
+
+	cl->state = cs_connected;
+	SZ_Init (&cl->datagram, cl->datagram_buf, sizeof(cl->datagram_buf));
+	cl->datagram.allowoverflow = true;
+	cl->lastmessage = cl->lastconnect = svs.realtime;
+	cl->lastframe = -1;
+	cl->commandMsec = (16 * SV_FRAMETIME_MSEC) + 200;
+
+	sv_player = cl->edict;
+	SV_New_f ();
+	Cmd_TokenizeString (va("begin %i\n", svs.spawncount), false);
+	SV_Begin_f ();
+
+	SZ_Clear (&cl->netchan.message);
+	return cl->state == cs_spawned;
+}
+
+/*
+==================
+SV_BenchLoadCommands
+==================
+*/
+static qboolean SV_BenchLoadCommands(char *name)
+{
+	char			path[MAX_QPATH];
+	svbenchcmds_t	*header;
+	int				i, size, msec;
+
+	Com_sprintf (path, sizeof(path), "bench/%s.cmd", name);
+	size = FS_LoadFile (path, (void **)&header);
+	if (size == -1)
+	{
+		Com_Printf ("svbench: couldn't load %s\n", path);
+		return false;
+	}
+
+	if (size < (int)sizeof(*header) || LittleLong(header->ident) != SVBENCH_IDENT || LittleLong(header->version) != SVBENCH_VERSION
+		|| LittleLong(header->numcmds) <= 0 || size != sizeof(*header) + LittleLong(header->numcmds) * sizeof(usercmd_t))
+	{
+		Com_Printf ("svbench: %s is not a command stream\n", path);
+		FS_FreeFile (header);
+		return false;
+	}
+
+	bench_numcmds = LittleLong(header->numcmds);
+	bench_cmds = Z_Malloc (bench_numcmds * sizeof(usercmd_t));
+	memcpy (bench_cmds, header + 1, bench_numcmds * sizeof(usercmd_t));
+	FS_FreeFile (header);
+
+	for (i = msec = 0; i < bench_numcmds; i++)
+	{
+		bench_cmds[i].angles[0] = LittleShort(bench_cmds[i].angles[0]);
+		bench_cmds[i].angles[1] = LittleShort(bench_cmds[i].angles[1]);
+		bench_cmds[i].angles[2] = LittleShort(bench_cmds[i].angles[2]);
+		bench_cmds[i].forwardmove = LittleShort(bench_cmds[i].forwardmove);
+		bench_cmds[i].sidemove = LittleShort(bench_cmds[i].sidemove);
+		bench_cmds[i].upmove = LittleShort(bench_cmds[i].upmove);
+		msec += bench_cmds[i].msec;
+	}
+
+	Com_Printf ("svbench: %i commands, %.1f seconds from %s\n", bench_numcmds, msec / 1000.0f, path);
+	return true;
+}
+
+/*
+==================
+SV_BenchSpawnMovers
+
+Copies of the inline models, stacked above the originals so the crates don't
+start inside each other
+==================
+*/
+static void SV_BenchSpawnMovers(int count)
+{
+	gentity_t	*mover, *crate;
+	cmodel_t	*mod;
+	char		name[16];
+	int			i, num, numinline;
+	float		height;
+
+	bench_nummovers = 0;
+	if (count < 1)
+		return;
+
+	numinline = CM_NumInlineModels ();
+	if (numinline < 2)
+	{
+		Com_Printf ("svbench: the map has no inline models to move\n");
+		return;
+	}
+
+	if (count > SVBENCH_MAXMOVERS)
+		count = SVBENCH_MAXMOVERS;
+
+	for (i = 0; i < count; i++)
+	{
+		num = 1 + i % (numinline - 1);
+		Com_sprintf (name, sizeof(name), "*%i", num);
+		mod = CM_InlineModel (name);
+		height = mod->maxs[2] - mod->mins[2] + 64;
+
+		mover = SV_SpawnEntity ();
+		mover->v.classname = Scr_SetString ("svbench_mover");
+		mover->v.solid = SOLID_BSP;
+		mover->v.movetype = MOVETYPE_PUSH;
+		mover->v.model = Scr_SetString (name);
+		mover->v.modelindex = MODELINDEX_WORLD + num;	// SV_SpawnServer precached every inline model after the world
+		mover->v.origin[2] = (i / (numinline - 1) + 1) * height;
+		VectorCopy (mod->mins, mover->v.mins);
+		VectorCopy (mod->maxs, mover->v.maxs);
+		SV_LinkEdict (mover);
+		bench_movers[bench_nummovers++] = NUM_FOR_ENT(mover);
+
+		crate = SV_SpawnEntity ();
+		crate->v.classname = Scr_SetString ("svbench_crate");
+		crate->v.solid = SOLID_BBOX;
+		crate->v.movetype = MOVETYPE_TOSS;
+		crate->v.clipmask = MASK_SOLID;
+		VectorSet (crate->v.mins, -8, -8, -8);
+		VectorSet (crate->v.maxs, 8, 8, 8);
+		crate->v.origin[0] = (mod->mins[0] + mod->maxs[0]) * 0.5;
+		crate->v.origin[1] = (mod->mins[1] + mod->maxs[1]) * 0.5;
+		crate->v.origin[2] = mover->v.origin[2] + mod->maxs[2] + 9;
+		SV_LinkEdict (crate);
+	}
+}
+
+/*
+==================
+SV_BenchRunMovers
+
+A second up, a second down
+==================
+*/
+static void SV_BenchRunMovers(int tick)
+{
+	gentity_t	*mover;
+	int			i;
+
+	for (i = 0; i < bench_nummovers; i++)
+	{
+		mover = EDICT_NUM(bench_movers[i]);
+		if (mover->inuse && mover->v.movetype == MOVETYPE_PUSH)
+			mover->v.velocity[2] = ((tick / SERVER_FPS) & 1) ? -32 : 32;
+	}
+}
+
+/*
+==================
+SV_BenchStateHash
+
+FNV-1a of every entity in use, equal hashes mean the runs did the same thing
+==================
+*/
+static unsigned SV_BenchStateHash(void)
+{
+	unsigned	hash;
+	gentity_t	*ent;
+	byte		*p;
+	int			i, j;
+
+	hash = 2166136261u;
+	for (i = 0; i < sv.max_edicts; i++)
+	{
+		ent = EDICT_NUM(i);
+		if (!ent->inuse)
+			continue;
+
+		p = (byte *)&ent->s;
+		for (j = 0; j < sizeof(ent->s); j++)
+			hash = (hash ^ p[j]) * 16777619u;
+
+		p = (byte *)&ent->v;
+		for (j = 0; j < sizeof(ent->v); j++)
+			hash = (hash ^ p[j]) * 16777619u;
+	}
+	return hash;
+}
+
+/*
+==================
+SV_BenchJSONString
+
+Copies in to out with quotes, backslashes and control characters escaped
+==================
+*/
+static void SV_BenchJSONString(const char *in, char *out, int outsize)
+{
+	int		len;
+
+	for (len = 0; *in && len < outsize - 7; in++)
+	{
+		if (*in == '"' || *in == '\\')
+		{
+			out[len++] = '\\';
+			out[len++] = *in;
+		}
+		else if ((unsigned char)*in < ' ')
+		{
+			Com_sprintf (out + len, outsize - len, "\\u%04x", (unsigned char)*in);
+			len += 6;
+		}
+		else
+			out[len++] = *in;
+	}
+	out[len] = 0;
+}
+
+/*
+==================
+SV_Bench_f
+
+svbench <map> [bots] [ticks] [seed] [cmds]
+==================
+*/
+void SV_Bench_f(void)
+{
+	char		map[MAX_QPATH], cmdname[MAX_QPATH], path[MAX_OSPATH], json[1024];
+	char		jsonmap[MAX_QPATH * 6], jsoncmds[MAX_QPATH * 6];
+	int			numbots, ticks, seed, tick, i;
+	cvar_t		*movers;
+	long long	wall, start, statements;
+	client_t	*cl;
+	FILE		*f;
+
+	if (Cmd_Argc() < 2)
+	{
+		Com_Printf ("USAGE: svbench <map> [bots] [ticks] [seed] [cmds]\n");
+		return;
+	}
+
+	Com_sprintf (map, sizeof(map), "%s", Cmd_Argv(1));
+	numbots = Cmd_Argc() > 2 ? atoi(Cmd_Argv(2)) : 8;
+	ticks = Cmd_Argc() > 3 ? atoi(Cmd_Argv(3)) : 30 * SERVER_FPS;
+	seed = Cmd_Argc() > 4 ? atoi(Cmd_Argv(4)) : 1;
+	Com_sprintf (cmdname, sizeof(cmdname), "%s", Cmd_Argc() > 5 ? Cmd_Argv(5) : "");
+
+	if (numbots < 1)
+		numbots = 1;
+	else if (numbots > MAX_CLIENTS)
+		numbots = MAX_CLIENTS;
+	if (ticks < 1)
+		ticks = 1;
+
+	Com_sprintf (path, sizeof(path), "maps/%s.bsp", map);
+	if (FS_LoadFile (path, NULL) == -1)
+	{
+		Com_Printf ("Server cannot find map: `%s`\n", path);
+		return;
+	}
+
+	if (bench_cmds)
+		Z_Free (bench_cmds);
+	bench_cmds = NULL;
+	bench_numcmds = 0;
+	if (cmdname[0] && !SV_BenchLoadCommands (cmdname))
+		return;
+
+	// fresh multiplayer game with a slot for every bot
+	Cvar_FullSet ("multiplayer", "1", CVAR_SERVERINFO | CVAR_LATCH, NULL);
+	Cvar_FullSet ("coop", "0", CVAR_SERVERINFO | CVAR_LATCH, NULL);
+	Cvar_FullSet ("sv_maxclients", va("%i", numbots), CVAR_SERVERINFO | CVAR_LATCH, NULL);
+
+	srand (seed);
+	sv.state = ss_dead;
+	SV_Map (false, map, false, false, false);
+
+	if (sv.state != ss_game || svs.max_clients < numbots)
+	{
+		Com_Printf ("svbench: couldn't start %s\n", map);
+		return;
+	}
+
+	Scr_BindVM (VM_SVGAME);
+
+	for (i = 0; i < numbots; i++)
+	{
+		bench_bots[i].random = (unsigned)seed * 2654435761u + (i + 1);
+		if (!bench_bots[i].random)
+			bench_bots[i].random = 1;
+		bench_bots[i].cmdpos = bench_numcmds ? i * bench_numcmds / numbots : 0;
+		memset (&bench_bots[i].cmd, 0, sizeof(bench_bots[i].cmd));
+
+		if (!SV_BenchConnect (i))
+		{
+			SV_Shutdown ("Server benchmark failed.\n", false);
+			return;
+		}
+	}
+
+	movers = Cvar_Get ("svbench_movers", "0", 0, "Moving copies of the map's inline models svbench adds, each carrying a crate.");
+	SV_BenchSpawnMovers ((int)movers->value);
+
+	Com_Printf ("svbench: %s, %i bots, %i ticks, seed %i, %i movers\n", map, numbots, ticks, seed, bench_nummovers);
+
+	f = sv_bench.record;
+	memset (&sv_bench, 0, sizeof(sv_bench));
+	sv_bench.record = f;
+	sv_bench.active = true;
+	statements = Scr_GetStatementCount (VM_SVGAME);
+	wall = Sys_Microseconds ();
+
+	for (tick = 0; tick < ticks && sv.state == ss_game; tick++)
+	{
+		svs.realtime += SV_FRAMETIME_MSEC;
+
+		start = Sys_Microseconds ();
+		for (i = 0, cl = svs.clients; i < numbots; i++, cl++)
+		{
+			if (cl->state == cs_spawned)
+				SV_BenchThink (cl, &bench_bots[i], tick);
+		}
+		sv_bench.thinkTime += Sys_Microseconds () - start;
+
+		SV_GiveMsec ();
+		SV_BenchRunMovers (tick);
+
+		start = Sys_Microseconds ();
+		SV_RunGameFrame ();
+		sv_bench.gameTime += Sys_Microseconds () - start;
+
+		start = Sys_Microseconds ();
+		SV_SendClientMessages ();
+		sv_bench.sendTime += Sys_Microseconds () - start;
+
+		// perfect network, everything sent has been acknowledged by the next frame
+		for (i = 0, cl = svs.clients; i < numbots; i++, cl++)
+			cl->lastframe = sv.framenum;
+
+		SV_PrepWorldFrame ();
+	}
+
+	wall = Sys_Microseconds () - wall;
+	statements = Scr_GetStatementCount (VM_SVGAME) - statements;
+	sv_bench.active = false;
+
+	if (tick < ticks)
+		Com_Printf ("WARNING: svbench: server left %s after %i ticks\n", map, tick);
+
+	SV_BenchJSONString (map, jsonmap, sizeof(jsonmap));
+	SV_BenchJSONString (cmdname[0] ? cmdname : "random", jsoncmds, sizeof(jsoncmds));
+	Com_sprintf (json, sizeof(json),
+		"{\"map\":\"%s\",\"bots\":%i,\"ticks\":%i,\"seed\":%i,\"cmds\":\"%s\",\"movers\":%i,"
+		"\"wall_ms\":%.3f,\"tick_ms\":%.4f,\"game_frame_ms\":%.3f,\"send_messages_ms\":%.3f,"
+		"\"client_think_ms\":%.3f,\"physics_ms\":%.3f,\"traces\":%i,\"swept_traces\":%i,\"trace_ms\":%.3f,"
+		"\"pushes\":%i,\"push_checks\":%i,"
+		"\"vm_statements\":%lld,\"bytes_sent\":%lld,\"state_hash\":\"%08x\"}",
+		jsonmap, numbots, tick, seed, jsoncmds, bench_nummovers,
+		wall / 1000.0, tick ? wall / 1000.0 / tick : 0.0, sv_bench.gameTime / 1000.0, sv_bench.sendTime / 1000.0,
+		sv_bench.thinkTime / 1000.0, sv_bench.physicsTime / 1000.0, sv_bench.traces, sv_bench.sweptTraces, sv_bench.traceTime / 1000.0,
+		sv_bench.pushes, sv_bench.pushChecks,
+		statements, sv_bench.bytesSent, SV_BenchStateHash());
+
+	Com_Printf ("%s\n", json);
+
+	Com_sprintf (path, sizeof(path), "%s/svbench.json", FS_Gamedir());
+	f = fopen (path, "w");
+	if (f)
+	{
+		fprintf (f, "%s\n", json);
+		fclose (f);
+	}
+	else
+		Com_Printf ("WARNING: couldn't write %s\n", path);
+
+	SV_Shutdown ("Server benchmark finished.\n", false);
+}
+
+/*
+==================
+SV_BenchRecord_f
+
+svbench_record <name> starts recording the commands of the first client, without a name it stops
+==================
+*/
+void SV_BenchRecord_f(void)
+{
+	char			path[MAX_OSPATH], *name;
+	svbenchcmds_t	header;
+
+	if (sv_bench.record)
+	{
+		header.ident = LittleLong(SVBENCH_IDENT);
+		header.version = LittleLong(SVBENCH_VERSION);
+		header.numcmds = LittleLong(bench_numrecorded);
+		fseek (sv_bench.record, 0, SEEK_SET);
+		fwrite (&header, sizeof(header), 1, sv_bench.record);
+		fclose (sv_bench.record);
+		sv_bench.record = NULL;
+
+		Com_Printf ("Recorded %i commands.\n", bench_numrecorded);
+		if (Cmd_Argc() < 2)
+			return;
+	}
+
+	if (Cmd_Argc() != 2)
+	{
+		Com_Printf ("USAGE: svbench_record <name>\n");
+		return;
+	}
+
+	name = Cmd_Argv(1);
+	if (strstr (name, "..") || strstr (name, "/") || strstr (name, "\\"))
+	{
+		Com_Printf ("Bad name.\n");
+		return;
+	}
+
+	Com_sprintf (path, sizeof(path), "%s/bench/%s.cmd", FS_Gamedir(), name);
+	FS_CreatePath (path);
+	sv_bench.record = fopen (path, "wb");
+	if (!sv_bench.record)
+	{
+		Com_Printf ("ERROR: couldn't open %s\n", path);
+		return;
+	}
+
+	// the header is written again with the count when recording stops
+	memset (&header, 0, sizeof(header));
+	fwrite (&header, sizeof(header), 1, sv_bench.record);
+	bench_numrecorded = 0;
+
+	Com_Printf ("Recording commands of the first client to %s\n", path);
+}
+
+/*
+==================
+SV_BenchRecordCommand
+==================
+*/
+void SV_BenchRecordCommand(client_t *cl, usercmd_t *cmd)
+{
+	usercmd_t	out;
+
+	if (cl != svs.clients || cl->bot)
+		return;
+
+	out = *cmd;
+	out.angles[0] = LittleShort(out.angles[0]);
+	out.angles[1] = LittleShort(out.angles[1]);
+	out.angles[2] = LittleShort(out.angles[2]);
+	out.forwardmove = LittleShort(out.forwardmove);
+	out.sidemove = LittleShort(out.sidemove);
+	out.upmove = LittleShort(out.upmove);
+
+	fwrite (&out, sizeof(out), 1, sv_bench.record);
+	bench_numrecorded++;
+}
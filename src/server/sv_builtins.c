@@ -1967,7 +1967,7 @@ void PFSV_tagexists(void)
 	svmodel_t* model;
 	orientation_t* tag;
 
-	ent = Scr_GetParmString(0);
+	ent = Scr_GetParmEdict(0);
 	tagName = Scr_GetParmString(1);
 
 	if (!ent->inuse)
@@ -2027,7 +2027,7 @@ void PFSV_gettagorigin(void)
 	tag = SV_PositionTagOnEntity(ent, tagName);
 	if (!tag)
 	{
-		Scr_RunError("gettagorigin(): model '%s' nas no tag '%s'\n", model->name, tagName);
+		Scr_RunError("gettagorigin(): model '%s' has no tag '%s'\n", model->name, tagName);
 		return;
 	}
 
@@ -2074,7 +2074,7 @@ void PFSV_gettagangles(void)
 	tag = SV_PositionTagOnEntity(ent, tagName);
 	if (!tag)
 	{
-		Scr_RunError("gettagangles(): model '%s' nas no tag '%s'\n", model->name, tagName);
+		Scr_RunError("gettagangles(): model '%s' has no tag '%s'\n", model->name, tagName);
 		return;
 	}
 
@@ -2088,6 +2088,110 @@ void PFSV_gettagangles(void)
 	Scr_ReturnVector(out);
 }
 
+/*
+=================
+PFSV_gettagid
+
+float gettagid(string tagName)
+Returns numeric id of a tag name for use with gettagoriginid() and gettaganglesid()
+Ids are cheaper than strings to look up, but are only valid for the current level
+
+float tag_head = gettagid("tag_head");
+=================
+*/
+void PFSV_gettagid(void)
+{
+	Scr_ReturnFloat(SV_InternName(Scr_GetParmString(0)));
+}
+
+/*
+=================
+PFSV_gettagoriginid
+
+vector gettagoriginid(entity ent, float tagId)
+Same as gettagorigin() but takes a tag id from gettagid()
+
+vector head_ = gettagoriginid(self, tag_head);
+=================
+*/
+void PFSV_gettagoriginid(void)
+{
+	gentity_t* ent;
+	int tagId;
+	svmodel_t* model;
+	orientation_t* tag;
+
+	ent = Scr_GetParmEdict(0);
+	tagId = (int)Scr_GetParmFloat(1);
+
+	if (!ent->inuse)
+	{
+		Scr_RunError("gettagoriginid(): entity %i not in use\n", NUM_FOR_ENT(ent));
+		return;
+	}
+
+	model = SV_ModelForNum((int)ent->v.modelindex);
+	if (!model || model->type != MOD_MD3 || !model->numTags)
+	{
+		Scr_ReturnVector(ent->v.origin);
+		return;
+	}
+
+	tag = SV_PositionTagOnEntityForId(ent, tagId);
+	if (!tag)
+	{
+		Scr_RunError("gettagoriginid(): model '%s' has no tag %i\n", model->name, tagId);
+		return;
+	}
+
+	Scr_ReturnVector(tag->origin);
+}
+
+/*
+=================
+PFSV_gettaganglesid
+
+vector gettaganglesid(entity ent, float tagId)
+Same as gettagangles() but takes a tag id from gettagid()
+
+vector looking_at = gettaganglesid(self, tag_head);
+=================
+*/
+void PFSV_gettaganglesid(void)
+{
+	gentity_t* ent;
+	int tagId;
+	svmodel_t* model;
+	orientation_t* tag;
+	vec3_t out;
+
+	ent = Scr_GetParmEdict(0);
+	tagId = (int)Scr_GetParmFloat(1);
+
+	if (!ent->inuse)
+	{
+		Scr_RunError("gettaganglesid(): entity %i not in use\n", NUM_FOR_ENT(ent));
+		return;
+	}
+
+	model = SV_ModelForNum((int)ent->v.modelindex);
+	if (!model || model->type != MOD_MD3 || !model->numTags)
+	{
+		Scr_ReturnVector(ent->v.angles);
+		return;
+	}
+
+	tag = SV_PositionTagOnEntityForId(ent, tagId);
+	if (!tag)
+	{
+		Scr_RunError("gettaganglesid(): model '%s' has no tag %i\n", model->name, tagId);
+		return;
+	}
+
+	VectorAngles(tag->axis[0], tag->axis[2], out);
+	Scr_ReturnVector(out);
+}
+
 
 static void PFSV_none(void) { Scr_RunError("BUILTIN WAS REMOVED\n"); }
 /*
@@ -2217,4 +2321,9 @@ void SV_InitScriptBuiltins()
 	Scr_DefineBuiltin(PFSV_drawpoint, PF_SV, "drawpoint", "void(vector p, vector c, float th, float dt, float t)");
 	Scr_DefineBuiltin(PFSV_drawbox, PF_SV, "drawbox", "void(vector p, vector p1, vector p2, vector c, float th, float dt, float t)"); // fixme?
 	Scr_DefineBuiltin(PFSV_drawstring, PF_SV, "drawstring", "void(vector p, vector c, float fs, float dt, float t, string s, ...)");
+
+	// models, appended so existing builtin numbers don't shift
+	Scr_DefineBuiltin(PFSV_gettagid, PF_SV, "gettagid", "float(string tn)");
+	Scr_DefineBuiltin(PFSV_gettagoriginid, PF_SV, "gettagoriginid", "vector(entity e, float tid)");
+	Scr_DefineBuiltin(PFSV_gettaganglesid, PF_SV, "gettaganglesid", "vector(entity e, float tid)");
 }
@@ -78,6 +78,127 @@ void SV_ModelList_f(void)
 }
 
 
+/*
+====================
+SV_TagBench_PositionByName
+
+The string lookup and transform SV_PositionTag did before tag names were
+interned, kept here so sv_tagbench has something to compare against
+====================
+*/
+static orientation_t* SV_TagBench_PositionByName(vec3_t origin, vec3_t angles, int modelindex, int frame, char* tagName)
+{
+	static orientation_t	out;
+	orientation_t			*tag, parent;
+	vec3_t					tempAxis[3];
+	svmodel_t				*mod;
+	int						i;
+
+	mod = SV_ModelForNum(modelindex);
+	if (!mod || mod->type != MOD_MD3)
+		return NULL;
+
+	if (frame >= mod->numFrames)
+		frame = mod->numFrames - 1;
+	else if (frame < 0)
+		frame = 0;
+
+	tag = mod->tagFrames + (frame * mod->numTags);
+	for (i = 0; i < mod->numTags; i++, tag++)
+	{
+		if (!strcmp(mod->tagNames[i], tagName))
+			break;
+	}
+	if (i == mod->numTags)
+		return NULL;
+
+	AxisClear(parent.axis);
+	VectorCopy(origin, parent.origin);
+	AnglesToAxis(angles, parent.axis);
+
+	AxisClear(out.axis);
+	VectorCopy(parent.origin, out.origin);
+	AxisClear(tempAxis);
+
+	for (i = 0; i < 3; i++)
+		VectorMA(out.origin, tag->origin[i], parent.axis[i], out.origin);
+
+	MatrixMultiply(out.axis, parent.axis, tempAxis);
+	MatrixMultiply(tag->axis, tempAxis, out.axis);
+	return &out;
+}
+
+/*
+====================
+SV_TagBench_f
+
+Resolves every tag on every entity with a tagged md3 model the way scripts
+do, first with the old string compare and no caching and then by id through
+the entity cache. Spawn lots of models with attachments before running it.
+====================
+*/
+void SV_TagBench_f(void)
+{
+	gentity_t	*ent;
+	svmodel_t	*mod;
+	long long	start, byname, byid;
+	int			i, j, pass, passes, numents, numtags;
+
+	if (sv.state != ss_game)
+	{
+		Com_Printf("No map loaded.\n");
+		return;
+	}
+
+	passes = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 100;
+	if (passes < 1)
+		passes = 1;
+
+	numents = numtags = 0;
+	byname = byid = 0;
+
+	for (pass = 0; pass < passes; pass++)
+	{
+		// a pass stands for a server frame, so the cache is cold at the start of it
+		for (i = 1; i < sv.num_edicts; i++)
+		{
+			ent = EDICT_NUM(i);
+			if (!ent->inuse)
+				continue;
+			mod = SV_ModelForNum((int)ent->v.modelindex);
+			if (!mod || mod->type != MOD_MD3 || !mod->numTags)
+				continue;
+
+			if (!pass)
+			{
+				numents++;
+				numtags += mod->numTags;
+			}
+			ent->tagcache.valid = false;
+
+			start = Sys_Microseconds();
+			for (j = 0; j < mod->numTags; j++)
+				SV_TagBench_PositionByName(ent->v.origin, ent->v.angles, (int)ent->v.modelindex, (int)ent->v.animFrame, mod->tagNames[j]);
+			byname += Sys_Microseconds() - start;
+
+			start = Sys_Microseconds();
+			for (j = 0; j < mod->numTags; j++)
+				SV_PositionTagOnEntityForId(ent, mod->tagIds[j]);
+			byid += Sys_Microseconds() - start;
+		}
+	}
+
+	if (!numtags)
+	{
+		Com_Printf("No entities with tagged models.\n");
+		return;
+	}
+
+	Com_Printf("%i entities, %i tags, %i passes\n", numents, numtags, passes);
+	Com_Printf("by name: %.3f ms (%.3f us per tag)\n", byname / 1000.0, (double)byname / ((double)numtags * passes));
+	Com_Printf("by id:   %.3f ms (%.3f us per tag)\n", byid / 1000.0, (double)byid / ((double)numtags * passes));
+}
+
 /*
 ====================
 SV_SetMaster_f
@@ -371,6 +492,7 @@ void SV_ReadLevelFile (void)
 		return;
 	}
 	FS_Read (sv.configstrings, sizeof(sv.configstrings), f);
+	SV_ClearAssetIndex();
 	CM_ReadPortalState (f);
 	fclose (f);
 
@@ -652,47 +774,36 @@ SV_Loadgame_f
 */
 void SV_Loadgame_f (void)
 {
-#if 0
-	char	name[MAX_OSPATH];
-	FILE	*f;
+	char	mapname[MAX_QPATH];
 	char	*dir;
 
 	if (Cmd_Argc() != 2)
 	{
-		Com_Printf ("USAGE: loadgame <directory>\n");
+		Com_Printf ("USAGE: load <directory>\n");
 		return;
 	}
 
-	Com_Printf ("Loading game...\n");
-
 	dir = Cmd_Argv(1);
 	if (strstr (dir, "..") || strstr (dir, "/") || strstr (dir, "\\") )
 	{
 		Com_Printf ("Bad savedir.\n");
-	}
-
-	// make sure the server.ssv file exists
-	Com_sprintf (name, sizeof(name), "%s/save/%s/server.ssv", FS_Gamedir(), Cmd_Argv(1));
-	f = fopen (name, "rb");
-	if (!f)
-	{
-		Com_Printf ("No such savegame: %s\n", name);
 		return;
 	}
-	fclose (f);
 
-	SV_CopySaveGame (Cmd_Argv(1), "current");
+	Com_Printf ("Loading game...\n");
+
+	// sets the cvars it was saved with and keeps the snapshot for SV_SpawnServer
+	if (!SV_ReadSnapshot (dir, mapname, sizeof(mapname)))
+		return;
 
-	SV_ReadServerFile ();
+	// start a new game fresh with new cvars
+	SV_InitGame ();
 
 	// go to the map
 	sv.state = ss_dead;		// don't save current level when changing
-	SV_Map (false, svs.mapcmd, true, false, false);
-#endif
+	SV_Map (false, mapname, true, false, false);
 }
 
-
-
 /*
 ==============
 SV_Savegame_f
@@ -711,7 +822,7 @@ void SV_Savegame_f (void)
 
 	if (Cmd_Argc() != 2)
 	{
-		Com_Printf ("USAGE: savegame <directory>\n");
+		Com_Printf ("USAGE: save <directory>\n");
 		return;
 	}
 
@@ -737,22 +848,13 @@ void SV_Savegame_f (void)
 	if (strstr (dir, "..") || strstr (dir, "/") || strstr (dir, "\\") )
 	{
 		Com_Printf ("Bad savedir.\n");
+		return;
 	}
 
-	Com_Printf ("Saving game...\n");
-
 	// archive current level, including all client edicts.
 	// when the level is reloaded, they will be shells awaiting
 	// a connecting client
-	SV_WriteLevelFile ();
-
-	// save server state
-//	SV_WriteServerFile (false);
-
-	// copy it off
-//	SV_CopySaveGame ("current", dir);
-
-	Com_Printf ("Done.\n");
+	SV_WriteSnapshot (dir);
 }
 
 //===============================================================
@@ -1111,6 +1213,9 @@ void SV_InitOperatorCommands (void)
 	Cmd_AddCommand ("setmaster", SV_SetMaster_f);
 
 	Cmd_AddCommand("sv_modellist", SV_ModelList_f);
+	Cmd_AddCommand("sv_tagbench", SV_TagBench_f);
+	Cmd_AddCommand("svbench", SV_Bench_f);
+	Cmd_AddCommand("svbench_record", SV_BenchRecord_f);
 
 	if ( dedicated->value )
 		Cmd_AddCommand ("say", SV_ConSay_f);
@@ -1118,8 +1223,8 @@ void SV_InitOperatorCommands (void)
 	Cmd_AddCommand ("serverrecord", SV_ServerRecord_f);
 	Cmd_AddCommand ("serverstop", SV_ServerStop_f);
 
-//	Cmd_AddCommand ("save", SV_Savegame_f);
-//	Cmd_AddCommand ("load", SV_Loadgame_f);
+	Cmd_AddCommand ("save", SV_Savegame_f);
+	Cmd_AddCommand ("load", SV_Loadgame_f);
 
 	Cmd_AddCommand ("killserver", SV_KillServer_f);
 }
@@ -90,6 +90,25 @@ struct gclient_s
 #define ENTITYNUM_NULL -1
 #define ENTITYNUM_WORLD 0
 
+// world space tags resolved on an entity, kept until its origin, angles,
+// model or frame change so repeated tag queries in a frame skip the math
+#define	TAGCACHE_SLOTS		4
+
+typedef struct
+{
+	qboolean		valid;
+	int				spawncount;				// svs.spawncount the cache was filled in
+	vec3_t			origin;
+	vec3_t			angles;
+	int				modelindex;
+	int				frame;
+	vec3_t			axis[3];				// AnglesToAxis(angles)
+
+	int				tagIds[TAGCACHE_SLOTS];	// 0 if the slot is empty
+	orientation_t	tags[TAGCACHE_SLOTS];
+	int				nextslot;				// round robin replacement
+} tagcache_t;
+
 struct gentity_s
 {
 	entity_state_t		s;
@@ -112,6 +131,12 @@ struct gentity_s
 	gentity_t	*teamchain;
 	gentity_t	*teammaster;
 
+	tagcache_t	tagcache;
+
+	// resting toss and step entities skip physics, see SV_CheckSleep
+	qboolean	asleep;
+	int			restframes;			// frames in a row it could have slept
+
 	sv_entvars_t	v;
 };
 
@@ -42,6 +42,8 @@ void SV_InitEntity(gentity_t* ent)
 
 	ent->teamchain = ent->teammaster = NULL;
 	ent->bEntityStateForClientChanged = false;
+
+	SV_WakeEntity(ent);
 }
 
 /*
@@ -166,7 +168,9 @@ qboolean SV_RunThink(gentity_t* ent)
 	if (thinktime > sv.gameTime + 0.001)
 		return true;
 
+	PROF_BEGIN("think");
 	Scr_Think(ent);
+	PROF_END();
 
 	return false;
 }
@@ -355,6 +355,7 @@ void SV_SpawnServer (char *server, char *spawnpoint, server_state_t serverstate,
 	int			i;
 	unsigned	checksum_map, checksum_cgprogs;
 	gentity_t	*ent;
+	qboolean	restored;
 
 	if (attractloop)
 		Cvar_Set ("paused", "0");
@@ -372,9 +373,11 @@ void SV_SpawnServer (char *server, char *spawnpoint, server_state_t serverstate,
 	//
 	// clean memory and wipe the entire per-level structure
 	//
+	SV_ShutdownSweep();		// its buffers go with the level
 	Z_FreeTags(TAG_SERVER_GAME);
 	Z_FreeTags(TAG_SERVER_MODELDATA);
 	memset (&sv, 0, sizeof(sv));
+	SV_ClearAssetIndex();
 
 	svs.realtime = 0;
 	sv.loadgame = loadgame;
@@ -486,23 +489,31 @@ void SV_SpawnServer (char *server, char *spawnpoint, server_state_t serverstate,
 	Cvar_FullSet("gamename", "pragma", CVAR_SERVERINFO | CVAR_LATCH, NULL);
 	Cvar_FullSet("gamedate", __DATE__, CVAR_SERVERINFO | CVAR_NOSET, NULL);
 
-	// load and spawn all other entities
-	SV_SpawnEntities( sv.name, CM_EntityString(), spawnpoint );
+	// a savegame brings its own entities, pathnodes and configstrings, it must not run spawn functions
+	restored = loadgame && SV_RestoreSnapshot();
 
-	// call the main function in server progs
-	SV_ScriptMain();
+	if (!restored)
+	{
+		// load and spawn all other entities
+		SV_SpawnEntities( sv.name, CM_EntityString(), spawnpoint );
 
+		// call the main function in server progs
+		SV_ScriptMain();
+	}
 
 	Com_sprintf(sv.configstrings[CS_CHEATS_ENABLED], sizeof(sv.configstrings[CS_CHEATS_ENABLED]), "%i", (int)sv_cheats->value);
 
-	// give it a frame so the entities can spawn and drop to floor
-	SV_RunWorldFrame();
+	if (!restored)
+	{
+		// give it a frame so the entities can spawn and drop to floor
+		SV_RunWorldFrame();
 
-	// link pathnodes
-	SV_LinkAllPathNodes(); 
+		// link pathnodes
+		SV_LinkAllPathNodes(); 
 
-	// one more frame to settle everything
-	SV_RunWorldFrame();
+		// one more frame to settle everything
+		SV_RunWorldFrame();
+	}
 
 	// all precaches are complete
 	SV_SetWorldEntityFields();
@@ -20,6 +20,40 @@ static void SV_LoadSP2(svmodel_t* out, void* buffer);
 static svmodel_t* SV_LoadModel(char* name, qboolean crash);
 static qboolean SV_FileExists(char* name, qboolean crash);
 static int SV_FindOrCreateAssetIndex(char* name, int start, int max, const char* func);
+
+//
+// name indexes over the asset configstrings and sv.models, filled in
+// lazily from whatever is in them when a lookup misses
+//
+typedef struct
+{
+	nameindex_t	names;
+	int			count;		// slots indexed so far
+} svassetindex_t;
+
+static svassetindex_t	sv_assetindex[3];	// models, sounds, images configstrings
+static svassetindex_t	sv_modelindex;		// sv.models
+
+/*
+================
+SV_ClearAssetIndex
+
+Must be called when asset configstrings or models are changed in place
+================
+*/
+void SV_ClearAssetIndex(void)
+{
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		NameIndex_Clear(&sv_assetindex[i].names);
+		sv_assetindex[i].count = 0;
+	}
+	NameIndex_Clear(&sv_modelindex.names);
+	sv_modelindex.count = 0;
+}
+
 /*
 ================
 SV_ModelIndex
@@ -84,15 +118,28 @@ Returns svmodel
 svmodel_t* SV_ModelForName(char *name)
 {
 	svmodel_t* model;
-	model = &sv.models[0];
-	for (int i = 0; i < sv.num_models; i++, model++)
+	int i;
+
+	i = NameIndex_Find(&sv_modelindex.names, name);
+	if (i < 0)
 	{
-		if (!model->name[0] || model->type == MOD_BAD)
-			continue;
-		if (!strcmp(model->name, name))
-			return model;
+		// index the models added since the last miss
+		for (i = sv_modelindex.count; i < sv.num_models; i++)
+		{
+			if (sv.models[i].name[0])
+				NameIndex_Add(&sv_modelindex.names, sv.models[i].name, i);
+		}
+		sv_modelindex.count = sv.num_models;
+
+		i = NameIndex_Find(&sv_modelindex.names, name);
+		if (i < 0)
+			return NULL;
 	}
-	return NULL;
+
+	model = &sv.models[i];
+	if (model->type == MOD_BAD)
+		return NULL;
+	return model;
 }
 
 /*
@@ -105,17 +152,34 @@ Used to load or find server assets (currently only loads only th important MD3 i
 static int SV_FindOrCreateAssetIndex(char* name, int start, int max, const char* func)
 {
 	static char fullname[MAX_QPATH];
+	svassetindex_t	*assets;
 	int		index;
 
 	if (!name || !name[0])
 		return 0;
 
+	if (start == CS_MODELS)
+		assets = &sv_assetindex[0];
+	else if (start == CS_SOUNDS)
+		assets = &sv_assetindex[1];
+	else
+		assets = &sv_assetindex[2];
+
 	//
 	//  return early if asset has been indexed
 	//
-	for (index = 1; index < max && sv.configstrings[start + index][0]; index++)
+	index = NameIndex_Find(&assets->names, name);
+	if (index > 0)
+		return index;
+
+	// configstrings can be set without coming through here
+	for (index = assets->count + 1; index < max && sv.configstrings[start + index][0]; index++)
+	{
+		NameIndex_Add(&assets->names, sv.configstrings[start + index], index);
+		assets->count = index;
 		if (!strcmp(sv.configstrings[start + index], name))
 			return index;
+	}
 
 	//
 	// load asset
@@ -155,6 +219,8 @@ static int SV_FindOrCreateAssetIndex(char* name, int start, int max, const char*
 	// update configstring
 
 	strncpy(sv.configstrings[start + index], name, sizeof(sv.configstrings[index]));
+	NameIndex_Add(&assets->names, sv.configstrings[start + index], index);
+	assets->count = index;
 
 	if (sv.state != ss_loading)
 	{	// send the update to everyone
@@ -255,7 +321,7 @@ static svmodel_t* SV_LoadModel(char* name, qboolean crash)
 {
 	svmodel_t	*model;
 	unsigned	*buf;
-	int			fileLen, i;
+	int			fileLen;
 
 	crash = false;
 	if (!name[0])
@@ -273,13 +339,9 @@ static svmodel_t* SV_LoadModel(char* name, qboolean crash)
 
 	// search the currently loaded models
 	// if were coming from *Index its been already searched but be paranoid!
-	for (i = 0, model = &sv.models[MODELINDEX_WORLD]; i < MAX_MODELS; i++, model++)
-	{
-		if (!model->name[0])
-			continue;
-		if (!strcmp(model->name, name))
-			return model;
-	}
+	model = SV_ModelForName(name);
+	if (model)
+		return model;
 
 	// find a free model slot spot
 //	for (i = 0, model = &sv.models[MODELINDEX_WORLD]; i < MAX_MODELS; i++, model++)
@@ -394,6 +456,8 @@ static void SV_LoadMD3(svmodel_t* out, void* buffer)
 			// lowercase the tag name so search compares are faster
 			_strlwr(tag->name);
 			memcpy(out->tagNames[i], tag->name, sizeof(tag->name));
+			out->tagNames[i][MD3_MAX_NAME - 1] = 0;
+			out->tagIds[i] = SV_InternName(out->tagNames[i]);
 		}
 
 		// copy tags
@@ -446,6 +510,8 @@ static void SV_LoadMD3(svmodel_t* out, void* buffer)
 		}
 
 		memcpy(out->surfNames[i], surf->name, sizeof(surf->name));
+		out->surfNames[i][MD3_MAX_NAME - 1] = 0;
+		out->surfIds[i] = SV_InternName(out->surfNames[i]);
 
 		// find the next surface
 		surf = (md3Surface_t*)((byte*)surf + surf->ofsEnd);
@@ -484,6 +550,51 @@ static void SV_LoadSP2(svmodel_t* out, void* buffer)
 
 
 
+/*
+=================
+SV_InternName
+
+Returns the id of a tag or surface name, adding it to the table if it isn't
+there yet. Ids start at 1 and are only valid for the current level, 0 is
+returned for names too long to belong to any md3.
+=================
+*/
+int SV_InternName(const char* name)
+{
+	int slot;
+
+	if (strlen(name) >= MD3_MAX_NAME)
+		return 0;
+
+	slot = NameIndex_Find(&sv.internedIndex, name);
+	if (slot != -1)
+		return slot + 1;
+
+	if (sv.num_internedNames == NAMEINDEX_MAX)
+	{
+		Com_Error(ERR_DROP, "SV_InternName: more than %i tag and surface names\n", NAMEINDEX_MAX);
+		return 0;
+	}
+
+	slot = sv.num_internedNames++;
+	strcpy(sv.internedNames[slot], name);
+	NameIndex_Add(&sv.internedIndex, sv.internedNames[slot], slot);
+	return slot + 1;
+}
+
+/*
+=================
+SV_NameIdForString
+
+Returns the id of an already interned name or 0 if no model uses it
+=================
+*/
+int SV_NameIdForString(const char* name)
+{
+	return NameIndex_Find(&sv.internedIndex, name) + 1;
+}
+
+
 /*
 =================
 SV_ModelSurfIndexForName
@@ -492,7 +603,8 @@ SV_ModelSurfIndexForName
 int SV_ModelSurfIndexForName(int modelindex, char* surfaceName)
 {
 	svmodel_t* mod;
-	int index;
+	char lowername[MD3_MAX_NAME];
+	int index, id;
 
 	mod = SV_ModelForNum(modelindex);
 	if (!mod || mod->type != MOD_MD3)
@@ -500,9 +612,19 @@ int SV_ModelSurfIndexForName(int modelindex, char* surfaceName)
 		return -1;
 	}
 
+	// surface names are lowercased at load
+	if (strlen(surfaceName) >= MD3_MAX_NAME)
+		return -1;
+	strcpy(lowername, surfaceName);
+	_strlwr(lowername);
+
+	id = SV_NameIdForString(lowername);
+	if (!id)
+		return -1;
+
 	for (index = 0; index < mod->numSurfaces; index++)
 	{
-		if (!Q_stricmp(mod->surfNames[index], surfaceName))
+		if (mod->surfIds[index] == id)
 		{
 			return index;
 		}
@@ -511,6 +633,31 @@ int SV_ModelSurfIndexForName(int modelindex, char* surfaceName)
 }
 
 
+/*
+=================
+SV_TagIndexForId
+
+returns index of a tag or -1 if not found
+=================
+*/
+int SV_TagIndexForId(svmodel_t* mod, int tagId)
+{
+	int index;
+
+	if (!tagId)
+		return -1;
+
+	for (index = 0; index < mod->numTags; index++)
+	{
+		if (mod->tagIds[index] == tagId)
+		{
+			return index; // found it
+		}
+	}
+	return -1;
+}
+
+
 /*
 =================
 SV_TagIndexForName
@@ -521,9 +668,6 @@ returns index of a tag or -1 if not found
 int SV_TagIndexForName(int modelindex, char* tagName)
 {
 	svmodel_t* mod;
-	orientation_t* tagdata;
-	int index;
-	int frame = 0;
 
 	mod = SV_ModelForNum(modelindex);
 	if (!mod || mod->type != MOD_MD3)
@@ -532,28 +676,19 @@ int SV_TagIndexForName(int modelindex, char* tagName)
 		return -1; //doesn't get here
 	}
 
-	tagdata = (orientation_t*)((byte*)mod->tagFrames) + (frame * mod->numTags);
-	for (index = 0; index < mod->numTags; index++, tagdata++)
-	{
-		if (!strcmp(mod->tagNames[index], tagName))
-		{
-			return index; // found it
-		}
-	}
-	return -1;
+	return SV_TagIndexForId(mod, SV_NameIdForString(tagName));
 }
 
 /*
 =================
-SV_GetTag
+SV_GetTagForId
 
 returns orientation_t of a tag for a given frame or NULL if not found
 =================
 */
-orientation_t* SV_GetTag(int modelindex, int frame, char* tagName)
+orientation_t* SV_GetTagForId(int modelindex, int frame, int tagId)
 {
 	svmodel_t* mod;
-	orientation_t* tagdata;
 	int index;
 
 	mod = SV_ModelForNum(modelindex);
@@ -563,21 +698,29 @@ orientation_t* SV_GetTag(int modelindex, int frame, char* tagName)
 		return NULL;
 	}
 
+	index = SV_TagIndexForId(mod, tagId);
+	if (index == -1)
+		return NULL;
+
 	// it is possible to have a bad frame while changing models, so don't error
 	if (frame >= mod->numFrames)
 		frame = mod->numFrames - 1;
 	else if (frame < 0)
 		frame = 0;
 
-	tagdata = (orientation_t*)((byte*)mod->tagFrames) + (frame * mod->numTags);
-	for (index = 0; index < mod->numTags; index++, tagdata++)
-	{
-		if (!strcmp(mod->tagNames[index], tagName))
-		{
-			return tagdata; // found it
-		}
-	}
-	return NULL;
+	return mod->tagFrames + (frame * mod->numTags) + index;
+}
+
+/*
+=================
+SV_GetTag
+
+returns orientation_t of a tag for a given frame or NULL if not found
+=================
+*/
+orientation_t* SV_GetTag(int modelindex, int frame, char* tagName)
+{
+	return SV_GetTagForId(modelindex, frame, SV_NameIdForString(tagName));
 }
 
 /*
@@ -624,41 +767,97 @@ void AngleVectors2(const vec3_t angles, vec3_t forward, vec3_t right, vec3_t up)
 }
 
 
+/*
+=================
+SV_TransformTag
+
+moves tag into the space of parent placed at origin with axis
+=================
+*/
+static void SV_TransformTag(orientation_t* tag, vec3_t origin, vec3_t axis[3], orientation_t* result)
+{
+	int i;
+
+	VectorCopy(origin, result->origin);
+	for (i = 0; i < 3; i++)
+	{
+		VectorMA(result->origin, tag->origin[i], axis[i], result->origin);
+	}
+
+	// translate rotation
+	MatrixMultiply(tag->axis, axis, result->axis);
+}
+
 orientation_t out;
 orientation_t* SV_PositionTag(vec3_t origin, vec3_t angles, int modelindex, int animframe, char* tagName)
 {
 	orientation_t	*tag;
-	orientation_t    parent;
-	vec3_t			tempAxis[3];
+	vec3_t			axis[3];
 
 	tag = SV_GetTag(modelindex, animframe, tagName);
 	if (!tag)
 		return NULL;
 
-	AxisClear(parent.axis);
-	VectorCopy(origin, parent.origin);
-	AnglesToAxis(angles, parent.axis);
+	AnglesToAxis(angles, axis);
+	SV_TransformTag(tag, origin, axis, &out);
+	return &out;
+}
+
 
-	AxisClear(out.axis);
-	VectorCopy(parent.origin, out.origin);
+/*
+=================
+SV_PositionTagOnEntityForId
 
-//	AngleVectors2(angles, out.axis[0], out.axis[1], out.axis[2]);
-//	AnglesToAxis(angles, out.axis);
+Same as SV_PositionTag but for entity's current placement, results are cached
+on the entity until its origin, angles, modelindex or animFrame change.
+The returned pointer is valid until the next tag query on this entity.
+=================
+*/
+orientation_t* SV_PositionTagOnEntityForId(gentity_t* ent, int tagId)
+{
+	tagcache_t		*cache = &ent->tagcache;
+	orientation_t	*tag;
+	int				modelindex, frame, slot;
 
-	AxisClear(tempAxis);
+	modelindex = (int)ent->v.modelindex;
+	frame = (int)ent->v.animFrame;
 
-	for (int i = 0; i < 3; i++)
+	if (!cache->valid || cache->spawncount != svs.spawncount || cache->modelindex != modelindex || cache->frame != frame
+		|| !VectorCompare(cache->origin, ent->v.origin) || !VectorCompare(cache->angles, ent->v.angles))
 	{
-		VectorMA(out.origin, tag->origin[i], parent.axis[i], out.origin);
+		tag = SV_GetTagForId(modelindex, frame, tagId); // validates model
+		if (!tag)
+			return NULL;
+
+		cache->valid = true;
+		cache->spawncount = svs.spawncount;
+		cache->modelindex = modelindex;
+		cache->frame = frame;
+		VectorCopy(ent->v.origin, cache->origin);
+		VectorCopy(ent->v.angles, cache->angles);
+		AnglesToAxis(ent->v.angles, cache->axis);
+		memset(cache->tagIds, 0, sizeof(cache->tagIds));
+		cache->nextslot = 0;
 	}
+	else
+	{
+		for (slot = 0; slot < TAGCACHE_SLOTS; slot++)
+		{
+			if (tagId && cache->tagIds[slot] == tagId)
+				return &cache->tags[slot];
+		}
 
-	// translate origin
-//	MatrixMultiply(tag->axis, parent.axis, out.axis); 
+		tag = SV_GetTagForId(modelindex, frame, tagId);
+		if (!tag)
+			return NULL;
+	}
 
-	// translate rotation and origin
-	MatrixMultiply(out.axis, parent.axis, tempAxis);
-	MatrixMultiply(tag->axis, tempAxis, out.axis);
-	return &out;
+	slot = cache->nextslot;
+	cache->nextslot = (slot + 1) % TAGCACHE_SLOTS;
+
+	SV_TransformTag(tag, cache->origin, cache->axis, &cache->tags[slot]);
+	cache->tagIds[slot] = tagId;
+	return &cache->tags[slot];
 }
 
 
@@ -669,7 +868,5 @@ SV_PositionTagOnEntity
 */
 orientation_t* SV_PositionTagOnEntity(gentity_t* ent, char* tagName)
 {
-	orientation_t* tag;
-	tag = SV_PositionTag(ent->v.origin, ent->v.angles, (int)ent->v.modelindex, (int)ent->v.animFrame, tagName);
-	return tag;
-}
\ No newline at end of file
+	return SV_PositionTagOnEntityForId(ent, SV_NameIdForString(tagName));
+}
@@ -28,8 +28,11 @@ cvar_t	*allow_download;
 cvar_t *allow_download_models;
 cvar_t *allow_download_sounds;
 cvar_t *allow_download_maps;
+cvar_t	*sv_download_window;
+cvar_t	*sv_download_rate;
 
 cvar_t	*sv_noreload;			// don't reload level state when reentering
+cvar_t	*sv_savekeyframes;
 
 cvar_t	*sv_password;
 cvar_t	*sv_maxclients;	
@@ -71,6 +74,7 @@ void ShowServerStats(int x, int y)
 	UI_DrawString(x, y + 10 * 2, XALIGN_RIGHT, va("server: frame %i time %i", sv.framenum, sv.time));
 	UI_DrawString(x, y + 10 * 3, XALIGN_RIGHT, va("game: frame %i time %f", sv.gameFrame, sv.gameTime));
 	UI_DrawString(x, y + 10 * 5, XALIGN_RIGHT, va("entities: %i/%i", sv.num_edicts, sv.max_edicts));
+	UI_DrawString(x, y + 10 * 6, XALIGN_RIGHT, va("physics: %i awake %i asleep %i swept", sv.numAwake, sv.numAsleep, sv.numSwept));
 
 	UI_DrawString(x, y + 10 * 7, XALIGN_RIGHT, va("server %i ms", time_between - time_before));
 	UI_DrawString(x, y + 10 * 8, XALIGN_RIGHT, va("progs %i ms", time_after_game - time_before_game));
@@ -113,11 +117,7 @@ void SV_DropClient (client_t *drop)
 		Scr_ClientDisconnect(drop->edict);
 	}
 
-	if (drop->download)
-	{
-		FS_FreeFile (drop->download);
-		drop->download = NULL;
-	}
+	SV_FreeDownload (drop);
 
 	drop->state = cs_zombie;		// become free in a few seconds
 	drop->name[0] = 0;
@@ -792,6 +792,8 @@ void SV_SetConfigString(int index, char *valueString)
 
 	// change the string in sv
 	strncpy(sv.configstrings[index], valueString, sizeof(sv.configstrings[index]));
+	if (index >= CS_MODELS && index < CS_LIGHTS)
+		SV_ClearAssetIndex();
 
 	if (sv.state != ss_loading)
 	{
@@ -857,7 +859,10 @@ void SV_Frame (int msec)
 	
 	rand();				// keep the random time dependent, WHY SO OFTEN?
 	SV_CheckTimeouts();	// check timeouts
+	PROF_BEGIN("SV_ReadPackets");
 	SV_ReadPackets();	// get packets from clients
+	PROF_END();
+	SV_SendDownloads();	// windowed downloads don't wait for game frames
 
 	// move autonomous things around if enough time has passed
 	if (!sv_timedemo->value && svs.realtime < sv.time)
@@ -878,7 +883,9 @@ void SV_Frame (int msec)
 	SV_CalcPings();				// update ping based on the last known frame from all clients
 	SV_GiveMsec();				// give the clients some timeslices
 	SV_RunGameFrame();			// let everything in the world think and move
+	PROF_BEGIN("SV_SendClientMessages");
 	SV_SendClientMessages();	// send messages back to the clients that had packets read this frame
+	PROF_END();
 	SV_RecordDemoMessage();		// save the entire world state if recording a serverdemo
 	Master_Heartbeat();			// send a heartbeat to the master if needed
 	SV_PrepWorldFrame();		// clear teleport flags, etc for next frame
@@ -1037,6 +1044,8 @@ void SV_Init (void)
 	sv_maxentities = Cvar_Get("sv_maxentities", va("%i", MAX_GENTITIES), CVAR_LATCH, "Maximum number of server entities. Better don't change.");
 	sv_maxvelocity = Cvar_Get("sv_maxevelocity", "1500", 0, "Maximum velocity of an entities (excluding players).");
 	sv_gravity = Cvar_Get("sv_gravity", "800", 0, "Gravity (default 800).");
+	sv_sleep = Cvar_Get("sv_sleep", "1", 0, "Resting toss, bounce and step entities skip physics until something disturbs them.");
+	SV_InitSweep();
 
 	sv_hostname = Cvar_Get ("hostname", "pragma server", CVAR_SERVERINFO | CVAR_ARCHIVE, "This is the server's name.");
 
@@ -1052,8 +1061,11 @@ void SV_Init (void)
 	allow_download_models = Cvar_Get ("allow_download_models", "1", CVAR_ARCHIVE, "Allow downloading models.");
 	allow_download_sounds = Cvar_Get ("allow_download_sounds", "1", CVAR_ARCHIVE, "Allow downloading sounds.");
 	allow_download_maps	  = Cvar_Get ("allow_download_maps", "1", CVAR_ARCHIVE, "Allow downloading maps.");
+	sv_download_window = Cvar_Get ("sv_download_window", "16", 0, "Number of download fragments in flight for windowed downloads (1-32).");
+	sv_download_rate = Cvar_Get ("sv_download_rate", "131072", 0, "Maximum bytes per second sent to each client for windowed downloads.");
 
 	sv_noreload = Cvar_Get ("sv_noreload", "1", 0, NULL);
+	sv_savekeyframes = Cvar_Get ("sv_savekeyframes", "8", 0, "Number of incremental saves into a savegame slot before a full one is written again.");
 
 	public_server = Cvar_Get ("public", "1", 0, "Set to 0 if you don't want server to be visible in server browser (no worky atm sowwy).");
 
@@ -1091,11 +1103,11 @@ void SV_FinalMessage (char *message, qboolean reconnect)
 	// stagger the packets to crutch operating system limited buffers
 
 	for (i=0, cl = svs.clients ; i<sv_maxclients->value ; i++, cl++)
-		if (cl->state >= cs_connected)
+		if (cl->state >= cs_connected && !cl->bot)
 			Netchan_Transmit (&cl->netchan, net_message.cursize, net_message.data);
 
 	for (i=0, cl = svs.clients ; i<sv_maxclients->value ; i++, cl++)
-		if (cl->state >= cs_connected)
+		if (cl->state >= cs_connected && !cl->bot)
 			Netchan_Transmit (&cl->netchan, net_message.cursize, net_message.data);
 }
 
@@ -1119,6 +1131,9 @@ void SV_Shutdown (char *finalmsg, qboolean reconnect)
 
 	Master_Shutdown ();
 
+	sv_bench.active = false;
+	SV_ShutdownSweep();
+
 	// free current level
 	if (sv.demofile)
 		fclose (sv.demofile);
@@ -1133,6 +1148,7 @@ void SV_Shutdown (char *finalmsg, qboolean reconnect)
 	Z_FreeTags(TAG_SERVER_GAME);
 	Z_FreeTags(TAG_SERVER_MODELDATA);
 	memset (&sv, 0, sizeof(sv));
+	SV_ClearAssetIndex();
 	 
 	Nav_Shutdown();
 
@@ -12,6 +12,7 @@ See the attached GNU General Public License v2 for more details.
 
 cvar_t* sv_maxvelocity;
 cvar_t* sv_gravity;
+cvar_t* sv_sleep;
 
 //FIXME: hacked in for E3 demo for 25 years
 #define	sv_stopspeed		100
@@ -385,7 +386,8 @@ retry:
 	else
 		mask = MASK_SOLID;
 
-	trace = SV_Trace(start, ent->v.mins, ent->v.maxs, end, ent, mask);
+	if (!SV_SweptTrace(ent, start, end, mask, &trace))
+		trace = SV_Trace(start, ent->v.mins, ent->v.maxs, end, ent, mask);
 
 	VectorCopy(trace.endpos, ent->v.origin);
 	SV_LinkEdict(ent);
@@ -422,6 +424,101 @@ typedef struct // FIME: find a better place for this?
 static pushed_t pushed[MAX_GENTITIES], *pushed_p;
 static gentity_t* obstacle;
 
+// entities standing on each entity, from the ground links at the start of the frame
+static int	push_firstRider[MAX_GENTITIES];
+static int	push_nextRider[MAX_GENTITIES];
+
+static gentity_t*	push_touch[MAX_GENTITIES];
+static int	push_checks[MAX_GENTITIES];
+static int	push_marks[MAX_GENTITIES], push_markCount;
+
+/*
+============
+SV_LinkRiders
+Collects everything that stands on something into a list for each ground entity,
+so a pusher doesn't have to look at every entity to find its riders
+============
+*/
+void SV_LinkRiders(void)
+{
+	gentity_t* ent;
+	int			e, ground;
+
+	memset(push_firstRider, 0, sizeof(push_firstRider[0]) * sv.max_edicts);
+
+	for (e = sv.max_edicts - 1; e > 0; e--)
+	{
+		ent = EDICT_NUM(e);
+		if (!ent->inuse)
+			continue;
+
+		ground = (int)ent->v.groundentity_num;
+		if (ground <= 0 || ground >= sv.max_edicts)
+			continue;
+
+		push_nextRider[e] = push_firstRider[ground];
+		push_firstRider[ground] = e;
+	}
+}
+
+/*
+============
+SV_CompareEntityNums
+============
+*/
+static int SV_CompareEntityNums(const void* a, const void* b)
+{
+	return *(const int*)a - *(const int*)b;
+}
+
+/*
+============
+SV_PushCandidates
+Everything linked in the area the pusher covers before and after the move and
+everything that stood on it when the frame started, in entity number order.
+Entities that start standing on the pusher during the frame do so next to it,
+so the area takes care of them.
+============
+*/
+static int SV_PushCandidates(gentity_t* pusher, vec3_t mins, vec3_t maxs)
+{
+	vec3_t		areamins, areamaxs;
+	int			i, e, num, count;
+
+	if (++push_markCount <= 0)
+	{
+		memset(push_marks, 0, sizeof(push_marks));
+		push_markCount = 1;
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		areamins[i] = min(pusher->v.absmin[i], mins[i]);
+		areamaxs[i] = max(pusher->v.absmax[i], maxs[i]);
+	}
+
+	count = 0;
+	num = SV_AreaLinked(areamins, areamaxs, push_touch, MAX_GENTITIES);
+	for (i = 0; i < num; i++)
+	{
+		e = NUM_FOR_ENT(push_touch[i]);
+		push_marks[e] = push_markCount;
+		push_checks[count++] = e;
+	}
+
+	for (e = push_firstRider[NUM_FOR_ENT(pusher)]; e; e = push_nextRider[e])
+	{
+		if (push_marks[e] != push_markCount)
+		{
+			push_marks[e] = push_markCount;
+			push_checks[count++] = e;
+		}
+	}
+
+	qsort(push_checks, count, sizeof(push_checks[0]), SV_CompareEntityNums);
+	return count;
+}
+
 /*
 ============
 SV_Push
@@ -431,7 +528,7 @@ otherwise riders would continue to slide.
 */
 qboolean SV_Push(gentity_t* pusher, vec3_t move, vec3_t amove)
 {
-	int			i, e;
+	int			i, c, numchecks;
 	gentity_t* check, * block;
 	vec3_t		mins, maxs;
 	pushed_t* p;
@@ -462,6 +559,14 @@ qboolean SV_Push(gentity_t* pusher, vec3_t move, vec3_t amove)
 	VectorSubtract(vec3_origin, amove, org);
 	AngleVectors(org, forward, right, up);
 
+	// everything that may be in the way or riding, gathered before the pusher moves
+	numchecks = SV_PushCandidates(pusher, mins, maxs);
+	if (sv_bench.active)
+	{
+		sv_bench.pushes++;
+		sv_bench.pushChecks += numchecks;
+	}
+
 	// save the pusher's original position
 	pushed_p->ent = pusher;
 	VectorCopy(pusher->v.origin, pushed_p->origin);
@@ -478,9 +583,9 @@ qboolean SV_Push(gentity_t* pusher, vec3_t move, vec3_t amove)
 	SV_LinkEdict(pusher);
 
 	// see if any solid entities are inside the final position
-	for (e = 1; e < sv.max_edicts; e++) //sv.num_edicts
+	for (c = 0; c < numchecks; c++)
 	{
-		check = EDICT_NUM(e);
+		check = EDICT_NUM(push_checks[c]);
 
 		if (!check->inuse)
 			continue;
@@ -697,11 +802,11 @@ TOSS / BOUNCE
 
 /*
 =============
-SV_Physics_Toss
+SV_TossMove
 Toss, bounce, and fly movement. When onground, do nothing.
 =============
 */
-void SV_Physics_Toss(gentity_t* ent)
+static void SV_TossMove(gentity_t* ent)
 {
 	trace_t		trace;
 	vec3_t		move;
@@ -711,11 +816,6 @@ void SV_Physics_Toss(gentity_t* ent)
 	qboolean	isinwater;
 	vec3_t		old_origin;
 
-	// regular thinking
-	SV_RunThink(ent);
-	if (!ent->inuse)
-		return; // could have deleted itself in think
-
 	// if not a team captain, so movement will be handled elsewhere
 	if ((int)ent->v.flags & FL_TEAMSLAVE)
 		return;
@@ -802,6 +902,21 @@ void SV_Physics_Toss(gentity_t* ent)
 	}
 }
 
+/*
+=============
+SV_Physics_Toss
+=============
+*/
+void SV_Physics_Toss(gentity_t* ent)
+{
+	// regular thinking
+	SV_RunThink(ent);
+	if (!ent->inuse)
+		return; // could have deleted itself in think
+
+	SV_TossMove(ent);
+}
+
 /*
 ===============================================================================
 STEPPING MOVEMENT
@@ -949,9 +1064,135 @@ void SV_Physics_Step(gentity_t* ent)
 	SV_RunThink(ent);
 }
 
+/*
+===============================================================================
+SLEEPING
+===============================================================================
+*/
+
+#define	SV_SLEEP_VELOCITY	1.0f	// slower than this counts as at rest
+#define	SV_SLEEP_FRAMES		4		// frames at rest before physics stop running
+
+/*
+=============
+SV_CanSleep
+
+Only things that fall and come to rest, on ground that isn't moving
+=============
+*/
+static qboolean SV_CanSleep(gentity_t* ent)
+{
+	gentity_t* ground;
+	int		movetype;
+
+	movetype = (int)ent->v.movetype;
+	if (movetype != MOVETYPE_TOSS && movetype != MOVETYPE_BOUNCE && movetype != MOVETYPE_STEP)
+		return false;
+	if (((int)ent->v.flags & (FL_TEAMSLAVE | FL_FLY | FL_SWIM)) || ent->teamchain)
+		return false;
+	if (DotProduct(ent->v.velocity, ent->v.velocity) > SV_SLEEP_VELOCITY * SV_SLEEP_VELOCITY)
+		return false;
+	if (ent->v.avelocity[0] || ent->v.avelocity[1] || ent->v.avelocity[2])
+		return false;
+
+	if ((int)ent->v.groundentity_num == ENTITYNUM_NULL)
+		return false;
+	ground = EDICT_NUM((int)ent->v.groundentity_num);
+	if (!ground->inuse || ground->v.linkcount != (int)ent->v.groundentity_linkcount)
+		return false;
+	if (ground->v.velocity[0] || ground->v.velocity[1] || ground->v.velocity[2])
+		return false;
+	if (ground->v.avelocity[0] || ground->v.avelocity[1] || ground->v.avelocity[2])
+		return false;
+
+	return true;
+}
+
+/*
+=============
+SV_CheckSleep
+
+Called after physics, puts the entity to sleep once it has been at rest for a few frames
+=============
+*/
+void SV_CheckSleep(gentity_t* ent)
+{
+	if (!sv_sleep->value || !SV_CanSleep(ent))
+	{
+		ent->restframes = 0;
+		return;
+	}
+
+	if (++ent->restframes < SV_SLEEP_FRAMES)
+		return;
+
+	VectorClear(ent->v.velocity);
+	ent->asleep = true;
+}
+
+/*
+=============
+SV_StaysAsleep
+
+Anything progs did to a sleeping entity wakes it, so does its ground moving.
+Links and touches wake it where they happen.
+=============
+*/
+qboolean SV_StaysAsleep(gentity_t* ent)
+{
+	if (sv_sleep->value && SV_CanSleep(ent) && !ent->v.velocity[0] && !ent->v.velocity[1] && !ent->v.velocity[2])
+		return true;
+
+	SV_WakeEntity(ent);
+	return false;
+}
+
+/*
+=============
+SV_RunAsleep
+
+Sleeping entities still think, if that disturbs them they move in the same frame like they would awake
+=============
+*/
+void SV_RunAsleep(gentity_t* ent)
+{
+	int		movetype;
+
+	SV_RunThink(ent);
+	if (!ent->inuse || (ent->asleep && SV_StaysAsleep(ent)))
+		return;
+
+	// step thinks after moving, so it wouldn't have moved before the next frame anyway
+	movetype = (int)ent->v.movetype;
+	if (movetype == MOVETYPE_TOSS || movetype == MOVETYPE_BOUNCE || movetype == MOVETYPE_FLY || movetype == MOVETYPE_FLYMISSILE)
+		SV_TossMove(ent);
+}
+
+/*
+=============
+SV_WakeEntity
+=============
+*/
+void SV_WakeEntity(gentity_t* ent)
+{
+	ent->asleep = false;
+	ent->restframes = 0;
+}
+
+static const char* sv_movetypeNames[] =
+{
+	"MOVETYPE_NONE", "MOVETYPE_NOCLIP", "MOVETYPE_PUSH", "MOVETYPE_STOP", "MOVETYPE_WALK",
+	"MOVETYPE_STEP", "MOVETYPE_FLY", "MOVETYPE_TOSS", "MOVETYPE_FLYMISSILE", "MOVETYPE_BOUNCE"
+};
+
 void SV_RunEntityPhysics(gentity_t* ent)
 {
-	switch ((int)ent->v.movetype)
+	int		movetype = (int)ent->v.movetype;
+
+	if (prof_capturing)
+		Prof_Begin((movetype >= 0 && movetype < (int)(sizeof(sv_movetypeNames) / sizeof(sv_movetypeNames[0]))) ? sv_movetypeNames[movetype] : "physics");
+
+	switch (movetype)
 	{
 	case MOVETYPE_PUSH:
 	case MOVETYPE_STOP:
@@ -975,4 +1216,6 @@ void SV_RunEntityPhysics(gentity_t* ent)
 	default:
 		Com_Error(ERR_DROP, "SV_Physics: entity %i has bad movetype %i\n", NUM_FOR_EDICT(ent), (int)ent->v.movetype);
 	}
+
+	PROF_END();
 }
\ No newline at end of file
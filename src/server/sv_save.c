@@ -0,0 +1,923 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// sv_save.c -- binary snapshots of the whole game for savegames
+
+/*
+A snapshot is a memory image of everything a level needs to continue: svgame
+globals and string heap, the entire edict block, gclients, configstrings,
+areaportals and pathnodes. Pointers in gentity_t are stored as entity or client
+numbers and area links only as a flag, the entity gets relinked on load.
+Entity references in progs are already offsets, so nothing else needs fixing.
+
+A save slot holds a keyframe (base.sav) and at most one delta (delta.sav).
+The first save into a slot writes a keyframe, the following ones only xor the
+new image against it, which leaves long runs of zeros for everything that
+didn't change, so both files are run length packed. After sv_savekeyframes
+deltas (or a map change) a new keyframe is written.
+
+Loading restarts the server on the saved map but skips spawn functions and
+main(), the snapshot is applied in SV_SpawnServer right after the qcvm and
+the world are created.
+*/
+
+#include "server.h"
+#include <time.h>
+
+void Nav_Init();
+int Nav_AddPathNode(float x, float y, float z);
+qboolean Nav_AddPathNodeLink(int nodeId, int linkTo);
+int Nav_GetNodesCount();
+int Nav_GetNodeLinkCount(int node);
+int Nav_GetNodeLink(int node, int link);
+void Nav_GetNodePos(int num, float* x, float* y, float* z);
+
+#define	SNAP_IDENT		(('V'<<24)+('A'<<16)+('S'<<8)+'P')	// little-endian "PSAV"
+#define	SNAP_VERSION	1
+#define	SNAP_MINRUN		4		// shorter runs are cheaper as literals
+
+typedef struct
+{
+	int		ident;
+	int		version;
+	int		keyframe;			// id of the keyframe, a delta only applies to the keyframe it was made from
+	int		delta;				// number of the delta, 0 for a keyframe
+	int		rawSize;
+	int		packedSize;
+	char	mapname[MAX_QPATH];
+	char	comment[32];
+} snapheader_t;
+
+// lumps, the fixed size ones go first so a delta doesn't get shifted when a variable one grows
+typedef enum
+{
+	SNAP_INFO,
+	SNAP_CONFIGSTRINGS,
+	SNAP_PORTALS,
+	SNAP_CLIENTS,
+	SNAP_EDICTS,
+	SNAP_PROGS,
+	SNAP_NAV,
+	SNAP_CVARS,
+	NUM_SNAP_LUMPS
+} snaplump_t;
+
+typedef struct
+{
+	unsigned	progsCRC;
+	int			pointerSize;		// gentity_t is stored as is, so the build must match too
+	int			maxEdicts, entitySize, numEdicts;
+	int			maxClients, clientSize;
+
+	unsigned	time;
+	int			framenum;
+	int			gameFrame;
+	float		gameTime;
+
+	float		saved[MAX_PERS_FIELDS];
+} snapinfo_t;
+
+typedef struct
+{
+	byte	*data;
+	int		size, maxsize;
+} snapbuf_t;
+
+// last keyframe written or loaded, kept so the next save into its slot can be a delta
+static struct
+{
+	char	dir[MAX_QPATH];
+	char	mapname[MAX_QPATH];
+	int		id;
+	int		numDeltas;
+	byte	*raw;
+	int		rawSize;
+} sv_keyframe;
+
+// read by SV_Loadgame_f, applied by SV_SpawnServer
+static snapbuf_t sv_pendingSnapshot;
+
+/*
+==============================================================================
+
+SNAPSHOT IMAGE
+
+==============================================================================
+*/
+
+/*
+================
+SV_SnapLump
+
+Appends a lump and returns where its data goes
+================
+*/
+static byte* SV_SnapLump(snapbuf_t* buf, snaplump_t id, int size)
+{
+	int		need;
+	byte	*newdata, *p;
+
+	need = buf->size + 2 * sizeof(int) + ((size + 3) & ~3);
+	if (need > buf->maxsize)
+	{
+		buf->maxsize = need + (need >> 1);
+		newdata = Z_Malloc(buf->maxsize);
+		if (buf->data)
+		{
+			memcpy(newdata, buf->data, buf->size);
+			Z_Free(buf->data);
+		}
+		buf->data = newdata;
+	}
+
+	p = buf->data + buf->size;
+	memcpy(p, &id, sizeof(int));
+	memcpy(p + sizeof(int), &size, sizeof(int));
+	memset(p + 2 * sizeof(int), 0, (size + 3) & ~3);
+	buf->size = need;
+
+	return p + 2 * sizeof(int);
+}
+
+/*
+================
+SV_SnapFindLump
+
+Returns NULL if the lump is missing or the image is damaged
+================
+*/
+static byte* SV_SnapFindLump(snapbuf_t* buf, snaplump_t id, int* size)
+{
+	int		ofs, lumpid, lumpsize;
+
+	for (ofs = 0; ofs + 2 * (int)sizeof(int) <= buf->size; ofs += 2 * sizeof(int) + ((lumpsize + 3) & ~3))
+	{
+		memcpy(&lumpid, buf->data + ofs, sizeof(int));
+		memcpy(&lumpsize, buf->data + ofs + sizeof(int), sizeof(int));
+
+		if (lumpsize < 0 || lumpsize > buf->size - ofs - 2 * (int)sizeof(int))
+			return NULL;
+
+		if (lumpid == id)
+		{
+			*size = lumpsize;
+			return buf->data + ofs + 2 * sizeof(int);
+		}
+	}
+	return NULL;
+}
+
+/*
+================
+SV_SnapEdicts
+
+Copies the edict block with pointers turned into numbers
+================
+*/
+static void SV_SnapEdicts(byte* out)
+{
+	gentity_t	*ent, *save;
+	int			i;
+
+	memcpy(out, sv.edicts, sv.max_edicts * sv.entity_size);
+
+	for (i = 0; i < sv.max_edicts; i++)
+	{
+		ent = EDICT_NUM(i);
+		save = (gentity_t*)(out + i * sv.entity_size);
+
+		save->client = ent->client ? (gclient_t*)(size_t)(ent->client - svs.gclients + 1) : NULL;
+		save->teamchain = ent->teamchain ? (gentity_t*)(size_t)(NUM_FOR_EDICT(ent->teamchain) + 1) : NULL;
+		save->teammaster = ent->teammaster ? (gentity_t*)(size_t)(NUM_FOR_EDICT(ent->teammaster) + 1) : NULL;
+
+		// only whether it was linked, SV_LinkEdict rebuilds the rest
+		save->area.prev = ent->area.prev ? (link_t*)1 : NULL;
+		save->area.next = NULL;
+
+		memset(&save->tagcache, 0, sizeof(save->tagcache));
+	}
+}
+
+/*
+================
+SV_SnapNav
+================
+*/
+static int SV_SnapNav(byte* out)
+{
+	int		i, j, numnodes, numlinks, link, size;
+	float	origin[3];
+
+	numnodes = Nav_GetNodesCount();
+	if (out)
+		memcpy(out, &numnodes, sizeof(int));
+	size = sizeof(int);
+
+	for (i = 0; i < numnodes; i++)
+	{
+		numlinks = Nav_GetNodeLinkCount(i);
+		if (out)
+		{
+			Nav_GetNodePos(i, &origin[0], &origin[1], &origin[2]);
+			memcpy(out + size, origin, sizeof(origin));
+			memcpy(out + size + sizeof(origin), &numlinks, sizeof(int));
+			for (j = 0; j < numlinks; j++)
+			{
+				link = Nav_GetNodeLink(i, j);
+				memcpy(out + size + sizeof(origin) + (j + 1) * sizeof(int), &link, sizeof(int));
+			}
+		}
+		size += sizeof(origin) + (numlinks + 1) * sizeof(int);
+	}
+	return size;
+}
+
+/*
+================
+SV_SnapCvars
+
+Latched cvars like coop and sv_maxclients, as name and value string pairs
+================
+*/
+static int SV_SnapCvars(byte* out)
+{
+	cvar_t	*var;
+	int		size = 0, len;
+
+	for (var = cvar_vars; var; var = var->next)
+	{
+		if (!(var->flags & CVAR_LATCH))
+			continue;
+
+		len = (int)strlen(var->name) + 1;
+		if (out)
+			memcpy(out + size, var->name, len);
+		size += len;
+
+		len = (int)strlen(var->string) + 1;
+		if (out)
+			memcpy(out + size, var->string, len);
+		size += len;
+	}
+	return size;
+}
+
+/*
+================
+SV_BuildSnapshot
+================
+*/
+static void SV_BuildSnapshot(snapbuf_t* buf)
+{
+	snapinfo_t	*info;
+	int			size;
+
+	info = (snapinfo_t*)SV_SnapLump(buf, SNAP_INFO, sizeof(snapinfo_t));
+	info->progsCRC = Scr_GetProgsCRC(VM_SVGAME);
+	info->pointerSize = sizeof(void*);
+	info->maxEdicts = sv.max_edicts;
+	info->entitySize = sv.entity_size;
+	info->numEdicts = sv.num_edicts;
+	info->maxClients = svs.max_clients;
+	info->clientSize = sizeof(gclient_t);
+	info->time = sv.time;
+	info->framenum = sv.framenum;
+	info->gameFrame = sv.gameFrame;
+	info->gameTime = sv.gameTime;
+	memcpy(info->saved, svs.saved, sizeof(info->saved));
+
+	memcpy(SV_SnapLump(buf, SNAP_CONFIGSTRINGS, sizeof(sv.configstrings)), sv.configstrings, sizeof(sv.configstrings));
+
+	size = CM_WritePortalStateToBuffer(NULL);
+	CM_WritePortalStateToBuffer(SV_SnapLump(buf, SNAP_PORTALS, size));
+
+	memcpy(SV_SnapLump(buf, SNAP_CLIENTS, svs.max_clients * sizeof(gclient_t)), svs.gclients, svs.max_clients * sizeof(gclient_t));
+
+	SV_SnapEdicts(SV_SnapLump(buf, SNAP_EDICTS, sv.max_edicts * sv.entity_size));
+
+	size = Scr_WriteState(VM_SVGAME, NULL);
+	Scr_WriteState(VM_SVGAME, SV_SnapLump(buf, SNAP_PROGS, size));
+
+	size = SV_SnapNav(NULL);
+	SV_SnapNav(SV_SnapLump(buf, SNAP_NAV, size));
+
+	size = SV_SnapCvars(NULL);
+	SV_SnapCvars(SV_SnapLump(buf, SNAP_CVARS, size));
+}
+
+/*
+==============================================================================
+
+PACKING
+
+==============================================================================
+*/
+
+/*
+================
+SV_SnapWriteCount
+================
+*/
+static byte* SV_SnapWriteCount(byte* out, unsigned count)
+{
+	while (count >= 0x80)
+	{
+		*out++ = (byte)(count | 0x80);
+		count >>= 7;
+	}
+	*out++ = (byte)count;
+	return out;
+}
+
+/*
+================
+SV_SnapPack
+
+Run length packs raw, xor'd against base when there is one. Literal spans and
+runs are each a count (count << 1 | isRun) followed by the bytes or the one
+repeated byte. Returns packed size, out must hold SV_SnapPackBound bytes.
+================
+*/
+#define	SV_SnapPackBound(size)	((size) + (size) / 4 + 16)
+
+static int SV_SnapPack(const byte* raw, int size, const byte* base, int baseSize, byte* out)
+{
+	byte	*work, *p = out;
+	int		i, run, literal;
+
+	work = Z_Malloc(size);
+	for (i = 0; i < size; i++)
+		work[i] = raw[i] ^ (i < baseSize ? base[i] : 0);
+
+	literal = 0;
+	for (i = 0; i < size; i += run)
+	{
+		for (run = 1; i + run < size && work[i + run] == work[i]; run++)
+			;
+
+		if (run < SNAP_MINRUN)
+		{
+			literal += run;
+			continue;
+		}
+
+		if (literal)
+		{
+			p = SV_SnapWriteCount(p, literal << 1);
+			memcpy(p, work + i - literal, literal);
+			p += literal;
+			literal = 0;
+		}
+		p = SV_SnapWriteCount(p, (run << 1) | 1);
+		*p++ = work[i];
+	}
+
+	if (literal)
+	{
+		p = SV_SnapWriteCount(p, literal << 1);
+		memcpy(p, work + size - literal, literal);
+		p += literal;
+	}
+
+	Z_Free(work);
+	return (int)(p - out);
+}
+
+/*
+================
+SV_SnapUnpack
+
+Returns false if packed data doesn't decode to exactly size bytes
+================
+*/
+static qboolean SV_SnapUnpack(const byte* in, int packedSize, const byte* base, int baseSize, byte* out, int size)
+{
+	const byte	*end = in + packedSize;
+	unsigned	count;
+	int			i, shift, ofs = 0;
+
+	while (in < end)
+	{
+		count = 0;
+		for (shift = 0; in < end && shift < 35; shift += 7)
+		{
+			count |= (unsigned)(*in & 0x7f) << shift;
+			if (!(*in++ & 0x80))
+				break;
+		}
+
+		if ((count >> 1) > (unsigned)(size - ofs))
+			return false;
+
+		if (count & 1)
+		{
+			if (in == end)
+				return false;
+			memset(out + ofs, *in++, count >> 1);
+		}
+		else
+		{
+			if ((count >> 1) > (unsigned)(end - in))
+				return false;
+			memcpy(out + ofs, in, count >> 1);
+			in += count >> 1;
+		}
+		ofs += count >> 1;
+	}
+
+	if (ofs != size)
+		return false;
+
+	if (base)
+	{
+		for (i = 0; i < size && i < baseSize; i++)
+			out[i] ^= base[i];
+	}
+	return true;
+}
+
+/*
+==============================================================================
+
+SAVE SLOTS
+
+==============================================================================
+*/
+
+/*
+================
+SV_SnapWriteFile
+================
+*/
+static qboolean SV_SnapWriteFile(char* name, snapheader_t* header, byte* packed)
+{
+	FILE	*f;
+
+	FS_CreatePath(name);
+	f = fopen(name, "wb");
+	if (!f)
+	{
+		Com_Printf("Couldn't write %s\n", name);
+		return false;
+	}
+
+	fwrite(header, sizeof(*header), 1, f);
+	fwrite(packed, header->packedSize, 1, f);
+	fclose(f);
+	return true;
+}
+
+/*
+================
+SV_SnapReadFile
+
+Reads and unpacks a save, returns the raw image or NULL, base is the keyframe for deltas
+================
+*/
+static byte* SV_SnapReadFile(char* name, snapheader_t* header, byte* base, int baseSize, qboolean quiet)
+{
+	FILE	*f;
+	byte	*packed, *raw;
+
+	f = fopen(name, "rb");
+	if (!f)
+	{
+		if (!quiet)
+			Com_Printf("No such savegame: %s\n", name);
+		return NULL;
+	}
+
+	if (fread(header, sizeof(*header), 1, f) != 1 || header->ident != SNAP_IDENT || header->version != SNAP_VERSION ||
+		header->rawSize <= 0 || header->packedSize <= 0 || (header->delta && !base))
+	{
+		Com_Printf("%s is not a savegame of this version\n", name);
+		fclose(f);
+		return NULL;
+	}
+	header->mapname[sizeof(header->mapname) - 1] = 0;
+
+	packed = Z_Malloc(header->packedSize);
+	raw = Z_Malloc(header->rawSize);
+
+	if (fread(packed, header->packedSize, 1, f) != 1 ||
+		!SV_SnapUnpack(packed, header->packedSize, header->delta ? base : NULL, baseSize, raw, header->rawSize))
+	{
+		Com_Printf("%s is damaged\n", name);
+		Z_Free(raw);
+		raw = NULL;
+	}
+
+	Z_Free(packed);
+	fclose(f);
+	return raw;
+}
+
+/*
+================
+SV_SetKeyframe
+
+Takes ownership of raw
+================
+*/
+static void SV_SetKeyframe(char* dir, char* mapname, int id, byte* raw, int rawSize)
+{
+	if (sv_keyframe.raw)
+		Z_Free(sv_keyframe.raw);
+
+	Com_sprintf(sv_keyframe.dir, sizeof(sv_keyframe.dir), "%s", dir);
+	Com_sprintf(sv_keyframe.mapname, sizeof(sv_keyframe.mapname), "%s", mapname);
+	sv_keyframe.id = id;
+	sv_keyframe.numDeltas = 0;
+	sv_keyframe.raw = raw;
+	sv_keyframe.rawSize = rawSize;
+}
+
+/*
+================
+SV_WriteSnapshot
+
+Saves the running game into save/<dir>/
+================
+*/
+void SV_WriteSnapshot(char* dir)
+{
+	snapbuf_t		buf;
+	snapheader_t	header;
+	char			name[MAX_OSPATH];
+	byte			*packed, *raw;
+	qboolean		delta;
+	long long		start, built, packtime, written;
+	time_t			aclock;
+	struct tm		*newtime;
+
+	start = Sys_Microseconds();
+
+	memset(&buf, 0, sizeof(buf));
+	SV_BuildSnapshot(&buf);
+	built = Sys_Microseconds();
+
+	delta = sv_keyframe.raw && !strcmp(sv_keyframe.dir, dir) && !strcmp(sv_keyframe.mapname, sv.name) && sv_keyframe.numDeltas < (int)sv_savekeyframes->value;
+
+	memset(&header, 0, sizeof(header));
+	header.ident = SNAP_IDENT;
+	header.version = SNAP_VERSION;
+	header.keyframe = delta ? sv_keyframe.id : (rand() ^ (Sys_Milliseconds() << 12));
+	header.delta = delta ? sv_keyframe.numDeltas + 1 : 0;
+	header.rawSize = buf.size;
+	Com_sprintf(header.mapname, sizeof(header.mapname), "%s", sv.name);
+
+	time(&aclock);
+	newtime = localtime(&aclock);
+	Com_sprintf(header.comment, sizeof(header.comment), "%2i:%i%i %2i/%2i  %s", newtime->tm_hour, newtime->tm_min / 10, newtime->tm_min % 10, newtime->tm_mon + 1, newtime->tm_mday, sv.configstrings[CS_NAME]);
+
+	packed = Z_Malloc(SV_SnapPackBound(buf.size));
+	if (delta)
+		header.packedSize = SV_SnapPack(buf.data, buf.size, sv_keyframe.raw, sv_keyframe.rawSize, packed);
+	else
+		header.packedSize = SV_SnapPack(buf.data, buf.size, NULL, 0, packed);
+	packtime = Sys_Microseconds();
+
+	Com_sprintf(name, sizeof(name), "%s/save/%s/%s", FS_Gamedir(), dir, delta ? "delta.sav" : "base.sav");
+	if (!SV_SnapWriteFile(name, &header, packed))
+	{
+		Z_Free(packed);
+		Z_Free(buf.data);
+		return;
+	}
+
+	if (delta)
+	{
+		sv_keyframe.numDeltas++;
+		Z_Free(buf.data);
+	}
+	else
+	{
+		// an old delta would be ignored anyway, but don't leave it around
+		Com_sprintf(name, sizeof(name), "%s/save/%s/delta.sav", FS_Gamedir(), dir);
+		remove(name);
+
+		raw = Z_Malloc(buf.size);
+		memcpy(raw, buf.data, buf.size);
+		Z_Free(buf.data);
+		SV_SetKeyframe(dir, sv.name, header.keyframe, raw, header.rawSize);
+	}
+	Z_Free(packed);
+	written = Sys_Microseconds();
+
+	Com_Printf("Saved '%s' (%s): %.1f KB packed to %i bytes in %.2f ms (snapshot %.2f, pack %.2f, write %.2f)\n",
+		dir, delta ? va("delta %i", header.delta) : "keyframe", header.rawSize / 1024.0, header.packedSize,
+		(written - start) / 1000.0, (built - start) / 1000.0, (packtime - built) / 1000.0, (written - packtime) / 1000.0);
+}
+
+/*
+================
+SV_ReadSnapshot
+
+Reads save/<dir>/ and sets latched cvars it was made with, the caller restarts
+the server on mapname and SV_SpawnServer picks the snapshot up from there
+================
+*/
+qboolean SV_ReadSnapshot(char* dir, char* mapname, int mapnameSize)
+{
+	snapheader_t	header, deltaheader;
+	char			name[MAX_OSPATH];
+	byte			*raw, *deltaraw, *cvars;
+	char			*var, *value;
+	int				size, ofs;
+	long long		start;
+
+	start = Sys_Microseconds();
+
+	SV_FreePendingSnapshot();
+
+	Com_sprintf(name, sizeof(name), "%s/save/%s/base.sav", FS_Gamedir(), dir);
+	raw = SV_SnapReadFile(name, &header, NULL, 0, false);
+	if (!raw)
+		return false;
+
+	Com_sprintf(name, sizeof(name), "%s/save/%s/delta.sav", FS_Gamedir(), dir);
+	deltaraw = SV_SnapReadFile(name, &deltaheader, raw, header.rawSize, true);
+	if (deltaraw && deltaheader.keyframe != header.keyframe)
+	{
+		Com_Printf("%s was made from another keyframe, ignored\n", name);
+		Z_Free(deltaraw);
+		deltaraw = NULL;
+	}
+
+	if (deltaraw)
+	{
+		sv_pendingSnapshot.data = deltaraw;
+		sv_pendingSnapshot.size = deltaheader.rawSize;
+	}
+	else
+	{
+		sv_pendingSnapshot.data = Z_Malloc(header.rawSize);
+		sv_pendingSnapshot.size = header.rawSize;
+		memcpy(sv_pendingSnapshot.data, raw, header.rawSize);
+	}
+	sv_pendingSnapshot.maxsize = sv_pendingSnapshot.size;
+
+	// the keyframe stays around so saving into this slot again continues with deltas
+	SV_SetKeyframe(dir, header.mapname, header.keyframe, raw, header.rawSize);
+	sv_keyframe.numDeltas = deltaraw ? deltaheader.delta : 0;
+
+	cvars = SV_SnapFindLump(&sv_pendingSnapshot, SNAP_CVARS, &size);
+	if (!cvars)
+	{
+		Com_Printf("Savegame '%s' is damaged\n", dir);
+		SV_FreePendingSnapshot();
+		return false;
+	}
+
+	// these will be things like coop, skill, multiplayer, etc
+	ofs = 0;
+	while (ofs < size && memchr(cvars + ofs, 0, size - ofs))
+	{
+		var = (char*)cvars + ofs;
+		ofs += (int)strlen(var) + 1;
+		if (ofs >= size || !memchr(cvars + ofs, 0, size - ofs))
+			break;
+
+		value = (char*)cvars + ofs;
+		ofs += (int)strlen(value) + 1;
+		Com_DPrintf(DP_SV, "SV_ReadSnapshot: Set %s = %s\n", var, value);
+		Cvar_ForceSet(var, value);
+	}
+
+	Com_sprintf(mapname, mapnameSize, "%s", header.mapname);
+
+	Com_Printf("Read '%s' (%s): %.1f KB in %.2f ms\n", dir, deltaraw ? va("keyframe and delta %i", deltaheader.delta) : "keyframe",
+		sv_pendingSnapshot.size / 1024.0, (Sys_Microseconds() - start) / 1000.0);
+	return true;
+}
+
+/*
+================
+SV_FreePendingSnapshot
+================
+*/
+void SV_FreePendingSnapshot(void)
+{
+	if (sv_pendingSnapshot.data)
+		Z_Free(sv_pendingSnapshot.data);
+	memset(&sv_pendingSnapshot, 0, sizeof(sv_pendingSnapshot));
+}
+
+/*
+==============================================================================
+
+RESTORING
+
+==============================================================================
+*/
+
+/*
+================
+SV_RestoreEdicts
+
+Copies the edict block back in, turns numbers into pointers and relinks entities
+================
+*/
+static qboolean SV_RestoreEdicts(byte* in)
+{
+	gentity_t	*ent;
+	qboolean	*linked;
+	size_t		num;
+	int			i;
+
+	SV_ClearWorld();
+	memcpy(sv.edicts, in, sv.max_edicts * sv.entity_size);
+
+	linked = Z_Malloc(sv.max_edicts * sizeof(qboolean));
+	for (i = 0; i < sv.max_edicts; i++)
+	{
+		ent = EDICT_NUM(i);
+
+		num = (size_t)ent->client;
+		if (num > (size_t)svs.max_clients)
+			break;
+		ent->client = num ? &svs.gclients[num - 1] : NULL;
+
+		num = (size_t)ent->teamchain;
+		if (num > (size_t)sv.max_edicts)
+			break;
+		ent->teamchain = num ? EDICT_NUM(num - 1) : NULL;
+
+		num = (size_t)ent->teammaster;
+		if (num > (size_t)sv.max_edicts)
+			break;
+		ent->teammaster = num ? EDICT_NUM(num - 1) : NULL;
+
+		linked[i] = ent->area.prev != NULL;
+		ent->area.prev = ent->area.next = NULL;
+	}
+
+	if (i == sv.max_edicts)
+	{
+		for (i = 0; i < sv.max_edicts; i++)
+		{
+			if (linked[i])
+				SV_LinkEdict(EDICT_NUM(i));
+		}
+	}
+
+	Z_Free(linked);
+	return i == sv.max_edicts;
+}
+
+/*
+================
+SV_RestoreNav
+================
+*/
+static qboolean SV_RestoreNav(byte* in, int size)
+{
+	byte	*p = in, *end = in + size;
+	float	origin[3];
+	int		i, j, numnodes, numlinks, link;
+
+	if (size < (int)sizeof(int))
+		return false;
+	memcpy(&numnodes, p, sizeof(int));
+	p += sizeof(int);
+
+	Nav_Init();
+	for (i = 0; i < numnodes; i++)
+	{
+		if (end - p < (int)(sizeof(origin) + sizeof(int)))
+			return false;
+		memcpy(origin, p, sizeof(origin));
+		memcpy(&numlinks, p + sizeof(origin), sizeof(int));
+		p += sizeof(origin) + sizeof(int);
+
+		if (numlinks < 0 || end - p < numlinks * (int)sizeof(int) || Nav_AddPathNode(origin[0], origin[1], origin[2]) != i)
+			return false;
+
+		for (j = 0; j < numlinks; j++, p += sizeof(int))
+		{
+			memcpy(&link, p, sizeof(int));
+			Nav_AddPathNodeLink(i, link);
+		}
+	}
+	return p == end;
+}
+
+/*
+================
+SV_RestoreModels
+
+Loads models the snapshot's configstrings refer to, in the same order so they get the same indexes
+================
+*/
+static qboolean SV_RestoreModels(char (*configstrings)[MAX_QPATH])
+{
+	int		i;
+
+	for (i = sv.num_models; i < MAX_MODELS && configstrings[CS_MODELS + i][0]; i++)
+	{
+		if (SV_ModelIndex(configstrings[CS_MODELS + i]) != i)
+		{
+			Com_Printf("Model %s isn't where the savegame expects it\n", configstrings[CS_MODELS + i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+================
+SV_RestoreSnapshot
+
+Called by SV_SpawnServer once the qcvm and the world exist, returns false
+when there is nothing to restore and the level has to spawn its entities
+================
+*/
+qboolean SV_RestoreSnapshot(void)
+{
+	snapinfo_t	*info;
+	byte		*lump[NUM_SNAP_LUMPS];
+	int			size[NUM_SNAP_LUMPS];
+	char		cgprogs[MAX_QPATH];
+	snaplump_t	i;
+	long long	start;
+	char		*error = NULL;
+
+	if (!sv_pendingSnapshot.data)
+		return false;
+
+	start = Sys_Microseconds();
+
+	for (i = 0; i < NUM_SNAP_LUMPS; i++)
+	{
+		lump[i] = SV_SnapFindLump(&sv_pendingSnapshot, i, &size[i]);
+		if (!lump[i])
+			error = "savegame is damaged";
+	}
+
+	info = error ? NULL : (snapinfo_t*)lump[SNAP_INFO];
+	if (info && (size[SNAP_INFO] != sizeof(snapinfo_t) || info->pointerSize != sizeof(void*) || info->clientSize != sizeof(gclient_t)))
+		error = "savegame was made by a different build";
+	else if (info && (info->progsCRC != Scr_GetProgsCRC(VM_SVGAME) || info->entitySize != sv.entity_size))
+		error = "savegame was made with different progs";
+	else if (info && (info->maxEdicts != sv.max_edicts || info->maxClients != svs.max_clients))
+		error = "savegame was made with different sv_maxentities or sv_maxclients";
+	else if (info && (size[SNAP_CONFIGSTRINGS] != sizeof(sv.configstrings) || strcmp((char*)lump[SNAP_CONFIGSTRINGS] + CS_CHECKSUM_MAP * MAX_QPATH, sv.configstrings[CS_CHECKSUM_MAP])))
+		error = "map has changed since the game was saved";
+	else if (info && (size[SNAP_CLIENTS] != info->maxClients * info->clientSize || size[SNAP_EDICTS] != info->maxEdicts * info->entitySize))
+		error = "savegame is damaged";
+
+	if (!error)
+	{
+		// configstrings come with the models they index
+		Com_sprintf(cgprogs, sizeof(cgprogs), "%s", sv.configstrings[CS_CHECKSUM_CGPROGS]);
+		if (!SV_RestoreModels((char(*)[MAX_QPATH])lump[SNAP_CONFIGSTRINGS]))
+			error = "savegame models don't match";
+		else
+		{
+			memcpy(sv.configstrings, lump[SNAP_CONFIGSTRINGS], sizeof(sv.configstrings));
+			Com_sprintf(sv.configstrings[CS_CHECKSUM_CGPROGS], sizeof(sv.configstrings[CS_CHECKSUM_CGPROGS]), "%s", cgprogs);
+			SV_ClearAssetIndex();
+		}
+	}
+
+	if (!error && !CM_ReadPortalStateFromBuffer(lump[SNAP_PORTALS], size[SNAP_PORTALS]))
+		error = "savegame areaportals don't match";
+	if (!error && !Scr_ReadState(VM_SVGAME, lump[SNAP_PROGS], size[SNAP_PROGS]))
+		error = "savegame progs state is damaged";
+
+	if (!error)
+	{
+		memcpy(svs.gclients, lump[SNAP_CLIENTS], size[SNAP_CLIENTS]);
+		if (!SV_RestoreEdicts(lump[SNAP_EDICTS]))
+			error = "savegame entities are damaged";
+	}
+
+	if (!error && !SV_RestoreNav(lump[SNAP_NAV], size[SNAP_NAV]))
+		error = "savegame pathnodes are damaged";
+
+	if (error)
+	{
+		SV_FreePendingSnapshot();
+		Com_Error(ERR_DROP, "Couldn't load game: %s\n", error);
+		return false;
+	}
+
+	sv.num_edicts = info->numEdicts;
+	sv.time = info->time;
+	sv.framenum = info->framenum;
+	sv.gameFrame = info->gameFrame;
+	sv.gameTime = info->gameTime;
+	memcpy(svs.saved, info->saved, sizeof(svs.saved));
+
+	SV_FreePendingSnapshot();
+
+	Com_Printf("Restored game in %.2f ms\n", (Sys_Microseconds() - start) / 1000.0);
+	return true;
+}
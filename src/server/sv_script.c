@@ -81,6 +81,9 @@ void Scr_Event_Blocked(gentity_t* self, gentity_t* other)
 
 void Scr_Event_Touch(gentity_t* self, gentity_t* other, cplane_t* plane, csurface_t* surf)
 {
+	SV_WakeEntity(self);
+	SV_WakeEntity(other);
+
 	if (!self->v.touch || self->v.solid == SOLID_NOT)
 		return;
 
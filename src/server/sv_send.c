@@ -405,6 +405,27 @@ FRAME UPDATES
 
 
 
+/*
+=======================
+SV_Transmit
+
+Bots have nobody on the other end, their messages are only counted
+=======================
+*/
+static void SV_Transmit(client_t *client, int length, byte *data)
+{
+	if (sv_bench.active)
+		sv_bench.bytesSent += length + client->netchan.message.cursize;
+
+	if (client->bot)
+	{
+		SZ_Clear (&client->netchan.message);
+		return;
+	}
+
+	Netchan_Transmit (&client->netchan, length, data);
+}
+
 /*
 =======================
 SV_SendClientDatagram
@@ -418,7 +439,9 @@ qboolean SV_SendClientDatagram(client_t *client)
 	byte		msg_buf[MAX_MSGLEN];
 	sizebuf_t	msg;
 
+	PROF_BEGIN ("SV_BuildClientFrame");
 	SV_BuildClientFrame (client);
+	PROF_END ();
 
 #if 1 //#ifdef PARANOID
 	// clean up after CustomizeForClient...
@@ -438,7 +461,9 @@ qboolean SV_SendClientDatagram(client_t *client)
 	msg.allowoverflow = true;
 
 	// send over all the relevant entity_state_t and the player_state_t
+	PROF_BEGIN ("SV_WriteFrameToClient");
 	SV_WriteFrameToClient (client, &msg);
+	PROF_END ();
 		
 	// copy the accumulated multicast datagram for this client out to the message
 	// it is necessary for this to be after the WriteEntities so that entity references will be current
@@ -459,7 +484,7 @@ qboolean SV_SendClientDatagram(client_t *client)
 	}
 
 	// send the datagram
-	Netchan_Transmit (&client->netchan, msg.cursize, msg.data);
+	SV_Transmit (client, msg.cursize, msg.data);
 
 	// record the size for rate estimation
 	client->message_size[sv.framenum % RATE_MESSAGES] = msg.cursize;
@@ -582,7 +607,7 @@ void SV_SendClientMessages (void)
 			|| sv.state == ss_demo 
 			|| sv.state == ss_pic
 			)
-			Netchan_Transmit (&c->netchan, msglen, msgbuf);
+			SV_Transmit (c, msglen, msgbuf);
 		else if (c->state == cs_spawned)
 		{
 			// don't overrun bandwidth
@@ -595,7 +620,7 @@ void SV_SendClientMessages (void)
 		{
 	// just update reliable	if needed
 			if (c->netchan.message.cursize	|| curtime - c->netchan.last_sent > 1000 )
-				Netchan_Transmit (&c->netchan, 0, NULL);
+				SV_Transmit (c, 0, NULL);
 		}
 	}
 }
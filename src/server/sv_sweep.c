@@ -0,0 +1,443 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+// sv_sweep.c -- tracing projectiles and debris ahead of physics on worker threads
+
+/*
+Projectiles and tossed debris spend most of their physics in the one trace
+SV_TossMove does for them each frame. Before the entities run, the sweep
+predicts where every awake toss, bounce, fly and flymissile entity is going
+to move and traces all of them on the worker threads at once, nothing links
+while it runs so they all see the same frozen world.
+
+The entities then run one by one in entity order like they always did,
+touch and impact callbacks and relinking included. When SV_PushEntity is
+about to trace it takes the swept trace instead, but only if the move, the
+mover and every entity it could have hit are still exactly what the sweep
+saw, otherwise it traces like before. A think that changed the velocity or
+something else that moved into the way only costs the swept trace, so a
+frame comes out the same with the sweep on or off and for any number of
+threads, svbench state hashes can be compared to check that.
+*/
+
+#include "server.h"
+
+#define	MAX_SWEEP_WORKERS	(CM_MAX_BOXHULLS - 1)	// slot 0 is the main thread's
+#define	SWEEP_GRAIN			8		// movers per slice
+#define	SWEEP_MAX_TOUCH		8		// movers near more entities than this are traced as they run
+
+// what a swept trace depended on of an entity it could have hit
+typedef struct
+{
+	gentity_t		*ent;
+	vec3_t			origin, angles;
+	vec3_t			mins, maxs;
+	float			solid, svflags, modelindex;
+	scr_entity_t	owner;
+} sweeptouch_t;
+
+typedef struct
+{
+	gentity_t		*ent;
+	vec3_t			start, end;
+	vec3_t			mins, maxs;
+	int				mask;
+	scr_entity_t	owner;
+
+	qboolean		valid;			// traced, and nothing needed the main thread
+	trace_t			trace;
+	int				numtouch;
+	sweeptouch_t	touch[SWEEP_MAX_TOUCH];
+} sweepmove_t;
+
+typedef struct
+{
+	void			*threads[MAX_SWEEP_WORKERS];
+	int				slots[MAX_SWEEP_WORKERS];
+	int				numWorkers;
+
+	void			*wake;	// posted once per worker for each sweep
+	void			*done;	// posted by each worker when there are no slices left
+	volatile int	quit;
+
+	volatile int	next;	// first mover of the next slice
+} sweeppool_t;
+
+static sweeppool_t	sweeppool;
+
+static sweepmove_t	*sweep_moves;		// [sv.max_edicts]
+static int			*sweep_index;		// [sv.max_edicts], 1 + move of each entity, 0 when it has none
+static int			sweep_nummoves;
+
+cvar_t				*sv_physicsthreads;
+
+/*
+===============
+SV_SweepTouch
+
+Only what SV_Trace looks at, the mover itself is skipped and boxes don't rotate
+===============
+*/
+static void SV_SweepTouch(gentity_t* mover, gentity_t* ent, sweeptouch_t* touch)
+{
+	memset(touch, 0, sizeof(*touch));
+	touch->ent = ent;
+	if (ent == mover)
+		return;
+
+	VectorCopy(ent->v.origin, touch->origin);
+	if (ent->v.solid == SOLID_BSP)
+		VectorCopy(ent->v.angles, touch->angles);
+	VectorCopy(ent->v.mins, touch->mins);
+	VectorCopy(ent->v.maxs, touch->maxs);
+	touch->solid = ent->v.solid;
+	touch->svflags = ent->v.svflags;
+	touch->modelindex = ent->v.modelindex;
+	touch->owner = ent->v.owner;
+}
+
+/*
+===============
+SV_SweepMove
+
+Trace one mover, called on workers and the main thread
+===============
+*/
+static void SV_SweepMove(sweepmove_t* move, int slot)
+{
+	gentity_t	*list[SWEEP_MAX_TOUCH];
+	int			i;
+
+	move->numtouch = SV_MoveEdicts(move->start, move->mins, move->maxs, move->end, list, SWEEP_MAX_TOUCH);
+	if (move->numtouch < 0)
+		return;
+
+	if (!SV_TraceSlot(move->start, move->mins, move->maxs, move->end, move->ent, move->mask, list, move->numtouch, slot, &move->trace))
+		return;
+
+	for (i = 0; i < move->numtouch; i++)
+		SV_SweepTouch(move->ent, list[i], &move->touch[i]);
+
+	move->valid = true;
+}
+
+/*
+===============
+SV_SweepSlices
+
+Grab slices until every mover is traced
+===============
+*/
+static void SV_SweepSlices(int slot)
+{
+	int first, count;
+
+	for (;;)
+	{
+		first = Sys_AtomicAdd(&sweeppool.next, SWEEP_GRAIN) - SWEEP_GRAIN;
+		if (first >= sweep_nummoves)
+			break;
+
+		count = sweep_nummoves - first;
+		if (count > SWEEP_GRAIN)
+			count = SWEEP_GRAIN;
+
+		for (; count; count--, first++)
+			SV_SweepMove(&sweep_moves[first], slot);
+	}
+}
+
+/*
+===============
+SV_SweepWorker
+===============
+*/
+static void SV_SweepWorker(void* arg)
+{
+	int slot = *(int*)arg;
+
+	for (;;)
+	{
+		Sys_WaitSemaphore(sweeppool.wake);
+		if (sweeppool.quit)
+			break;
+
+		SV_SweepSlices(slot);
+		Sys_PostSemaphore(sweeppool.done);
+	}
+}
+
+/*
+===============
+SV_StopSweepWorkers
+===============
+*/
+static void SV_StopSweepWorkers(void)
+{
+	int i;
+
+	if (sweeppool.numWorkers)
+	{
+		sweeppool.quit = true;
+		for (i = 0; i < sweeppool.numWorkers; i++)
+			Sys_PostSemaphore(sweeppool.wake);
+		for (i = 0; i < sweeppool.numWorkers; i++)
+			Sys_WaitThread(sweeppool.threads[i]);
+	}
+
+	if (sweeppool.wake)
+		Sys_DestroySemaphore(sweeppool.wake);
+	if (sweeppool.done)
+		Sys_DestroySemaphore(sweeppool.done);
+
+	memset(&sweeppool, 0, sizeof(sweeppool));
+}
+
+/*
+===============
+SV_StartSweepWorkers
+
+Without threads movers are traced as they run, like the sweep was off
+===============
+*/
+static void SV_StartSweepWorkers(int count)
+{
+	void *thread;
+
+	SV_StopSweepWorkers();
+
+	if (count > MAX_SWEEP_WORKERS)
+		count = MAX_SWEEP_WORKERS;
+	if (count <= 0)
+		return;
+
+	sweeppool.wake = Sys_CreateSemaphore(0);
+	sweeppool.done = Sys_CreateSemaphore(0);
+	if (!sweeppool.wake || !sweeppool.done)
+	{
+		Com_Printf("SV_StartSweepWorkers: failed to create semaphores, movers are traced on main thread\n");
+		SV_StopSweepWorkers();
+		return;
+	}
+
+	while (sweeppool.numWorkers < count)
+	{
+		sweeppool.slots[sweeppool.numWorkers] = sweeppool.numWorkers + 1;
+		thread = Sys_CreateThread(SV_SweepWorker, &sweeppool.slots[sweeppool.numWorkers]);
+		if (!thread)
+			break;
+		sweeppool.threads[sweeppool.numWorkers++] = thread;
+	}
+
+	Com_DPrintf(DP_SV, "Server physics: %i worker threads\n", sweeppool.numWorkers);
+}
+
+/*
+===============
+SV_PredictMove
+
+Where SV_TossMove will push the entity if its think leaves it alone,
+false when it won't move
+===============
+*/
+static qboolean SV_PredictMove(gentity_t* ent, vec3_t start, vec3_t end)
+{
+	vec3_t	velocity, move;
+	float	vel;
+	int		i;
+
+	if ((int)ent->v.flags & FL_TEAMSLAVE)
+		return false;
+
+	// on ground, even when the ground went away this frame
+	if (ent->v.velocity[2] <= 0 && ent->v.groundentity_num != ENTITYNUM_NULL)
+		return false;
+
+	// same math as SV_CheckVelocity and SV_AddGravity, a difference only costs the swept trace
+	VectorCopy(ent->v.velocity, velocity);
+	vel = VectorLength(velocity);
+	if (vel > sv_maxvelocity->value)
+	{
+		for (i = 0; i < 3; i++)
+			velocity[i] = (velocity[i] / vel) * sv_maxvelocity->value;
+	}
+
+	if (ent->v.movetype != MOVETYPE_FLY && ent->v.movetype != MOVETYPE_FLYMISSILE)
+		velocity[2] -= ent->v.gravity * sv_gravity->value * (float)SV_FRAMETIME;
+
+	VectorScale(velocity, SV_FRAMETIME, move);
+	VectorCopy(ent->v.origin, start);
+	VectorAdd(start, move, end);
+	return true;
+}
+
+/*
+===============
+SV_SweepMovers
+
+Called before the entities run, traces the moves of all projectiles and debris
+===============
+*/
+void SV_SweepMovers(void)
+{
+	sweepmove_t	*move;
+	gentity_t	*ent;
+	int			i, movetype;
+
+	// forget last frame
+	for (i = 0; i < sweep_nummoves; i++)
+		sweep_index[NUM_FOR_EDICT(sweep_moves[i].ent)] = 0;
+	sweep_nummoves = 0;
+
+	if (sv_physicsthreads->modified)
+	{
+		sv_physicsthreads->modified = false;
+		SV_StartSweepWorkers((int)sv_physicsthreads->value);
+	}
+
+	if (!sweeppool.numWorkers)
+		return;
+
+	if (!sweep_moves)
+	{
+		sweep_moves = Z_TagMalloc(sv.max_edicts * sizeof(sweepmove_t), TAG_SERVER_GAME);
+		sweep_index = Z_TagMalloc(sv.max_edicts * sizeof(int), TAG_SERVER_GAME);
+		memset(sweep_index, 0, sv.max_edicts * sizeof(int));
+	}
+
+	for (i = svs.max_clients + 1; i < sv.max_edicts; i++)
+	{
+		ent = EDICT_NUM(i);
+		if (!ent->inuse || ent->asleep)
+			continue;
+
+		movetype = (int)ent->v.movetype;
+		if (movetype != MOVETYPE_TOSS && movetype != MOVETYPE_BOUNCE && movetype != MOVETYPE_FLY && movetype != MOVETYPE_FLYMISSILE)
+			continue;
+
+		move = &sweep_moves[sweep_nummoves];
+		if (!SV_PredictMove(ent, move->start, move->end))
+			continue;
+
+		move->ent = ent;
+		move->mask = ent->v.clipmask ? (int)ent->v.clipmask : MASK_SOLID;
+		VectorCopy(ent->v.mins, move->mins);
+		VectorCopy(ent->v.maxs, move->maxs);
+		move->owner = ent->v.owner;
+		move->valid = false;
+
+		sweep_index[i] = ++sweep_nummoves;
+	}
+
+	// not worth waking anyone
+	if (sweep_nummoves < SWEEP_GRAIN)
+	{
+		for (i = 0; i < sweep_nummoves; i++)
+			sweep_index[NUM_FOR_EDICT(sweep_moves[i].ent)] = 0;
+		sweep_nummoves = 0;
+		return;
+	}
+
+	PROF_BEGIN("SV_SweepMovers");
+
+	sweeppool.next = 0;
+	for (i = 0; i < sweeppool.numWorkers; i++)
+		Sys_PostSemaphore(sweeppool.wake);
+
+	SV_SweepSlices(0);
+
+	for (i = 0; i < sweeppool.numWorkers; i++)
+		Sys_WaitSemaphore(sweeppool.done);
+
+	PROF_END();
+}
+
+/*
+===============
+SV_SweptTrace
+
+Hands out the swept trace of the move when nothing it depends on changed
+since the sweep, each one only once so a retry after an impact traces again
+===============
+*/
+qboolean SV_SweptTrace(gentity_t* ent, vec3_t start, vec3_t end, int mask, trace_t* trace)
+{
+	sweepmove_t		*move;
+	sweeptouch_t	touch;
+	gentity_t		*list[SWEEP_MAX_TOUCH];
+	int				i, num, entnum;
+
+	if (!sweep_nummoves)
+		return false;
+
+	entnum = NUM_FOR_EDICT(ent);
+	if (!sweep_index[entnum])
+		return false;
+
+	move = &sweep_moves[sweep_index[entnum] - 1];
+	sweep_index[entnum] = 0;
+
+	if (!move->valid || mask != move->mask || ent->v.owner != move->owner)
+		return false;
+	if (memcmp(start, move->start, sizeof(vec3_t)) || memcmp(end, move->end, sizeof(vec3_t)))
+		return false;
+	if (memcmp(ent->v.mins, move->mins, sizeof(vec3_t)) || memcmp(ent->v.maxs, move->maxs, sizeof(vec3_t)))
+		return false;
+
+	num = SV_MoveEdicts(start, ent->v.mins, ent->v.maxs, end, list, SWEEP_MAX_TOUCH);
+	if (num != move->numtouch)
+		return false;
+
+	for (i = 0; i < num; i++)
+	{
+		SV_SweepTouch(ent, list[i], &touch);
+		if (memcmp(&touch, &move->touch[i], sizeof(touch)))
+			return false;
+	}
+
+	*trace = move->trace;
+	sv.numSwept++;
+	if (sv_bench.active)
+	{
+		sv_bench.traces++;
+		sv_bench.sweptTraces++;
+	}
+	return true;
+}
+
+/*
+===============
+SV_ShutdownSweep
+
+Workers are started again by the next sweep
+===============
+*/
+void SV_ShutdownSweep(void)
+{
+	SV_StopSweepWorkers();
+
+	sweep_moves = NULL;		// freed with the level
+	sweep_index = NULL;
+	sweep_nummoves = 0;
+
+	if (sv_physicsthreads)
+		sv_physicsthreads->modified = true;
+}
+
+/*
+===============
+SV_InitSweep
+===============
+*/
+void SV_InitSweep(void)
+{
+	sv_physicsthreads = Cvar_Get("sv_physicsthreads", "2", CVAR_ARCHIVE, "Number of worker threads tracing projectiles and debris ahead of physics, 0 traces them as they run.");
+	sv_physicsthreads->modified = true;
+}
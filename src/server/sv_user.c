@@ -284,6 +284,25 @@ void SV_Begin_f (void)
 
 //=============================================================================
 
+extern	cvar_t *sv_download_window;
+extern	cvar_t *sv_download_rate;
+
+static int sv_download_ids; // bumped for every windowed transfer
+
+/*
+==================
+SV_FreeDownload
+==================
+*/
+void SV_FreeDownload(client_t *cl)
+{
+	if (cl->download)
+		FS_FreeFile(cl->download);
+
+	cl->download = NULL;
+	cl->dl_windowed = false;
+}
+
 /*
 ==================
 SV_NextDownload_f
@@ -295,7 +314,7 @@ void SV_NextDownload_f (void)
 	int		percent;
 	int		size;
 
-	if (!sv_client->download)
+	if (!sv_client->download || sv_client->dl_windowed)
 		return;
 
 	r = sv_client->downloadsize - sv_client->downloadcount;
@@ -317,31 +336,24 @@ void SV_NextDownload_f (void)
 	if (sv_client->downloadcount != sv_client->downloadsize)
 		return;
 
-	FS_FreeFile (sv_client->download);
-	sv_client->download = NULL;
+	SV_FreeDownload (sv_client);
 }
 
 /*
 ==================
-SV_BeginDownload_f
+SV_OpenDownload
+
+Checks if the client is allowed to download the file and loads it
+into sv_client->download, sends back a refusal when it's not
 ==================
 */
-void SV_BeginDownload_f(void)
+static qboolean SV_OpenDownload(char *name, int offset, int svc)
 {
-	char	*name;
 	extern	cvar_t *allow_download;
 	extern	cvar_t *allow_download_models;
 	extern	cvar_t *allow_download_sounds;
 	extern	cvar_t *allow_download_maps;
 	extern	int		file_from_pak; // ZOID did file come from pak?
-	int offset = 0;
-
-	name = Cmd_Argv(1);
-
-	if (Cmd_Argc() > 2)
-	{
-		offset = (int)strtol(Cmd_Argv(2), (char**)NULL, 10); // downloaded offset, yquake2
-	}
 
 	// hacked by zoid to allow more control over download
 	// first off, no .. or global allow check
@@ -359,23 +371,18 @@ void SV_BeginDownload_f(void)
 		// MUST be in a subdirectory	
 		|| !strstr (name, "/") )	
 	{	// don't allow anything with .. path
-		MSG_WriteByte (&sv_client->netchan.message, SVC_DOWNLOAD);
-		MSG_WriteShort (&sv_client->netchan.message, -1);
-		MSG_WriteByte (&sv_client->netchan.message, 0);
-		return;
+		goto refuse;
 	}
 
-
-	if (sv_client->download)
-		FS_FreeFile (sv_client->download);
+	SV_FreeDownload (sv_client);
 
 	sv_client->downloadsize = FS_LoadFile (name, (void **)&sv_client->download);
 	sv_client->downloadcount = offset;
 
+	if (offset < 0)
+		sv_client->downloadcount = 0;
 	if (offset > sv_client->downloadsize)
-	{
 		sv_client->downloadcount = sv_client->downloadsize;
-	}
 
 	// special check for maps, if it came from a pak file, don't allow download  ZOID
 	if (!sv_client->download || (strncmp(name, "maps/", 5) == 0 && file_from_pak))
@@ -385,26 +392,226 @@ void SV_BeginDownload_f(void)
 		if (dedicated->value)
 			Com_Printf("[%s] client '%s' requested wrong download '%s'\n", GetTimeStamp(false), sv_client->name, name);
 
-		if (sv_client->download) 
-		{
-			FS_FreeFile (sv_client->download);
-			sv_client->download = NULL;
-		}
+		SV_FreeDownload (sv_client);
+		goto refuse;
+	}
+
+	strncpy (sv_client->downloadname, name, sizeof(sv_client->downloadname) - 1);
+
+	if (dedicated->value && !offset)
+		Com_Printf("[%s] client '%s' is downloading '%s'\n", GetTimeStamp(false), sv_client->name, name);
 
-		MSG_WriteByte (&sv_client->netchan.message, SVC_DOWNLOAD);
+	Com_DPrintf (DP_SV, "Downloading %s to %s\n", name, sv_client->name);
+	return true;
+
+refuse:
+	MSG_WriteByte (&sv_client->netchan.message, svc);
+	if (svc == SVC_DOWNLOAD)
+	{
 		MSG_WriteShort (&sv_client->netchan.message, -1);
 		MSG_WriteByte (&sv_client->netchan.message, 0);
-		return;
 	}
+	else
+	{
+		MSG_WriteLong (&sv_client->netchan.message, 0);
+		MSG_WriteLong (&sv_client->netchan.message, -1);
+		MSG_WriteLong (&sv_client->netchan.message, 0);
+	}
+	return false;
+}
+
+/*
+==================
+SV_BeginDownload_f
+
+Legacy download, file is pushed through the reliable message in 1KB chunks each requested by "nextdl"
+==================
+*/
+void SV_BeginDownload_f(void)
+{
+	int offset = 0;
+
+	if (Cmd_Argc() > 2)
+	{
+		offset = (int)strtol(Cmd_Argv(2), (char**)NULL, 10); // downloaded offset, yquake2
+	}
+
+	if (!SV_OpenDownload (Cmd_Argv(1), offset, SVC_DOWNLOAD))
+		return;
 
 	SV_NextDownload_f ();
+}
 
-	if (dedicated->value && !offset)
-		Com_Printf("[%s] client '%s' is downloading '%s'\n", GetTimeStamp(false), sv_client->name, name);
+/*
+==================
+SV_BeginWindowedDownload_f
 
-	Com_DPrintf (DP_SV, "Downloading %s to %s\n", name, sv_client->name);
+"wdownload <file> [offset]"
+
+The file is sent in DOWNLOAD_FRAGMENT_SIZE fragments outside of netchan so it
+doesn't compete with game traffic, up to sv_download_window fragments can be
+in flight and the client acknowledges them selectively with clc_download_ack
+==================
+*/
+void SV_BeginWindowedDownload_f(void)
+{
+	int offset = 0;
+
+	if (Cmd_Argc() > 2)
+		offset = (int)strtol(Cmd_Argv(2), (char**)NULL, 10);
+
+	if (!SV_OpenDownload (Cmd_Argv(1), offset, SVC_DOWNLOAD_WINDOWED))
+		return;
+
+	sv_client->dl_windowed = true;
+	sv_client->dl_id = ++sv_download_ids;
+	sv_client->dl_numfrags = (sv_client->downloadsize - sv_client->downloadcount + DOWNLOAD_FRAGMENT_SIZE - 1) / DOWNLOAD_FRAGMENT_SIZE;
+	sv_client->dl_base = sv_client->dl_next = 0;
+	sv_client->dl_budget = DOWNLOAD_FRAGMENT_SIZE;
+	sv_client->dl_lasttime = sv_client->dl_starttime = svs.realtime;
+
+	MSG_WriteByte (&sv_client->netchan.message, SVC_DOWNLOAD_WINDOWED);
+	MSG_WriteLong (&sv_client->netchan.message, sv_client->dl_id);
+	MSG_WriteLong (&sv_client->netchan.message, sv_client->downloadsize);
+	MSG_WriteLong (&sv_client->netchan.message, sv_client->downloadcount);
+
+	if (!sv_client->dl_numfrags)
+		SV_FreeDownload (sv_client); // client already has all of it
+}
+
+/*
+==================
+SV_DownloadAck
+
+The client has every fragment before base, and bit N of mask set when it also has base+1+N
+==================
+*/
+static void SV_DownloadAck(client_t *cl, int id, int base, unsigned int mask)
+{
+	int		i, frag;
+	float	secs;
+
+	if (!cl->download || !cl->dl_windowed || id != cl->dl_id)
+		return; // stale ack for a finished or replaced transfer
+
+	if (base < cl->dl_base || base > cl->dl_next)
+		base = cl->dl_base; // bogus or reordered, still take the mask
+
+	for (i = 0; i < MAX_DOWNLOAD_WINDOW; i++)
+	{
+		frag = base + 1 + i;
+		if (frag >= cl->dl_next)
+			break;
+		if (mask & (1u << i))
+			cl->dl_sendtime[frag % MAX_DOWNLOAD_WINDOW] = -1;
+	}
+
+	cl->dl_base = base;
+	while (cl->dl_base < cl->dl_next && cl->dl_sendtime[cl->dl_base % MAX_DOWNLOAD_WINDOW] == -1)
+		cl->dl_base++;
+
+	if (cl->dl_base < cl->dl_numfrags)
+		return;
+
+	secs = (svs.realtime - cl->dl_starttime) * 0.001f;
+	if (dedicated->value)
+		Com_Printf("[%s] client '%s' finished downloading '%s'\n", GetTimeStamp(false), cl->name, cl->downloadname);
+	Com_DPrintf (DP_SV, "Sent %s to %s, %i bytes in %.2f seconds (%.1f KB/s)\n", cl->downloadname, cl->name, 
+		cl->downloadsize - cl->downloadcount, secs, secs > 0.0f ? ((cl->downloadsize - cl->downloadcount) / 1024.0f / secs) : 0.0f);
+
+	SV_FreeDownload (cl);
+}
+
+/*
+==================
+SV_SendDownloadFragment
+==================
+*/
+static void SV_SendDownloadFragment(client_t *cl, int frag)
+{
+	sizebuf_t	msg;
+	byte		msg_buf[MAX_MSGLEN];
+	int			ofs, len;
+
+	ofs = cl->downloadcount + frag * DOWNLOAD_FRAGMENT_SIZE;
+	len = cl->downloadsize - ofs;
+	if (len > DOWNLOAD_FRAGMENT_SIZE)
+		len = DOWNLOAD_FRAGMENT_SIZE;
+
+	SZ_Init (&msg, msg_buf, sizeof(msg_buf));
+	SZ_Write (&msg, "dlfrag\n", 7);
+	MSG_WriteLong (&msg, cl->dl_id);
+	MSG_WriteLong (&msg, frag);
+	MSG_WriteShort (&msg, len);
+	SZ_Write (&msg, cl->download + ofs, len);
+
+	Netchan_OutOfBand (NS_SERVER, cl->netchan.remote_address, msg.cursize, msg.data);
+
+	cl->dl_sendtime[frag % MAX_DOWNLOAD_WINDOW] = svs.realtime;
+	cl->dl_budget -= len;
 }
 
+/*
+==================
+SV_SendDownloads
+
+Called every server frame, not only on game ticks, so the transfer isn't
+limited by sv_fps. Lost fragments are resent first, then new ones are
+added while the window and sv_download_rate allow
+==================
+*/
+void SV_SendDownloads(void)
+{
+	client_t	*cl;
+	int			i, frag, sent, window, rate, resend;
+
+	window = (int)sv_download_window->value;
+	if (window < 1)
+		window = 1;
+	if (window > MAX_DOWNLOAD_WINDOW)
+		window = MAX_DOWNLOAD_WINDOW;
+
+	rate = (int)sv_download_rate->value;
+	if (rate < DOWNLOAD_FRAGMENT_SIZE)
+		rate = DOWNLOAD_FRAGMENT_SIZE;
+
+	for (i = 0, cl = svs.clients; i < sv_maxclients->value; i++, cl++)
+	{
+		if (cl->state < cs_connected || !cl->download || !cl->dl_windowed)
+			continue;
+
+		// refill budget, allowing a burst of at most a tenth of a second
+		cl->dl_budget += (svs.realtime - cl->dl_lasttime) * rate / 1000;
+		cl->dl_lasttime = svs.realtime;
+		if (cl->dl_budget > max(rate / 10, DOWNLOAD_FRAGMENT_SIZE))
+			cl->dl_budget = max(rate / 10, DOWNLOAD_FRAGMENT_SIZE);
+
+		resend = cl->ping * 2 + 150;
+
+		for (sent = 0; cl->dl_budget > 0; sent++)
+		{
+			// loopback can only queue a few packets and the netchan needs some of them
+			if (cl->netchan.remote_address.type == NA_LOOPBACK && sent >= 2)
+				break;
+
+			for (frag = cl->dl_base; frag < cl->dl_next; frag++)
+			{
+				int t = cl->dl_sendtime[frag % MAX_DOWNLOAD_WINDOW];
+				if (t != -1 && svs.realtime - t >= resend)
+					break;
+			}
+
+			if (frag == cl->dl_next)
+			{
+				if (cl->dl_next >= cl->dl_numfrags || cl->dl_next >= cl->dl_base + window)
+					break; // everything is in flight
+				cl->dl_next++;
+			}
+
+			SV_SendDownloadFragment (cl, frag);
+		}
+	}
+}
 
 
 //============================================================================
@@ -509,6 +716,7 @@ ucmd_t ucmds[] =
 
 	{"download", SV_BeginDownload_f},
 	{"nextdl", SV_NextDownload_f},
+	{"wdownload", SV_BeginWindowedDownload_f},
 
 	{NULL, NULL}
 };
@@ -548,6 +756,9 @@ void SV_ClientThink (client_t *cl, usercmd_t *cmd)
 		return;
 	}
 
+	if (sv_bench.record)
+		SV_BenchRecordCommand (cl, cmd);
+
 	sv_entity = cl->edict;
 	Scr_ClientThink(cl->edict, cmd);
 }
@@ -604,6 +815,15 @@ void SV_ExecuteClientMessage (client_t *cl)
 		case clc_nop:
 			break;
 
+		case clc_download_ack:
+			{
+				int id = MSG_ReadLong (&net_message);
+				int base = MSG_ReadLong (&net_message);
+				unsigned int mask = MSG_ReadLong (&net_message);
+				SV_DownloadAck (cl, id, base, mask);
+			}
+			break;
+
 		case clc_userinfo:
 			strncpy (cl->userinfo, MSG_ReadString (&net_message), sizeof(cl->userinfo)-1);
 			SV_UserinfoChanged (cl);
@@ -124,6 +124,7 @@ void SV_RunWorldFrame(void)
 {
 	int		i;
 	gentity_t* ent;
+	long long	start = 0;
 
 	sv.gameFrame++;
 	sv.gameTime = sv.gameFrame * SV_FRAMETIME;
@@ -134,9 +135,12 @@ void SV_RunWorldFrame(void)
 		return;
 	}
 
+	PROF_BEGIN("SV_RunWorldFrame");
+
 	SV_ScriptStartFrame();
 
 	// run prethink!
+	PROF_BEGIN("prethink");
 	for (i = 0; i < sv.max_edicts; i++)
 	{
 		ent = EDICT_NUM(i);
@@ -146,6 +150,18 @@ void SV_RunWorldFrame(void)
 		sv_entity = ent;
 		Scr_EntityPreThink(ent);
 	}
+	PROF_END();
+
+	PROF_BEGIN("entities");
+	sv.numAwake = sv.numAsleep = sv.numSwept = 0;
+	if (sv_bench.active)
+		start = Sys_Microseconds();
+
+	// trace projectiles and debris ahead, while nothing moves
+	SV_SweepMovers();
+
+	// riders for the pushers that move this frame
+	SV_LinkRiders();
 
 	for (i = 0; i < sv.max_edicts; i++)
 	{
@@ -188,9 +204,31 @@ void SV_RunWorldFrame(void)
 			continue;
 		}
 
+		// resting, only thinks
+		if (ent->asleep && SV_StaysAsleep(ent))
+		{
+			sv.numAsleep++;
+			SV_RunAsleep(ent);
+			continue;
+		}
+
+		sv.numAwake++;
 		SV_RunEntity(ent);
+		if (ent->inuse)
+			SV_CheckSleep(ent);
 	}
+
+	if (sv_bench.active)
+		sv_bench.physicsTime += Sys_Microseconds() - start;
+	PROF_END();
+
 	SV_EndWorldFrame();
+
+	PROF_BEGIN("Scr_CollectStrings");
+	Scr_CollectStrings(VM_SVGAME);
+	PROF_END();
+
+	PROF_END();
 }
 
 
@@ -226,10 +264,17 @@ typedef struct areanode_s
 areanode_t	sv_areanodes[AREA_NODES];
 int			sv_numareanodes;
 
-float	*area_mins, *area_maxs;
-gentity_t	**area_list;
-int		area_count, area_maxcount;
-int		area_type;
+// one SV_AreaEdicts query, kept on the stack so swept traces can query from worker threads
+typedef struct
+{
+	float		*mins, *maxs;
+	gentity_t	**list;
+	int			count, maxcount;
+	int			type;
+	qboolean	overflowed;
+} areawork_t;
+
+#define	AREA_LINKED		0	// SV_AreaLinked, every list and deactivated entities too
 
 int SV_HullForEntity (gentity_t *ent);
 
@@ -554,6 +599,7 @@ void SV_LinkEdict (gentity_t *ent)
 		VectorCopy (ent->v.origin, ent->v.old_origin);
 	}
 	ent->v.linkcount++;
+	SV_WakeEntity(ent);	// pushed, teleported or moved by progs
 
 	if (ent->v.solid == SOLID_NOT)
 		return;
@@ -585,66 +631,73 @@ void SV_LinkEdict (gentity_t *ent)
 
 /*
 ====================
-SV_AreaEdicts_r
-
+SV_AreaList
 ====================
 */
-void SV_AreaEdicts_r (areanode_t *node)
+static void SV_AreaList (areawork_t *aw, link_t *start)
 {
-	link_t		*l, *next, *start;
+	link_t		*l, *next;
 	gentity_t		*check;
-	int			count;
-
-	count = 0;
-
-	// touch linked edicts
-	start = NULL;
-	if (area_type == AREA_SOLID)
-		start = &node->solid_edicts;
-	else if (area_type == AREA_TRIGGERS)
-		start = &node->trigger_edicts;
-	else  if (area_type == AREA_PATHNODES)
-		start = &node->pathnode_edicts;
-
-	if (start == NULL)
-	{
-		Com_Error(ERR_DROP, "%s: unknown area_type %i\n", __FUNCTION__, area_type);
-		return;
-	}
 
 	for (l=start->next  ; l != start ; l = next)
 	{
 		next = l->next;
 		check = EDICT_FROM_AREA(l);
 
-		if (check->v.solid == SOLID_NOT)
+		if (check->v.solid == SOLID_NOT && aw->type != AREA_LINKED)
 			continue;		// deactivated
-		if (check->v.absmin[0] > area_maxs[0]
-		|| check->v.absmin[1] > area_maxs[1]
-		|| check->v.absmin[2] > area_maxs[2]
-		|| check->v.absmax[0] < area_mins[0]
-		|| check->v.absmax[1] < area_mins[1]
-		|| check->v.absmax[2] < area_mins[2])
+		if (check->v.absmin[0] > aw->maxs[0]
+		|| check->v.absmin[1] > aw->maxs[1]
+		|| check->v.absmin[2] > aw->maxs[2]
+		|| check->v.absmax[0] < aw->mins[0]
+		|| check->v.absmax[1] < aw->mins[1]
+		|| check->v.absmax[2] < aw->mins[2])
 			continue;		// not touching
 
-		if (area_count == area_maxcount)
+		if (aw->count == aw->maxcount)
 		{
-			Com_Printf ("SV_AreaEdicts: MAXCOUNT\n");
+			aw->overflowed = true;
 			return;
 		}
 
-		area_list[area_count] = check;
-		area_count++;
+		aw->list[aw->count] = check;
+		aw->count++;
+	}
+}
+
+/*
+====================
+SV_AreaEdicts_r
+
+====================
+*/
+static void SV_AreaEdicts_r (areawork_t *aw, areanode_t *node)
+{
+	// touch linked edicts
+	if (aw->type == AREA_SOLID)
+		SV_AreaList (aw, &node->solid_edicts);
+	else if (aw->type == AREA_TRIGGERS)
+		SV_AreaList (aw, &node->trigger_edicts);
+	else if (aw->type == AREA_PATHNODES)
+		SV_AreaList (aw, &node->pathnode_edicts);
+	else
+	{
+		SV_AreaList (aw, &node->solid_edicts);
+		SV_AreaList (aw, &node->trigger_edicts);
+		SV_AreaList (aw, &node->pathnode_edicts);
 	}
+
+	if (aw->overflowed)
+		return;
 	
 	if (node->axis == -1)
 		return;		// terminal node
 
 	// recurse down both sides
-	if ( area_maxs[node->axis] > node->dist )
-		SV_AreaEdicts_r ( node->children[0] );
-	if ( area_mins[node->axis] < node->dist )
-		SV_AreaEdicts_r ( node->children[1] );
+	if ( aw->maxs[node->axis] > node->dist )
+		SV_AreaEdicts_r ( aw, node->children[0] );
+	if ( aw->mins[node->axis] < node->dist )
+		SV_AreaEdicts_r ( aw, node->children[1] );
 }
 
 /*
@@ -654,16 +707,58 @@ SV_AreaEdicts
 */
 int SV_AreaEdicts (vec3_t mins, vec3_t maxs, gentity_t **list, int maxcount, int areatype)
 {
-	area_mins = mins;
-	area_maxs = maxs;
-	area_list = list;
-	area_count = 0;
-	area_maxcount = maxcount;
-	area_type = areatype;
+	areawork_t	aw;
+
+	if (areatype != AREA_SOLID && areatype != AREA_TRIGGERS && areatype != AREA_PATHNODES)
+	{
+		Com_Error(ERR_DROP, "%s: unknown area_type %i\n", __FUNCTION__, areatype);
+		return 0;
+	}
+
+	aw.mins = mins;
+	aw.maxs = maxs;
+	aw.list = list;
+	aw.count = 0;
+	aw.maxcount = maxcount;
+	aw.type = areatype;
+	aw.overflowed = false;
+
+	PROF_BEGIN ("SV_AreaEdicts");
+	SV_AreaEdicts_r (&aw, sv_areanodes);
+	PROF_END ();
+
+	if (aw.overflowed)
+		Com_Printf ("SV_AreaEdicts: MAXCOUNT\n");
+
+	return aw.count;
+}
+
+/*
+================
+SV_AreaLinked
+
+Everything linked into the area nodes that touches the box, whatever list it
+is in and even when its solid was changed to SOLID_NOT without relinking
+================
+*/
+int SV_AreaLinked (vec3_t mins, vec3_t maxs, gentity_t **list, int maxcount)
+{
+	areawork_t	aw;
+
+	aw.mins = mins;
+	aw.maxs = maxs;
+	aw.list = list;
+	aw.count = 0;
+	aw.maxcount = maxcount;
+	aw.type = AREA_LINKED;
+	aw.overflowed = false;
+
+	SV_AreaEdicts_r (&aw, sv_areanodes);
 
-	SV_AreaEdicts_r (sv_areanodes);
+	if (aw.overflowed)
+		Com_Printf ("SV_AreaLinked: MAXCOUNT\n");
 
-	return area_count;
+	return aw.count;
 }
 
 
@@ -717,21 +812,24 @@ typedef struct
 	trace_t		trace;
 	gentity_t		*passedict;
 	int			contentmask;
+	int			slot;			// collision slot, 0 on the main thread
+	qboolean	failed;			// ran into something only the main thread may handle
 } moveclip_t;
 
 
 
 /*
 ================
-SV_HullForEntity
+SV_HullForEntitySlot
 
 Returns a headnode that can be used for testing or clipping an
 object of mins/maxs size.
 Offset is filled in to contain the adjustment that must be added to the
 testing object's origin to get a point to use with the returned hull.
+Off the main thread a bad model returns -1 instead of raising an error.
 ================
 */
-int SV_HullForEntity(gentity_t* ent)
+static int SV_HullForEntitySlot(gentity_t* ent, int slot)
 {
 	cmodel_t* model;
 
@@ -743,6 +841,9 @@ int SV_HullForEntity(gentity_t* ent)
 
 		if (!model)
 		{
+			if (slot)
+				return -1;
+
 			Scr_RunError("MOVETYPE_PUSH with a non BSP model for entity %s (%i) at [%i %i %i]\n", Scr_GetString(ent->v.classname),
 				NUM_FOR_EDICT(ent), (int)ent->v.origin[0], (int)ent->v.origin[1], (int)ent->v.origin[2]);
 			return -1; // msvc
@@ -752,7 +853,17 @@ int SV_HullForEntity(gentity_t* ent)
 	}
 
 	// create a temp hull from bounding box sizes
-	return CM_HeadnodeForBox (ent->v.mins, ent->v.maxs);
+	return CM_HeadnodeForBoxSlot (ent->v.mins, ent->v.maxs, slot);
+}
+
+/*
+================
+SV_HullForEntity
+================
+*/
+int SV_HullForEntity(gentity_t* ent)
+{
+	return SV_HullForEntitySlot(ent, 0);
 }
 
 
@@ -760,20 +871,18 @@ int SV_HullForEntity(gentity_t* ent)
 
 /*
 ====================
-SV_ClipMoveToEntities
+SV_ClipMoveToList
 
 ====================
 */
-void SV_ClipMoveToEntities ( moveclip_t *clip )
+static void SV_ClipMoveToList ( moveclip_t *clip, gentity_t **touchlist, int num )
 {
-	int			i, num;
-	gentity_t	*touchlist[MAX_GENTITIES], *touch;
+	int			i;
+	gentity_t	*touch;
 	trace_t		trace;
 	int			headnode;
 	float		*angles;
 
-	num = SV_AreaEdicts(clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES, AREA_SOLID);
-
 	// be careful, it is possible to have an entity in this
 	// list removed before we get to it (killtriggered)
 	for (i=0 ; i<num ; i++)
@@ -801,19 +910,24 @@ void SV_ClipMoveToEntities ( moveclip_t *clip )
 				continue;
 
 		// might intersect, so do an exact clip
-		headnode = SV_HullForEntity (touch);
+		headnode = SV_HullForEntitySlot (touch, clip->slot);
+		if (headnode == -1 && clip->slot)
+		{
+			clip->failed = true;
+			return;
+		}
 		angles = touch->v.angles;
 		if (touch->v.solid != SOLID_BSP)
 			angles = vec3_origin;	// boxes don't rotate
 
 		if ((int)touch->v.svflags & SVF_MONSTER)
-			trace = CM_TransformedBoxTrace (clip->start, clip->end,
+			trace = CM_TransformedBoxTraceSlot (clip->start, clip->end,
 				clip->mins2, clip->maxs2, headnode, clip->contentmask,
-				touch->v.origin, angles);
+				touch->v.origin, angles, clip->slot);
 		else
-			trace = CM_TransformedBoxTrace (clip->start, clip->end,
+			trace = CM_TransformedBoxTraceSlot (clip->start, clip->end,
 				clip->mins, clip->maxs, headnode,  clip->contentmask,
-				touch->v.origin, angles);
+				touch->v.origin, angles, clip->slot);
 
 		if (trace.allsolid || trace.startsolid ||
 		trace.fraction < clip->trace.fraction)
@@ -832,6 +946,21 @@ void SV_ClipMoveToEntities ( moveclip_t *clip )
 	}
 }
 
+/*
+====================
+SV_ClipMoveToEntities
+
+====================
+*/
+void SV_ClipMoveToEntities ( moveclip_t *clip )
+{
+	int			num;
+	gentity_t	*touchlist[MAX_GENTITIES];
+
+	num = SV_AreaEdicts(clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES, AREA_SOLID);
+	SV_ClipMoveToList (clip, touchlist, num);
+}
+
 
 /*
 ==================
@@ -865,52 +994,166 @@ boxmaxs[0] = boxmaxs[1] = boxmaxs[2] = 9999;
 
 /*
 ==================
-SV_Trace
-
-Moves the given mins/maxs volume through the world from start to end.
-
-Passedict and edicts owned by passedict are explicitly not checked.
+SV_StartClip
 
+Clips the move to the world, returns true when the world alone blocks it
 ==================
 */
-trace_t SV_Trace (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t *passedict, int contentmask)
+static qboolean SV_StartClip (moveclip_t *clip, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t *passedict, int contentmask, int slot)
 {
-	moveclip_t	clip;
-
 	if (!mins)
 		mins = vec3_origin;
 	if (!maxs)
 		maxs = vec3_origin;
 
-	memset ( &clip, 0, sizeof ( moveclip_t ) );
+	memset ( clip, 0, sizeof ( moveclip_t ) );
 
 	// clip to world
-	clip.trace = CM_BoxTrace (start, end, mins, maxs, 0, contentmask);
-	clip.trace.ent = sv.edicts;
-	if (clip.trace.fraction == 0)
-		return clip.trace;		// blocked by the world
-
-	clip.contentmask = contentmask;
-	clip.start = start;
-	clip.end = end;
-	clip.mins = mins;
-	clip.maxs = maxs;
-	clip.passedict = passedict;
-
-	VectorCopy (mins, clip.mins2);
-	VectorCopy (maxs, clip.maxs2);
+	clip->trace = CM_BoxTraceSlot (start, end, mins, maxs, 0, contentmask, slot);
+	clip->trace.ent = sv.edicts;
+	if (clip->trace.fraction == 0)
+		return true;		// blocked by the world
+
+	clip->contentmask = contentmask;
+	clip->start = start;
+	clip->end = end;
+	clip->mins = mins;
+	clip->maxs = maxs;
+	clip->passedict = passedict;
+	clip->slot = slot;
+
+	VectorCopy (mins, clip->mins2);
+	VectorCopy (maxs, clip->maxs2);
 	
 	// create the bounding box of the entire move
-	SV_TraceBounds ( start, clip.mins2, clip.maxs2, end, clip.boxmins, clip.boxmaxs );
+	SV_TraceBounds ( start, clip->mins2, clip->maxs2, end, clip->boxmins, clip->boxmaxs );
+	return false;
+}
+
+/*
+==================
+SV_FinishClip
+==================
+*/
+static trace_t SV_FinishClip (moveclip_t *clip)
+{
+	if (clip->trace.ent == NULL)
+		clip->trace.entitynum = ENTITYNUM_NULL;
+	else
+		clip->trace.entitynum = NUM_FOR_ENT(clip->trace.ent);
+
+	return clip->trace;
+}
+
+/*
+==================
+SV_ClipTrace
+==================
+*/
+static trace_t SV_ClipTrace (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t *passedict, int contentmask)
+{
+	moveclip_t	clip;
+
+	if (SV_StartClip (&clip, start, mins, maxs, end, passedict, contentmask, 0))
+		return clip.trace;
 
 	// clip to other solid entities
 	SV_ClipMoveToEntities ( &clip );
 
-	if (clip.trace.ent == NULL)
-		clip.trace.entitynum = ENTITYNUM_NULL;
+	return SV_FinishClip (&clip);
+}
+
+/*
+==================
+SV_MoveEdicts
+
+The solid entities a trace from start to end could hit, in the order SV_Trace
+clips against them. Returns -1 when there are more than maxcount.
+Only reads the world, so it is safe on worker threads while nothing links.
+==================
+*/
+int SV_MoveEdicts (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t **list, int maxcount)
+{
+	areawork_t	aw;
+	vec3_t		boxmins, boxmaxs;
+
+	if (!mins)
+		mins = vec3_origin;
+	if (!maxs)
+		maxs = vec3_origin;
+
+	SV_TraceBounds (start, mins, maxs, end, boxmins, boxmaxs);
+
+	aw.mins = boxmins;
+	aw.maxs = boxmaxs;
+	aw.list = list;
+	aw.count = 0;
+	aw.maxcount = maxcount;
+	aw.type = AREA_SOLID;
+	aw.overflowed = false;
+
+	SV_AreaEdicts_r (&aw, sv_areanodes);
+
+	return aw.overflowed ? -1 : aw.count;
+}
+
+/*
+==================
+SV_TraceSlot
+
+SV_Trace against the entities SV_MoveEdicts returned, for worker threads
+that each own a collision slot. Returns false when the trace has to be
+done on the main thread instead.
+==================
+*/
+qboolean SV_TraceSlot (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t *passedict, int contentmask, gentity_t **list, int num, int slot, trace_t *trace)
+{
+	moveclip_t	clip;
+
+	if (SV_StartClip (&clip, start, mins, maxs, end, passedict, contentmask, slot))
+	{
+		*trace = clip.trace;
+		return true;
+	}
+
+	SV_ClipMoveToList (&clip, list, num);
+	if (clip.failed)
+		return false;
+
+	*trace = SV_FinishClip (&clip);
+	return true;
+}
+
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+
+Passedict and edicts owned by passedict are explicitly not checked.
+
+==================
+*/
+trace_t SV_Trace (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, gentity_t *passedict, int contentmask)
+{
+	trace_t		trace;
+	long long	start_us;
+
+	if (!sv_bench.active && !prof_capturing)
+		return SV_ClipTrace (start, mins, maxs, end, passedict, contentmask);
+
+	PROF_BEGIN ("SV_Trace");
+	if (sv_bench.active)
+	{
+		start_us = Sys_Microseconds();
+		trace = SV_ClipTrace (start, mins, maxs, end, passedict, contentmask);
+		sv_bench.traceTime += Sys_Microseconds() - start_us;
+		sv_bench.traces++;
+	}
 	else
-		clip.trace.entitynum = NUM_FOR_ENT(clip.trace.ent);
+		trace = SV_ClipTrace (start, mins, maxs, end, passedict, contentmask);
+	PROF_END ();
 
-	return clip.trace;
+	return trace;
 }
 
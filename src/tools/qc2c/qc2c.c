@@ -0,0 +1,856 @@
+/*
+pragma
+Copyright (C) 2023-2024 BraXi.
+
+Quake 2 Engine 'Id Tech 2'
+Copyright (C) 1997-2001 Id Software, Inc.
+
+See the attached GNU General Public License v2 for more details.
+*/
+
+/*
+qc2c -- translates compiled progs to C ahead of time
+
+	qc2c svgame.dat svgame_aot.c
+	gcc -O2 -shared -fPIC -fvisibility=hidden -I src/script svgame_aot.c -o build/progs/svgame_aot.so
+	cl /O2 /LD /I src\script svgame_aot.c /Fe:build\progs\svgame_aot.dll
+
+Every function of the .dat becomes one C function with its parms and locals held
+in C variables, everything else still lives in the qcvm globals and entities so the
+translated code and the interpreter can call each other freely. Functions using an
+opcode this tool doesn't know are left out and keep running in the interpreter.
+
+The module is stamped with the CRC of the .dat, the engine only loads it when the
+progs it loaded have the very same CRC (see scr_aot.c), so a stale module can
+never run against different progs.
+
+This is a standalone program, it doesn't link with the engine.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+enum
+{
+#include "../../script/qc_opcodes.h"
+};
+
+#define	PROG_VERSION		6
+#define	PROG_VERSION_FTE	7
+
+#define	OFS_RETURN			1
+#define	OFS_PARM0			4
+#define	MAX_PARMS			8
+
+typedef struct
+{
+	int		first_statement;
+	int		parm_start;
+	int		locals;
+	int		profile;
+	int		s_name;
+	int		s_file;
+	int		numparms;
+	unsigned char	parm_size[MAX_PARMS];
+} dfunction_t;
+
+typedef struct
+{
+	unsigned short	op;
+	short	a, b, c;
+} dstatement_t;
+
+typedef struct
+{
+	unsigned short	type;
+	unsigned short	ofs;
+	int			s_name;
+} ddef_t;
+
+typedef struct
+{
+	int		version;
+	int		crc;
+	int		ofs_statements;
+	int		numStatements;
+	int		ofs_globaldefs;
+	int		numGlobalDefs;
+	int		ofs_fielddefs;
+	int		numFieldDefs;
+	int		ofs_functions;
+	int		numFunctions;
+	int		ofs_strings;
+	int		numstrings;
+	int		ofs_globals;
+	int		numGlobals;
+	int		entityfields;
+} dprograms_t;
+
+#define	SCR_AOT_LEAF		1	// keep in sync with scr_aot.h
+
+// builtins with an inline fast path, same set and semantics as the interpreter intrinsics
+typedef enum
+{
+	INL_NONE,
+	INL_VLEN,
+	INL_NORMALIZE,
+	INL_DOTPRODUCT,
+	INL_FABS,
+	INL_SQRT,
+	INL_FLOOR
+} inline_t;
+
+static const struct
+{
+	const char	*name;
+	int			numparms;
+	inline_t	inl;
+} inlines[] =
+{
+	{"vlen", 1, INL_VLEN},
+	{"vectorlength", 1, INL_VLEN},
+	{"normalize", 1, INL_NORMALIZE},
+	{"dotproduct", 2, INL_DOTPRODUCT},
+	{"fabs", 1, INL_FABS},
+	{"sqrt", 1, INL_SQRT},
+	{"floor", 1, INL_FLOOR},
+	{NULL, 0, INL_NONE}
+};
+
+typedef struct
+{
+	int		end;			// one past the last statement
+	int		translated;
+	int		flags;
+	const char	*skipped;	// reason it is left to the interpreter
+} funcinfo_t;
+
+static unsigned char	*progsfile;
+static int				progslen;
+static dprograms_t		*progs;
+static dfunction_t		*functions;
+static dstatement_t		*statements;
+static int				*globals;
+static char				*strings;
+
+static funcinfo_t		*info;
+static unsigned char	*labels;
+
+static FILE				*out;
+static dfunction_t		*cur;		// function being emitted
+
+static void Error(const char *fmt, ...)
+{
+	va_list	argptr;
+
+	va_start(argptr, fmt);
+	fprintf(stderr, "qc2c: ");
+	vfprintf(stderr, fmt, argptr);
+	fprintf(stderr, "\n");
+	va_end(argptr);
+	exit(1);
+}
+
+static void Emit(const char *fmt, ...)
+{
+	va_list	argptr;
+
+	va_start(argptr, fmt);
+	vfprintf(out, fmt, argptr);
+	va_end(argptr);
+}
+
+/*
+============
+CRC_Block
+
+Same 16 bit CCITT CRC the engine stores in qcvm_t->crc
+============
+*/
+static unsigned short CRC_Block(const unsigned char *data, int count)
+{
+	unsigned short	crc = 0xffff;
+	int				i;
+
+	while (count--)
+	{
+		crc ^= *data++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+static const char *String(int ofs)
+{
+	if (ofs < 0 || ofs >= progs->numstrings)
+		return "?";
+	return strings + ofs;
+}
+
+/*
+============
+CString
+
+Quotes a progs string so it can be pasted into the generated source
+============
+*/
+static const char *CString(const char *s)
+{
+	static char	buf[4][256];
+	static int	n;
+	char		*o;
+	int			i;
+
+	o = buf[n++ & 3];
+	for (i = 0; *s && i < 250; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			o[i++] = '\\';
+		if (*s == '*' && s[1] == '/')
+			continue;
+		o[i++] = (*s >= ' ' && *s < 127) ? *s : '?';
+	}
+	o[i] = 0;
+	return buf[(n - 1) & 3];
+}
+
+/*
+============
+W
+
+C lvalue of one global word, parms and locals of the current function are C variables
+============
+*/
+static const char *W(int ofs)
+{
+	static char	buf[16][32];
+	static int	n;
+	char		*o;
+
+	o = buf[n++ & 15];
+	if (ofs >= cur->parm_start && ofs < cur->parm_start + cur->locals)
+		sprintf(o, "l%d", ofs - cur->parm_start);
+	else
+		sprintf(o, "G[%d]", ofs);
+	return o;
+}
+
+// operand words of a statement, V* picks a vector component
+#define	A		W(a)
+#define	B		W(b)
+#define	C		W(c)
+#define	VA(k)	W(a + (k))
+#define	VB(k)	W(b + (k))
+#define	VC(k)	W(c + (k))
+
+/*
+============
+InlineFor
+
+Returns the fast path for a call through global 'ofs', if it holds a known builtin
+============
+*/
+static inline_t InlineFor(int ofs, int argc)
+{
+	dfunction_t	*f;
+	int			func, i;
+
+	if (ofs < 0 || ofs >= progs->numGlobals)
+		return INL_NONE;
+
+	func = globals[ofs];
+	if (func <= 0 || func >= progs->numFunctions)
+		return INL_NONE;
+
+	f = &functions[func];
+	if (f->first_statement >= 0)
+		return INL_NONE;
+
+	for (i = 0; inlines[i].name; i++)
+	{
+		if (inlines[i].numparms == argc && !strcmp(String(f->s_name), inlines[i].name))
+			return inlines[i].inl;
+	}
+	return INL_NONE;
+}
+
+/*
+============
+Supported
+
+Every opcode EmitStatement knows, the unsupported FTE pointer ops fail in the interpreter too
+============
+*/
+static int Supported(int op)
+{
+	switch (op)
+	{
+	case OP_DONE: case OP_RETURN: case OP_STATE:
+	case OP_IF: case OP_IFNOT: case OP_GOTO:
+	case OP_CALL0: case OP_CALL1: case OP_CALL2: case OP_CALL3: case OP_CALL4:
+	case OP_CALL5: case OP_CALL6: case OP_CALL7: case OP_CALL8:
+
+	case OP_ADD_F: case OP_SUB_F: case OP_MUL_F: case OP_DIV_F:
+	case OP_ADD_V: case OP_SUB_V: case OP_MUL_V: case OP_MUL_FV: case OP_MUL_VF:
+	case OP_BITAND: case OP_BITOR: case OP_AND: case OP_OR:
+	case OP_GE: case OP_LE: case OP_GT: case OP_LT:
+	case OP_NOT_F: case OP_NOT_V: case OP_NOT_S: case OP_NOT_FNC: case OP_NOT_ENT:
+	case OP_EQ_F: case OP_EQ_V: case OP_EQ_S: case OP_EQ_E: case OP_EQ_FNC:
+	case OP_NE_F: case OP_NE_V: case OP_NE_S: case OP_NE_E: case OP_NE_FNC:
+
+	case OP_STORE_F: case OP_STORE_V: case OP_STORE_S: case OP_STORE_ENT: case OP_STORE_FLD: case OP_STORE_FNC:
+	case OP_STORE_I: case OP_STORE_IF: case OP_STORE_FI:
+	case OP_STOREP_F: case OP_STOREP_V: case OP_STOREP_S: case OP_STOREP_ENT: case OP_STOREP_FLD: case OP_STOREP_FNC:
+	case OP_STOREP_I: case OP_STOREP_IF: case OP_STOREP_FI:
+	case OP_LOAD_F: case OP_LOAD_V: case OP_LOAD_S: case OP_LOAD_ENT: case OP_LOAD_FLD: case OP_LOAD_FNC:
+	case OP_LOAD_I: case OP_ADDRESS:
+
+	case OP_ADD_I: case OP_ADD_FI: case OP_ADD_IF: case OP_SUB_I: case OP_SUB_FI: case OP_SUB_IF:
+	case OP_CONV_ITOF: case OP_CONV_FTOI: case OP_MUL_I: case OP_DIV_I:
+	case OP_EQ_I: case OP_NE_I: case OP_NOT_I: case OP_EQ_IF: case OP_EQ_FI:
+	case OP_BITAND_I: case OP_BITOR_I: case OP_BITXOR_I: case OP_RSHIFT_I: case OP_LSHIFT_I:
+	case OP_LE_I: case OP_LE_IF: case OP_LE_FI: case OP_GT_I: case OP_GT_IF: case OP_GT_FI:
+	case OP_LT_I: case OP_LT_IF: case OP_LT_FI: case OP_GE_I: case OP_GE_IF: case OP_GE_FI:
+	case OP_MUL_IF: case OP_MUL_FI: case OP_MUL_VI: case OP_MUL_IV: case OP_DIV_IF: case OP_DIV_FI:
+	case OP_BITAND_IF: case OP_BITOR_IF: case OP_BITAND_FI: case OP_BITOR_FI:
+	case OP_AND_I: case OP_OR_I: case OP_AND_IF: case OP_OR_IF: case OP_AND_FI: case OP_OR_FI:
+	case OP_NE_IF: case OP_NE_FI:
+		return 1;
+	}
+	return 0;
+}
+
+/*
+============
+Analyze
+
+Finds the statements of every function, its jump targets and whether it can be translated
+============
+*/
+static void Analyze(void)
+{
+	int		i, j, s, next, target;
+	dstatement_t	*st;
+	dfunction_t	*f;
+
+	for (i = 1; i < progs->numFunctions; i++)
+	{
+		f = &functions[i];
+		if (f->first_statement <= 0)
+		{
+			info[i].skipped = "builtin";
+			continue;
+		}
+
+		// functions are laid out back to back, so this one ends where the next one starts
+		next = progs->numStatements;
+		for (j = 1; j < progs->numFunctions; j++)
+		{
+			if (functions[j].first_statement > f->first_statement && functions[j].first_statement < next)
+				next = functions[j].first_statement;
+		}
+		info[i].end = next;
+		info[i].flags = SCR_AOT_LEAF;
+
+		if (f->parm_start < 0 || f->locals < 0 || f->parm_start + f->locals > progs->numGlobals || f->numparms > MAX_PARMS)
+		{
+			info[i].skipped = "bad locals";
+			continue;
+		}
+
+		for (s = f->first_statement; s < next && !info[i].skipped; s++)
+		{
+			st = &statements[s];
+			if (!Supported(st->op))
+			{
+				info[i].skipped = "unsupported opcode";
+				break;
+			}
+
+			if ((st->op >= OP_CALL0 && st->op <= OP_CALL8) || st->op == OP_STATE)
+				info[i].flags &= ~SCR_AOT_LEAF;
+
+			target = -1;
+			if (st->op == OP_IF || st->op == OP_IFNOT)
+				target = s + st->b;
+			else if (st->op == OP_GOTO)
+				target = s + st->a;
+			else
+				continue;
+
+			if (target < f->first_statement || target >= next)
+				info[i].skipped = "jump out of function";
+			else
+				labels[target] = 1;
+		}
+
+		if (!info[i].skipped)
+		{
+			j = statements[next - 1].op;
+			if (j != OP_DONE && j != OP_RETURN && j != OP_GOTO)
+				info[i].skipped = "falls off the end";
+		}
+
+		info[i].translated = !info[i].skipped;
+	}
+}
+
+/*
+============
+EmitCall
+============
+*/
+static void EmitCall(int a, int argc)
+{
+	int		func;
+
+	switch (InlineFor(a, argc))
+	{
+	case INL_VLEN:
+		Emit("\tif (%s.i == %d)\n\t\tG[1].f = sqrt(G[4].f * G[4].f + G[5].f * G[5].f + G[6].f * G[6].f);\n", A, globals[a]);
+		break;
+	case INL_NORMALIZE:
+		Emit("\tif (%s.i == %d)\n\t{\n", A, globals[a]);
+		Emit("\t\tfloat len = sqrt(G[4].f * G[4].f + G[5].f * G[5].f + G[6].f * G[6].f);\n");
+		Emit("\t\tif (len == 0)\n\t\t\tG[1].f = G[2].f = G[3].f = 0;\n");
+		Emit("\t\telse\n\t\t{\n\t\t\tlen = 1 / len;\n");
+		Emit("\t\t\tG[1].f = G[4].f * len;\n\t\t\tG[2].f = G[5].f * len;\n\t\t\tG[3].f = G[6].f * len;\n\t\t}\n\t}\n");
+		break;
+	case INL_DOTPRODUCT:
+		Emit("\tif (%s.i == %d)\n\t\tG[1].f = G[4].f * G[7].f + G[5].f * G[8].f + G[6].f * G[9].f;\n", A, globals[a]);
+		break;
+	case INL_FABS:
+		Emit("\tif (%s.i == %d)\n\t\tG[1].f = fabs(G[4].f);\n", A, globals[a]);
+		break;
+	case INL_SQRT:
+		Emit("\tif (%s.i == %d)\n\t\tG[1].f = sqrt(G[4].f);\n", A, globals[a]);
+		break;
+	case INL_FLOOR:
+		Emit("\tif (%s.i == %d)\n\t\tG[1].f = floor(G[4].f);\n", A, globals[a]);
+		break;
+
+	default:
+		// a constant function global is called directly as long as nobody reassigned it
+		func = (a >= 0 && a < progs->numGlobals) ? globals[a] : 0;
+		if (func > 0 && func < progs->numFunctions && info[func].translated)
+			Emit("\tif (vm->direct && %s.i == %d)\n\t\tqc_%d();\n", A, func, func);
+		else
+		{
+			Emit("\tvm->call(%s.i, %d);\n", A, argc);
+			return;
+		}
+		break;
+	}
+	Emit("\telse\n\t\tvm->call(%s.i, %d);\n", A, argc);
+}
+
+/*
+============
+EmitStatement
+============
+*/
+static void EmitStatement(int s)
+{
+	dstatement_t	*st = &statements[s];
+	int				a, b, c, k;
+
+	a = (unsigned short)st->a;
+	b = (unsigned short)st->b;
+	c = (unsigned short)st->c;
+
+	switch (st->op)
+	{
+	case OP_ADD_F: Emit("\t%s.f = %s.f + %s.f;\n", C, A, B); break;
+	case OP_SUB_F: Emit("\t%s.f = %s.f - %s.f;\n", C, A, B); break;
+	case OP_MUL_F: Emit("\t%s.f = %s.f * %s.f;\n", C, A, B); break;
+	case OP_DIV_F: Emit("\t%s.f = %s.f / %s.f;\n", C, A, B); break;
+
+	case OP_ADD_V:
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = %s.f + %s.f;\n", VC(k), VA(k), VB(k));
+		break;
+	case OP_SUB_V:
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = %s.f - %s.f;\n", VC(k), VA(k), VB(k));
+		break;
+	case OP_MUL_V:
+		Emit("\t%s.f = %s.f * %s.f + %s.f * %s.f + %s.f * %s.f;\n", C, VA(0), VB(0), VA(1), VB(1), VA(2), VB(2));
+		break;
+	case OP_MUL_FV:
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = %s.f * %s.f;\n", VC(k), A, VB(k));
+		break;
+	case OP_MUL_VF:
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = %s.f * %s.f;\n", VC(k), B, VA(k));
+		break;
+
+	case OP_BITAND: Emit("\t%s.f = (int)%s.f & (int)%s.f;\n", C, A, B); break;
+	case OP_BITOR: Emit("\t%s.f = (int)%s.f | (int)%s.f;\n", C, A, B); break;
+	case OP_GE: Emit("\t%s.f = %s.f >= %s.f;\n", C, A, B); break;
+	case OP_LE: Emit("\t%s.f = %s.f <= %s.f;\n", C, A, B); break;
+	case OP_GT: Emit("\t%s.f = %s.f > %s.f;\n", C, A, B); break;
+	case OP_LT: Emit("\t%s.f = %s.f < %s.f;\n", C, A, B); break;
+	case OP_AND: Emit("\t%s.f = %s.f && %s.f;\n", C, A, B); break;
+	case OP_OR: Emit("\t%s.f = %s.f || %s.f;\n", C, A, B); break;
+
+	case OP_NOT_F: Emit("\t%s.f = !%s.f;\n", C, A); break;
+	case OP_NOT_V: Emit("\t%s.f = !%s.f && !%s.f && !%s.f;\n", C, VA(0), VA(1), VA(2)); break;
+	case OP_NOT_S: Emit("\t%s.f = vm->stringEmpty(%s.i);\n", C, A); break;
+	case OP_NOT_FNC: Emit("\t%s.f = !%s.i;\n", C, A); break;
+	case OP_NOT_ENT: Emit("\t%s.f = (%s.i == 0);\n", C, A); break;
+
+	case OP_EQ_F: Emit("\t%s.f = %s.f == %s.f;\n", C, A, B); break;
+	case OP_EQ_V:
+		Emit("\t%s.f = (%s.f == %s.f) && (%s.f == %s.f) && (%s.f == %s.f);\n", C, VA(0), VB(0), VA(1), VB(1), VA(2), VB(2));
+		break;
+	case OP_EQ_S: Emit("\t%s.f = vm->stringsEqual(%s.i, %s.i);\n", C, A, B); break;
+	case OP_EQ_E:
+	case OP_EQ_FNC: Emit("\t%s.f = %s.i == %s.i;\n", C, A, B); break;
+
+	case OP_NE_F: Emit("\t%s.f = %s.f != %s.f;\n", C, A, B); break;
+	case OP_NE_V:
+		Emit("\t%s.f = (%s.f != %s.f) || (%s.f != %s.f) || (%s.f != %s.f);\n", C, VA(0), VB(0), VA(1), VB(1), VA(2), VB(2));
+		break;
+	case OP_NE_S: Emit("\t%s.f = !vm->stringsEqual(%s.i, %s.i);\n", C, A, B); break;
+	case OP_NE_E:
+	case OP_NE_FNC: Emit("\t%s.f = %s.i != %s.i;\n", C, A, B); break;
+
+	case OP_STORE_F:
+	case OP_STORE_ENT:
+	case OP_STORE_FLD:
+	case OP_STORE_S:
+	case OP_STORE_I:
+	case OP_STORE_FNC:
+		Emit("\t%s.i = %s.i;\n", B, A);
+		break;
+	case OP_STORE_V:
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = %s.f;\n", VB(k), VA(k));
+		break;
+	case OP_STORE_IF: Emit("\t%s.f = (float)%s.i;\n", B, A); break;
+	case OP_STORE_FI: Emit("\t%s.i = (int)%s.f;\n", B, A); break;
+
+	case OP_STOREP_F:
+	case OP_STOREP_ENT:
+	case OP_STOREP_FLD:
+	case OP_STOREP_S:
+	case OP_STOREP_I:
+	case OP_STOREP_FNC:
+		Emit("\tPTR(%s.i)->i = %s.i;\n", B, A);
+		break;
+	case OP_STOREP_V:
+		for (k = 0; k < 3; k++)
+			Emit("\tPTR(%s.i)[%d].f = %s.f;\n", B, k, VA(k));
+		break;
+	case OP_STOREP_IF: Emit("\tPTR(%s.i)->f = (float)%s.i;\n", B, A); break;
+	case OP_STOREP_FI: Emit("\tPTR(%s.i)->i = (int)%s.f;\n", B, A); break;
+
+	case OP_ADDRESS:
+		Emit("\tif (!%s.i && vm->protectWorld)\n\t\tvm->error(\"tried to modify worldspawn entity fields which are read only\\n\");\n", A);
+		Emit("\t%s.i = (int)((unsigned char *)FIELD(%s.i, %s.i) - vm->entities);\n", C, A, B);
+		break;
+
+	case OP_LOAD_F:
+	case OP_LOAD_I:
+	case OP_LOAD_FLD:
+	case OP_LOAD_ENT:
+	case OP_LOAD_S:
+	case OP_LOAD_FNC:
+		Emit("\t%s.i = FIELD(%s.i, %s.i)->i;\n", C, A, B);
+		break;
+	case OP_LOAD_V:
+		Emit("\tp = FIELD(%s.i, %s.i);\n", A, B);
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = p[%d].f;\n", VC(k), k);
+		break;
+
+	// FTE integers, these mirror the interpreter exactly, conversions included
+	case OP_ADD_I: Emit("\t%s.i = %s.i + %s.i;\n", C, A, B); break;
+	case OP_ADD_FI: Emit("\t%s.f = %s.f + (float)%s.i;\n", C, A, B); break;
+	case OP_ADD_IF: Emit("\t%s.f = (float)%s.i + %s.f;\n", C, A, B); break;
+	case OP_SUB_I: Emit("\t%s.i = %s.i - %s.i;\n", C, A, B); break;
+	case OP_SUB_FI: Emit("\t%s.f = %s.f - (float)%s.i;\n", C, A, B); break;
+	case OP_SUB_IF: Emit("\t%s.f = (float)%s.i - %s.f;\n", C, A, B); break;
+	case OP_CONV_ITOF: Emit("\t%s.f = (float)%s.i;\n", C, A); break;
+	case OP_CONV_FTOI: Emit("\t%s.i = (int)%s.f;\n", C, A); break;
+	case OP_MUL_I: Emit("\t%s.i = %s.i * %s.i;\n", C, A, B); break;
+	case OP_DIV_I:
+		Emit("\tif (%s.i == 0)\n\t\tvm->error(\"division by zero\");\n\telse\n\t\t%s.i = %s.i / %s.i;\n", B, C, A, B);
+		break;
+	case OP_EQ_I: Emit("\t%s.i = (%s.i == %s.i);\n", C, A, B); break;
+	case OP_NE_I: Emit("\t%s.i = (%s.i != %s.i);\n", C, A, B); break;
+	case OP_NOT_I: Emit("\t%s.i = !%s.i;\n", C, A); break;
+	case OP_EQ_IF: Emit("\t%s.i = (float)(%s.i == %s.f);\n", C, A, B); break;
+	case OP_EQ_FI: Emit("\t%s.i = (float)(%s.f == %s.i);\n", C, A, B); break;
+	case OP_BITAND_I: Emit("\t%s.i = (%s.i & %s.i);\n", C, A, B); break;
+	case OP_BITOR_I: Emit("\t%s.i = (%s.i | %s.i);\n", C, A, B); break;
+	case OP_BITXOR_I: Emit("\t%s.i = %s.i ^ %s.i;\n", C, A, B); break;
+	case OP_RSHIFT_I: Emit("\t%s.i = %s.i >> %s.i;\n", C, A, B); break;
+	case OP_LSHIFT_I: Emit("\t%s.i = %s.i << %s.i;\n", C, A, B); break;
+	case OP_LE_I: Emit("\t%s.i = (int)(%s.i <= %s.i);\n", C, A, B); break;
+	case OP_LE_IF: Emit("\t%s.i = (int)(%s.i <= %s.f);\n", C, A, B); break;
+	case OP_LE_FI: Emit("\t%s.i = (int)(%s.f <= %s.i);\n", C, A, B); break;
+	case OP_GT_I: Emit("\t%s.i = (int)(%s.i > %s.i);\n", C, A, B); break;
+	case OP_GT_IF: Emit("\t%s.i = (int)(%s.i > %s.f);\n", C, A, B); break;
+	case OP_GT_FI: Emit("\t%s.i = (int)(%s.f > %s.i);\n", C, A, B); break;
+	case OP_LT_I: Emit("\t%s.i = (int)(%s.i < %s.i);\n", C, A, B); break;
+	case OP_LT_IF: Emit("\t%s.i = (int)(%s.i < %s.f);\n", C, A, B); break;
+	case OP_LT_FI: Emit("\t%s.i = (int)(%s.f < %s.i);\n", C, A, B); break;
+	case OP_GE_I: Emit("\t%s.i = (int)(%s.i >= %s.i);\n", C, A, B); break;
+	case OP_GE_IF: Emit("\t%s.i = (int)(%s.i >= %s.f);\n", C, A, B); break;
+	case OP_GE_FI: Emit("\t%s.i = (int)(%s.f >= %s.i);\n", C, A, B); break;
+	case OP_MUL_IF: Emit("\t%s.f = (%s.i * %s.f);\n", C, A, B); break;
+	case OP_MUL_FI: Emit("\t%s.f = (%s.f * %s.i);\n", C, A, B); break;
+	case OP_MUL_VI:
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = %s.f * %s.i;\n", VC(k), VA(k), B);
+		break;
+	case OP_MUL_IV:
+		for (k = 0; k < 3; k++)
+			Emit("\t%s.f = %s.i * %s.f;\n", VC(k), A, VB(k));
+		break;
+	case OP_DIV_IF: Emit("\t%s.f = (%s.i / %s.f);\n", C, A, B); break;
+	case OP_DIV_FI: Emit("\t%s.f = (%s.f / %s.i);\n", C, A, B); break;
+	case OP_BITAND_IF: Emit("\t%s.i = (%s.i & (int)%s.f);\n", C, A, B); break;
+	case OP_BITOR_IF: Emit("\t%s.i = (%s.i | (int)%s.f);\n", C, A, B); break;
+	case OP_BITAND_FI: Emit("\t%s.i = ((int)%s.f & %s.i);\n", C, A, B); break;
+	case OP_BITOR_FI: Emit("\t%s.i = ((int)%s.f | %s.i);\n", C, A, B); break;
+	case OP_AND_I: Emit("\t%s.i = (%s.i && %s.i);\n", C, A, B); break;
+	case OP_OR_I: Emit("\t%s.i = (%s.i || %s.i);\n", C, A, B); break;
+	case OP_AND_IF: Emit("\t%s.i = (%s.i && %s.f);\n", C, A, B); break;
+	case OP_OR_IF: Emit("\t%s.i = (%s.i || %s.f);\n", C, A, B); break;
+	case OP_AND_FI: Emit("\t%s.i = (%s.f && %s.i);\n", C, A, B); break;
+	case OP_OR_FI: Emit("\t%s.i = (%s.f || %s.i);\n", C, A, B); break;
+	case OP_NE_IF: Emit("\t%s.i = (%s.i != %s.f);\n", C, A, B); break;
+	case OP_NE_FI: Emit("\t%s.i = (%s.f != %s.i);\n", C, A, B); break;
+
+	// control flow, backward jumps count against the runaway limit
+	case OP_IF:
+	case OP_IFNOT:
+		Emit("\tif (%s%s.i)\n", st->op == OP_IFNOT ? "!" : "", A);
+		if (st->b <= 0)
+			Emit("\t{\n\t\tLOOP();\n\t\tgoto s%d;\n\t}\n", s + st->b);
+		else
+			Emit("\t\tgoto s%d;\n", s + st->b);
+		break;
+	case OP_GOTO:
+		if (st->a <= 0)
+			Emit("\tLOOP();\n");
+		Emit("\tgoto s%d;\n", s + st->a);
+		break;
+
+	case OP_CALL0:
+	case OP_CALL1:
+	case OP_CALL2:
+	case OP_CALL3:
+	case OP_CALL4:
+	case OP_CALL5:
+	case OP_CALL6:
+	case OP_CALL7:
+	case OP_CALL8:
+		EmitCall(a, st->op - OP_CALL0);
+		break;
+
+	case OP_STATE:
+		Emit("\tvm->state(&%s, &%s);\n", A, B);
+		break;
+
+	case OP_DONE:
+	case OP_RETURN:
+		for (k = 0; k < 3; k++)
+			Emit("\tG[%d] = %s;\n", OFS_RETURN + k, VA(k));
+		Emit("\tvm->depth--;\n\treturn;\n");
+		break;
+
+	default:
+		Error("opcode %d slipped past Analyze", st->op);
+	}
+}
+
+/*
+============
+EmitFunction
+============
+*/
+static void EmitFunction(int fnum)
+{
+	dfunction_t	*f = &functions[fnum];
+	int			i, j, o, s, op, usesp, usesev;
+	char		*init;
+
+	cur = f;
+
+	usesp = usesev = 0;
+	for (s = f->first_statement; s < info[fnum].end; s++)
+	{
+		op = statements[s].op;
+		usesp |= op == OP_LOAD_V;
+		usesev |= op == OP_ADDRESS || (op >= OP_LOAD_F && op <= OP_LOAD_FNC) || op == OP_LOAD_I;
+	}
+
+	Emit("\n/* %s (%s) */\n", CString(String(f->s_name)), CString(String(f->s_file)));
+	Emit("static void qc_%d(void)\n{\n", fnum);
+	Emit("\tscr_aotword_t *const G = vm->globals;\n");
+	if (usesev)
+		Emit("\tunsigned char *const EV = vm->entities + vm->offsetToEntVars;\n");
+	if (usesp)
+		Emit("\tscr_aotword_t *p;\n");
+
+	// locals start out with whatever the globals hold, parms are copied over them like EnterFunction does
+	init = calloc(f->locals + 1, 1);
+	o = 0;
+	for (i = 0; i < f->numparms; i++)
+	{
+		for (j = 0; j < f->parm_size[i] && o < f->locals; j++, o++)
+		{
+			Emit("\tscr_aotword_t l%d = G[%d];\n", o, OFS_PARM0 + i * 3 + j);
+			init[o] = 1;
+		}
+	}
+	for (i = 0; i < f->locals; i++)
+	{
+		if (!init[i])
+			Emit("\tscr_aotword_t l%d = G[%d];\n", i, f->parm_start + i);
+	}
+	free(init);
+
+	Emit("\n\tif (++vm->depth >= vm->maxDepth)\n\t\tvm->error(\"stack overflow in %s\");\n\n", CString(String(f->s_name)));
+	Emit("#undef LOOP_NAME\n#define LOOP_NAME \"%s\"\n", CString(String(f->s_name)));
+
+	for (s = f->first_statement; s < info[fnum].end; s++)
+	{
+		if (labels[s])
+			Emit("s%d:\n", s);
+		EmitStatement(s);
+	}
+
+	Emit("}\n");
+}
+
+/*
+============
+EmitModule
+============
+*/
+static void EmitModule(const char *source, unsigned short crc)
+{
+	int		i, n;
+
+	Emit("/* generated by qc2c from %s -- DO NOT EDIT */\n\n", CString(source));
+	Emit("#include <math.h>\n#include \"scr_aot.h\"\n\n");
+	Emit("static scr_aotvm_t *vm;\n\n");
+	Emit("#define	FIELD(e, f)	((scr_aotword_t *)(EV + (e)) + (f))\n");
+	Emit("#define	PTR(p)		((scr_aotword_t *)(vm->entities + (p)))\n");
+	Emit("#define	LOOP()		if (--vm->runaway <= 0) vm->error(\"runaway loop error in function %%s\", LOOP_NAME)\n\n");
+
+	for (i = 1; i < progs->numFunctions; i++)
+	{
+		if (info[i].translated)
+			Emit("static void qc_%d(void);\n", i);
+	}
+
+	for (i = 1, n = 0; i < progs->numFunctions; i++)
+	{
+		if (info[i].translated)
+		{
+			EmitFunction(i);
+			n++;
+		}
+	}
+
+	Emit("\nstatic const scr_aotfunc_t functions[%d] =\n{\n\t0,\n", progs->numFunctions);
+	for (i = 1; i < progs->numFunctions; i++)
+	{
+		if (info[i].translated)
+			Emit("\tqc_%d,\n", i);
+		else
+			Emit("\t0, /* %s: %s */\n", CString(String(functions[i].s_name)), info[i].skipped);
+	}
+	Emit("};\n");
+
+	Emit("\nstatic const unsigned char flags[%d] =\n{\n\t", progs->numFunctions);
+	for (i = 0; i < progs->numFunctions; i++)
+		Emit("%d,%s", info[i].translated ? info[i].flags : 0, (i & 31) == 31 ? "\n\t" : "");
+	Emit("\n};\n");
+
+	Emit("\nstatic void AOT_Init(scr_aotvm_t *imports)\n{\n\tvm = imports;\n}\n");
+	Emit("\nstatic scr_aotmodule_t module =\n{\n\tSCR_AOT_API_VERSION,\n\t%u,\n\t%d,\n\t%d,\n\tAOT_Init,\n\tfunctions,\n\tflags\n};\n", crc, progs->numFunctions, n);
+	Emit("\nSCR_AOT_EXPORT scr_aotmodule_t *Scr_GetAOTModule(void)\n{\n\treturn &module;\n}\n");
+
+	fprintf(stderr, "qc2c: %s: translated %d of %d functions, crc %u\n", source, n, progs->numFunctions - 1, crc);
+}
+
+/*
+============
+LoadProgs
+============
+*/
+static void LoadProgs(const char *filename)
+{
+	FILE	*f;
+
+	f = fopen(filename, "rb");
+	if (!f)
+		Error("couldn't open %s", filename);
+
+	fseek(f, 0, SEEK_END);
+	progslen = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (progslen < (int)sizeof(dprograms_t))
+		Error("%s is too small", filename);
+
+	progsfile = malloc(progslen);
+	if (fread(progsfile, 1, progslen, f) != (size_t)progslen)
+		Error("couldn't read %s", filename);
+	fclose(f);
+
+	// progs are little endian and so is every platform the engine runs on
+	progs = (dprograms_t*)progsfile;
+	if (progs->version != PROG_VERSION && progs->version != PROG_VERSION_FTE)
+		Error("%s is wrong version %d", filename, progs->version);
+
+	if (progs->ofs_statements + progs->numStatements * (int)sizeof(dstatement_t) > progslen ||
+		progs->ofs_functions + progs->numFunctions * (int)sizeof(dfunction_t) > progslen ||
+		progs->ofs_globals + progs->numGlobals * 4 > progslen ||
+		progs->ofs_strings + progs->numstrings > progslen)
+		Error("%s is truncated", filename);
+
+	functions = (dfunction_t*)(progsfile + progs->ofs_functions);
+	statements = (dstatement_t*)(progsfile + progs->ofs_statements);
+	globals = (int*)(progsfile + progs->ofs_globals);
+	strings = (char*)progsfile + progs->ofs_strings;
+
+	info = calloc(progs->numFunctions, sizeof(*info));
+	labels = calloc(progs->numStatements + 1, 1);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned short	crc;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: qc2c <progs.dat> <output.c>\n");
+		return 1;
+	}
+
+	LoadProgs(argv[1]);
+	crc = CRC_Block(progsfile, progslen);
+
+	Analyze();
+
+	out = fopen(argv[2], "w");
+	if (!out)
+		Error("couldn't write %s", argv[2]);
+
+	EmitModule(argv[1], crc);
+
+	if (fclose(out))
+		Error("couldn't write %s", argv[2]);
+	return 0;
+}